@@ -0,0 +1,87 @@
+
+# Throughput benchmark for Mallob's IPC socket interface.
+# Opens a number of concurrent client connections, each of which submits
+# (trivial) DUMMY jobs with up to a certain number of requests in flight,
+# and reports the number of completed requests per second.
+#
+# Usage: python3 scripts/run/bench_ipc_socket.py [#connections] [#jobs-per-connection] [#in-flight] [socket-path]
+# Run Mallob beforehand with the IPC interface enabled, e.g.:
+# build/mallob -interface-ipc=1 -interface-fs=0 -ajpc=1000 -ljpc=1000 -v=2
+# To compare with the thread-per-connection server, run once more with -ipc-elt=0
+# and #in-flight=1 (its connections process one request at a time).
+# test_event_socket_server compares both servers without a running Mallob.
+
+from multiprocessing.connection import Client
+from multiprocessing import Process, Queue
+import glob
+import json
+import sys
+import time
+
+# ASCII character to send in order to close an active connection.
+ASCII_CHAR_CANCEL = 24
+
+def send_string(conn, string):
+    conn.send_bytes(string.encode('ascii'))
+
+def recv(conn):
+    return conn.recv_bytes().decode('ascii')
+
+def find_mallob_socket():
+    files = glob.glob('/tmp/mallob_*.0.sk')
+    if files == []:
+        return None
+    return files[-1]
+
+def run_client(client_idx, socket_path, num_jobs, num_in_flight, out_queue):
+    conn = Client(socket_path)
+    latencies = []
+    send_times = dict()
+    num_sent = 0
+    num_received = 0
+    time_start = time.time()
+    while num_received < num_jobs:
+        # Keep the pipeline filled
+        while num_sent < num_jobs and num_sent - num_received < num_in_flight:
+            name = "bench-%i-%i" % (client_idx, num_sent)
+            send_times[name] = time.time()
+            send_string(conn, json.dumps({"user": "bench", "name": name,
+                "application": "DUMMY", "priority": 1.0, "files": []}))
+            num_sent += 1
+        response = json.loads(recv(conn))
+        name = response.get("name", None)
+        if name in send_times:
+            latencies.append(time.time() - send_times.pop(name))
+        num_received += 1
+    elapsed = time.time() - time_start
+    send_string(conn, chr(ASCII_CHAR_CANCEL))
+    conn.close()
+    out_queue.put((num_received, elapsed, latencies))
+
+def main():
+    num_conns = int(sys.argv[1]) if len(sys.argv) > 1 else 16
+    num_jobs = int(sys.argv[2]) if len(sys.argv) > 2 else 1000
+    num_in_flight = int(sys.argv[3]) if len(sys.argv) > 3 else 8
+    socket_path = sys.argv[4] if len(sys.argv) > 4 else find_mallob_socket()
+    if socket_path is None:
+        print("No Mallob IPC socket found")
+        sys.exit(1)
+
+    queue = Queue()
+    procs = [Process(target=run_client, args=(i, socket_path, num_jobs, num_in_flight, queue)) for i in range(num_conns)]
+    time_start = time.time()
+    for p in procs:
+        p.start()
+    results = [queue.get() for _ in procs]
+    for p in procs:
+        p.join()
+    elapsed = time.time() - time_start
+
+    total = sum([r[0] for r in results])
+    latencies = sorted([l for r in results for l in r[2]])
+    print("connections=%i in_flight=%i requests=%i time=%.3fs throughput=%.1f req/s" % (num_conns, num_in_flight, total, elapsed, total / elapsed))
+    if latencies:
+        print("latency median=%.3fms p99=%.3fms" % (1000*latencies[len(latencies)//2], 1000*latencies[int(0.99*(len(latencies)-1))]))
+
+if __name__ == '__main__':
+    main()
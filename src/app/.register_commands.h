@@ -0,0 +1,2 @@
+register_mallob_app_dummy();
+register_mallob_app_sat();
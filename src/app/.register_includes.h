@@ -0,0 +1,2 @@
+#include "app/dummy/register.hpp"
+#include "app/sat/register.hpp"
@@ -0,0 +1,2 @@
+#include "app/dummy/options.hpp"
+#include "app/sat/options.hpp"
@@ -11,6 +11,7 @@ namespace app_registry {
             JobReader reader;
             JobCreator creator;
             JobSolutionFormatter solutionFormatter;
+            ProgramOptionsValidator optionsValidator;
         };
 
         std::vector<AppEntry> _app_entries;
@@ -22,10 +23,13 @@ namespace app_registry {
     // reader: a lambda which reads a number of description files into a JobDescription object.
     // creator: a lambda which returns a new instance of a particular subclass of Job.
     // solutionFormatter: a lambda which transforms a found job result into 
+    // optionsValidator: a lambda which reports whether the program options are consistent
+    //   as far as the application is concerned (reporting any error itself).
     void registerApplication(const std::string& key,
         JobReader reader, 
         JobCreator creator, 
-        JobSolutionFormatter solutionFormatter
+        JobSolutionFormatter solutionFormatter,
+        ProgramOptionsValidator optionsValidator
     ) {
         int appId = _app_entries.size();
         _app_key_to_app_id[key] = appId;
@@ -36,6 +40,7 @@ namespace app_registry {
         entry.reader = reader;
         entry.creator = creator;
         entry.solutionFormatter = solutionFormatter;
+        entry.optionsValidator = optionsValidator;
         _app_entries.push_back(std::move(entry));
     }
 
@@ -65,5 +70,12 @@ namespace app_registry {
         getAppKey(appId); // check existence
         return _app_entries.at(appId).solutionFormatter;
     }
-}
 
+    bool areProgramOptionsValid(const Parameters& params) {
+        bool valid = true;
+        for (auto& entry : _app_entries) {
+            valid &= entry.optionsValidator(params);
+        }
+        return valid;
+    }
+}
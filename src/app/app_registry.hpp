@@ -18,11 +18,13 @@ namespace app_registry {
     typedef std::function<bool(const Parameters&, const std::vector<std::string>&, JobDescription&)> JobReader;
     typedef std::function<Job*(const Parameters&, const Job::JobSetup&, AppMessageTable&)> JobCreator;
     typedef std::function<nlohmann::json(const JobResult&)> JobSolutionFormatter;
+    typedef std::function<bool(const Parameters&)> ProgramOptionsValidator;
 
     void registerApplication(const std::string& key,
         JobReader reader, 
         JobCreator creator, 
-        JobSolutionFormatter resultPrinter
+        JobSolutionFormatter resultPrinter,
+        ProgramOptionsValidator optionsValidator = [](const Parameters&) {return true;}
     );
 
     int getAppId(const std::string& key);
@@ -31,4 +33,6 @@ namespace app_registry {
     JobReader getJobReader(int appId);
     JobCreator getJobCreator(int appId);
     JobSolutionFormatter getJobSolutionFormatter(int appId);
+
+    bool areProgramOptionsValid(const Parameters& params);
 }
@@ -1,8 +1,10 @@
 #include "kmeans_job.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
-#include <random>
-#include <thread>
+#include <limits>
 
 #include "app/job.hpp"
 #include "app/job_tree.hpp"
@@ -12,6 +14,7 @@
 #include "kmeans_utils.hpp"
 #include "util/assert.hpp"
 #include "util/logger.hpp"
+#include "util/random.hpp"
 #include "util/sys/proc.hpp"
 #include "util/sys/process.hpp"
 #include "util/sys/thread_pool.hpp"
@@ -27,7 +30,7 @@ void KMeansJob::appl_start() {
 
     _num_curr_workers = 1;
     if (_is_root) {
-        LOG(V2_INFO, "%s : kmeans instance loaded\n", toStr());
+        LOG(V2_INFO, "%s : kmeans instance loaded (distance kernel: %s)\n", toStr(), KMeansUtils::simdLevelToStr(KMeansUtils::getSimdLevel()));
     }
     LOG(V5_DEBG, "COMMSIZE: %i myRank: %i myIndex: %i\n",
         _num_curr_workers, _my_rank, _my_index);
@@ -43,6 +46,12 @@ void KMeansJob::appl_start() {
 
     loadInstance();
     _cluster_membership.assign(_num_points, -1);
+    if (_params.kmeansPruning()) {
+        _upper_bounds.resize(_num_points);
+        _lower_bounds.resize(_num_points);
+        _bound_assignment.resize(_num_points);
+        _bounds_epoch.assign(_num_points, -2);
+    }
 
     _local_cluster_centers.resize(_num_clusters);
     _cluster_centers.resize(_num_clusters);
@@ -128,14 +137,28 @@ void KMeansJob::initReducer(JobMessage& msg) {
 void KMeansJob::sendRootNotification() {
     _init_send = false;
     _base_msg.tag = MSG_BROADCAST_DATA;
-    _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-    _base_msg.payload.push_back(_num_curr_workers);
+    _base_msg.payload = getBroadcast(_num_curr_workers);
     LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification0\n", _my_index);
     getJobTree().sendToRoot(_base_msg);
 }
 void KMeansJob::doInitWork() {
     _init_msg_task = ProcessWideThreadPool::get().addTask([&]() {
-        setRandomStartCenters();
+        if (_params.kmeansInitRounds() > 0) {
+            // k-means|| over the job tree, starting from a single random candidate
+            SplitMix64Rng rng(getInitSeed());
+            _init_candidates.assign(1, rng() % _num_points);
+            _init_round = 0;
+            _init_cost = 0;
+            _phase = INIT_COST;
+            _time_of_init = Timer::elapsedSeconds();
+        } else {
+            setStartCenters();
+        }
+        if (_params.kmeansMiniBatch() > 0) {
+            _batch_means.resize((size_t) _num_clusters * _dimension);
+            _center_matrix_root.resize((size_t) _num_clusters * _dimension);
+        }
+        _time_of_first_iteration = Timer::elapsedSeconds();
         _init_send = true;
     });
 
@@ -187,6 +210,8 @@ void KMeansJob::reset() {
     if (_init_msg_task.valid()) _init_msg_task.get();
     if (_calculating_task.valid()) _calculating_task.get();
     _reducer.reset();
+    _phase = LLOYD;
+    releaseInitState();
 
     _terminate = false;
     appl_start();
@@ -228,7 +253,7 @@ void KMeansJob::appl_communicate() {
                 if (!_right_done) _right_done = (currentIndex == (_my_index * 2 + 2));
                 LOG(V5_DEBG, "KMDBG myIndex: %i Start Calc\n", _my_index);
                 if (!_skip_current_iter) {
-                    calcNearestCenter(metric, cI);
+                    processInterval(cI);
                 }
                 LOG(V5_DEBG, "KMDBG myIndex: %i End Calc childs\n", _my_index);
 
@@ -249,6 +274,7 @@ void KMeansJob::appl_communicate() {
         LOG(V5_DEBG, "KMDBG myIndex: %i all work Finished2!!!\n", _my_index);
         if (!_skip_current_iter) {
             auto producer = [&]() {
+                if (_phase != LLOYD) return initStepToReduce();
                 calcCurrentClusterCenters();
 
                 // LOG(V5_DEBG, "clusterCenters: \n%s\n", dataToString(localClusterCenters).c_str());
@@ -264,12 +290,11 @@ void KMeansJob::appl_communicate() {
         if (!_skip_current_iter) {
             if (_is_root && (_reducer)->hasResult()) {
                 LOG(V5_DEBG, "KMDBG myIndex: %i received Result from Transform\n", _my_index);
-                setClusterCenters((_reducer)->extractResult());
+                readBroadcast((_reducer)->extractResult());
                 _cluster_membership.assign(_num_points, -1);
 
                 _base_msg.tag = MSG_BROADCAST_DATA;
-                _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-                _base_msg.payload.push_back(_num_curr_workers);
+                _base_msg.payload = getBroadcast(_num_curr_workers);
                 LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification1\n", _my_index);
                 getJobTree().sendToRoot(_base_msg);
                 // only root...?
@@ -289,8 +314,7 @@ void KMeansJob::appl_communicate() {
             _reducer.reset();
             _cluster_membership.assign(_num_points, -1);
             _base_msg.tag = MSG_BROADCAST_DATA;
-            _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-            _base_msg.payload.push_back(this->getVolume());
+            _base_msg.payload = getBroadcast(this->getVolume());
             LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification2\n", _my_index);
             getJobTree().sendToRoot(_base_msg);
         }
@@ -378,7 +402,7 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
     if (msg.tag == MSG_BROADCAST_DATA) {
         LOG(V5_DEBG, "KMDBG myIndex: %i MSG_BROADCAST_DATA \n", _my_index);
         LOG(V5_DEBG, "KMDBG myIndex: %i Workers: %i!\n", _my_index, _num_curr_workers);
-        setClusterCenters(msg.payload);
+        readBroadcast(msg.payload);
         if (_my_index < _num_curr_workers) {
             initReducer(msg);
             _cluster_membership.assign(_num_points, -1);
@@ -389,7 +413,7 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
             //     dataToString(clusterCenters).c_str());
             _calculating_task = ProcessWideThreadPool::get().addTask([&]() {
                 LOG(V5_DEBG, "KMDBG myIndex: %i Start Calc\n", _my_index);
-                calcNearestCenter(metric, _my_index);
+                processInterval(_my_index);
                 LOG(V5_DEBG, "KMDBG myIndex: %i End Calc basic\n", _my_index);
                 _calculating_finished = true;
             });
@@ -428,95 +452,327 @@ void KMeansJob::loadInstance() {
     setMaxDemand();
 }
 
-void KMeansJob::setRandomStartCenters() {  // use RNG with seed
+uint64_t KMeansJob::getInitSeed() const {
+    // Deterministic w.r.t. the user seed and the job ID
+    return ((uint64_t) _params.seed() << 32) | (uint32_t) getId();
+}
+
+void KMeansJob::setStartCenters() {
+    const float time = Timer::elapsedSeconds();
+    auto centers = KMeansUtils::initCentersRandom(_points_start, _num_points, _dimension, _num_clusters, getInitSeed());
     _cluster_centers.clear();
     _cluster_centers.resize(_num_clusters);
-    std::vector<int> selectedPoints;
-    selectedPoints.reserve(_num_clusters);
-    int randomNumber;
-    std::random_device rd;
-    //std::mt19937 gen(42);  // seed 42 for testing
-    std::mt19937 gen(rd());  
-    std::uniform_int_distribution<> distr(0, _num_points - 1);
     for (int i = 0; i < _num_clusters; ++i) {
-        randomNumber = distr(gen);
-        while (std::find(selectedPoints.begin(), selectedPoints.end(), randomNumber) != selectedPoints.end()) {
-            randomNumber = distr(gen);
+        _cluster_centers[i].assign(centers.begin() + (size_t) i * _dimension, centers.begin() + (size_t) (i+1) * _dimension);
+    }
+    LOG(V3_VERB, "%s : initial centers computed in %.3fs\n", toStr(), Timer::elapsedSeconds() - time);
+}
+
+void KMeansJob::updateCenterMatrix() {
+    // Flatten the centers such that the distances from a point to all centers
+    // can be computed in one pass of the vectorized kernel
+    std::vector<float> matrix((size_t) _num_clusters * _dimension);
+    for (int clusterID = 0; clusterID < _num_clusters; ++clusterID) {
+        std::copy(_cluster_centers[clusterID].begin(), _cluster_centers[clusterID].end(),
+            matrix.begin() + (size_t) clusterID * _dimension);
+    }
+    // Same centers as before (e.g., repeated broadcast): all bounds remain valid
+    if (matrix == _center_matrix) return;
+
+    ++_center_epoch;
+    if (_params.kmeansPruning()) {
+        // Movement of each center since the last epoch
+        const bool hasPrevious = _center_matrix.size() == matrix.size();
+        _center_movement.assign(_num_clusters, 0);
+        _max_movement = 0;
+        _second_max_movement = 0;
+        _max_movement_center = -1;
+        for (int clusterID = 0; hasPrevious && clusterID < _num_clusters; ++clusterID) {
+            const size_t offset = (size_t) clusterID * _dimension;
+            float movement = std::sqrt(KMeansUtils::eukild(matrix.data() + offset,
+                _center_matrix.data() + offset, _dimension));
+            _center_movement[clusterID] = movement;
+            if (movement > _max_movement) {
+                _second_max_movement = _max_movement;
+                _max_movement = movement;
+                _max_movement_center = clusterID;
+            } else if (movement > _second_max_movement) {
+                _second_max_movement = movement;
+            }
         }
-        LOG(V5_DEBG, "                          randomNumber: %i\n", randomNumber);
-        selectedPoints.push_back(randomNumber);
-        _cluster_centers[i].reserve(_dimension);
-        for (int d = 0; d < _dimension; d++) {
-            _cluster_centers[i].push_back(getKMeansData(randomNumber)[d]);
+        // Half the distance of each center to its nearest other center
+        std::vector<float> distances(_num_clusters);
+        _center_separation.assign(_num_clusters, std::numeric_limits<float>::infinity());
+        for (int clusterID = 0; clusterID < _num_clusters; ++clusterID) {
+            KMeansUtils::squaredDistances(matrix.data() + (size_t) clusterID * _dimension,
+                matrix.data(), _num_clusters, _dimension, distances.data());
+            for (int other = 0; other < _num_clusters; ++other) {
+                if (other == clusterID) continue;
+                _center_separation[clusterID] = std::min(_center_separation[clusterID], 0.5f * std::sqrt(distances[other]));
+            }
         }
     }
+    _center_matrix = std::move(matrix);
 }
 
-void KMeansJob::calcNearestCenter(std::function<float(const float* p1, const float* p2, const size_t dim)> metric, int intervalId) {
-    int currentCluster;
-    float currentDistance;
-    float distanceToCluster;
-    // while own or child slices todo
-    int startIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(intervalId) / static_cast<float>(_num_curr_workers)));
-    int endIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(intervalId + 1) / static_cast<float>(_num_curr_workers)));
-    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i start:%i end:%i!!      iter:%i k:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, startIndex, endIndex, _iterations_done, _num_clusters);
-    for (int pointID = startIndex; pointID < endIndex; ++pointID) {
-        if (_terminate) return;
-        // LOG(V1_WARN, "(pointID / endIndex) < 0.25: %i iAmRoot: %i countCurrentWorkers == 1: %i std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end()): %i leftDone && rightDone:%i this->getVolume() > 1:%i\n", (pointID / endIndex) < 0.25, iAmRoot, countCurrentWorkers == 1, std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end(), leftDone && rightDone,  this->getVolume() > 1);
-
-        if (((float)pointID / endIndex) < 0.25 &&
-            _is_root &&
-            (_num_curr_workers == 1 ||
-             (std::find(_work.begin(), _work.end(), 1) != _work.end() && std::find(_work.begin(), _work.end(), 2) != _work.end())) &&
-            (_left_done && _right_done) &&
-            this->getVolume() > 1) {
-            LOG(V3_VERB, "%s : will skip Iter\n", toStr());
-            _skip_current_iter = true;
-            _work.clear();
-            _work_done.clear();
-            return;
+void KMeansJob::runInParallel(int begin, int end, const std::function<void(int, int, int)>& f) {
+    // Use all threads granted to this job, but not for tiny ranges
+    const int numChunks = std::max(1, std::min(getNumThreads(), (end - begin) / 4096));
+    if (numChunks == 1) {
+        f(0, begin, end);
+        return;
+    }
+    // Chunks are claimed by the calling thread and by tasks in the process-wide thread pool.
+    // The calling thread (usually a pool thread itself) also runs each chunk which no pool thread
+    // has claimed yet, so it never waits for a queued task. Tasks which start late find nothing
+    // left to do and only touch the shared state.
+    struct State {
+        std::atomic_int nextChunk {0};
+        int numDone {0};
+        Mutex mutex;
+        ConditionVariable condVar;
+    };
+    auto state = std::make_shared<State>();
+    auto runChunks = [state, &f, begin, end, numChunks]() {
+        int chunk;
+        while ((chunk = state->nextChunk.fetch_add(1)) < numChunks) {
+            f(chunk, begin + (long) (end - begin) * chunk / numChunks, begin + (long) (end - begin) * (chunk+1) / numChunks);
+            {
+                auto lock = state->mutex.getLock();
+                state->numDone++;
+            }
+            state->condVar.notify();
         }
-        currentCluster = -1;
-        currentDistance = std::numeric_limits<float>::infinity();
-        for (int clusterID = 0; clusterID < _num_clusters; ++clusterID) {
-            distanceToCluster = metric(getKMeansData(pointID), _cluster_centers[clusterID].data(), _dimension);
-            if (distanceToCluster < currentDistance) {
-                currentCluster = clusterID;
-                currentDistance = distanceToCluster;
+    };
+    for (int chunk = 1; chunk < numChunks; ++chunk) ProcessWideThreadPool::get().addDetachedTask(runChunks);
+    runChunks();
+    auto lock = state->mutex.getLock();
+    state->condVar.waitWithLockedMutex(lock, [&]() {return state->numDone == numChunks;});
+}
+
+void KMeansJob::runInParallel(const std::vector<std::pair<int, int>>& ranges, const std::function<void(int, int, int)>& f) {
+    // Split the concatenation of all ranges and map each chunk back to (sub-)ranges
+    std::vector<long> offsets(1, 0);
+    for (auto& [begin, end] : ranges) offsets.push_back(offsets.back() + end - begin);
+    runInParallel(0, offsets.back(), [&](int chunk, int chunkBegin, int chunkEnd) {
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            const long begin = std::max((long) chunkBegin, offsets[r]);
+            const long end = std::min((long) chunkEnd, offsets[r+1]);
+            if (begin >= end) continue;
+            f(chunk, ranges[r].first + (begin - offsets[r]), ranges[r].first + (end - offsets[r]));
+        }
+    });
+}
+
+std::vector<std::pair<int, int>> KMeansJob::getIntervalRanges(int intervalId) {
+    if (_slice_owners_num_workers != _num_curr_workers) {
+        // Slices stay with their worker unless it left (or new workers take over some of them),
+        // so the Hamerly bounds of most points remain valid after a volume change
+        KMeansUtils::getSliceOwners(_num_points, _num_curr_workers, _slice_owners);
+        _slice_owners_num_workers = _num_curr_workers;
+    }
+    return KMeansUtils::getWorkerRanges(_num_points, _slice_owners, intervalId);
+}
+
+void KMeansJob::processInterval(int intervalId) {
+    if (_phase == LLOYD) calcNearestCenter(intervalId);
+    else calcInitStep(intervalId);
+}
+
+void KMeansJob::calcInitStep(int intervalId) {
+    const auto ranges = getIntervalRanges(intervalId);
+    const int numCandidates = _init_candidates.size();
+    const double expectedPerRound = _params.kmeansInitOversampling() * _num_clusters;
+    const uint64_t seed = getInitSeed();
+
+    // Cost and nearest counts (cost step) or samples (sampling step), accumulated per thread
+    const int numThreads = std::max(1, getNumThreads());
+    std::vector<double> partialCosts(numThreads, 0);
+    std::vector<std::vector<int>> partialCounts(numThreads);
+    if (_phase == INIT_COST) partialCounts.assign(numThreads, std::vector<int>(numCandidates, 0));
+    std::vector<std::vector<int>> partialSamples(numThreads);
+    runInParallel(ranges, [&](int chunk, int begin, int end) {
+        std::vector<float> distances(numCandidates);
+        for (int pointID = begin; pointID < end; ++pointID) {
+            if (_terminate) break;
+            // Catch up with the candidates added since this point was last processed
+            const int covered = _init_covered[pointID];
+            if (covered < numCandidates) {
+                const int j = KMeansUtils::nearestCenter(getKMeansData(pointID),
+                    _init_candidate_matrix.data() + (size_t) covered * _dimension, numCandidates - covered,
+                    _dimension, distances.data());
+                if (distances[j] < _init_min_dist[pointID]) {
+                    _init_min_dist[pointID] = distances[j];
+                    _init_nearest[pointID] = covered + j;
+                }
+                _init_covered[pointID] = numCandidates;
+            }
+            if (_phase == INIT_COST) {
+                partialCosts[chunk] += _init_min_dist[pointID];
+                partialCounts[chunk][_init_nearest[pointID]]++;
+            } else if (KMeansUtils::getSamplingCoin(seed, _init_round, pointID)
+                    < expectedPerRound * _init_min_dist[pointID] / _init_cost) {
+                partialSamples[chunk].push_back(pointID);
             }
         }
+    });
+    if (_terminate) return;
+    for (int t = 0; t < numThreads; ++t) {
+        _init_local_cost += partialCosts[t];
+        if (_phase == INIT_COST) {
+            for (int c = 0; c < numCandidates; ++c) _init_local_counts[c] += partialCounts[t][c];
+        }
+        _init_local_samples.insert(_init_local_samples.end(), partialSamples[t].begin(), partialSamples[t].end());
+    }
+}
+
+void KMeansJob::calcNearestCenter(int intervalId) {
+    updateCenterMatrix();
+    const bool prune = _params.kmeansPruning();
+    // while own or child slices todo
+    const auto ranges = getIntervalRanges(intervalId);
+    long numIntervalPoints = 0;
+    for (auto& [begin, end] : ranges) numIntervalPoints += end - begin;
+    const float time = Timer::elapsedSeconds();
+    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i ranges:%lu points:%li!!      iter:%i k:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, ranges.size(), numIntervalPoints, _iterations_done, _num_clusters);
+
+    // In mini-batch mode, each point takes part in the iteration with the given probability
+    const float batchFraction = _params.kmeansMiniBatch() > 0 ? _params.kmeansMiniBatch() : 1;
+    std::atomic_bool abort {false};
+    std::atomic_ulong numComputed {0};
+    std::atomic_ulong numAssigned {0};
+    std::atomic_ulong numWithBounds {0};
+    std::atomic_long numDoneInFirstChunk {0};
+    const long firstChunkSize = numIntervalPoints / std::max(1, std::min(getNumThreads(), (int) (numIntervalPoints / 4096)));
+    runInParallel(ranges, [&](int chunk, int begin, int end) {
+        std::vector<float> distances(_num_clusters);
+        unsigned long computed = 0;
+        unsigned long assigned = 0;
+        unsigned long withBounds = 0;
+        SplitMix64Rng rng(((uint64_t) _params.seed() << 32) ^ ((uint64_t) getId() << 20)
+            ^ ((uint64_t) _iterations_done << 40) ^ begin);
+        for (int pointID = begin; pointID < end; ++pointID) {
+            if (_terminate || abort) break;
+            // LOG(V1_WARN, "(pointID / endIndex) < 0.25: %i iAmRoot: %i countCurrentWorkers == 1: %i std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end()): %i leftDone && rightDone:%i this->getVolume() > 1:%i\n", (pointID / endIndex) < 0.25, iAmRoot, countCurrentWorkers == 1, std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end(), leftDone && rightDone,  this->getVolume() > 1);
+
+            if (chunk == 0 &&
+                (float) (numDoneInFirstChunk++) / firstChunkSize < 0.25 &&
+                _is_root &&
+                (_num_curr_workers == 1 ||
+                 (std::find(_work.begin(), _work.end(), 1) != _work.end() && std::find(_work.begin(), _work.end(), 2) != _work.end())) &&
+                (_left_done && _right_done) &&
+                this->getVolume() > 1) {
+                LOG(V3_VERB, "%s : will skip Iter\n", toStr());
+                _skip_current_iter = true;
+                _work.clear();
+                _work_done.clear();
+                abort = true;
+                break;
+            }
+            if (batchFraction < 1 && rng.randomInRange(0, 1) >= batchFraction) continue;
+            const float* point = getKMeansData(pointID);
+            ++assigned;
+
+            if (prune && _bounds_epoch[pointID] >= _center_epoch - 1) {
+                ++withBounds;
+                const int assigned = _bound_assignment[pointID];
+                float& upper = _upper_bounds[pointID];
+                float& lower = _lower_bounds[pointID];
+                if (_bounds_epoch[pointID] != _center_epoch) {
+                    // Adjust the bounds to the center movement of the last epoch
+                    upper += _center_movement[assigned];
+                    lower -= assigned == _max_movement_center ? _second_max_movement : _max_movement;
+                    _bounds_epoch[pointID] = _center_epoch;
+                }
+                const float bound = std::max(lower, _center_separation[assigned]);
+                if (upper > bound) {
+                    // Tighten the upper bound and check again
+                    upper = std::sqrt(KMeansUtils::eukild(point,
+                        _center_matrix.data() + (size_t) assigned * _dimension, _dimension));
+                    ++computed;
+                }
+                if (upper <= bound) {
+                    // No other center can be nearer than the assigned one
+                    _cluster_membership[pointID] = assigned;
+                    continue;
+                }
+            }
 
-        _cluster_membership[pointID] = currentCluster;
+            const int nearest = KMeansUtils::nearestCenter(point,
+                _center_matrix.data(), _num_clusters, _dimension, distances.data());
+            computed += _num_clusters;
+            _cluster_membership[pointID] = nearest;
+            if (prune) {
+                float secondNearest = std::numeric_limits<float>::infinity();
+                for (int clusterID = 0; clusterID < _num_clusters; ++clusterID) {
+                    if (clusterID != nearest) secondNearest = std::min(secondNearest, distances[clusterID]);
+                }
+                _upper_bounds[pointID] = std::sqrt(distances[nearest]);
+                _lower_bounds[pointID] = std::sqrt(secondNearest);
+                _bound_assignment[pointID] = nearest;
+                _bounds_epoch[pointID] = _center_epoch;
+            }
+        }
+        numComputed += computed;
+        numAssigned += assigned;
+        numWithBounds += withBounds;
+    });
+    if (_terminate || abort) return;
+    _num_distances_computed += numComputed;
+    _num_distances_total += numAssigned * _num_clusters;
+    if (_last_num_workers != _num_curr_workers) {
+        // Report the time to resume with an interval after a change of the job's volume
+        if (_last_num_workers != -1) LOG(V3_VERB, "%s : #%i first interval %i after volume %i->%i: %li points, %.1f%% with valid bounds, %.4fs\n",
+            toStr(), _my_index, intervalId, _last_num_workers, _num_curr_workers, numIntervalPoints,
+            numAssigned == 0 ? 0 : 100.0 * numWithBounds / numAssigned, Timer::elapsedSeconds() - time);
+        _last_num_workers = _num_curr_workers;
     }
-    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i start:%i end:%i COMPLETED iter:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, startIndex, endIndex, _iterations_done);
+    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i points:%li COMPLETED iter:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, numIntervalPoints, _iterations_done);
 }
 
 void KMeansJob::calcCurrentClusterCenters() {
     _old_cluster_centers = _cluster_centers;
 
-    countMembers();
-
+    // Per-cluster member counts and coordinate sums of the points in all intervals done,
+    // accumulated per thread and merged afterwards
+    const int numThreads = std::max(1, getNumThreads());
+    std::vector<std::vector<int>> partialCounts(numThreads, std::vector<int>(_num_clusters, 0));
+    std::vector<std::vector<double>> partialSums(numThreads, std::vector<double>((size_t) _num_clusters * _dimension, 0));
+    for (auto workIndex : _work_done) {
+        runInParallel(getIntervalRanges(workIndex), [&](int chunk, int begin, int end) {
+            auto& counts = partialCounts[chunk];
+            auto& sums = partialSums[chunk];
+            for (int pointID = begin; pointID < end; ++pointID) {
+                int clusterId = _cluster_membership[pointID];
+                if (clusterId == -1) continue;
+                counts[clusterId]++;
+                auto currentSum = sums.data() + (size_t) clusterId * _dimension;
+                auto currentDataPoint = getKMeansData(pointID);
+                for (int d = 0; d < _dimension; ++d) {
+                    currentSum[d] += currentDataPoint[d];
+                }
+            }
+        });
+    }
+    _local_sum_members.assign(_num_clusters, 0);
     for (int cluster = 0; cluster < _num_clusters; ++cluster) {
         auto currentCenter = _local_cluster_centers[cluster].data();
+        for (int t = 0; t < numThreads; ++t) _local_sum_members[cluster] += partialCounts[t][cluster];
         for (int d = 0; d < _dimension; ++d) {
-            currentCenter[d] = 0;
+            double sum = 0;
+            for (int t = 0; t < numThreads; ++t) sum += partialSums[t][(size_t) cluster * _dimension + d];
+            currentCenter[d] = _local_sum_members[cluster] == 0 ? 0 : sum / _local_sum_members[cluster];
         }
     }
-    for (auto workIndex : _work_done) {
-        int startIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(workIndex) / static_cast<float>(_num_curr_workers)));
-
-        int endIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(workIndex + 1) / static_cast<float>(_num_curr_workers)));
-        for (int pointID = startIndex; pointID < endIndex; ++pointID) {
-            // if (clusterMembership[pointID] != -1) {
-            int clusterId = _cluster_membership[pointID];
-            auto currentCenter = _local_cluster_centers[clusterId].data();
-            float divisor = static_cast<float>(_local_sum_members[clusterId]);
-            auto currentDataPoint = getKMeansData(pointID);
-            for (int d = 0; d < _dimension; ++d) {
-                currentCenter[d] += currentDataPoint[d] / divisor;
-            }
-        }
+    LOG(V5_DEBG, "KMDBG myIndex: %i sumMembers: %s\n",
+        _my_index, dataToString(_local_sum_members).c_str());
+
+    if (_num_distances_total > 0) {
+        LOG(V4_VVER, "%s : iteration %i: pruned %.4f of %lu distance computations\n", toStr(), _iterations_done,
+            1 - _num_distances_computed / (double) _num_distances_total, _num_distances_total);
     }
+    _num_distances_computed = 0;
+    _num_distances_total = 0;
     ++_iterations_done;
 }
 
@@ -541,18 +797,6 @@ std::string KMeansJob::dataToString(std::vector<int> data) {
     return result.str();
 }
 
-void KMeansJob::countMembers() {
-    _local_sum_members.assign(_num_clusters, 0);
-    for (int i = 0; i < _num_points; ++i) {
-        int clusterID = _cluster_membership[i];
-        if (clusterID != -1) {
-            _local_sum_members[clusterID] += 1;
-        }
-    }
-    LOG(V5_DEBG, "KMDBG myIndex: %i sumMembers: %s\n",
-        _my_index, dataToString(_local_sum_members).c_str());
-}
-
 bool KMeansJob::centersChanged() {
     if (_iterations_done == 0) {
         return true;
@@ -632,19 +876,148 @@ std::vector<KMeansJob::Point> KMeansJob::broadcastToClusterCenters(const std::ve
 
     return localClusterCentersResult;
 }
-void KMeansJob::setClusterCenters(const std::vector<int>& reduce) {
-    const int elementsCount = _all_red_elem_size - _num_clusters;
-    for (int k = 0; k < _num_clusters; ++k) {
-        assert(k < _cluster_centers.size());
-        auto& currentCenter = _cluster_centers[k];
-        for (int d = 0; d < _dimension; ++d) {
-            assert(k*_dimension + d < reduce.size());
-            int val = reduce[k*_dimension + d];
-            currentCenter[d] = *((float*)(&val));
-        }
+std::vector<int> KMeansJob::getBroadcast(int numWorkers) {
+    std::vector<int> result(1, _phase);
+    if (_phase == LLOYD) {
+        auto centers = clusterCentersToBroadcast(_cluster_centers);
+        result.insert(result.end(), centers.begin(), centers.end());
+    } else {
+        static_assert(sizeof(double) == 2 * sizeof(int));
+        result.push_back(_init_round);
+        result.resize(4);
+        memcpy(result.data() + 2, &_init_cost, sizeof(double));
+        result.push_back(_init_candidates.size());
+        result.insert(result.end(), _init_candidates.begin(), _init_candidates.end());
     }
-    _num_curr_workers = reduce[elementsCount];
+    result.push_back(numWorkers);
+    return result;
+}
+
+void KMeansJob::readBroadcast(const std::vector<int>& payload) {
+    _phase = (Phase) payload[0];
+    _num_curr_workers = payload.back();
     LOG(V5_DEBG, "KMDBG myIndex: %i countCurrentWorkers: %i\n", _my_index, _num_curr_workers);
+    if (_phase == LLOYD) {
+        assert(payload.size() == 2 + (size_t) _num_clusters * _dimension);
+        for (int k = 0; k < _num_clusters; ++k) {
+            auto& currentCenter = _cluster_centers[k];
+            for (int d = 0; d < _dimension; ++d) {
+                int val = payload[1 + k*_dimension + d];
+                currentCenter[d] = *((float*)(&val));
+            }
+        }
+        releaseInitState();
+        return;
+    }
+
+    _init_round = payload[1];
+    memcpy(&_init_cost, payload.data() + 2, sizeof(double));
+    const int numCandidates = payload[4];
+    assert(payload.size() == 6 + (size_t) numCandidates);
+    _init_candidates.assign(payload.begin() + 5, payload.begin() + 5 + numCandidates);
+    // Candidates are only ever appended, except if the initialization started over
+    if (_init_candidate_matrix.size() > (size_t) numCandidates * _dimension) releaseInitState();
+    if (_init_covered.empty()) {
+        _init_min_dist.assign(_num_points, std::numeric_limits<float>::infinity());
+        _init_nearest.assign(_num_points, -1);
+        _init_covered.assign(_num_points, 0);
+    }
+    for (size_t c = _init_candidate_matrix.size() / _dimension; c < (size_t) numCandidates; ++c) {
+        const float* point = getKMeansData(_init_candidates[c]);
+        _init_candidate_matrix.insert(_init_candidate_matrix.end(), point, point + _dimension);
+    }
+    _init_local_cost = 0;
+    _init_local_counts.assign(numCandidates, 0);
+    _init_local_samples.clear();
+}
+
+void KMeansJob::releaseInitState() {
+    if (_init_covered.empty() && _init_candidate_matrix.empty()) return;
+    std::vector<float>().swap(_init_candidate_matrix);
+    std::vector<float>().swap(_init_min_dist);
+    std::vector<int>().swap(_init_nearest);
+    std::vector<int>().swap(_init_covered);
+    std::vector<int>().swap(_init_local_counts);
+    std::vector<int>().swap(_init_local_samples);
+}
+
+// Parses a reduced k-means|| step and adds it to the given cost, counts, and samples.
+// The neutral (all-zero) element of the reduction is an empty step.
+static void readInitStep(const std::vector<int>& step, double& cost, std::vector<int>& counts, std::vector<int>& samples) {
+    if (step.size() < 4) return;
+    double stepCost;
+    memcpy(&stepCost, step.data(), sizeof(double));
+    cost += stepCost;
+    size_t pos = 2;
+    const size_t numCounts = step[pos++];
+    assert(pos + numCounts < step.size());
+    if (counts.size() < numCounts) counts.resize(numCounts, 0);
+    for (size_t c = 0; c < numCounts; ++c) counts[c] += step[pos++];
+    const size_t numSamples = step[pos++];
+    assert(pos + numSamples <= step.size());
+    samples.insert(samples.end(), step.begin() + pos, step.begin() + pos + numSamples);
+}
+
+static std::vector<int> writeInitStep(double cost, const std::vector<int>& counts, const std::vector<int>& samples) {
+    std::vector<int> result(2);
+    memcpy(result.data(), &cost, sizeof(double));
+    result.push_back(counts.size());
+    result.insert(result.end(), counts.begin(), counts.end());
+    result.push_back(samples.size());
+    result.insert(result.end(), samples.begin(), samples.end());
+    return result;
+}
+
+std::vector<int> KMeansJob::initStepToReduce() {
+    return writeInitStep(_init_local_cost, _phase == INIT_COST ? _init_local_counts : std::vector<int>(), _init_local_samples);
+}
+
+std::vector<int> KMeansJob::aggregateInitSteps(const std::list<std::vector<int>>& messages) {
+    double cost = 0;
+    std::vector<int> counts;
+    std::vector<int> samples;
+    for (auto& message : messages) readInitStep(message, cost, counts, samples);
+    return writeInitStep(cost, counts, samples);
+}
+
+std::vector<int> KMeansJob::transformInitStepAtRoot(const std::vector<int>& payload) {
+    double cost = 0;
+    std::vector<int> counts;
+    std::vector<int> samples;
+    readInitStep(payload, cost, counts, samples);
+
+    if (_phase == INIT_SAMPLE) {
+        // The order of the samples depends on the job tree, so sort them for determinism
+        std::sort(samples.begin(), samples.end());
+        _init_candidates.insert(_init_candidates.end(), samples.begin(), samples.end());
+        ++_init_round;
+        _phase = INIT_COST;
+        LOG(V4_VVER, "%s : k-means|| round %i: %lu candidates\n", toStr(), _init_round, _init_candidates.size());
+        return getBroadcast(this->getVolume());
+    }
+
+    // Keep sampling while rounds are left or, for a bounded number of extra rounds, too few candidates exist
+    _init_cost = cost;
+    const int rounds = _params.kmeansInitRounds();
+    if (cost > 0 && (_init_round < rounds || ((int) _init_candidates.size() < _num_clusters && _init_round < 2 * rounds))) {
+        _phase = INIT_SAMPLE;
+        return getBroadcast(this->getVolume());
+    }
+
+    // Weighted k-means++ over the candidates, weighted by the number of points nearest to them
+    std::vector<double> weights(counts.begin(), counts.end());
+    weights.resize(_init_candidates.size(), 0);
+    SplitMix64Rng rng(getInitSeed() + 1);
+    auto centers = KMeansUtils::chooseCentersFromCandidates(_points_start, _num_points, _dimension,
+        _init_candidates, weights, _num_clusters, rng);
+    for (int i = 0; i < _num_clusters; ++i) {
+        _cluster_centers[i].assign(centers.begin() + (size_t) i * _dimension, centers.begin() + (size_t) (i+1) * _dimension);
+    }
+    _phase = LLOYD;
+    LOG(V3_VERB, "%s : initial centers computed in %.3fs (%i rounds, %lu candidates, w:%i)\n", toStr(),
+        Timer::elapsedSeconds() - _time_of_init, _init_round, _init_candidates.size(), this->getVolume());
+    _time_of_first_iteration = Timer::elapsedSeconds();
+    return getBroadcast(this->getVolume());
 }
 
 std::vector<int> KMeansJob::clusterCentersToReduce(const std::vector<int>& reduceSumMembers, const std::vector<Point>& reduceClusterCenters) {
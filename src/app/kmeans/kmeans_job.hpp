@@ -12,6 +12,7 @@
 #include "comm/job_tree_all_reduction.hpp"
 #include "kmeans_utils.hpp"
 #include "util/params.hpp"
+#include "util/sys/timer.hpp"
 
 class KMeansJob : public Job {
    private:
@@ -20,6 +21,54 @@ class KMeansJob : public Job {
     std::vector<Point> _cluster_centers;       // The centers of cluster 0..n
     std::vector<Point> _local_cluster_centers;  // The centers of cluster 0..n
     std::vector<Point> _old_cluster_centers;
+    std::vector<float> _center_matrix;  // _cluster_centers as contiguous row-major matrix (k x dim) for the distance kernels
+
+    // Hamerly-style bounds for skipping distance computations, carried across iterations.
+    // The bounds of a point are valid w.r.t. the centers of the epoch they are stamped with;
+    // the epoch advances whenever the centers change.
+    int _center_epoch = 0;
+    std::vector<float> _upper_bounds;       // distance to the assigned center
+    std::vector<float> _lower_bounds;       // distance to the second nearest center
+    std::vector<int> _bound_assignment;
+    std::vector<int> _bounds_epoch;
+    std::vector<float> _center_movement;    // distance each center moved in the last epoch
+    std::vector<float> _center_separation;  // half the distance of each center to its nearest other center
+    float _max_movement = 0;
+    float _second_max_movement = 0;
+    int _max_movement_center = -1;
+    unsigned long _num_distances_computed = 0;
+    unsigned long _num_distances_total = 0;
+
+    // Mini-batch mode: cumulative member counts per center at the root, used for the learning rates
+    std::vector<long> _cumulative_counts;
+    std::vector<float> _batch_means;
+    std::vector<float> _center_matrix_root;
+    std::vector<float> _previous_center_matrix_root;
+    float _time_of_first_iteration = 0;
+
+    // Before the Lloyd iterations, the k-means|| initialization runs in the same broadcast/reduce
+    // cycles: computing the cost w.r.t. the candidates alternates with sampling new candidates.
+    // LLOYD must be zero since an all-zero broadcast still denotes the (final) Lloyd centers.
+    enum Phase {LLOYD = 0, INIT_COST, INIT_SAMPLE};
+    Phase _phase = LLOYD;
+    int _init_round = 0;
+    double _init_cost = 0;                    // total cost w.r.t. the candidates (broadcast for sampling)
+    std::vector<int> _init_candidates;        // candidates as point indices (the points are replicated)
+    std::vector<float> _init_candidate_matrix;
+    // Per point: squared distance to and index of the nearest candidate among the first _init_covered[i] ones
+    std::vector<float> _init_min_dist;
+    std::vector<int> _init_nearest;
+    std::vector<int> _init_covered;
+    // Contribution of the intervals done in the current step
+    double _init_local_cost = 0;
+    std::vector<int> _init_local_counts;
+    std::vector<int> _init_local_samples;
+    float _time_of_init = 0;
+
+    // Owner (interval ID) of each slice of points for the current number of workers
+    std::vector<int> _slice_owners;
+    int _slice_owners_num_workers = -1;
+    int _last_num_workers = -1;
     std::vector<int> _cluster_membership;  // A point KMeansData[i] belongs to cluster ClusterMembership[i]
     std::vector<int> _local_sum_members;
 
@@ -55,36 +104,55 @@ class KMeansJob : public Job {
     JobResult _internal_result;
     std::unique_ptr<JobTreeAllReduction> _reducer;
 
-    const std::function<float(const float* p1, const float* p2, const size_t dim)> metric =
-        [&](const float* p1, const float* p2, const size_t dim) {
-            return KMeansUtils::eukild(p1, p2, dim);
-        };
     const std::function<std::vector<int>(std::list<std::vector<int>>&)> folder =
         [&](std::list<std::vector<int>>& elems) {
-            return aggregate(elems);
+            return _phase == LLOYD ? aggregate(elems) : aggregateInitSteps(elems);
         };
     const std::function<std::vector<int>(const std::vector<int>&)> rootTransform =
         [&](const std::vector<int>& payload) {
             LOG(V5_DEBG, "KMDBG myIndex: %i start Roottransform\n", _my_index);
+            if (_phase != LLOYD) return transformInitStepAtRoot(payload);
             auto data = reduceToclusterCenters(payload);
             const int* sumMembers;
 
-            _cluster_centers = data.first;
+            if (_params.kmeansMiniBatch() > 0) {
+                // The reduced centers are the means of this iteration's batch
+                for (int i = 0; i < _num_clusters; ++i) {
+                    std::copy(data.first[i].begin(), data.first[i].end(), _batch_means.begin() + (size_t) i * _dimension);
+                    std::copy(_cluster_centers[i].begin(), _cluster_centers[i].end(), _center_matrix_root.begin() + (size_t) i * _dimension);
+                }
+                _previous_center_matrix_root = _center_matrix_root;
+                KMeansUtils::miniBatchUpdate(_center_matrix_root.data(), _batch_means.data(), data.second.data(),
+                    _cumulative_counts, _num_clusters, _dimension);
+                for (int i = 0; i < _num_clusters; ++i) {
+                    _cluster_centers[i].assign(_center_matrix_root.begin() + (size_t) i * _dimension,
+                        _center_matrix_root.begin() + (size_t) (i+1) * _dimension);
+                }
+            } else {
+                _cluster_centers = data.first;
+            }
             sumMembers = data.second.data();
             int sum = 0;
             for (int i = 0; i < _num_clusters; ++i) {
                 sum += sumMembers[i];
             }
             
-            auto transformed = clusterCentersToBroadcast(_cluster_centers);
-            transformed.push_back(this->getVolume());  // will be countCurrentWorkers
+            auto transformed = getBroadcast(this->getVolume());  // will be countCurrentWorkers
             LOG(V5_DEBG, "KMDBG COMMSIZE: %i myIndex: %i \n",
                 this->getVolume(), _my_index);
             LOG(V5_DEBG, "KMDBG Children: %i\n",
                 this->getJobTree().getNumChildren());
 
-            if (!centersChanged(0.001f)) {
-                LOG(V2_INFO, "%s : finished after %i iterations\n", toStr(), _iterations_done);
+            const bool iterationLimitHit = _params.kmeansMaxIterations() > 0 && _iterations_done >= _params.kmeansMaxIterations();
+            // The mini-batch centers keep moving slightly due to sampling, so their convergence
+            // is measured relative to the distances between centers instead of per coordinate
+            const bool converged = _params.kmeansMiniBatch() > 0 ?
+                _iterations_done > 1 && KMeansUtils::maxRelativeMovement(_previous_center_matrix_root.data(),
+                    _center_matrix_root.data(), _num_clusters, _dimension) <= _params.kmeansMiniBatchTolerance()
+                : !centersChanged(_params.kmeansConvergenceThreshold());
+            if (converged || iterationLimitHit) {
+                LOG(V2_INFO, "%s : finished after %i iterations (%.3fs)%s\n", toStr(), _iterations_done,
+                    Timer::elapsedSeconds() - _time_of_first_iteration, iterationLimitHit ? " - iteration limit hit" : "");
                 _internal_result.result = RESULT_SAT;
                 _internal_result.id = getId();
                 _internal_result.revision = getRevision();
@@ -95,7 +163,7 @@ class KMeansJob : public Job {
                 _internal_result.setSolutionToSerialize((int*)(solution.data()), solution.size());
                 _finished_job = true;
                 LOG(V5_DEBG, "%s : solution cluster centers: \n%s\n", toStr(), dataToString(_cluster_centers).c_str());
-                return std::move(std::vector<int>(_all_red_elem_size, 0));
+                return getBroadcast(0);
 
             } else {
                 if (_is_root && _iterations_done == 1) {
@@ -166,19 +234,34 @@ class KMeansJob : public Job {
     void loadInstance();
     void doInitWork();
     void sendRootNotification();
-    void setRandomStartCenters();
-    void calcNearestCenter(std::function<float(const float* p1, const float* p2, const size_t dim)> metric, int intervalId);
+    void setStartCenters();
+    uint64_t getInitSeed() const;
+    // Splits [begin, end) into one chunk per thread of this job and runs f(chunk, chunkBegin, chunkEnd)
+    // for all chunks concurrently on the process-wide thread pool and the calling thread
+    void runInParallel(int begin, int end, const std::function<void(int, int, int)>& f);
+    void runInParallel(const std::vector<std::pair<int, int>>& ranges, const std::function<void(int, int, int)>& f);
+    std::vector<std::pair<int, int>> getIntervalRanges(int intervalId);
+    void updateCenterMatrix();
+    void processInterval(int intervalId);
+    void calcNearestCenter(int intervalId);
+    void calcInitStep(int intervalId);
     void calcCurrentClusterCenters();
     std::string dataToString(std::vector<Point> data);
     std::string dataToString(std::vector<int> data);
-    void countMembers();
     float calculateDifference(std::function<float(const float* p1, const float* p2, const size_t dim)> metric);
     bool centersChanged();
     bool centersChanged(float factor);
     std::vector<float> clusterCentersToSolution();
     std::vector<int> clusterCentersToBroadcast(const std::vector<Point>&);
     std::vector<Point> broadcastToClusterCenters(const std::vector<int>&);
-    void setClusterCenters(const std::vector<int>&);
+    // Broadcast of the root: [phase, centers (Lloyd) or k-means|| state, numWorkers]
+    std::vector<int> getBroadcast(int numWorkers);
+    void readBroadcast(const std::vector<int>&);
+    void releaseInitState();
+    // Reduced k-means|| step: [cost (double), #counts, nearest counts per candidate, #samples, samples]
+    std::vector<int> initStepToReduce();
+    std::vector<int> aggregateInitSteps(const std::list<std::vector<int>>&);
+    std::vector<int> transformInitStepAtRoot(const std::vector<int>&);
     std::vector<int> clusterCentersToReduce(const std::vector<int>&, const std::vector<Point>&);
     std::pair<std::vector<std::vector<float>>, std::vector<int>> reduceToclusterCenters(const std::vector<int>&);
     std::vector<int> aggregate(const std::list<std::vector<int>>&);
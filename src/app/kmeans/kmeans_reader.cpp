@@ -1,12 +1,113 @@
 #include "kmeans_reader.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <vector>
 
+#include "util/logger.hpp"
 #include "util/sys/terminator.hpp"
-bool KMeansReader::read(const std::string &filename, JobDescription &desc) {
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Parses all whitespace-separated numbers within [begin, end) into out.
+// Returns false upon a malformed token.
+bool parseFloats(const char* begin, const char* end, std::vector<float>& out) {
+    const char* pos = begin;
+    while (true) {
+        while (pos < end && isSpace(*pos)) ++pos;
+        if (pos == end) return true;
+        if (*pos == '+') ++pos; // not accepted by from_chars
+        float num;
+#if defined(__cpp_lib_to_chars)
+        auto [next, ec] = std::from_chars(pos, end, num);
+        if (ec != std::errc() || (next < end && !isSpace(*next))) return false;
+#else
+        // strtof requires a terminated token
+        char token[64];
+        const char* tokenEnd = pos;
+        while (tokenEnd < end && !isSpace(*tokenEnd) && tokenEnd-pos < 63) ++tokenEnd;
+        memcpy(token, pos, tokenEnd-pos);
+        token[tokenEnd-pos] = '\0';
+        char* parsedEnd;
+        num = strtof(token, &parsedEnd);
+        if (parsedEnd != token + (tokenEnd-pos) || parsedEnd == token) return false;
+        const char* next = tokenEnd;
+#endif
+        out.push_back(num);
+        pos = next;
+        if ((out.size() & 0xffff) == 0 && Terminator::isTerminating()) return false;
+    }
+}
+
+// Checks that the header describes a meaningful problem and that the number of bytes
+// of its points, written to numBytes, can be computed without overflow.
+bool checkHeader(int64_t numClusters, int64_t dimension, int64_t numPoints, size_t bytesPerCoordinate, size_t& numBytes) {
+    if (numPoints <= 0 || numPoints > INT32_MAX || numClusters <= 0 || numClusters > numPoints
+            || dimension <= 0 || dimension > KMeansReader::MAX_DIMENSION) {
+        LOG(V0_CRIT, "[ERROR] Invalid K-Means header: k=%ld dim=%ld n=%ld\n", numClusters, dimension, numPoints);
+        return false;
+    }
+    size_t numCoordinates;
+    if (__builtin_mul_overflow((size_t) numPoints, (size_t) dimension, &numCoordinates)
+            || __builtin_mul_overflow(numCoordinates, bytesPerCoordinate, &numBytes)) {
+        LOG(V0_CRIT, "[ERROR] K-Means problem of %ld x %ld coordinates is too large\n", numPoints, dimension);
+        return false;
+    }
+    return true;
+}
+
+bool readBinary(const char* data, size_t size, JobDescription& desc) {
+    KMeansReader::BinaryHeader header;
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.dtype != KMeansReader::FLOAT32 && header.dtype != KMeansReader::FLOAT64) {
+        LOG(V0_CRIT, "[ERROR] Malformed binary K-Means file\n");
+        return false;
+    }
+    const size_t dtypeSize = header.dtype == KMeansReader::FLOAT32 ? sizeof(float) : sizeof(double);
+    size_t payloadSize;
+    if (!checkHeader(header.numClusters, header.dimension, header.numPoints, dtypeSize, payloadSize)) return false;
+    if (size - sizeof(header) < payloadSize) {
+        LOG(V0_CRIT, "[ERROR] Binary K-Means file is truncated\n");
+        return false;
+    }
+    const size_t numCoordinates = header.numPoints * header.dimension;
+    desc.reserveSize((3 + numCoordinates) * sizeof(float));
+    desc.addPermanentData((int) header.numClusters);
+    desc.addPermanentData((int) header.dimension);
+    desc.addPermanentData((int) header.numPoints);
+    const char* payload = data + sizeof(header);
+    if (header.dtype == KMeansReader::FLOAT32) {
+        desc.addPermanentData((const float*) payload, numCoordinates);
+    } else {
+        std::vector<float> buffer(std::min(numCoordinates, (size_t) 1<<16));
+        for (size_t offset = 0; offset < numCoordinates; offset += buffer.size()) {
+            const size_t num = std::min(buffer.size(), numCoordinates - offset);
+            for (size_t i = 0; i < num; ++i) {
+                double x;
+                memcpy(&x, payload + (offset+i) * sizeof(double), sizeof(double));
+                buffer[i] = x;
+            }
+            desc.addPermanentData(buffer.data(), num);
+        }
+    }
+    return true;
+}
+
+bool readText(const char* data, size_t size, JobDescription& desc, int numThreads) {
     /*
     files have to be in format:
     k = k of kmeans
@@ -19,56 +120,134 @@ bool KMeansReader::read(const std::string &filename, JobDescription &desc) {
     1.0 1.1 1.2
     one point per row
     */
-
-    // allocate necessary structs for the revision to read
-
-    desc.beginInitialization(0);
-
-    std::ifstream ifile(filename.c_str(), std::ios::in);
-
-    // check to see that the file was opened correctly:
-    if (!ifile.is_open()) {
-        std::cerr << "There was a problem opening the input file!\n";
+    const char* end = data + size;
+    int header[4];
+    const char* pos = data;
+    for (int i = 0; i < 4; ++i) {
+        while (pos < end && isSpace(*pos)) ++pos;
+        auto [next, ec] = std::from_chars(pos, end, header[i]);
+        if (ec != std::errc()) {
+            LOG(V0_CRIT, "[ERROR] Malformed header of K-Means file\n");
+            return false;
+        }
+        pos = next;
+    }
+    const int countClusters = header[0];
+    const int dimension = header[1];
+    const int columnsInFile = header[2];
+    const int pointsCount = header[3];
+    size_t numBytes;
+    if (!checkHeader(countClusters, dimension, pointsCount, sizeof(float), numBytes)) return false;
+    if (columnsInFile < dimension) {
+        LOG(V0_CRIT, "[ERROR] Malformed header of K-Means file\n");
         return false;
     }
 
-    int countClusters = 0;
-    int dimension = 0;
-    int columnsInFile = 0;
-    int pointsCount = 0;
-
-    ifile >> countClusters;
-    ifile >> dimension;
-    ifile >> columnsInFile;
-    ifile >> pointsCount;
+    // Split the remaining content into chunks at whitespace and parse them in parallel
+    numThreads = std::max(1, std::min(numThreads, (int) ((end - pos) / (1<<20)) + 1));
+    std::vector<const char*> borders(numThreads+1, end);
+    borders[0] = pos;
+    for (int t = 1; t < numThreads; ++t) {
+        const char* border = std::max(borders[t-1], pos + (end - pos) * t / numThreads);
+        while (border < end && !isSpace(*border)) ++border;
+        borders[t] = border;
+    }
+    std::vector<std::vector<float>> chunks(numThreads);
+    std::vector<char> success(numThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {success[t] = parseFloats(borders[t], borders[t+1], chunks[t]);});
+    }
+    // each number takes at least two characters, so the header cannot provoke a huge allocation
+    chunks[0].reserve(std::min((size_t) pointsCount * columnsInFile / numThreads,
+        (size_t) (borders[1] - borders[0]) / 2 + 1));
+    success[0] = parseFloats(borders[0], borders[1], chunks[0]);
+    for (auto& thread : threads) thread.join();
 
-    int skipCols = columnsInFile - dimension;  // dont read the last few columns
+    size_t numParsed = 0;
+    for (int t = 0; t < numThreads; ++t) {
+        if (!success[t]) {
+            if (!Terminator::isTerminating()) LOG(V0_CRIT, "[ERROR] Malformed number in K-Means file\n");
+            return false;
+        }
+        numParsed += chunks[t].size();
+    }
+    if (numParsed < (size_t) pointsCount * columnsInFile) {
+        LOG(V0_CRIT, "[ERROR] K-Means file contains %lu instead of %lu numbers\n",
+            numParsed, (size_t) pointsCount * columnsInFile);
+        return false;
+    }
 
+    desc.reserveSize((3 + (size_t) pointsCount * dimension) * sizeof(float));
     desc.addPermanentData(countClusters);
     desc.addPermanentData(dimension);
     desc.addPermanentData(pointsCount);
-    //LOG(V5_DEBG, "                          countClusters: %i dimension %i pointsCount: %i columnsInFile: %i skipCols:%i\n", countClusters, dimension, pointsCount, columnsInFile, skipCols);
-    float num = 0.0;
-    for (int point = 0; point < pointsCount; ++point) {
-        for (int entry = 0; entry < dimension; ++entry) {
-            ifile >> num;
-            desc.addPermanentData(num);
-            //if (point < 10) {
-            //    LOG(V5_DEBG, "                          num: %f\n", num);
-            //}
+    if (columnsInFile == dimension) {
+        size_t remaining = (size_t) pointsCount * dimension;
+        for (auto& chunk : chunks) {
+            const size_t num = std::min(remaining, chunk.size());
+            desc.addPermanentData(chunk.data(), num);
+            remaining -= num;
         }
-        if (Terminator::isTerminating()) return false;
-        for (int skip = 0; skip < skipCols; ++skip) {
-            ifile >> num;  // dont read the last few columns of each row
-            // num wont be read until reset
-            //if (point < 10) {
-            //    LOG(V5_DEBG, "                          skip num: %f\n", num);
-            //}
+    } else {
+        // dont read the last few columns of each row
+        size_t index = 0;
+        for (auto& chunk : chunks) for (float num : chunk) {
+            if (index / columnsInFile >= (size_t) pointsCount) break;
+            if (index % columnsInFile < (size_t) dimension) desc.addPermanentData(num);
+            ++index;
         }
     }
+    return true;
+}
+}
+
+bool KMeansReader::read(const std::string &filename, JobDescription &desc, int numThreads) {
+
+    // allocate necessary structs for the revision to read
+    desc.beginInitialization(0);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat s;
+    if (fd == -1 || fstat(fd, &s) == -1) {
+        std::cerr << "There was a problem opening the input file!\n";
+        if (fd != -1) close(fd);
+        return false;
+    }
+    const size_t size = s.st_size;
+    void* mmapped = size == 0 ? nullptr : mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mmapped == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    const char* data = (const char*) mmapped;
+    if (size > 0) madvise(mmapped, size, MADV_SEQUENTIAL);
+
+    bool success;
+    if (size >= 4 && memcmp(data, "KMB1", 4) == 0) {
+        success = readBinary(data, size, desc);
+    } else {
+        success = readText(data, size, desc, numThreads);
+    }
+    if (mmapped != nullptr) munmap(mmapped, size);
+    close(fd);
+    if (!success) return false;
 
-    ifile.close();
     desc.endInitialization();
     // success
     return true;
 }
+
+bool KMeansReader::writeBinary(const std::string& filename, int numClusters, int dimension, int64_t numPoints, const float* data) {
+    BinaryHeader header;
+    memcpy(header.magic, "KMB1", 4);
+    header.numClusters = numClusters;
+    header.dimension = dimension;
+    header.dtype = FLOAT32;
+    header.numPoints = numPoints;
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs.is_open()) return false;
+    ofs.write((const char*) &header, sizeof(header));
+    ofs.write((const char*) data, numPoints * dimension * sizeof(float));
+    return ofs.good();
+}
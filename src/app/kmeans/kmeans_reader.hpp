@@ -2,12 +2,32 @@
 #ifndef DOMPASCH_MALLOB_KMEANS_READER_HPP
 #define DOMPASCH_MALLOB_KMEANS_READER_HPP
 
+#include <cstdint>
 #include <string>
 
 #include "data/job_description.hpp"
 
 namespace KMeansReader {
-bool read(const std::string& filename, JobDescription& desc);
+
+/*
+Binary point files begin with this header, followed by numPoints*dimension
+coordinates (row-major) of the type given by dtype.
+*/
+struct BinaryHeader {
+    char magic[4];  // "KMB1"
+    int32_t numClusters;
+    int32_t dimension;
+    int32_t dtype;  // 0: float32, 1: float64
+    int64_t numPoints;
+};
+enum BinaryDataType {FLOAT32 = 0, FLOAT64 = 1};
+// Larger dimensions are rejected as malformed
+const int32_t MAX_DIMENSION = 1<<20;
+
+// Reads a text or binary (detected by its header) point file.
+// Text files are parsed in the given number of parallel chunks.
+bool read(const std::string& filename, JobDescription& desc, int numThreads = 1);
+bool writeBinary(const std::string& filename, int numClusters, int dimension, int64_t numPoints, const float* data);
 };
 
 #endif
@@ -1,45 +1,429 @@
 #include "kmeans_utils.hpp"
 
+#if defined(__x86_64__) || defined(__i386__)
 #include <x86intrin.h>
+#define MALLOB_KMEANS_X86 1
+#endif
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <vector>
 
 #include "util/assert.hpp"
 #include "util/logger.hpp"
+#include "util/random.hpp"
 namespace KMeansUtils {
 
 typedef std::vector<float> Point;
-float eukild(const float* p1, const float* p2, const size_t dim) {
-    //const int vecLen = 4;
-    //const int d4 = dim / vecLen;
-    float sum = 0;
-    float diff;
-    //float sumArr[d4 + vecLen -1];
-    //__m128 v1, v2, vd;
-    //for (int i = 0; i < d4; ++i) {
-    //    v1 = _mm_loadu_ps(p1 + (i * vecLen));
-    //    v2 = _mm_loadu_ps(p2 + (i * vecLen));
-    //    vd = _mm_sub_ps(v1, v2);
-    //    vd = _mm_dp_ps(vd, vd, 255);
-    //    _mm_storeu_ps(sumArr + i, vd);
-    //}
-    //for (int i = d4 * vecLen; i < dim; ++i) {
-    //    diff = p1[i] - p2[i];
-    //    sum += diff * diff;
-    //}
-    //for (int j = 0; j < d4; j++) {
-    //    sum += sumArr[j];
-    //}
-
-     for(const float* const p1End = p1 + dim; p1 < p1End; ++p1, ++p2 ) {
-        diff = p1[0] - p2[0];
-        sum += diff*diff;
+typedef void (*DistanceKernel)(const float*, const float*, int, int, float*);
+
+// Each kernel processes the centers in blocks of four such that each loaded
+// chunk of the point is reused for four centers.
+
+void squaredDistancesScalar(const float* p, const float* c, int k, int dim, float* out) {
+    int j = 0;
+    for (; j + 4 <= k; j += 4) {
+        const float* c0 = c + (size_t) j * dim;
+        const float* c1 = c0 + dim;
+        const float* c2 = c1 + dim;
+        const float* c3 = c2 + dim;
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (int d = 0; d < dim; ++d) {
+            const float x = p[d];
+            float diff;
+            diff = x - c0[d]; s0 += diff * diff;
+            diff = x - c1[d]; s1 += diff * diff;
+            diff = x - c2[d]; s2 += diff * diff;
+            diff = x - c3[d]; s3 += diff * diff;
+        }
+        out[j] = s0; out[j+1] = s1; out[j+2] = s2; out[j+3] = s3;
+    }
+    for (; j < k; ++j) {
+        const float* cj = c + (size_t) j * dim;
+        float sum = 0;
+        for (int d = 0; d < dim; ++d) {
+            const float diff = p[d] - cj[d];
+            sum += diff * diff;
+        }
+        out[j] = sum;
+    }
+}
+
+#ifdef MALLOB_KMEANS_X86
+
+__attribute__((target("avx2,fma")))
+static inline float horizontalSumAvx2(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(lo);
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("avx2,fma")))
+void squaredDistancesAvx2(const float* p, const float* c, int k, int dim, float* out) {
+    const int vecEnd = dim - dim % 8;
+    int j = 0;
+    for (; j + 4 <= k; j += 4) {
+        const float* c0 = c + (size_t) j * dim;
+        const float* c1 = c0 + dim;
+        const float* c2 = c1 + dim;
+        const float* c3 = c2 + dim;
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        for (int d = 0; d < vecEnd; d += 8) {
+            const __m256 x = _mm256_loadu_ps(p + d);
+            __m256 diff;
+            diff = _mm256_sub_ps(x, _mm256_loadu_ps(c0 + d)); a0 = _mm256_fmadd_ps(diff, diff, a0);
+            diff = _mm256_sub_ps(x, _mm256_loadu_ps(c1 + d)); a1 = _mm256_fmadd_ps(diff, diff, a1);
+            diff = _mm256_sub_ps(x, _mm256_loadu_ps(c2 + d)); a2 = _mm256_fmadd_ps(diff, diff, a2);
+            diff = _mm256_sub_ps(x, _mm256_loadu_ps(c3 + d)); a3 = _mm256_fmadd_ps(diff, diff, a3);
+        }
+        float s0 = horizontalSumAvx2(a0), s1 = horizontalSumAvx2(a1);
+        float s2 = horizontalSumAvx2(a2), s3 = horizontalSumAvx2(a3);
+        for (int d = vecEnd; d < dim; ++d) {
+            const float x = p[d];
+            float diff;
+            diff = x - c0[d]; s0 += diff * diff;
+            diff = x - c1[d]; s1 += diff * diff;
+            diff = x - c2[d]; s2 += diff * diff;
+            diff = x - c3[d]; s3 += diff * diff;
+        }
+        out[j] = s0; out[j+1] = s1; out[j+2] = s2; out[j+3] = s3;
+    }
+    for (; j < k; ++j) {
+        const float* cj = c + (size_t) j * dim;
+        __m256 acc = _mm256_setzero_ps();
+        for (int d = 0; d < vecEnd; d += 8) {
+            const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(p + d), _mm256_loadu_ps(cj + d));
+            acc = _mm256_fmadd_ps(diff, diff, acc);
+        }
+        float sum = horizontalSumAvx2(acc);
+        for (int d = vecEnd; d < dim; ++d) {
+            const float diff = p[d] - cj[d];
+            sum += diff * diff;
+        }
+        out[j] = sum;
+    }
+}
+
+__attribute__((target("avx512f")))
+void squaredDistancesAvx512(const float* p, const float* c, int k, int dim, float* out) {
+    // The last (partial) chunk of each row is processed via masked loads
+    const int vecEnd = dim - dim % 16;
+    const __mmask16 tailMask = (__mmask16) ((1u << (dim % 16)) - 1);
+    int j = 0;
+    for (; j + 4 <= k; j += 4) {
+        const float* c0 = c + (size_t) j * dim;
+        const float* c1 = c0 + dim;
+        const float* c2 = c1 + dim;
+        const float* c3 = c2 + dim;
+        __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+        __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+        for (int d = 0; d < vecEnd; d += 16) {
+            const __m512 x = _mm512_loadu_ps(p + d);
+            __m512 diff;
+            diff = _mm512_sub_ps(x, _mm512_loadu_ps(c0 + d)); a0 = _mm512_fmadd_ps(diff, diff, a0);
+            diff = _mm512_sub_ps(x, _mm512_loadu_ps(c1 + d)); a1 = _mm512_fmadd_ps(diff, diff, a1);
+            diff = _mm512_sub_ps(x, _mm512_loadu_ps(c2 + d)); a2 = _mm512_fmadd_ps(diff, diff, a2);
+            diff = _mm512_sub_ps(x, _mm512_loadu_ps(c3 + d)); a3 = _mm512_fmadd_ps(diff, diff, a3);
+        }
+        if (tailMask != 0) {
+            const __m512 x = _mm512_maskz_loadu_ps(tailMask, p + vecEnd);
+            __m512 diff;
+            diff = _mm512_sub_ps(x, _mm512_maskz_loadu_ps(tailMask, c0 + vecEnd)); a0 = _mm512_fmadd_ps(diff, diff, a0);
+            diff = _mm512_sub_ps(x, _mm512_maskz_loadu_ps(tailMask, c1 + vecEnd)); a1 = _mm512_fmadd_ps(diff, diff, a1);
+            diff = _mm512_sub_ps(x, _mm512_maskz_loadu_ps(tailMask, c2 + vecEnd)); a2 = _mm512_fmadd_ps(diff, diff, a2);
+            diff = _mm512_sub_ps(x, _mm512_maskz_loadu_ps(tailMask, c3 + vecEnd)); a3 = _mm512_fmadd_ps(diff, diff, a3);
+        }
+        out[j] = _mm512_reduce_add_ps(a0);
+        out[j+1] = _mm512_reduce_add_ps(a1);
+        out[j+2] = _mm512_reduce_add_ps(a2);
+        out[j+3] = _mm512_reduce_add_ps(a3);
+    }
+    for (; j < k; ++j) {
+        const float* cj = c + (size_t) j * dim;
+        __m512 acc = _mm512_setzero_ps();
+        for (int d = 0; d < vecEnd; d += 16) {
+            const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(p + d), _mm512_loadu_ps(cj + d));
+            acc = _mm512_fmadd_ps(diff, diff, acc);
+        }
+        if (tailMask != 0) {
+            const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(tailMask, p + vecEnd),
+                _mm512_maskz_loadu_ps(tailMask, cj + vecEnd));
+            acc = _mm512_fmadd_ps(diff, diff, acc);
+        }
+        out[j] = _mm512_reduce_add_ps(acc);
+    }
+}
+
+#endif
+
+bool isSupported(SimdLevel level) {
+#ifdef MALLOB_KMEANS_X86
+    // may be called during static initialization
+    __builtin_cpu_init();
+    switch (level) {
+    case SIMD_AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case SIMD_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    default:
+        return true;
     }
+#else
+    return level == SIMD_SCALAR;
+#endif
+}
+
+DistanceKernel getKernel(SimdLevel level) {
+#ifdef MALLOB_KMEANS_X86
+    if (level == SIMD_AVX512) return &squaredDistancesAvx512;
+    if (level == SIMD_AVX2) return &squaredDistancesAvx2;
+#endif
+    return &squaredDistancesScalar;
+}
+
+// Constant-initialized to the scalar kernel, upgraded during dynamic initialization
+static SimdLevel _simd_level = SIMD_SCALAR;
+static DistanceKernel _kernel = &squaredDistancesScalar;
+static const SimdLevel _initial_simd_level = setSimdLevel(SIMD_AVX512);
+
+SimdLevel getSimdLevel() {
+    return _simd_level;
+}
 
+SimdLevel setSimdLevel(SimdLevel level) {
+    while (level != SIMD_SCALAR && !isSupported(level)) level = (SimdLevel) (level-1);
+    _simd_level = level;
+    _kernel = getKernel(level);
+    return level;
+}
+
+const char* simdLevelToStr(SimdLevel level) {
+    switch (level) {
+    case SIMD_AVX512: return "avx512";
+    case SIMD_AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// Points with fewer dimensions than a single AVX2 register are faster without vectorization
+static inline DistanceKernel kernelFor(int dim) {
+    return dim < 8 ? &squaredDistancesScalar : _kernel;
+}
+
+void squaredDistances(const float* point, const float* centers, int numCenters, int dim, float* distances) {
+    kernelFor(dim)(point, centers, numCenters, dim, distances);
+}
+
+int nearestCenter(const float* point, const float* centers, int numCenters, int dim, float* distances) {
+    kernelFor(dim)(point, centers, numCenters, dim, distances);
+    int best = 0;
+    for (int j = 1; j < numCenters; ++j) {
+        if (distances[j] < distances[best]) best = j;
+    }
+    return best;
+}
+
+int jumpConsistentHash(uint64_t key, int numBuckets) {
+    int64_t b = -1, j = 0;
+    while (j < numBuckets) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = (b + 1) * ((double) (1LL << 31) / (double) ((key >> 33) + 1));
+    }
+    return b;
+}
+
+int getSliceOwners(int numPoints, int numWorkers, std::vector<int>& owners) {
+    // Enough slices to balance the load among many workers, independent of numWorkers
+    const int numSlices = std::min(numPoints, 1<<16);
+    owners.resize(numSlices);
+    for (int slice = 0; slice < numSlices; ++slice) {
+        // sequential slice indices are scrambled first (SplitMix64 finalizer)
+        uint64_t z = slice + UINT64_C(0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+        owners[slice] = jumpConsistentHash(z ^ (z >> 31), numWorkers);
+    }
+    return numSlices;
+}
+
+std::vector<std::pair<int, int>> getWorkerRanges(int numPoints, const std::vector<int>& owners, int worker) {
+    std::vector<std::pair<int, int>> ranges;
+    const int numSlices = owners.size();
+    for (int slice = 0; slice < numSlices; ++slice) {
+        if (owners[slice] != worker) continue;
+        const int begin = (long) numPoints * slice / numSlices;
+        const int end = (long) numPoints * (slice+1) / numSlices;
+        if (!ranges.empty() && ranges.back().second == begin) ranges.back().second = end;
+        else ranges.emplace_back(begin, end);
+    }
+    return ranges;
+}
+
+std::vector<float> initCentersRandom(const float* points, int numPoints, int dim, int numCenters, uint64_t seed) {
+    SplitMix64Rng rng(seed);
+    std::vector<int> selectedPoints;
+    std::vector<float> centers;
+    centers.reserve((size_t) numCenters * dim);
+    for (int i = 0; i < numCenters; ++i) {
+        int point = rng() % numPoints;
+        while (std::find(selectedPoints.begin(), selectedPoints.end(), point) != selectedPoints.end()) {
+            point = rng() % numPoints;
+        }
+        selectedPoints.push_back(point);
+        centers.insert(centers.end(), points + (size_t) point * dim, points + (size_t) (point+1) * dim);
+    }
+    return centers;
+}
+
+// Index drawn with probability proportional to its weight
+static int sampleByWeight(const std::vector<double>& weights, double totalWeight, SplitMix64Rng& rng) {
+    double target = rng.randomInRange(0, totalWeight);
+    for (size_t i = 0; i < weights.size(); ++i) {
+        target -= weights[i];
+        if (target < 0) return i;
+    }
+    // rounding errors: last index with nonzero weight
+    for (int i = weights.size()-1; i >= 0; --i) if (weights[i] > 0) return i;
+    return 0;
+}
+
+std::vector<float> initCentersScalable(const float* points, int numPoints, int dim, int numCenters,
+        int rounds, float oversampling, uint64_t seed) {
+
+    SplitMix64Rng rng(seed);
+    auto point = [&](int i) {return points + (size_t) i * dim;};
+
+    // Candidates as point indices, each point's squared distance to and index of the nearest candidate
+    std::vector<int> candidates;
+    std::vector<float> minDist(numPoints, std::numeric_limits<float>::infinity());
+    std::vector<int> nearest(numPoints, -1);
+    std::vector<float> matrix;
+    std::vector<float> distances;
+
+    // Add the given new candidates and update the nearest candidate of each point
+    auto addCandidates = [&](const std::vector<int>& newCandidates) {
+        const int offset = candidates.size();
+        matrix.clear();
+        for (int c : newCandidates) {
+            candidates.push_back(c);
+            matrix.insert(matrix.end(), point(c), point(c) + dim);
+        }
+        distances.resize(newCandidates.size());
+        double cost = 0;
+        for (int i = 0; i < numPoints; ++i) {
+            int j = nearestCenter(point(i), matrix.data(), newCandidates.size(), dim, distances.data());
+            if (distances[j] < minDist[i]) {
+                minDist[i] = distances[j];
+                nearest[i] = offset + j;
+            }
+            cost += minDist[i];
+        }
+        return cost;
+    };
+
+    double cost = addCandidates({(int) (rng() % numPoints)});
+    const double expectedPerRound = oversampling * numCenters;
+    for (int r = 0; r < rounds && cost > 0; ++r) {
+        std::vector<int> newCandidates;
+        for (int i = 0; i < numPoints; ++i) {
+            if (rng.randomInRange(0, 1) < expectedPerRound * minDist[i] / cost) newCandidates.push_back(i);
+        }
+        if (!newCandidates.empty()) cost = addCandidates(newCandidates);
+    }
+    // Too few candidates (e.g., few rounds): add further ones k-means++ style
+    while ((int) candidates.size() < numCenters && cost > 0) {
+        std::vector<double> weights(minDist.begin(), minDist.end());
+        cost = addCandidates({sampleByWeight(weights, cost, rng)});
+    }
+
+    // Weight of a candidate: number of points nearest to it
+    std::vector<double> weights(candidates.size(), 0);
+    for (int i = 0; i < numPoints; ++i) weights[nearest[i]] += 1;
+    return chooseCentersFromCandidates(points, numPoints, dim, candidates, weights, numCenters, rng);
+}
+
+std::vector<float> chooseCentersFromCandidates(const float* points, int numPoints, int dim,
+        const std::vector<int>& candidates, const std::vector<double>& weights, int numCenters, SplitMix64Rng& rng) {
+
+    auto point = [&](int i) {return points + (size_t) i * dim;};
+    // Weighted k-means++ over the candidates
+    const int numCandidates = candidates.size();
+    std::vector<double> candMinDist(numCandidates, std::numeric_limits<double>::infinity());
+    std::vector<double> sampleWeights = weights;
+    double totalWeight = 0;
+    for (double weight : weights) totalWeight += weight;
+    std::vector<float> centers;
+    centers.reserve((size_t) numCenters * dim);
+    std::vector<float> distances(1);
+    for (int c = 0; c < numCenters; ++c) {
+        int chosen;
+        if (totalWeight > 0) {
+            chosen = candidates[sampleByWeight(sampleWeights, totalWeight, rng)];
+        } else {
+            // All points are covered exactly (fewer distinct points than centers)
+            chosen = rng() % numPoints;
+        }
+        centers.insert(centers.end(), point(chosen), point(chosen) + dim);
+        totalWeight = 0;
+        for (int j = 0; j < numCandidates; ++j) {
+            squaredDistances(point(candidates[j]), point(chosen), 1, dim, distances.data());
+            candMinDist[j] = std::min(candMinDist[j], (double) distances[0]);
+            sampleWeights[j] = weights[j] * candMinDist[j];
+            totalWeight += sampleWeights[j];
+        }
+    }
+    return centers;
+}
+
+double getSamplingCoin(uint64_t seed, int round, int pointID) {
+    SplitMix64Rng rng(seed ^ ((uint64_t) round << 40) ^ ((uint64_t) pointID * UINT64_C(0x9E3779B97F4A7C15)));
+    return (rng() >> 11) * 0x1.0p-53;
+}
+
+void miniBatchUpdate(float* centers, const float* batchMeans, const int* batchCounts,
+        std::vector<long>& cumulativeCounts, int numCenters, int dim) {
+    cumulativeCounts.resize(numCenters, 0);
+    for (int c = 0; c < numCenters; ++c) {
+        if (batchCounts[c] == 0) continue;
+        cumulativeCounts[c] += batchCounts[c];
+        const float learningRate = batchCounts[c] / (float) cumulativeCounts[c];
+        float* center = centers + (size_t) c * dim;
+        const float* mean = batchMeans + (size_t) c * dim;
+        for (int d = 0; d < dim; ++d) center[d] += learningRate * (mean[d] - center[d]);
+    }
+}
+
+float maxRelativeMovement(const float* oldCenters, const float* newCenters, int numCenters, int dim) {
+    std::vector<float> distances(numCenters);
+    float maxMovement = 0;
+    for (int c = 0; c < numCenters; ++c) {
+        const float* center = newCenters + (size_t) c * dim;
+        squaredDistances(center, newCenters, numCenters, dim, distances.data());
+        float separation = std::numeric_limits<float>::infinity();
+        for (int other = 0; other < numCenters; ++other) {
+            if (other != c) separation = std::min(separation, distances[other]);
+        }
+        const float movement = eukild(center, oldCenters + (size_t) c * dim, dim);
+        if (movement == 0) continue;
+        maxMovement = std::max(maxMovement, std::sqrt(movement / separation));
+    }
+    return maxMovement;
+}
+
+float eukild(const float* p1, const float* p2, const size_t dim) {
+    float sum;
+    kernelFor(dim)(p1, p2, 1, dim, &sum);
     return sum;
 }
 // childIndexesOf(1, 12) = [3, 4, 7, 8, 9, 10]
@@ -60,4 +444,4 @@ std::vector<int> childIndexesOf(int parentIndex, int jobVolume) {
     }
     return indexList;
 }
-}  // namespace KMeansUtils
\ No newline at end of file
+}  // namespace KMeansUtils
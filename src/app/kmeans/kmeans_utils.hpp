@@ -1,9 +1,60 @@
+#pragma once
+
 #include <string>
 
 #include "data/job_description.hpp"
+#include "util/random.hpp"
 
 namespace KMeansUtils {
     typedef std::vector<float> Point;
     float eukild(const float* p1, const float* p2, const size_t dim);
     std::vector<int> childIndexesOf(int parentIndex, int jobVolume);
+
+    // Squared euclidean distance kernels. The best instruction set supported by the
+    // CPU is selected at runtime; it can be overridden (e.g., for benchmarks), in which
+    // case the next best supported level is used.
+    enum SimdLevel {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+    SimdLevel getSimdLevel();
+    SimdLevel setSimdLevel(SimdLevel level);
+    const char* simdLevelToStr(SimdLevel level);
+
+    // Writes the squared distances from a point to each of the numCenters centers,
+    // given as a contiguous row-major matrix (numCenters x dim), to distances.
+    void squaredDistances(const float* point, const float* centers, int numCenters, int dim, float* distances);
+    // Returns the index of the center nearest to the point and leaves all squared
+    // distances in distances (of size numCenters).
+    int nearestCenter(const float* point, const float* centers, int numCenters, int dim, float* distances);
+
+    // Jump consistent hash (Lamping and Veach, 2014): maps the key to a bucket in [0, numBuckets)
+    // such that only keys of removed buckets move if numBuckets decreases (and vice versa).
+    int jumpConsistentHash(uint64_t key, int numBuckets);
+    // The points are partitioned into fixed slices, each of which is owned by one of numWorkers
+    // workers via jumpConsistentHash. Returns the number of slices and writes each slice's owner.
+    int getSliceOwners(int numPoints, int numWorkers, std::vector<int>& owners);
+    // Point ranges [first, second) of the slices owned by the given worker.
+    std::vector<std::pair<int, int>> getWorkerRanges(int numPoints, const std::vector<int>& owners, int worker);
+
+    // Initial centers (row-major, numCenters x dim) as distinct points chosen uniformly at random.
+    std::vector<float> initCentersRandom(const float* points, int numPoints, int dim, int numCenters, uint64_t seed);
+    // Initial centers via k-means|| (Bahmani et al., 2012): in each of the given rounds, each point
+    // becomes a candidate with probability oversampling*numCenters*d(x)^2/cost. The weighted candidates
+    // are then reduced to numCenters centers via k-means++. Deterministic for a given seed.
+    std::vector<float> initCentersScalable(const float* points, int numPoints, int dim, int numCenters,
+        int rounds, float oversampling, uint64_t seed);
+    // Final step of k-means||: numCenters centers (row-major) chosen from the candidates (point indices)
+    // via k-means++, where each candidate's probability is additionally scaled by its weight.
+    std::vector<float> chooseCentersFromCandidates(const float* points, int numPoints, int dim,
+        const std::vector<int>& candidates, const std::vector<double>& weights, int numCenters, SplitMix64Rng& rng);
+    // Uniform value in [0, 1) for sampling the given point in the given round of k-means||.
+    // Only depends on its arguments, so the sample is the same no matter which worker draws it.
+    double getSamplingCoin(uint64_t seed, int round, int pointID);
+
+    // Mini-batch update (Sculley, 2010): moves each center towards the mean of its batch members
+    // with the per-center learning rate batchCount/cumulativeCount, which decays over the iterations.
+    // Centers without batch members stay in place.
+    void miniBatchUpdate(float* centers, const float* batchMeans, const int* batchCounts,
+        std::vector<long>& cumulativeCounts, int numCenters, int dim);
+    // Largest movement of a center from oldCenters to newCenters relative to the distance between
+    // the moved center and its nearest other center. Scale-invariant measure of convergence.
+    float maxRelativeMovement(const float* oldCenters, const float* newCenters, int numCenters, int dim);
 };  // namespace KMeansUtils
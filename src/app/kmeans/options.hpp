@@ -3,7 +3,23 @@
 
 #include "optionslist.hpp"
 
-// Add your application-specific options here
+// Application-specific program options for K-Means clustering.
+// memberName                               short option name, long option name          default   min  max
 
-// OPTION_GROUP(grpAppYourapp, "app/yourappkey", "Options for application XXX")
-// OPT_* ...
+OPTION_GROUP(grpAppKmeans, "app/kmeans", "K-Means clustering options")
+ OPT_BOOL(kmeansPruning,                    "kmp", "kmeans-pruning",                     true,
+    "Skip distance computations during point assignment which are proven unnecessary by triangle inequality bounds (Hamerly)")
+ OPT_INT(kmeansInitRounds,                  "kmir", "kmeans-init-rounds",                5,        0,   LARGE_INT,
+    "Number of k-means|| rounds to compute the initial centers (0: uniformly random initial centers)")
+ OPT_FLOAT(kmeansInitOversampling,          "kmio", "kmeans-init-oversampling",          2,        0,   LARGE_INT,
+    "Expected number of k-means|| candidates sampled per round, as a multiple of the number of clusters")
+ OPT_INT(kmeansReaderThreads,               "kmrt", "kmeans-reader-threads",             1,        1,   LARGE_INT,
+    "Number of threads for parsing a K-Means text file (binary files are mapped into memory without parsing)")
+ OPT_FLOAT(kmeansMiniBatch,                 "kmmb", "kmeans-mini-batch",                 0,        0,   1,
+    "Mini-batch K-Means: fraction of each job node's points sampled per iteration, with decaying per-center learning rate (0: full Lloyd iterations)")
+ OPT_FLOAT(kmeansMiniBatchTolerance,        "kmmbt", "kmeans-mini-batch-tolerance",      0.01,     0,   1,
+    "Finish mini-batch K-Means as soon as no center moves by more than this fraction of its distance to the nearest other center")
+ OPT_FLOAT(kmeansConvergenceThreshold,      "kmct", "kmeans-convergence-threshold",      0.001,    0,   1,
+    "Finish as soon as no center coordinate moves by more than this fraction within an iteration")
+ OPT_INT(kmeansMaxIterations,               "kmmi", "kmeans-max-iterations",             0,        0,   LARGE_INT,
+    "Finish after this many iterations even if the centers have not converged (0: no limit)")
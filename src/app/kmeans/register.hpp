@@ -11,7 +11,7 @@ void register_mallob_app_kmeans() {
         "KMEANS",
         // Job reader
         [](const Parameters& params, const std::vector<std::string>& files, JobDescription& desc) {
-            return KMeansReader::read(files.front(), desc);
+            return KMeansReader::read(files.front(), desc, params.kmeansReaderThreads());
         },
         // Job creator
         [](const Parameters& params, const Job::JobSetup& setup, AppMessageTable& table) -> Job* {
@@ -7,4 +7,11 @@ set(BASE_SOURCES ${BASE_SOURCES} ${KMEANS_SOURCES} CACHE INTERNAL "")
 
 #message("commons+DUMMY sources: ${BASE_SOURCES}") # Use to debug
 
+# Add unit tests
+new_test(kmeans_distance)
+new_test(kmeans_init)
+new_test(kmeans_reader)
+new_test(kmeans_minibatch)
+new_test(kmeans_partition)
+
 # Done!
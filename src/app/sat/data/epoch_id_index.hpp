@@ -0,0 +1,69 @@
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "util/assert.hpp"
+
+/*
+Ascending list of the first clause IDs of all sharing epochs (starting with 0),
+with a lookup of the epoch a clause ID belongs to. Equivalent to
+ClauseMetadata::getEpoch, i.e., ID x belongs to the last epoch whose start is
+smaller than x. IDs beyond the last epoch start are answered directly.
+Other IDs are looked up in a table which maps fixed-size ranges ("buckets")
+of the ID space to the epoch at the start of the range. A binary search is
+only needed among the epoch starts within the same bucket, which are few
+since the bucket width grows with the range of IDs.
+*/
+class EpochIdIndex {
+
+private:
+    std::vector<unsigned long> _starts;
+    // _table[b]: epoch of ID b << _shift (for each bucket up to the last epoch start)
+    std::vector<int> _table;
+    int _shift {0};
+
+    static constexpr size_t MIN_TABLE_SIZE = 64;
+
+public:
+    EpochIdIndex() {}
+    EpochIdIndex(const std::vector<unsigned long>& starts) {
+        for (auto start : starts) push_back(start);
+    }
+
+    void push_back(unsigned long start) {
+        assert(_starts.empty() || start >= _starts.back());
+        _starts.push_back(start);
+        // Coarsen the table if it would grow too large relative to the number of epochs
+        const size_t maxTableSize = MIN_TABLE_SIZE + 4 * _starts.size();
+        while ((start >> _shift) + 1 > maxTableSize) {
+            for (size_t b = 0; 2*b < _table.size(); b++) _table[b] = _table[2*b];
+            _table.resize((_table.size() + 1) / 2);
+            _shift++;
+        }
+        // Table entries for the buckets up to the new start
+        const int epochBeforeStart = _starts.size() - 2;
+        for (size_t b = _table.size(); b <= (start >> _shift); b++) {
+            _table.push_back(std::max(0, epochBeforeStart));
+        }
+    }
+
+    int getEpoch(unsigned long id) const {
+        assert(!_starts.empty() && id > _starts.front());
+        const int lastEpoch = _starts.size() - 1;
+        if (id > _starts.back()) return lastEpoch;
+        const size_t bucket = id >> _shift;
+        // The epoch is among those between the starts of this bucket and the next one
+        const int lo = _table[bucket];
+        const int hi = bucket+1 < _table.size() ? _table[bucket+1] : lastEpoch;
+        auto it = std::lower_bound(_starts.begin()+lo+1, _starts.begin()+hi+1, id);
+        return std::distance(_starts.begin(), it) - 1;
+    }
+
+    size_t size() const {return _starts.size();}
+    bool empty() const {return _starts.empty();}
+    unsigned long back() const {return _starts.back();}
+    unsigned long operator[](size_t epoch) const {return _starts[epoch];}
+    const std::vector<unsigned long>& getStarts() const {return _starts;}
+};
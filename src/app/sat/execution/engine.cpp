@@ -56,7 +56,9 @@ SatEngine::SatEngine(const Parameters& params, const SatProcessConfig& config, L
 			_params.inputShuffleProbability.set(0);
 		}
 
-		// Override options
+		// Override options. Only CaDiCaL can produce LRAT proofs with clause IDs
+		// that match our alignment scheme; no other LRAT-capable backend is available,
+		// so e.g. Kissat cannot take part in certified runs.
 		if (solverChoices != "c") {
 			LOG(V2_INFO, "Certified UNSAT mode: Overriding portfolio to non-incremental CaDiCaL only\n");
 			solverChoices = "c";
@@ -167,6 +169,7 @@ SatEngine::SatEngine(const Parameters& params, const SatProcessConfig& config, L
 	setup.numVars = numVars;
 	setup.numOriginalClauses = numClauses;
 	setup.proofDir = proofDirectory;
+	setup.proofTrimWindow = params.proofTrimWindow();
 
 	// Instantiate solvers according to the global solver IDs and diversification indices
 	int cyclePos = begunCyclePos;
@@ -55,4 +55,6 @@ struct SolverSetup {
 	bool certifiedUnsat;
 	int maxNumSolvers;
 	std::string proofDir;
+	// Size of the window for trimming proofs on the fly, or 0 for no trimming
+	size_t proofTrimWindow;
 };
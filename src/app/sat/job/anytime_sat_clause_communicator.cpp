@@ -368,6 +368,11 @@ void AnytimeSatClauseCommunicator::setupProofProducer(JobMessage& msg) {
     memcpy(&setup.globalStartOfSuccessEpoch, msg.payload.data()+1, 2*sizeof(int));
     setup.solvingTime = _solving_time;
     setup.jobAgeSinceActivation = _job->getAgeSinceActivation();
+    if (_params.proofCheckThreads() > 0 && MyMpi::rank(MPI_COMM_WORLD) == 0 && _job->hasDescription()) {
+        // The proof is checked against the original formula where it is merged
+        const auto& desc = _job->getDescription();
+        setup.formula.assign(desc.getFormulaPayload(0), desc.getFormulaPayload(0) + desc.getFormulaPayloadSize(0));
+    }
 
     _proof_producer.reset(new ProofProducer(_params, setup, _job->getJobTree()));
 }
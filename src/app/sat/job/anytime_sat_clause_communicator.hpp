@@ -57,6 +57,7 @@ public:
     int getCurrentEpoch() const {return _current_epoch;}
 
     bool isDoneAssemblingProof() const {return _proof_producer && _proof_producer->isDoneAssemblingProof();}
+    bool isProofValid() const {return !_proof_producer || _proof_producer->isProofValid();}
 
 private:
     bool handleClauseHistoryMessage(int source, int mpiTag, JobMessage& msg);
@@ -108,6 +108,12 @@ int ForkedSatJob::appl_solved() {
     if (_done_locally || _assembling_proof) {
         if (_assembling_proof && _clause_comm->isDoneAssemblingProof()) {
             _assembling_proof = false;
+            if (!_clause_comm->isProofValid()) {
+                // An UNSAT result without a valid proof must not be reported
+                LOG(V0_CRIT, "[ERROR] %s : proof check failed - reporting UNKNOWN\n", toStr());
+                _internal_result.result = RESULT_UNKNOWN;
+                _internal_result.updateSerialization();
+            }
             return _internal_result.result;
         }
         return result;
@@ -121,6 +121,7 @@ void SatProcessAdapter::doInitialize() {
     if (_terminate) return;
 
     // Create SAT solving child process
+    _spawn_time = Timer::elapsedSeconds();
     Subprocess subproc(_params, "mallob_sat_process");
     pid_t res = subproc.start();
 
@@ -342,6 +343,12 @@ SatProcessAdapter::SubprocessStatus SatProcessAdapter::check() {
         return CRASHED;
     }
 
+    if (!_reported_startup && _hsm->isInitialized) {
+        _reported_startup = true;
+        LOG(V3_VERB, "%s : child %ld solving %.4fs after spawn\n", _config.getJobStr().c_str(),
+            _child_pid, Timer::elapsedSeconds() - _spawn_time);
+    }
+
     doWriteRevisions();
 
     if (_hsm->didReturnClauses)         _hsm->doReturnClauses         = false;
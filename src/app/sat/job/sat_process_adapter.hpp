@@ -89,6 +89,8 @@ private:
     int _epoch_of_export_buffer {-1};
 
     pid_t _child_pid = -1;
+    float _spawn_time = 0;
+    bool _reported_startup {false};
     SolvingStates::SolvingState _state = SolvingStates::INITIALIZING;
 
     std::atomic_int _written_revision = 0;
@@ -52,6 +52,7 @@ int main(int argc, char *argv[]) {
     logConfig.verbosity = params.verbosity();
     logConfig.coloredOutput = params.coloredOutput();
     logConfig.flushFileImmediately = params.immediateFileFlush();
+    logConfig.asyncLogging = params.asyncLogging();
     logConfig.quiet = params.quiet();
     if (params.zeroOnlyLogging() && rankOfParent > 0) logConfig.quiet = true;
     logConfig.cPrefix = params.monoFilename.isSet();
@@ -1,6 +1,8 @@
 
 #include "util/sys/process_dispatcher.hpp"
 
-int main() {
-    ProcessDispatcher().dispatch();
+#include <cstring>
+
+int main(int argc, char** argv) {
+    ProcessDispatcher().dispatch(argc > 1 && strcmp(argv[1], "pooled") == 0);
 }
@@ -90,8 +90,15 @@ OPTION_GROUP(grpAppSatDiversification, "app/sat/diversification", "Diversificati
 OPTION_GROUP(grpAppSatProof, "app/sat/proof", "Production of UNSAT proofs")
  OPT_BOOL(certifiedUnsat,                 "cu", "certified-unsat",                     false,                   "Generate UNSAT proof (only supports mono mode + CaDiCaL solver)")
  OPT_BOOL(distributedProofAssembly,  "dpa", "distributed-proof-assembly",              false,                   "Distributed UNSAT proof assembly into a single file")
+ OPT_INT(proofTrimWindow,                 "ptw", "proof-trim-window",                  0,       0, LARGE_INT,   "Trim solver proofs on the fly before writing them, keeping a window of this many recent lines (0: disabled)")
  OPT_BOOL(interleaveProofMerging,        "ipm", "interleave-proof-merging",            false,                   "Interleave filtering and merging of proof lines")
  OPT_STRING(proofOutputFile,              "pof", "proof-output-file",                  "final-proof.lrat",      "Path and name of final LRAT proof file, output by rank zero")
+ OPT_BOOL(writeProofFile,                 "wpf", "write-proof-file",                   true,                    "Write the final LRAT proof file (can be disabled if the proof is checked in process)")
+ OPT_INT(proofCheckThreads,               "pct", "proof-check-threads",                0,       0, LARGE_INT,   "Check the final proof at rank zero with this many threads while it is assembled (0: no check)")
  OPT_STRING(extMemDiskDirectory,          "extmem-disk-dir", "",                       ".disk",                 "Directory where to create external memory files") //[[AUTOCOMPLETE_DIRECTORY]]
+ OPT_INT(extMemBlockSize,                 "extmem-block-size", "",                     4096,    8, 1<<24,       "Size of blocks in external memory files (multiple of 4096 for direct I/O)")
+ OPT_BOOL(extMemDirectIo,                 "extmem-direct-io", "",                      false,                   "Bypass the page cache (O_DIRECT) for external memory files")
+ OPT_BOOL(extMemIoUring,                  "extmem-io-uring", "",                       false,                   "Use io_uring for external memory files if available (default: a few I/O threads)")
+ OPT_INT(extMemReadAhead,                 "extmem-read-ahead", "",                     16,      0, LARGE_INT,   "Max. number of blocks of the next epoch to read ahead from external memory files")
  OPT_STRING(satPreprocessor,              "sat-preprocessor", "",                      "",                      "Executable which preprocesses CNF file") //[[AUTOCOMPLETE_EXECUTABLE]]
  OPT_FLOAT(satSolvingWallclockLimit,      "sswl", "sat-solving-wallclock-limit",       0,    0, LARGE_INT,      "Cancel job if not done solving after this many seconds (0: no limit)")
@@ -14,8 +14,9 @@ private:
     std::priority_queue<unsigned long> _internal_queue;
 
 public:
-    ExternalIdPriorityQueue(const std::string& diskFilename, int maxEpoch) : 
-        _current_epoch(maxEpoch), _ext_mem(diskFilename, 4096) {}
+    ExternalIdPriorityQueue(const std::string& diskFilename, int maxEpoch,
+            const ExternalMemoryConfig& config = ExternalMemoryConfig()) :
+        _current_epoch(maxEpoch), _ext_mem(diskFilename, config) {}
 
     void push(unsigned long id, int epoch) {
         if (epoch >= _current_epoch) {
@@ -59,6 +60,8 @@ private:
             _ext_mem.fetchAndRemove(_current_epoch, result);
             if (result.empty()) _current_epoch--;
         }
+        // Epochs are processed in decreasing order: read ahead the next one
+        if (_current_epoch > 0) _ext_mem.prefetch(_current_epoch-1);
         for (auto id : result) {
             _internal_queue.push(id);
         }
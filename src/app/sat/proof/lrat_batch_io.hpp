@@ -0,0 +1,279 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "lrat_line.hpp"
+#include "lrat_utils.hpp"
+#include "serialized_lrat_line.hpp"
+#include "util/assert.hpp"
+
+// Block-oriented binary LRAT I/O: whole batches of lines are encoded into
+// (or decoded from) a reusable memory arena which is written (or read) at once.
+namespace lrat_utils {
+
+    // Reusable arena into which batches of binary LRAT lines are encoded.
+    // In FORWARD direction, each line is appended after the previous lines.
+    // In BACKWARD direction, each line is put in front of the previous lines,
+    // so that the lines of a proof arriving in reverse order can be prepended
+    // to a file which is written back to front.
+    class LratBatchEncoder {
+
+    public:
+        enum Direction {FORWARD, BACKWARD};
+
+    private:
+        Direction _direction;
+        size_t _batch_size;
+        std::vector<uint8_t> _arena;
+        size_t _begin {0};
+        size_t _end {0};
+        size_t _num_lines {0};
+        size_t _reserved {0};
+
+    public:
+        // The arena is allocated lazily with the first line.
+        LratBatchEncoder(Direction direction = FORWARD, size_t batchSize = 1<<20) :
+                _direction(direction), _batch_size(batchSize) {}
+
+        void encodeLine(SerializedLratLine& line) {
+            auto [lits, numLits] = line.getLiterals();
+            auto [hints, numHints] = line.getUnsignedHints();
+            auto signs = line.getSignsOfHints();
+            size_t size = 3 + getVarintSize(toVarintValue(line.getId()));
+            if (_direction == BACKWARD) {
+                for (int i = 0; i < numLits; i++) size += getVarintSize(toVarintValue(lits[i]));
+                for (int i = 0; i < numHints; i++) size += getVarintSize(2*hints[i] + !signs[i]);
+            } else {
+                size += 5*numLits + 10*numHints;
+            }
+            uint8_t* out = reserve(size);
+            *out++ = 'a';
+            out = encodeVarint(out, toVarintValue(line.getId()));
+            for (int i = 0; i < numLits; i++) out = encodeVarint(out, toVarintValue(lits[i]));
+            *out++ = 0;
+            for (int i = 0; i < numHints; i++) out = encodeVarint(out, 2*hints[i] + !signs[i]);
+            *out++ = 0;
+            commit(out);
+        }
+
+        void encodeLine(const LratLine& line) {
+            size_t size = 3 + getVarintSize(toVarintValue(line.id));
+            for (int lit : line.literals) size += getVarintSize(toVarintValue(lit));
+            for (size_t i = 0; i < line.hints.size(); i++)
+                size += getVarintSize(2*line.hints[i] + !line.signsOfHints[i]);
+            uint8_t* out = reserve(size);
+            *out++ = 'a';
+            out = encodeVarint(out, toVarintValue(line.id));
+            for (int lit : line.literals) out = encodeVarint(out, toVarintValue(lit));
+            *out++ = 0;
+            for (size_t i = 0; i < line.hints.size(); i++)
+                out = encodeVarint(out, 2*line.hints[i] + !line.signsOfHints[i]);
+            *out++ = 0;
+            commit(out);
+        }
+
+        void encodeDeletionLine(const unsigned long* ids, int numIds) {
+            size_t size = 2;
+            for (int i = 0; i < numIds; i++) size += getVarintSize(2*ids[i]);
+            uint8_t* out = reserve(size);
+            *out++ = 'd';
+            for (int i = 0; i < numIds; i++) out = encodeVarint(out, 2*ids[i]);
+            *out++ = 0;
+            commit(out);
+        }
+
+        // Adds arbitrary bytes as a line (e.g., a line of a textual proof)
+        void appendRaw(const char* data, size_t size) {
+            uint8_t* out = reserve(size);
+            memcpy(out, data, size);
+            commit(out + size);
+        }
+
+        const uint8_t* data() const {return _arena.data() + _begin;}
+        size_t size() const {return _end - _begin;}
+        size_t getNumLines() const {return _num_lines;}
+        bool empty() const {return _num_lines == 0;}
+        // Whether the batch should be written now
+        bool full() const {return size() >= _batch_size;}
+
+        void clear() {
+            _begin = _end = _direction == FORWARD ? 0 : _arena.size();
+            _num_lines = 0;
+        }
+        // Clears the batch for the given direction, keeping the arena
+        void reset(Direction direction) {
+            _direction = direction;
+            clear();
+        }
+
+        void writeTo(std::ostream& stream) {
+            stream.write((const char*) data(), size());
+            clear();
+        }
+
+    private:
+        // Returns a position from which at least maxSize bytes can be written.
+        // In BACKWARD direction, maxSize must be the exact size of the line.
+        uint8_t* reserve(size_t maxSize) {
+            if (_direction == FORWARD) {
+                if (_end + maxSize > _arena.size()) _arena.resize(getGrownArenaSize(_end + maxSize));
+                return _arena.data() + _end;
+            }
+            if (maxSize > _begin) {
+                // Move the data to the end of a larger arena
+                std::vector<uint8_t> grown(getGrownArenaSize(size() + maxSize));
+                const size_t newBegin = grown.size() - size();
+                memcpy(grown.data() + newBegin, data(), size());
+                _arena.swap(grown);
+                _begin = newBegin;
+                _end = _arena.size();
+            }
+            _begin -= maxSize;
+            _reserved = maxSize;
+            return _arena.data() + _begin;
+        }
+        size_t getGrownArenaSize(size_t minSize) const {
+            return std::max({2*_arena.size(), 2*_batch_size, minSize});
+        }
+        void commit(uint8_t* lineEnd) {
+            if (_direction == FORWARD) _end = lineEnd - _arena.data();
+            else assert(lineEnd == _arena.data() + _begin + _reserved);
+            _num_lines++;
+        }
+    };
+
+    // Reads a binary LRAT file in large chunks and decodes the lines directly
+    // from the chunk in memory.
+    class LratBlockReader {
+
+    private:
+        std::ifstream& _ifs;
+        std::vector<uint8_t> _buffer;
+        size_t _pos {0};
+        size_t _end {0};
+        bool _input_exhausted {false};
+
+        std::vector<int> _lits;
+        std::vector<uint64_t> _hints;
+        std::vector<uint8_t> _signs;
+
+    public:
+        LratBlockReader(std::ifstream& ifs, size_t chunkSize = 1<<20) : _ifs(ifs), _buffer(chunkSize) {}
+
+        bool readLine(SerializedLratLine& line) {
+            LratClauseId id;
+            if (!decodeLine(id)) return false;
+            auto& data = line.data();
+            data.resize(SerializedLratLine::getSize(_lits.size(), _hints.size()));
+            uint8_t* out = data.data();
+            const int numLits = _lits.size();
+            const int numHints = _hints.size();
+            memcpy(out, &id, sizeof(LratClauseId)); out += sizeof(LratClauseId);
+            memcpy(out, &numLits, sizeof(int)); out += sizeof(int);
+            memcpy(out, _lits.data(), numLits*sizeof(int)); out += numLits*sizeof(int);
+            memcpy(out, &numHints, sizeof(int)); out += sizeof(int);
+            memcpy(out, _hints.data(), numHints*sizeof(LratClauseId)); out += numHints*sizeof(LratClauseId);
+            memcpy(out, _signs.data(), numHints);
+            return true;
+        }
+
+        bool readLine(LratLine& line) {
+            line.id = -1;
+            line.literals.clear();
+            line.hints.clear();
+            line.signsOfHints.clear();
+            LratClauseId id;
+            if (!decodeLine(id)) return false;
+            line.id = id;
+            line.literals = _lits;
+            line.hints.assign(_hints.begin(), _hints.end());
+            line.signsOfHints.assign(_signs.begin(), _signs.end());
+            return true;
+        }
+
+        // Returns the type of the next line ('a' or 'd'), or 0 if the input is exhausted.
+        char peekLineType() {
+            while (_pos == _end && !_input_exhausted) refill();
+            return _pos < _end ? _buffer[_pos] : 0;
+        }
+
+        bool readDeletionLine(std::vector<LratClauseId>& ids) {
+            while (true) {
+                if (_pos < _end) {
+                    if (_buffer[_pos] != 'd') return false;
+                    if (tryDecodeDeletionLine(ids)) return true;
+                }
+                if (_input_exhausted) return false;
+                refill();
+            }
+        }
+
+    private:
+        // Decodes the next addition line into id, _lits, _hints, and _signs.
+        bool decodeLine(LratClauseId& id) {
+            while (true) {
+                if (_pos < _end) {
+                    if (_buffer[_pos] != 'a') return false;
+                    if (tryDecodeLine(id)) return true;
+                }
+                // The line is (possibly) incomplete: read more data
+                if (_input_exhausted) return false;
+                refill();
+            }
+        }
+
+        bool tryDecodeLine(LratClauseId& id) {
+            const uint8_t* in = _buffer.data() + _pos + 1;
+            const uint8_t* end = _buffer.data() + _end;
+            uint64_t n;
+            if (!(in = decodeVarint(in, end, n))) return false;
+            id = n >> 1;
+            _lits.clear();
+            while (true) {
+                if (!(in = decodeVarint(in, end, n))) return false;
+                if (n == 0) break;
+                _lits.push_back(fromVarintValue(n));
+            }
+            _hints.clear();
+            _signs.clear();
+            while (true) {
+                if (!(in = decodeVarint(in, end, n))) return false;
+                if (n == 0) break;
+                _hints.push_back(n >> 1);
+                _signs.push_back(!(n & 1));
+            }
+            _pos = in - _buffer.data();
+            return true;
+        }
+
+        bool tryDecodeDeletionLine(std::vector<LratClauseId>& ids) {
+            const uint8_t* in = _buffer.data() + _pos + 1;
+            const uint8_t* end = _buffer.data() + _end;
+            uint64_t n;
+            ids.clear();
+            while (true) {
+                if (!(in = decodeVarint(in, end, n))) return false;
+                if (n == 0) break;
+                ids.push_back(n >> 1);
+            }
+            _pos = in - _buffer.data();
+            return true;
+        }
+
+        void refill() {
+            // Move the remaining bytes to the front (and grow the buffer for huge lines)
+            const size_t remaining = _end - _pos;
+            memmove(_buffer.data(), _buffer.data() + _pos, remaining);
+            _pos = 0;
+            _end = remaining;
+            if (_end == _buffer.size()) _buffer.resize(2*_buffer.size());
+            _ifs.read((char*) _buffer.data() + _end, _buffer.size() - _end);
+            _end += _ifs.gcount();
+            if (!_ifs) _input_exhausted = true;
+        }
+    };
+}
@@ -0,0 +1,209 @@
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lrat_batch_io.hpp"
+#include "util/logger.hpp"
+#include "util/robin_hood.hpp"
+#include "util/sys/background_worker.hpp"
+#include "util/sys/threading.hpp"
+
+/*
+Trims a solver's binary LRAT output on the fly, before it reaches the disk.
+The solver writes its proof, including deletions, into a named pipe which is read
+by a background thread. The most recent lines are kept in a window, together with
+the number of times each of them is referenced as a hint by a retained line.
+A line which the solver has deleted, which is not referenced by any retained line,
+and whose clause has not been exported to other solvers (see pinClause) cannot be
+required for the refutation. Such a line is dropped, which in turn releases the
+references of its own hints. Lines leaving the window are written to the output
+file (without any deletions, as expected by the proof assembly).
+*/
+class LratOnlineTrimmer {
+
+public:
+    struct Stats {
+        unsigned long numReadLines {0};
+        unsigned long numDeletedIds {0};
+        unsigned long numDroppedLines {0};
+        unsigned long numWrittenLines {0};
+        unsigned long numWrittenBytes {0};
+    };
+
+private:
+    struct Entry {
+        LratClauseId id;
+        SerializedLratLine line;
+        int numReferences {0};
+        bool deleted {false};
+        bool dropped {false};
+        Entry(LratClauseId id, SerializedLratLine&& line) : id(id), line(std::move(line)) {}
+    };
+
+    const std::string _pipe_filename;
+    const std::string _output_filename;
+    const size_t _window_size;
+
+    std::deque<Entry> _window;
+    std::vector<Entry*> _drop_stack;
+
+    // IDs of exported clauses, which must never be dropped
+    robin_hood::unordered_flat_set<LratClauseId> _pinned_ids;
+    Mutex _mtx_new_pinned_ids;
+    std::vector<LratClauseId> _new_pinned_ids;
+
+    std::ofstream _output;
+    lrat_utils::LratBatchEncoder _output_batch;
+    Stats _stats;
+
+    BackgroundWorker _worker;
+
+public:
+    // Creates the named pipe pipeFilename, to which the solver must write its proof.
+    LratOnlineTrimmer(const std::string& pipeFilename, const std::string& outputFilename, size_t windowSize) :
+            _pipe_filename(pipeFilename), _output_filename(outputFilename), _window_size(windowSize),
+            _output(outputFilename, std::ios::binary) {
+
+        ::unlink(_pipe_filename.c_str());
+        if (mkfifo(_pipe_filename.c_str(), 0600) != 0) {
+            LOG(V0_CRIT, "[ERROR] Cannot create pipe %s: %s\n", _pipe_filename.c_str(), strerror(errno));
+            abort();
+        }
+        _worker.run([&]() {run();});
+    }
+    ~LratOnlineTrimmer() {
+        join();
+    }
+
+    // Called by the solver for each clause which is exported, i.e., which the proofs
+    // of other solvers can refer to. Must be called before the clause's deletion is written.
+    void pinClause(LratClauseId id) {
+        auto lock = _mtx_new_pinned_ids.getLock();
+        _new_pinned_ids.push_back(id);
+    }
+
+    // Waits until the solver has closed the pipe and the output is complete.
+    void join() {
+        _worker.stop();
+    }
+
+    const Stats& getStats() const {
+        return _stats;
+    }
+
+private:
+    void run() {
+        // (blocks until the solver has opened the pipe)
+        std::ifstream input(_pipe_filename, std::ios::binary);
+        ::unlink(_pipe_filename.c_str());
+        lrat_utils::LratBlockReader reader(input);
+
+        SerializedLratLine line;
+        std::vector<LratClauseId> ids;
+        while (true) {
+            char type = reader.peekLineType();
+            if (type == 'a' && reader.readLine(line)) {
+                add(line);
+            } else if (type == 'd' && reader.readDeletionLine(ids)) {
+                fetchPinnedIds();
+                for (auto id : ids) remove(id);
+            } else {
+                if (type != 0) LOG(V0_CRIT, "[ERROR] Malformed proof line in %s\n", _pipe_filename.c_str());
+                break;
+            }
+        }
+        while (!_window.empty()) evict();
+        _stats.numWrittenBytes += _output_batch.size();
+        _output_batch.writeTo(_output);
+        _output.flush();
+
+        LOG(V3_VERB, "Online proof trimming %s: read %lu lines, deleted %lu IDs, dropped %lu lines, wrote %lu lines (%lu bytes)\n",
+            _output_filename.c_str(), _stats.numReadLines, _stats.numDeletedIds, _stats.numDroppedLines,
+            _stats.numWrittenLines, _stats.numWrittenBytes);
+    }
+
+    void add(SerializedLratLine& line) {
+        _stats.numReadLines++;
+        const auto id = line.getId();
+        if (!_window.empty() && id <= _window.back().id) {
+            // IDs are not ascending: lookups in the window would fail, so write everything
+            LOG(V1_WARN, "[WARN] Proof line ID %lu after ID %lu in %s\n", id, _window.back().id, _pipe_filename.c_str());
+            while (!_window.empty()) evict();
+        }
+        auto [hints, numHints] = line.getUnsignedHints();
+        for (int i = 0; i < numHints; i++) {
+            Entry* entry = find(hints[i]);
+            if (!entry) continue;
+            if (entry->dropped) {
+                LOG(V0_CRIT, "[ERROR] Proof line ID %lu refers to deleted clause ID %lu in %s\n",
+                    id, hints[i], _pipe_filename.c_str());
+                abort();
+            }
+            entry->numReferences++;
+        }
+        _window.emplace_back(id, std::move(line));
+        if (_window.size() > _window_size) evict();
+    }
+
+    void remove(LratClauseId id) {
+        _stats.numDeletedIds++;
+        Entry* entry = find(id);
+        if (!entry) return;
+        entry->deleted = true;
+        _drop_stack.push_back(entry);
+        while (!_drop_stack.empty()) {
+            entry = _drop_stack.back();
+            _drop_stack.pop_back();
+            if (entry->dropped || !entry->deleted || entry->numReferences > 0
+                    || _pinned_ids.count(entry->id)) continue;
+            // The line can be dropped: release the references of its hints
+            entry->dropped = true;
+            _stats.numDroppedLines++;
+            auto [hints, numHints] = entry->line.getUnsignedHints();
+            for (int i = 0; i < numHints; i++) {
+                Entry* hintEntry = find(hints[i]);
+                if (!hintEntry) continue;
+                hintEntry->numReferences--;
+                _drop_stack.push_back(hintEntry);
+            }
+            std::vector<uint8_t>().swap(entry->line.data());
+        }
+    }
+
+    void evict() {
+        fetchPinnedIds();
+        auto& entry = _window.front();
+        if (!entry.dropped) {
+            _output_batch.encodeLine(entry.line);
+            _stats.numWrittenLines++;
+            if (_output_batch.full()) {
+                _stats.numWrittenBytes += _output_batch.size();
+                _output_batch.writeTo(_output);
+            }
+        }
+        _pinned_ids.erase(entry.id);
+        _window.pop_front();
+    }
+
+    Entry* find(LratClauseId id) {
+        if (_window.empty() || id < _window.front().id || id > _window.back().id) return nullptr;
+        auto it = std::lower_bound(_window.begin(), _window.end(), id,
+            [](const Entry& entry, LratClauseId id) {return entry.id < id;});
+        return it->id == id ? &*it : nullptr;
+    }
+
+    void fetchPinnedIds() {
+        auto lock = _mtx_new_pinned_ids.getLock();
+        for (auto id : _new_pinned_ids) {
+            // (lines which have left the window already are irrelevant)
+            if (_window.empty() || id >= _window.front().id) _pinned_ids.insert(id);
+        }
+        _new_pinned_ids.clear();
+    }
+};
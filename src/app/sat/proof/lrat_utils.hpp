@@ -1,171 +1,78 @@
-
 #pragma once
 
-#include <fstream>
-
-#include "lrat_line.hpp"
-#include "serialized_lrat_line.hpp"
-#include "util/sys/buffered_io.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
+// Encoding of numbers in binary DRAT/LRAT proofs
+// https://github.com/marijnheule/drat-trim#binary-drat-format
 namespace lrat_utils {
 
-    enum WriteMode {NORMAL, REVERSED};
-    
-    struct WriteBuffer {
-    
-        BufferedFileWriter writer;
-
-        WriteBuffer(std::ofstream& stream) : writer(stream) {}
-
-        void writeLineHeader() {
-            writer.put('a');
-            //char header = 'a';
-            //ofs.write((const char*) &header, 1);
-        }
-
-        void writeDeletionLineHeader() {
-            writer.put('d');
-            //char header = 'd';
-            //ofs.write((const char*) &header, 1);
-        }
-
-        void writeSeparator() {
-            writer.put('\0');
-            //char zero = '\0';
-            //ofs.write((const char*) &zero, 1);
+    // Variable-length integers: groups of 7 bits, least significant first,
+    // with the most significant bit set in all bytes except for the last one.
+
+    inline int getVarintSize(uint64_t n) {
+        return n < 128 ? 1 : (64 - __builtin_clzll(n) + 6) / 7;
+    }
+
+    inline uint64_t toVarintValue(int64_t signedNumber) {
+        return 2 * (uint64_t) std::abs(signedNumber) + (signedNumber < 0);
+    }
+    inline int64_t fromVarintValue(uint64_t n) {
+        // odd values map to negative numbers
+        return (n & 1) ? -(int64_t) (n >> 1) : (int64_t) (n >> 1);
+    }
+
+    inline uint8_t* encodeVarint(uint8_t* out, uint64_t n) {
+        while (n >= 128) {
+            *out++ = (n & 0x7f) | 0x80;
+            n >>= 7;
         }
-
-        void writeVariableLengthUnsigned(int64_t n) {
-            assert (n > 0);
-            unsigned char ch;
-            while (n & ~0x7f) {
-                ch = (n & 0x7f) | 0x80;
-                writer.put(ch);
-                //ofs.write((const char*) &ch, 1);
-                n >>= 7;
-            }
-            ch = n;
-            writer.put(ch);
-            //ofs.write((const char*) &ch, 1);
+        *out++ = n;
+        return out;
+    }
+
+    // Decodes the varint beginning at in. Returns the position after the varint,
+    // or nullptr if the varint is incomplete within [in, end).
+    inline const uint8_t* decodeVarint(const uint8_t* in, const uint8_t* end, uint64_t& n) {
+        if (in < end && !(*in & 0x80)) {
+            n = *in;
+            return in + 1;
         }
-
-        void writeVariableLengthUnsignedReversed(int64_t n) {
-            assert (n > 0);
-            
-            auto original = n;
-            int numIterations = 0;
-            while (n & ~0x7f) {
-                numIterations++;
-                n >>= 7;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (end - in >= 8) {
+            // Find the terminating byte among the next eight bytes at once
+            uint64_t word;
+            memcpy(&word, in, sizeof(word));
+            const uint64_t stops = ~word & 0x8080808080808080UL;
+            if (stops) {
+                const int numBytes = (__builtin_ctzll(stops) >> 3) + 1;
+                if (numBytes < 8) word &= (1UL << (8*numBytes)) - 1;
+#ifdef __BMI2__
+                n = _pext_u64(word, 0x7f7f7f7f7f7f7f7fUL);
+#else
+                // Gather the 7-bit groups within the word pairwise
+                word &= 0x7f7f7f7f7f7f7f7fUL;
+                word = (word & 0x007f007f007f007fUL) | ((word & 0x7f007f007f007f00UL) >> 1);
+                word = (word & 0x00003fff00003fffUL) | ((word & 0x3fff00003fff0000UL) >> 2);
+                word = (word & 0x000000000fffffffUL) | ((word & 0x0fffffff00000000UL) >> 4);
+                n = word;
+#endif
+                return in + numBytes;
             }
-
-            unsigned char ch = n;
-            writer.put(ch);
-            //ofs.write((const char*) &ch, 1);
-
-            for (int i = 1; i <= numIterations; i++) {
-                n = original >> (7*(numIterations - i));
-                ch = (n & 0x7f) | 0x80;
-                writer.put(ch);
-                //ofs.write((const char*) &ch, 1);
-            }
-        }
-
-        void writeVariableLengthSigned(int64_t n) {
-            writeVariableLengthUnsigned(2*std::abs(n) + (n < 0));
-        }
-
-        void writeVariableLengthSignedReversed(int64_t n) {
-            writeVariableLengthUnsignedReversed(2*std::abs(n) + (n < 0));
         }
-
-        void writeSignedClauseId(int64_t id, lrat_utils::WriteMode mode) {
-            if (mode == lrat_utils::REVERSED) {
-                writeVariableLengthSignedReversed(id);
-            } else {
-                writeVariableLengthSigned(id);
-            }
+#endif
+        n = 0;
+        int shift = 0;
+        while (in < end) {
+            const uint8_t byte = *in++;
+            n |= (uint64_t) (byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return in;
+            shift += 7;
         }
-
-        void writeLiteral(int lit, lrat_utils::WriteMode mode) {
-            if (mode == lrat_utils::REVERSED) {
-                writeVariableLengthSignedReversed(lit);
-            } else {
-                writeVariableLengthSigned(lit);
-            }
-        }
-    };
-
-    struct ReadBuffer {
-
-        BufferedFileReader reader;
-
-        ReadBuffer(std::ifstream& ifs) : reader(ifs) {}
-
-        char get() {
-            return reader.get();
-        }
-
-        bool endOfFile() const {
-            return reader.endOfFile();
-        }
-
-        bool readSignedClauseId(int64_t& id) {
-            int64_t unadjusted = 0;
-            int64_t coefficient = 1;
-            int32_t tmp = reader.get();
-            if (tmp == 0) return false;
-            while (tmp) {
-                // continuation bit set?
-                if (tmp & 0b10000000) {
-                    unadjusted += coefficient * (tmp & 0b01111111); // remove first bit
-                } else {
-                    // last byte
-                    unadjusted += coefficient * tmp; // first bit is 0, so can leave it
-                    break;
-                }
-                coefficient *= 128; // 2^7 because we essentially have 7-bit bytes
-                tmp = reader.get(); //*((unsigned char*) (_num_buffer+i));
-            }
-            if (unadjusted % 2) { // odds map to negatives
-                id = -(unadjusted - 1) / 2;
-            } else {
-                id = unadjusted / 2;
-            }
-            return true;
-        }
-
-        bool readLiteral(int32_t& lit) {
-            int32_t unadjusted = 0;
-            int32_t coefficient = 1;
-            int32_t tmp = reader.get();
-            if (tmp == 0) return false;
-            while (tmp >= 0) {
-                // continuation bit set?
-                if (tmp & 0b10000000) {
-                    unadjusted += coefficient * (tmp & 0b01111111); // remove first bit
-                } else {
-                    // last byte
-                    unadjusted += coefficient * tmp; // first bit is 0, so can leave it
-                    break;
-                }
-                coefficient *= 128; // 2^7 because we essentially have 7-bit bytes
-                tmp = reader.get();
-            }
-            if (unadjusted % 2) { // odds map to negatives
-                lit = -(unadjusted - 1) / 2;
-            } else {
-                lit = unadjusted / 2;
-            }
-            return true;
-        }
-    };
-
-    void writeLine(WriteBuffer& ofs, const LratLine& line);
-    void writeLine(WriteBuffer& ofs, SerializedLratLine& line, WriteMode mode = NORMAL);
-    void writeDeletionLine(WriteBuffer& ofs, LratClauseId headerId, const std::vector<unsigned long>& ids, WriteMode mode = NORMAL);
-    void writeDeletionLine(WriteBuffer& ofs, LratClauseId headerId, const unsigned long* hints, int numHints, WriteMode mode = NORMAL);
-    
-    bool readLine(ReadBuffer& ifs, LratLine& line);
-    bool readLine(ReadBuffer& ifs, SerializedLratLine& line);
+        return nullptr;
+    }
 }
@@ -10,16 +10,19 @@
 #include "util/sys/thread_pool.hpp"
 #include "util/logger.hpp"
 #include "util/sys/timer.hpp"
-#include "util/bloom_filter.hpp"
+#include "util/sys/process.hpp"
+#include "util/compressed_id_set.hpp"
 #include "app/sat/proof/lrat_line.hpp"
 #include "app/sat/proof/serialized_lrat_line.hpp"
 #include "app/sat/proof/lrat_utils.hpp"
+#include "app/sat/proof/parallel_lrat_checker.hpp"
 #include "app/sat/proof/reverse_binary_lrat_parser.hpp"
-#include "util/sys/buffered_io.hpp"
 #include "merge_message.hpp"
 #include "merge_child.hpp"
 #include "proof_writer.hpp"
-#include "util/small_merger.hpp"
+#include "util/tournament_merger.hpp"
+#include "util/spsc_blocking_ringbuffer.hpp"
+#include "util/sys/background_worker.hpp"
 
 class DistributedProofMerger {
 
@@ -28,11 +31,12 @@ public:
 
 private:
     const static int FULL_CHUNK_SIZE_BYTES = 900'000;
+    const static int ROOT_BATCH_SIZE = 1024;
     
     MPI_Comm _comm;
     int _branching_factor;
-    MergeSourceInterface<SerializedLratLine>* _local_source;
-    std::unique_ptr<SmallMerger<SerializedLratLine>> _merger;
+    std::vector<MergeSourceInterface<SerializedLratLine>*> _local_sources;
+    std::unique_ptr<TournamentMerger<SerializedLratLine>> _merger;
     bool _merger_valid {false};
     int _num_original_clauses = 0;
     
@@ -55,7 +59,12 @@ private:
     // rank zero only
     std::string _output_filename;
     std::unique_ptr<ProofWriter> _proof_writer;
-    std::unique_ptr<BloomFilter<unsigned long>> _output_id_filter;
+    std::unique_ptr<ParallelLratChecker> _checker;
+    CompressedIdSet _output_ids;
+    // Batches of merged lines handed from the merging thread to the thread
+    // which adds deletion lines and forwards all lines to the proof writer
+    SPSCBlockingRingbuffer<std::vector<SerializedLratLine>> _root_batches;
+    BackgroundWorker _root_filter;
     std::future<void> _fut_root_prepare;
     bool _root_prepared = false;
 
@@ -66,7 +75,11 @@ private:
     std::future<void> _fut_merging;
     bool _began_merging = false;
     bool _began_final_barrier = false;
-    bool _reversed_file = false;
+    bool _output_complete = false;
+    // outcome of the proof check at rank zero (1 if valid or unchecked),
+    // reduced to all processes in the final barrier
+    int _proof_valid_local = 1;
+    int _proof_valid_global = 1;
 
     float _timepoint_merge_begin {0};
     float _time_inactive {0};
@@ -77,9 +90,12 @@ private:
 
 public:
     DistributedProofMerger(MPI_Comm comm, int branchingFactor, 
-        MergeSourceInterface<SerializedLratLine>* localSource, const std::string& outputFileAtZero) : 
+        const std::vector<MergeSourceInterface<SerializedLratLine>*>& localSources, 
+        const std::string& outputFileAtZero, int numCheckerThreadsAtZero = 0,
+        std::vector<int>&& formulaAtZero = std::vector<int>()) : 
             _log(Logger::getMainInstance().copy("DFM", ".proofmerge")),
-            _comm(comm), _branching_factor(branchingFactor), _local_source(localSource) {
+            _comm(comm), _branching_factor(branchingFactor), _local_sources(localSources),
+            _root_batches(16) {
 
         int myRank = MyMpi::rank(comm);
         _is_root = myRank == 0;
@@ -87,14 +103,19 @@ public:
         setUpMergeTree();
 
         if (myRank == 0) {
-            _fut_root_prepare = ProcessWideThreadPool::get().addTask([&, outputFileAtZero]() {
-                // Create final output file
+            _fut_root_prepare = ProcessWideThreadPool::get().addTask([&, outputFileAtZero, numCheckerThreadsAtZero,
+                    formula = std::move(formulaAtZero)]() {
+                // Create final output file (unless disabled)
                 _output_filename = outputFileAtZero;
-                std::string reverseFilename = _output_filename + ".inv";
-                LOGGER(_log, V3_VERB, "Opening output file \"%s\"\n", reverseFilename.c_str());
-                _proof_writer.reset(new ProofWriter(reverseFilename, _binary_output));
-                // TODO choose size relative to proof size
-                _output_id_filter.reset(new BloomFilter<unsigned long>(268435399, 4));
+                if (!_output_filename.empty()) {
+                    LOGGER(_log, V3_VERB, "Opening output file \"%s\"\n", _output_filename.c_str());
+                    _proof_writer.reset(new ProofWriter(_output_filename, _binary_output));
+                }
+                // Set up checking of the merged proof
+                if (numCheckerThreadsAtZero > 0) {
+                    LOGGER(_log, V3_VERB, "Checking proof with %i threads\n", numCheckerThreadsAtZero);
+                    _checker.reset(new ParallelLratChecker(numCheckerThreadsAtZero, formula));
+                }
                 _root_prepared = true;
             });
         } else {
@@ -130,9 +151,9 @@ public:
         _began_merging = true;
         _timepoint_merge_begin = Timer::elapsedSeconds();
         _fut_merging = ProcessWideThreadPool::get().addTask([&]() {
+            if (_is_root) runRootFilter();
             doMerging();
             concludeMerging();
-            reverseFile();
         });
     }
 
@@ -228,14 +249,15 @@ public:
 
     bool finished() const {
         if (!isFullyExhausted()) return false;
-        if (_is_root) return _reversed_file;
+        if (_is_root) return _output_complete;
         return true;
     }
 
     bool allProcessesFinished() {
         if (finished()) {
             if (!_began_final_barrier) {
-                MPI_Ibarrier(_comm, &_barrier_request);
+                MPI_Iallreduce(&_proof_valid_local, &_proof_valid_global, 1, MPI_INT,
+                    MPI_MIN, _comm, &_barrier_request);
                 _began_final_barrier = true;
             }
             int flag;
@@ -245,6 +267,11 @@ public:
         return false;
     }
 
+    // Only meaningful after allProcessesFinished() returned true.
+    bool isProofValid() const {
+        return _proof_valid_global == 1;
+    }
+
 private:
 
     void setUpMergeTree() {
@@ -299,16 +326,16 @@ private:
 
         assert(_num_original_clauses > 0);
 
-        std::vector<MergeSourceInterface<SerializedLratLine>*> mergeSources;
-        mergeSources.push_back(_local_source);
+        // Merge the local proof parts and the outputs of all children at once
+        std::vector<MergeSourceInterface<SerializedLratLine>*> mergeSources = _local_sources;
         for (auto& child : _children) {
             mergeSources.push_back(&child);
         }
-        _merger.reset(new SmallMerger<SerializedLratLine>(mergeSources));
+        _merger.reset(new TournamentMerger<SerializedLratLine>(mergeSources));
         auto& merger = *_merger.get();
         _merger_valid = true;
 
-        std::vector<LratClauseId> hintsToDelete;
+        std::vector<SerializedLratLine> rootBatch;
         SerializedLratLine bufferLine;
         float inactiveTimeStart = 0;
         LratClauseId lastId = std::numeric_limits<LratClauseId>::max();
@@ -363,23 +390,13 @@ private:
                     chosenLine.clear();
                     continue;
                 }
-                auto [ptr, numHints] = chosenLine.getUnsignedHints();
-                for (size_t i = 0; i < numHints; i++) {
-                    auto hint = ptr[i];
-                    if (hint > _num_original_clauses &&
-                            _output_id_filter->tryInsert(hint)) {
-                        // Guarantee that ID was never output before.
-                        // Can add a deletion line.
-                        hintsToDelete.push_back(hint);
-                    }
-                }
-                if (!hintsToDelete.empty()) {
-                    _proof_writer->pushDeletionBlocking(chosenId, hintsToDelete);
-                    hintsToDelete.clear();
-                }
-                // Write into final file
-                _proof_writer->pushAdditionBlocking(chosenLine);
+                // Hand over to the filtering thread
+                rootBatch.push_back(std::move(chosenLine));
                 chosenLine.clear();
+                if (rootBatch.size() == ROOT_BATCH_SIZE) {
+                    _root_batches.pushBlocking(rootBatch);
+                    rootBatch.clear();
+                }
             } else {
                 // Write into output buffer
                 auto lock = _output_buffer_mutex.getLock();
@@ -394,45 +411,79 @@ private:
             _time_inactive += Timer::elapsedSeconds() - inactiveTimeStart;
             inactiveTimeStart = 0;
         }
+
+        if (_is_root) {
+            if (!rootBatch.empty()) _root_batches.pushBlocking(rootBatch);
+            _root_batches.markExhausted();
+        }
+    }
+
+    // Root only: Adds a deletion line for each hint which occurs for the last time
+    // in the proof (i.e., for the first time in the reversed merged proof)
+    // and forwards all lines to the proof writer and/or the proof checker.
+    void runRootFilter() {
+        _root_filter.run([&]() {
+            std::vector<SerializedLratLine> batch;
+            std::vector<LratClauseId> hintsToDelete;
+            // Runs until the merging thread marks the batches exhausted
+            while (_root_batches.pollBlocking(batch)) {
+                for (auto& line : batch) {
+                    if (_checker) _checker->submitReversed(line);
+                    if (!_proof_writer) continue;
+                    auto [ptr, numHints] = line.getUnsignedHints();
+                    for (size_t i = 0; i < numHints; i++) {
+                        auto hint = ptr[i];
+                        if (hint > _num_original_clauses &&
+                                _output_ids.tryInsert(hint)) {
+                            // ID was never output before (i.e., is not used later in the proof).
+                            // Can add a deletion line.
+                            hintsToDelete.push_back(hint);
+                        }
+                    }
+                    if (!hintsToDelete.empty()) {
+                        _proof_writer->pushDeletionBlocking(line.getId(), hintsToDelete);
+                        hintsToDelete.clear();
+                    }
+                    // Write into final file
+                    _proof_writer->pushAdditionBlocking(line);
+                }
+                batch.clear();
+            }
+        });
     }
 
     void concludeMerging() {
-        if (_is_root) {
+        if (!_is_root) return;
+
+        _root_filter.stop(); // waits for all batches to be processed
+
+        if (_proof_writer) {
+            // The proof writer outputs the lines in forward order
             _proof_writer->markExhausted();
             while (!_proof_writer->isDone()) usleep(1000*10);
             _proof_writer.reset(); // internally waits for writer to finish
         }
-    }
 
-    void reverseFile() {
-        if (!_is_root) return;
-
-        LOG(V2_INFO, "PROOFSTATS partialproofbytes=%lu partialprooflines=%lu combinedprooflines=%lu\n",
-                    _total_partial_proof_bytes, _total_partial_proof_clauses, _total_combined_proof_clauses);
-
-        if (_binary_output) {
-            // Read binary file in reverse order, output lines into new file
-            std::ofstream ofs(_output_filename, std::ofstream::binary);
-            BufferedFileWriter writer(ofs);
-            ReverseFileReader reader(_output_filename + ".inv");
-            char c;
-            while (reader.nextAsChar(c)) {
-                writer.put(c);
+        if (_checker) {
+            // waits for the remaining checks
+            bool valid = _checker->finish();
+            float time = Timer::elapsedSeconds() - _timepoint_merge_begin;
+            if (valid) {
+                LOG(V2_INFO, "PROOFCHECK valid lines=%lu time=%.3f\n", _checker->getNumCheckedLines(), time);
+            } else {
+                LOG(V0_CRIT, "[ERROR] PROOFCHECK invalid lines=%lu time=%.3f: %s\n", _checker->getNumSubmittedLines(),
+                    time, _checker->getError().c_str());
+                _proof_valid_local = 0;
+                // The process must not report success
+                Process::requestExitCode(1);
             }
-            writer.flush();
-            ofs.close();
-        } else {
-            // Just "tac" the text file
-            std::string cmd = "tac " + _output_filename + ".inv > " + _output_filename;
-            int result = system(cmd.c_str());
-            assert(result == 0);
+            _checker.reset();
         }
-        // remove original (reversed) file
-        std::string cmd = "rm " + _output_filename + ".inv";
-        int result = system(cmd.c_str());
-        assert(result == 0);
 
-        _reversed_file = true;
+        LOG(V2_INFO, "PROOFSTATS partialproofbytes=%lu partialprooflines=%lu combinedprooflines=%lu deletedids=%lu idsetbytes=%lu\n",
+                    _total_partial_proof_bytes, _total_partial_proof_clauses, _total_combined_proof_clauses,
+                    _output_ids.size(), _output_ids.getSizeInBytes());
+        _output_complete = true;
     }
 
     bool isFullyExhausted() const {
@@ -3,21 +3,21 @@
 
 #include "../serialized_lrat_line.hpp"
 #include "util/merge_source_interface.hpp"
-#include "../lrat_utils.hpp"
+#include "../lrat_batch_io.hpp"
 #include "util/spsc_blocking_ringbuffer.hpp"
 
 class ProofMergeFileInput : public MergeSourceInterface<SerializedLratLine> {
 
 private:
     std::ifstream _ifs;
-    lrat_utils::ReadBuffer _readbuf;
+    lrat_utils::LratBlockReader _reader;
 
 public:
     ProofMergeFileInput(const std::string& inputFilename) : 
-        _ifs(inputFilename, std::ios::binary), _readbuf(_ifs) {}
+        _ifs(inputFilename, std::ios::binary), _reader(_ifs) {}
 
     bool pollBlocking(SerializedLratLine& elem) override {
-        return lrat_utils::readLine(_readbuf, elem);
+        return _reader.readLine(elem);
     }
     size_t getCurrentSize() const override {
         return 0;
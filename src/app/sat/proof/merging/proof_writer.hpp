@@ -1,25 +1,25 @@
 
 #pragma once
 
-#include "../lrat_utils.hpp"
+#include "../lrat_batch_io.hpp"
+#include "util/reverse_file_writer.hpp"
 #include "util/spsc_blocking_ringbuffer.hpp"
 #include "util/sys/background_worker.hpp"
 
+// Writes the combined proof, whose lines arrive in reverse order, directly in forward order.
+// The lines are encoded in the caller's thread into batches which are filled back to front;
+// the writer thread then puts each finished batch in front of the file as a single block.
 class ProofWriter {
 
-public:
-    struct LratOutputLine {
-        enum Type {ADD, DELETE} type;
-        std::vector<uint8_t> data;
-        LratOutputLine() {}
-        LratOutputLine(Type type, std::vector<uint8_t>&& data) : type(type), data(std::move(data)) {}
-    };
-
 private:
+    static constexpr size_t BATCH_SIZE = 1<<20;
+
     const std::string _filename;
     const bool _binary;
-    std::ofstream _ofs;
-    SPSCBlockingRingbuffer<LratOutputLine> _buffer;
+    ReverseFileWriter _output;
+    lrat_utils::LratBatchEncoder _batch;
+    // Batches are swapped in and out, so their arenas are reused
+    SPSCBlockingRingbuffer<lrat_utils::LratBatchEncoder> _buffer;
     BackgroundWorker _worker;
 
     unsigned long _num_pushed_lines {0};
@@ -28,37 +28,40 @@ private:
 
 public:
     ProofWriter(const std::string& filename, bool binary) : _filename(filename), _binary(binary),
-        _ofs([&](){
-            if (_binary) {
-                return std::ofstream(_filename, std::ios::binary);
-            } else {
-                return std::ofstream(_filename);
-            }
-        }()), _buffer(131072) {
+        _output(filename), _batch(lrat_utils::LratBatchEncoder::BACKWARD, BATCH_SIZE), _buffer(16) {
         
         runWriter();
     } 
 
     void pushAdditionBlocking(SerializedLratLine& line) {
-        LratOutputLine out(LratOutputLine::ADD, std::move(line.data()));
-        _buffer.pushBlocking(out);
+        if (_binary) {
+            _batch.encodeLine(line);
+        } else {
+            std::string output = line.toStr();
+            _batch.appendRaw(output.c_str(), output.size());
+        }
         _num_pushed_lines++;
+        if (_batch.full()) pushBatch();
     }
 
     void pushDeletionBlocking(LratClauseId id, const std::vector<LratClauseId>& hintsToDelete) {
-        std::vector<uint8_t> data;
-        data.resize((1+hintsToDelete.size()) * sizeof(LratClauseId));
-        memcpy(data.data(), &id, sizeof(LratClauseId));
-        for (size_t i = 0; i < hintsToDelete.size(); i++) {
-            memcpy(data.data()+(i+1)*sizeof(LratClauseId), hintsToDelete.data()+i, sizeof(LratClauseId));
+        if (_binary) {
+            _batch.encodeDeletionLine(hintsToDelete.data(), hintsToDelete.size());
+        } else {
+            std::string delLine = std::to_string(id) + " d";
+            for (auto hint : hintsToDelete) {
+                delLine += " " + std::to_string(hint);
+            }
+            delLine += " 0\n";
+            _batch.appendRaw(delLine.c_str(), delLine.size());
         }
-        LratOutputLine out(LratOutputLine::DELETE, std::move(data));
-        _buffer.pushBlocking(out);
         _num_pushed_lines++;
+        if (_batch.full()) pushBatch();
     }
 
     void markExhausted() {
         LOG(V2_INFO, "Proof writer received full proof (%lu lines)\n", _num_pushed_lines);
+        if (!_batch.empty()) pushBatch();
         _buffer.markExhausted();
     }
 
@@ -77,52 +80,44 @@ public:
     }
 
 private:
+    void pushBatch() {
+        _buffer.pushBlocking(_batch);
+        // (we now hold a batch which was written before, or a fresh one)
+        _batch.reset(lrat_utils::LratBatchEncoder::BACKWARD);
+    }
+
     void runWriter() {
         _worker.run([&]() {
 
-            LratOutputLine line;
-            SerializedLratLine sline;
-            {
-                lrat_utils::WriteBuffer out(_ofs);
-
-                while (_worker.continueRunning() && _buffer.pollBlocking(line)) {
-                    
-                    if (line.type == LratOutputLine::ADD) {
-                        // write ADD line
-
-                        sline.data().swap(line.data);
-                        if (_binary) {
-                            lrat_utils::writeLine(out, sline, lrat_utils::REVERSED);
-                        } else {
-                            std::string output = sline.toStr();
-                            _ofs.write(output.c_str(), output.size());
-                        }
-
-                    } else {
-                        // write DELETE line
-
-                        LratClauseId id = *((LratClauseId*) line.data.data());
-                        LratClauseId* hints = (LratClauseId*) (line.data.data() + sizeof(LratClauseId));
-                        int numHints = (line.data.size() / sizeof(LratClauseId)) - 1;
-
-                        if (_binary) {
-                            lrat_utils::writeDeletionLine(out, id, hints, numHints, lrat_utils::REVERSED);
-                        } else {
-                            std::string delLine = std::to_string(id) + " d";
-                            for (int i = 0; i < numHints; i++) {
-                                delLine += " " + std::to_string(hints[i]);
-                            } 
-                            delLine += " 0\n";
-                            _ofs.write(delLine.c_str(), delLine.size());
-                        }
-                    }
-
-                    _num_written_lines++;
-                }
+            lrat_utils::LratBatchEncoder batch;
+            while (_worker.continueRunning() && _buffer.pollBlocking(batch)) {
+                _output.prepend((const char*) batch.data(), batch.size());
+                _num_written_lines += batch.getNumLines();
+                batch.clear();
             }
 
-            _ofs.flush();
+            _output.finalize([&](size_t numBytes) {return getPadding(numBytes);});
             _done = true;
         });
     }
+
+    // Lines without effect to put in front of the proof
+    std::string getPadding(size_t numBytes) const {
+        if (!_binary) return std::string(numBytes, ' ');
+        // Empty deletion lines "d 0" take two bytes each. An odd number of bytes
+        // needs a deletion of an ID which is never used (2^55, varint of nine bytes).
+        std::string padding;
+        if (numBytes % 2 == 1) {
+            if (numBytes < 11) return padding;
+            padding += 'd';
+            for (int i = 0; i < 8; i++) padding += (char) 0x80;
+            padding += (char) 0x01;
+            padding += '\0';
+        }
+        while (padding.size() < numBytes) {
+            padding += 'd';
+            padding += '\0';
+        }
+        return padding;
+    }
 };
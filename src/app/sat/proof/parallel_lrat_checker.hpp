@@ -0,0 +1,267 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "serialized_lrat_line.hpp"
+#include "util/logger.hpp"
+#include "util/robin_hood.hpp"
+#include "util/sys/proc.hpp"
+#include "util/sys/threading.hpp"
+
+/*
+Multi-threaded LRAT checker which verifies a proof while it is being streamed
+in reverse order (i.e., with decreasing clause IDs), as it is emitted by the proof merger.
+Each line is a pending check until all clauses it refers to have arrived. Since all lines
+referring to a clause arrive before the clause itself, the clause's literals are handed
+to exactly the waiting checks and released as soon as these checks are done.
+Checks whose antecedents are complete are verified via reverse unit propagation
+by a number of worker threads. Deletion information is not needed. RAT steps are
+not supported.
+*/
+class ParallelLratChecker {
+
+private:
+    typedef std::shared_ptr<const std::vector<int>> ClauseRef;
+
+    struct Check {
+        LratClauseId id;
+        std::vector<int> lits;
+        // clauses of the hints (in the order of the hints), nullptr if not yet arrived
+        std::vector<ClauseRef> hints;
+        int numUnresolved {0};
+    };
+    typedef std::vector<std::unique_ptr<Check>> CheckBatch;
+    static constexpr size_t BATCH_SIZE = 256;
+    static constexpr size_t MAX_QUEUED_BATCHES = 1024;
+
+    std::vector<ClauseRef> _original_clauses;
+
+    // (accessed only by the submitting thread)
+    LratClauseId _last_id {std::numeric_limits<LratClauseId>::max()};
+    robin_hood::unordered_flat_map<LratClauseId, std::unique_ptr<Check>> _pending_checks;
+    robin_hood::unordered_node_map<LratClauseId, std::vector<std::pair<Check*, int>>> _waiting_checks;
+    CheckBatch _ready_batch;
+    bool _derived_empty_clause {false};
+    unsigned long _num_submitted_lines {0};
+
+    std::vector<std::thread> _workers;
+    std::list<CheckBatch> _queue;
+    Mutex _queue_mutex;
+    ConditionVariable _queue_cond_var;
+    bool _input_done {false};
+
+    std::atomic_ulong _num_checked_lines {0};
+    std::atomic_bool _failed {false};
+    Mutex _error_mutex;
+    std::string _error;
+
+public:
+    // formula: the original clauses, each terminated by a zero, with IDs 1, 2, 3, ...
+    ParallelLratChecker(int numThreads, const std::vector<int>& formula) {
+        std::vector<int> clause;
+        for (int lit : formula) {
+            if (lit != 0) {
+                clause.push_back(lit);
+                continue;
+            }
+            _original_clauses.emplace_back(new std::vector<int>(clause));
+            clause.clear();
+        }
+        _ready_batch.reserve(BATCH_SIZE);
+        for (int i = 0; i < numThreads; i++) {
+            _workers.emplace_back([&]() {runWorker();});
+        }
+    }
+    ~ParallelLratChecker() {
+        stopWorkers();
+    }
+
+    // The lines must be submitted with strictly decreasing IDs.
+    void submitReversed(SerializedLratLine& line) {
+        if (_failed.load(std::memory_order_relaxed)) return;
+        _num_submitted_lines++;
+
+        const auto id = line.getId();
+        if (id <= _original_clauses.size() || id >= _last_id) {
+            fail("Line ID " + std::to_string(id) + " is not a derived ID below " + std::to_string(_last_id));
+            return;
+        }
+        _last_id = id;
+
+        std::unique_ptr<Check> check(new Check());
+        check->id = id;
+        auto [lits, numLits] = line.getLiterals();
+        check->lits.assign(lits, lits + numLits);
+        if (numLits == 0) _derived_empty_clause = true;
+
+        auto [hints, numHints] = line.getUnsignedHints();
+        auto signs = line.getSignsOfHints();
+        check->hints.resize(numHints);
+        for (int i = 0; i < numHints; i++) {
+            const auto hint = hints[i];
+            if (!signs[i] || hint == 0 || hint >= id) {
+                fail("Line ID " + std::to_string(id) + " has invalid hint " + (signs[i] ? "" : "-") + std::to_string(hint));
+                return;
+            }
+            if (hint <= _original_clauses.size()) {
+                check->hints[i] = _original_clauses[hint-1];
+            } else {
+                _waiting_checks[hint].emplace_back(check.get(), i);
+                check->numUnresolved++;
+            }
+        }
+
+        // Hand the clause to the checks which have been waiting for it
+        auto it = _waiting_checks.find(id);
+        if (it != _waiting_checks.end()) {
+            ClauseRef clause(new std::vector<int>(check->lits));
+            for (auto [waitingCheck, hintIdx] : it->second) {
+                waitingCheck->hints[hintIdx] = clause;
+                if (--waitingCheck->numUnresolved == 0) {
+                    auto pendingIt = _pending_checks.find(waitingCheck->id);
+                    dispatch(std::move(pendingIt->second));
+                    _pending_checks.erase(pendingIt);
+                }
+            }
+            _waiting_checks.erase(it);
+        }
+
+        if (check->numUnresolved == 0) dispatch(std::move(check));
+        else _pending_checks[id] = std::move(check);
+    }
+
+    // Waits until all submitted lines are checked. Returns true iff the proof
+    // is a valid refutation of the formula.
+    bool finish() {
+        if (!_ready_batch.empty()) pushBatch();
+        stopWorkers();
+        if (!_failed && !_waiting_checks.empty()) {
+            fail(std::to_string(_waiting_checks.size()) + " clause IDs (e.g., "
+                + std::to_string(_waiting_checks.begin()->first) + ") are referenced but never derived");
+        }
+        if (!_failed && !_derived_empty_clause) fail("No empty clause was derived");
+        _pending_checks.clear();
+        _waiting_checks.clear();
+        return !_failed;
+    }
+
+    unsigned long getNumSubmittedLines() const {return _num_submitted_lines;}
+    unsigned long getNumCheckedLines() const {return _num_checked_lines.load(std::memory_order_relaxed);}
+    std::string getError() {
+        auto lock = _error_mutex.getLock();
+        return _error;
+    }
+
+private:
+    void dispatch(std::unique_ptr<Check>&& check) {
+        _ready_batch.push_back(std::move(check));
+        if (_ready_batch.size() >= BATCH_SIZE) pushBatch();
+    }
+
+    void pushBatch() {
+        {
+            auto lock = _queue_mutex.getLock();
+            // Wait if the workers fall behind
+            _queue_cond_var.waitWithLockedMutex(lock, [&]() {
+                return _queue.size() < MAX_QUEUED_BATCHES || _workers.empty();
+            });
+            _queue.push_back(std::move(_ready_batch));
+        }
+        _queue_cond_var.notify();
+        _ready_batch = CheckBatch();
+        _ready_batch.reserve(BATCH_SIZE);
+    }
+
+    void stopWorkers() {
+        {
+            auto lock = _queue_mutex.getLock();
+            _input_done = true;
+        }
+        _queue_cond_var.notify();
+        for (auto& worker : _workers) worker.join();
+        _workers.clear();
+    }
+
+    void runWorker() {
+        Proc::nameThisThread("LratChecker");
+        std::vector<int8_t> assignment;
+        std::vector<int> assigned;
+        while (true) {
+            CheckBatch batch;
+            {
+                auto lock = _queue_mutex.getLock();
+                _queue_cond_var.waitWithLockedMutex(lock, [&]() {return _input_done || !_queue.empty();});
+                if (_queue.empty()) return;
+                batch = std::move(_queue.front());
+                _queue.pop_front();
+            }
+            _queue_cond_var.notify();
+            for (auto& check : batch) {
+                if (!_failed.load(std::memory_order_relaxed) && !verify(*check, assignment, assigned)) {
+                    fail("Line ID " + std::to_string(check->id) + " cannot be derived via its hints");
+                }
+                _num_checked_lines.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Reverse unit propagation: Assigning all literals of the clause to false
+    // and propagating the hints one after the other must result in a conflict.
+    bool verify(const Check& check, std::vector<int8_t>& assignment, std::vector<int>& assigned) {
+        auto value = [&](int lit) -> int {
+            const int var = std::abs(lit);
+            if (var >= (int) assignment.size()) return 0;
+            return lit > 0 ? assignment[var] : -assignment[var];
+        };
+        auto assignTrue = [&](int lit) {
+            const int var = std::abs(lit);
+            if (var >= (int) assignment.size()) assignment.resize(2*var, 0);
+            assignment[var] = lit > 0 ? 1 : -1;
+            assigned.push_back(var);
+        };
+        auto result = [&](bool valid) {
+            for (int var : assigned) assignment[var] = 0;
+            assigned.clear();
+            return valid;
+        };
+
+        for (int lit : check.lits) {
+            const int val = value(lit);
+            // a tautology is trivially implied
+            if (val == 1) return result(true);
+            if (val == 0) assignTrue(-lit);
+        }
+        for (auto& hint : check.hints) {
+            int unassignedLit = 0;
+            int numUnassigned = 0;
+            for (int lit : *hint) {
+                const int val = value(lit);
+                // a satisfied hint is not unit
+                if (val == 1) return result(false);
+                if (val == 0 && lit != unassignedLit) {
+                    unassignedLit = lit;
+                    numUnassigned++;
+                }
+            }
+            if (numUnassigned == 0) return result(true); // conflict
+            if (numUnassigned > 1) return result(false);
+            assignTrue(unassignedLit);
+        }
+        return result(false);
+    }
+
+    void fail(const std::string& error) {
+        auto lock = _error_mutex.getLock();
+        if (_failed) return;
+        _error = error;
+        _failed = true;
+    }
+};
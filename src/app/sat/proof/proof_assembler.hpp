@@ -250,13 +250,18 @@ private:
 
             // if necessary, create directory for external memory disk files 
             FileUtils::mkdir(_params.extMemDiskDirectory());
+            ExternalMemoryConfig extMemConfig;
+            extMemConfig.blockSize = _params.extMemBlockSize();
+            extMemConfig.directIo = _params.extMemDirectIo();
+            extMemConfig.backend = _params.extMemIoUring() ? AsyncBlockFile::IO_URING : AsyncBlockFile::THREADS;
+            extMemConfig.readAheadBlocks = _params.extMemReadAhead();
 
             // create proof instance
             _proof_instances.emplace_back(
                 instanceId, numInstances, _num_original_clauses, proofFilenameBase + ".lrat", 
                 _success_epoch, _winning_instance, globalIdStarts,
                 std::move(localIdStartsPerInstance[i]), std::move(localIdOffsetsPerInstance[i]),
-                _params.extMemDiskDirectory(), 
+                _params.extMemDiskDirectory(), extMemConfig,
                 _params.interleaveProofMerging() ? "" : proofFilenameBase + ".filtered.lrat"
             );
         }
@@ -3,10 +3,11 @@
 
 #include <algorithm>
 
+#include "app/sat/data/clause_metadata.hpp"
 #include "app/sat/proof/reverse_binary_lrat_parser.hpp"
 #include "external_id_priority_queue.hpp"
 #include "util/sys/thread_pool.hpp"
-#include "app/sat/proof/lrat_utils.hpp"
+#include "app/sat/proof/lrat_batch_io.hpp"
 #include "merging/proof_merge_connector.hpp"
 
 /*
@@ -31,8 +32,9 @@ private:
     bool _winning_instance;
 
     ReverseBinaryLratParser _parser;
-    SerializedLratLine _current_line;
-    bool _current_line_aligned = false;
+    ReverseBinaryLratParser::LineView _current_line;
+    bool _has_current_line = false;
+    SerializedLratLine _output_line;
     ExternalIdPriorityQueue _frontier;
     ExternalIdPriorityQueue _backlog;
 
@@ -43,7 +45,7 @@ private:
 
     std::string _output_filename;
     std::ofstream _output;
-    lrat_utils::WriteBuffer _output_buf;
+    lrat_utils::LratBatchEncoder _output_batch;
 
     std::future<void> _work_future;
     bool _work_done = true;
@@ -63,14 +65,14 @@ public:
         int winningInstance, const std::vector<LratClauseId>& globalEpochStarts, 
         std::vector<LratClauseId>&& localEpochStarts, 
         std::vector<LratClauseId>&& localEpochOffsets, const std::string& extMemDiskDir, 
-        const std::string& outputFilenameOrEmpty) :
+        const ExternalMemoryConfig& extMemConfig, const std::string& outputFilenameOrEmpty) :
             _log(Logger::getMainInstance().copy("Proof", ".proof")),
             _instance_id(instanceId), _num_instances(numInstances), 
             _original_num_clauses(originalNumClauses),
             _winning_instance(winningInstance == instanceId),
             _parser(proofFilename), 
-            _frontier(extMemDiskDir + "/disk." + std::to_string(instanceId) + ".frontier", finalEpoch),
-            _backlog(extMemDiskDir + "/disk." + std::to_string(instanceId) + ".backlog", finalEpoch),
+            _frontier(extMemDiskDir + "/disk." + std::to_string(instanceId) + ".frontier", finalEpoch, extMemConfig),
+            _backlog(extMemDiskDir + "/disk." + std::to_string(instanceId) + ".backlog", finalEpoch, extMemConfig),
             _local_epoch_starts(localEpochStarts), 
             _local_epoch_offsets(localEpochOffsets), _global_epoch_starts(globalEpochStarts),
             _current_epoch(finalEpoch), 
@@ -79,7 +81,6 @@ public:
                 if (outputFilenameOrEmpty.empty()) return std::ofstream(); 
                 else return std::ofstream(outputFilenameOrEmpty, std::ofstream::binary);
             }()),
-            _output_buf(_output),
             _interleave_merging(outputFilenameOrEmpty.empty()) {}
 
     ~ProofInstance() {
@@ -142,26 +143,20 @@ private:
         LOGGER(_log, V4_VVER, "%i reading e.%i\n", _instance_id, _current_epoch);
         int numReadLines = 0;
 
-        if (!_current_line.valid() && _parser.getNextLine(_current_line)) {
-            _current_line_aligned = false;
+        if (!_has_current_line && _parser.getNextLineView(_current_line)) {
+            _has_current_line = true;
             numReadLines++;
         } 
         
         LratClauseId id = std::numeric_limits<unsigned long>::max();
         auto formerId = id;
         int numSkippedLines = 0;
-        while (_current_line.valid()) {
+        while (_has_current_line) {
 
-            auto& alignedId = _current_line.getId();
-            auto unalignedId = alignedId;
-            auto [hints, numHints] = _current_line.getUnsignedHints();
-            auto [lits, numLits] = _current_line.getLiterals();
-
-            if (!_current_line_aligned) {
-                alignSelfProducedClauseIds(alignedId, hints, numHints, /*assertSelfProduced=*/true);
-                _current_line_aligned = true;
-            }
-            auto nextId = alignedId;
+            // Only the clause ID is decoded unless the line is needed
+            auto unalignedId = _current_line.id;
+            auto nextId = unalignedId;
+            alignClauseId(nextId, /*assertSelfProduced=*/true);
             assert(nextId <= id || log_return_false("[ERROR] Instance %i: Read clause ID %lu, expected <= %lu\n", 
                 _instance_id, nextId, id));
             formerId = id;
@@ -172,10 +167,8 @@ private:
             if (epoch > _current_epoch) {
                 // TODO fail if the current epoch isn't the final one
                 numSkippedLines++;
-                if (_parser.getNextLine(_current_line)) {
-                    _current_line_aligned = false;
-                    numReadLines++;
-                }
+                _has_current_line = _parser.getNextLineView(_current_line);
+                if (_has_current_line) numReadLines++;
                 continue;
             }
             // stop reading if a former epoch has been reached
@@ -186,13 +179,18 @@ private:
             }
 
             if ((!_frontier.empty() && _frontier.top() == id) || 
-                    (numLits == 0 && _winning_instance)) {
+                    (!_current_line.hasLiterals() && _winning_instance)) {
                 // Clause derivation is necessary for the combined proof
                 _num_traced_clauses++;
-                if (numLits == 0) {
+                if (!_current_line.hasLiterals()) {
                     LOGGER(_log, V3_VERB, "%i found \"winning\" empty clause\n", _instance_id);
                 }
 
+                _parser.decode(_current_line, _output_line);
+                auto [hints, numHints] = _output_line.getUnsignedHints();
+                alignSelfProducedClauseIds(_output_line.getId(), hints, numHints, /*assertSelfProduced=*/true);
+                assert(_output_line.getId() == id);
+
                 // Traverse clause hints
                 for (size_t i = 0; i < numHints; i++) {
                     auto hintId = hints[i];
@@ -203,7 +201,8 @@ private:
                         if (hintEpoch >= epoch) {
                             LOGGER(_log, V0_CRIT, "[ERROR] Proof %i found ext. hint %ld from epoch %i for clause %ld from epoch %i!\n", 
                                 _instance_id, hintId, hintEpoch, id, epoch);
-                            LOGGER(_log, V0_CRIT, "[ERROR] Concerned line: %s\n", _current_line.toStr().c_str());
+                            LOGGER(_log, V0_CRIT, "[ERROR] Concerned line: %s\n", _output_line.toStr().c_str());
+                            _output_batch.writeTo(_output);
                             _output.flush();
                             abort();
                         }
@@ -213,9 +212,10 @@ private:
 
                 // Output the line
                 if (_interleave_merging) {
-                    _merge_connector->pushBlocking(_current_line);
+                    _merge_connector->pushBlocking(_output_line);
                 } else {
-                    lrat_utils::writeLine(_output_buf, _current_line);
+                    _output_batch.encodeLine(_output_line);
+                    if (_output_batch.full()) _output_batch.writeTo(_output);
                 }
                 _num_output_lines++;
 
@@ -231,10 +231,8 @@ private:
             }
 
             // Get next proof line
-            if (_parser.getNextLine(_current_line)) {
-                _current_line_aligned = false;
-                numReadLines++;
-            }
+            _has_current_line = _parser.getNextLineView(_current_line);
+            if (_has_current_line) numReadLines++;
         }
 
         // print a warning if some lines needed to be skipped
@@ -255,8 +253,8 @@ private:
             // End of the procedure reached!
             
             // -- the proof file must have been read completely
-            assert(!_current_line.valid());
-            assert(!_parser.getNextLine(_current_line));
+            assert(!_has_current_line);
+            assert(!_parser.getNextLineView(_current_line));
 
             // -- there may not be any underived clauses left
             assert(_frontier.empty());
@@ -276,6 +274,10 @@ private:
                 _merge_connector->pushBlocking(serializedStatsLine);
 
                 _merge_connector->markExhausted();
+            } else {
+                // The output file is complete and ready to be merged
+                _output_batch.writeTo(_output);
+                _output.flush();
             }
 
             _finished = true;
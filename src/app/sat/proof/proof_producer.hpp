@@ -4,7 +4,7 @@
 #include "proof_assembler.hpp"
 #include "merging/distributed_proof_merger.hpp"
 #include "merging/proof_merge_connector.hpp"
-#include "util/small_merger.hpp"
+#include "util/prefetching_merge_source.hpp"
 #include "comm/job_tree_all_reduction.hpp"
 #include "app/sat/proof/merging/proof_merge_file_input.hpp"
 #include "comm/msg_queue/message_subscription.hpp"
@@ -24,6 +24,8 @@ public:
         unsigned long globalStartOfSuccessEpoch;
         float solvingTime;
         float jobAgeSinceActivation;
+        // original formula (at rank zero, if the proof is checked)
+        std::vector<int> formula;
     };
 
 private:
@@ -36,9 +38,9 @@ private:
     bool _done_assembling_proof = false;
     std::vector<int> _proof_all_reduction_result;
 
-    std::unique_ptr<DistributedProofMerger> _file_merger;
+    // (declared before the merger, which reads from them until it is destructed)
     std::vector<std::unique_ptr<MergeSourceInterface<SerializedLratLine>>> _local_merge_inputs;
-    std::unique_ptr<SmallMerger<SerializedLratLine>> _local_merger;
+    std::unique_ptr<DistributedProofMerger> _file_merger;
     std::vector<ProofMergeConnector*> _merge_connectors;
 
     float _reconstruction_time = 0;
@@ -131,6 +133,11 @@ public:
         return _done_assembling_proof;
     }
 
+    // False if the assembled proof was checked and found invalid
+    bool isProofValid() const {
+        return !_file_merger || _file_merger->isProofValid();
+    }
+
 private:
 
     std::vector<ProofMergeConnector*> setUpProofMerger(int numLocalInstances) {
@@ -149,21 +156,22 @@ private:
             
         } else {
 
-            // Populate _local_merge_inputs with local file inputs
+            // Populate _local_merge_inputs with local file inputs,
+            // each of which is parsed in a separate thread
             auto proofFiles = _proof_assembler->getProofOutputFiles();
             for (auto& proofFile : proofFiles) {
-                _local_merge_inputs.emplace_back(new ProofMergeFileInput(proofFile));
+                _local_merge_inputs.emplace_back(new PrefetchingMergeSource<SerializedLratLine>(
+                    new ProofMergeFileInput(proofFile)));
             }
         }
 
-        // Set up local merger: Merges together all local proof parts
+        // Set up distributed merge procedure, which merges the local proof parts
+        // together with the outputs of the child processes
         std::vector<MergeSourceInterface<SerializedLratLine>*> ptrs;
         for (auto& source : _local_merge_inputs) ptrs.push_back(source.get());
-        _local_merger.reset(new SmallMerger<SerializedLratLine>(ptrs));
-
-        // Set up distributed merge procedure
         _file_merger.reset(new DistributedProofMerger(MPI_COMM_WORLD, /*branchingFactor=*/6, 
-            _local_merger.get(), _params.proofOutputFile()));
+            ptrs, _params.writeProofFile() ? _params.proofOutputFile() : "",
+            _params.proofCheckThreads(), std::move(_setup.formula)));
 
         // Register callback for processing merge messages
         _subscription_merge = MessageSubscription(MSG_ADVANCE_DISTRIBUTED_FILE_MERGE, [&](MessageHandle& h) {
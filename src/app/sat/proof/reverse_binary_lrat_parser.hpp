@@ -1,249 +1,205 @@
 
 #pragma once
 
-#include "util/reverse_file_reader.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+
 #include "lrat_line.hpp"
+#include "lrat_utils.hpp"
 #include "serialized_lrat_line.hpp"
 #include "util/assert.hpp"
-
+#include "util/logger.hpp"
+
+// Reads a binary LRAT proof from its end to its beginning.
+// The file is memory-mapped and walked backwards. Since the kernel's readahead only works
+// in forward direction, it is disabled (MADV_RANDOM) and the window of pages preceding
+// the current position is prefetched explicitly (MADV_WILLNEED) while the pages behind the
+// current position are released (MADV_DONTNEED). Lines are handed out as views into the mapping,
+// so a line is only decoded if its content is actually required.
 class ReverseBinaryLratParser {
 
-private:
-    ReverseFileReader _reader;
-    std::vector<char> _num_buffer;
-    bool _exhausted = false;
-
-    enum LineParseState {
-        PARSING_ZERO, 
-        PARSING_HINTS,
-        PARSING_HINTS_MAYBE_ENDING, 
-        PARSING_LITS_AND_ID,
-        PARSING_LITS_AND_ID_MAYBE_ENDING
-    } _state = PARSING_ZERO;
+public:
+    // Anatomy of a binary LRAT proof line:
+    // a <id> <lit1> <lit2> <lit3> 0 <proof1> <proof2> 0
+    struct LineView {
+        const uint8_t* begin; // line type indicator 'a'
+        const uint8_t* literals; // first byte after the clause ID
+        const uint8_t* separator; // zero between literals and hints
+        const uint8_t* end; // one past the terminating zero
+        LratClauseId id;
+        bool hasLiterals() const {return literals != separator;}
+    };
 
-    LratLine _line;
-    SerializedLratLine _sline;
+private:
+    static constexpr uint8_t LINE_TYPE_ADD = 'a';
+    static constexpr size_t PREFETCH_WINDOW = 1<<24;
 
-    unsigned long _num_read_bytes = 0;
+    int _fd {-1};
+    const uint8_t* _data {nullptr};
+    size_t _size {0};
+    const uint8_t* _pos {nullptr}; // one past the last unread byte
+    const uint8_t* _prefetched {nullptr}; // pages from here on have been requested
+    const uint8_t* _released {nullptr}; // pages from here on have been released
 
 public:
-    ReverseBinaryLratParser(const std::string& filename) : _reader(filename) {}
-
-    bool getNextLine(SerializedLratLine& out) {
+    ReverseBinaryLratParser(const std::string& filename) {
+        _fd = open(filename.c_str(), O_RDONLY);
+        if (_fd < 0) return;
+        struct stat st;
+        if (fstat(_fd, &st) != 0 || st.st_size == 0) return;
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (map == MAP_FAILED) {
+            LOG(V0_CRIT, "[ERROR] Cannot map proof file \"%s\": %s\n", filename.c_str(), strerror(errno));
+            return;
+        }
+        _data = (const uint8_t*) map;
+        _size = st.st_size;
+        _pos = _prefetched = _released = _data + _size;
+        madvise((void*) _data, _size, MADV_RANDOM);
+        prefetch();
+    }
+    ~ReverseBinaryLratParser() {
+        if (_data) munmap((void*) _data, _size);
+        if (_fd >= 0) close(_fd);
+    }
 
-        out.clear();
-        _line.literals.clear();
-        _line.hints.clear();
-        _line.signsOfHints.clear();
-
-        if (_exhausted || !_reader.valid()) return false;
-
-        // Anatomy of a binary LRAT proof line:
-        // a <id> <lit1> <lit2> <lit3> 0 <proof1> <proof2> 0
-
-        constexpr char LINE_TYPE_ADD = 'a'; // 97 - 01100001
-
-        char byte;
-        bool readCompleteLine = false;
-        while (!readCompleteLine) {
-
-            // Fetching of next (previous) byte unsuccessful?
-            if (!_reader.nextAsChar(byte)) {
-                if (_state == PARSING_LITS_AND_ID_MAYBE_ENDING) {
-                    // File has been read completely!
-                    // Finalize last read line
-                    publishNumbers(PublishNumbersMode::LITERALS_THEN_ID);
-                    readCompleteLine = true;
-                }
-                _exhausted = true;
-                break;
-            }
-            _num_read_bytes++;
-
-            LOG(V6_DEBGV, "HANDLE_BYTE %i tbc:%s\n", (int) *((unsigned char*)&byte), 
-                isNonFinalByteOfNumber(byte) ? "yes":"no");
-
-            // Process read byte
-            switch (_state) {
-
-            case PARSING_ZERO:
-                assert(byte == 0);
-                _state = PARSING_HINTS;
-                break;
-
-            case PARSING_HINTS:
-                if (byte == 0) {
-                    // Could be separator zero transitioning to literals
-                    // OR final byte of a number.
-                    // => Decided by the next byte (isNonFinalByteOfNumber)
-                    _state = PARSING_HINTS_MAYBE_ENDING;
-                } else {
-                    // Handle a byte of a hint number
-                    handleByteOfNumber(byte);
-                }
-                break;
-
-            case PARSING_HINTS_MAYBE_ENDING:
-                if (isNonFinalByteOfNumber(byte)) {
-                    // Last read zero was not a separator but the ending of a number.
-                    handleByteOfNumber(0);
-                    _state = PARSING_HINTS;
-                } else {
-                    // Indeed transitioned to parsing literals / ID
-                    publishNumbers(PublishNumbersMode::HINTS);
-                    _state = PARSING_LITS_AND_ID;
-                }
-                handleByteOfNumber(byte);
-                break;
-
-            case PARSING_LITS_AND_ID:
-                if (byte == LINE_TYPE_ADD) {
-                    // Could be line type indicator transitioning to previous line
-                    // OR final byte of a number.
-                    // => Decided by the next byte (isNonFinalByteOfNumber)
-                    _state = PARSING_LITS_AND_ID_MAYBE_ENDING;
-                } else {
-                    // Handle a byte of a literal or clause ID
-                    handleByteOfNumber(byte);
-                }
-                break;
-
-            case PARSING_LITS_AND_ID_MAYBE_ENDING:
-                if (byte != 0 || isNonFinalByteOfNumber(byte)) {
-                    // Last read 'a' was not a line type indicator but a number's ending.
-                    handleByteOfNumber(LINE_TYPE_ADD);
-                    _state = PARSING_LITS_AND_ID;
-                    handleByteOfNumber(byte);
-                } else {
-                    // Indeed transitioned to the line's beginning.
-                    // Finalize completely read line
-                    publishNumbers(PublishNumbersMode::LITERALS_THEN_ID);
-                    readCompleteLine = true;
-                    // Begin to handle next (earlier) line
-                    _state = PARSING_HINTS;
-                }
-                break;
-            }
+    // Yields the next (i.e., previous) line of the proof. The view remains valid
+    // for the lifetime of this parser.
+    bool getNextLineView(LineView& view) {
+        if (_pos == nullptr || _pos == _data) return false;
+
+        // Terminating zero of the hints
+        view.end = _pos;
+        assert(_pos[-1] == 0);
+
+        // The separator is the first zero (from the back) which is not the final byte of a number
+        const uint8_t* zero = _pos-1;
+        do {
+            zero = findZeroBackwards(_data, zero);
+            assert(zero != nullptr);
+        } while (zero > _data && isNonFinalByteOfNumber(zero[-1]));
+        view.separator = zero;
+
+        // The line begins with an 'a' after the terminating zero of the previous line
+        // or at the file's beginning
+        const uint8_t* begin = zero;
+        while (true) {
+            zero = findZeroBackwards(_data, begin);
+            begin = zero == nullptr ? _data : zero+1;
+            if (*begin == LINE_TYPE_ADD) break;
+            assert(zero != nullptr);
+            begin = zero;
         }
+        view.begin = begin;
+        const uint8_t* pos = view.begin+1;
+        int64_t id = readSignedNumber(pos);
+        assert(id > 0);
+        view.id = id;
+        view.literals = pos;
+
+        _pos = view.begin;
+        if (_pos < _prefetched + PREFETCH_WINDOW / 2) prefetch();
+        return true;
+    }
 
-        if (readCompleteLine) {
-            _sline.reset(_line);
-            _sline.data().swap(out.data());
-            return true;
-        } else {
-            return false;
+    // Decodes the line into its serialized representation.
+    void decode(const LineView& view, SerializedLratLine& out) const {
+        // Each number ends at a byte without continuation bit
+        const int numLits = countFinalBytes(view.literals, view.separator);
+        const int numHints = countFinalBytes(view.separator+1, view.end-1);
+
+        auto& data = out.data();
+        data.resize(SerializedLratLine::getSize(numLits, numHints));
+        uint8_t* dataPtr = data.data();
+        LratClauseId id = view.id;
+        memcpy(dataPtr, &id, sizeof(LratClauseId));
+        dataPtr += sizeof(LratClauseId);
+        memcpy(dataPtr, &numLits, sizeof(int));
+        dataPtr += sizeof(int);
+
+        const uint8_t* pos = view.literals;
+        for (int i = 0; i < numLits; i++) {
+            int lit = readSignedNumber(pos);
+            memcpy(dataPtr, &lit, sizeof(int));
+            dataPtr += sizeof(int);
         }
+        assert(pos == view.separator);
+
+        memcpy(dataPtr, &numHints, sizeof(int));
+        dataPtr += sizeof(int);
+        uint8_t* signPtr = dataPtr + numHints*sizeof(LratClauseId);
+        pos = view.separator+1;
+        for (int i = 0; i < numHints; i++) {
+            int64_t hint = readSignedNumber(pos);
+            LratClauseId unsignedHint = std::abs(hint);
+            memcpy(dataPtr, &unsignedHint, sizeof(LratClauseId));
+            dataPtr += sizeof(LratClauseId);
+            *(signPtr++) = hint > 0;
+        }
+        assert(pos == view.end-1);
+    }
+
+    bool getNextLine(SerializedLratLine& out) {
+        out.clear();
+        LineView view;
+        if (!getNextLineView(view)) return false;
+        decode(view, out);
+        return true;
     }
 
     unsigned long getNumReadBytes() const {
-        return _num_read_bytes;
+        return _pos == nullptr ? 0 : (_data + _size) - _pos;
     }
 
 private:
-
-    void handleByteOfNumber(char byte) {
-        // Last byte in a number (= first read byte) must be the final byte
-        if (_num_buffer.empty()) 
-            assert(!isNonFinalByteOfNumber(byte));
-        // Append byte
-        _num_buffer.push_back(byte);
+    void prefetch() {
+        // Release the pages which have been read completely
+        const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+        const uint8_t* releaseFrom = (const uint8_t*) (((uintptr_t) _pos + PREFETCH_WINDOW + pageSize-1) & ~(pageSize-1));
+        if (releaseFrom < _released) {
+            madvise((void*) releaseFrom, _released - releaseFrom, MADV_DONTNEED);
+            _released = releaseFrom;
+        }
+        // Request the window of pages in front of the current position
+        const uint8_t* prefetchFrom = _pos - _data > (long) PREFETCH_WINDOW ? _pos - PREFETCH_WINDOW : _data;
+        prefetchFrom = (const uint8_t*) ((uintptr_t) prefetchFrom & ~(pageSize-1));
+        if (prefetchFrom < _prefetched) {
+            madvise((void*) prefetchFrom, _prefetched - prefetchFrom, MADV_WILLNEED);
+            _prefetched = prefetchFrom;
+        }
     }
 
-    enum PublishNumbersMode {HINTS, LITERALS_THEN_ID};
-    void publishNumbers(PublishNumbersMode mode) {
-        // The buffer contains the parsed bytes in reverse order.
-        // => Traverse the featured NUMBERS from the buffer's end towards its start
-        //    and handle the BYTES of each number from right to left.
-        int numberRightIdx = _num_buffer.size()-1;
-        assert(numberRightIdx >= 0);
-        int i = numberRightIdx;
-        bool firstNum = true;
-        while (i >= 0) {
-            // Done reading a number?
-            if (i == 0 || !isNonFinalByteOfNumber(_num_buffer[i])) {
-                int numberLeftIdx = i;
-
-                if (mode == HINTS) {
-                    // Publish hint
-                    auto hint = readSignedClauseId(numberLeftIdx, numberRightIdx);
-                    LOG(V6_DEBGV, "PUSH_HINT %ld [%i,%i]\n", hint, numberLeftIdx, numberRightIdx);
-                    _line.hints.push_back(std::abs(hint));
-                    _line.signsOfHints.push_back(hint>0);
-                } else if (firstNum) {
-                    // Publish ID
-                    auto id = readSignedClauseId(numberLeftIdx, numberRightIdx);
-                    assert(id > 0);
-                    LOG(V6_DEBGV, "PUSH_ID %ld [%i,%i]\n", id, numberLeftIdx, numberRightIdx);
-                    _line.id = id;
-                    firstNum = false;
-                } else {
-                    // Publish literal
-                    auto lit = readLiteral(numberLeftIdx, numberRightIdx);
-                    LOG(V6_DEBGV, "PUSH_LIT %i [%i,%i]\n", lit, numberLeftIdx, numberRightIdx);
-                    _line.literals.push_back(lit);
-                }
-
-                numberRightIdx = i-1;
-            }
-            i--;
-        }
-        _num_buffer.clear();
+    // Last zero byte in [begin, end) or nullptr
+    static const uint8_t* findZeroBackwards(const uint8_t* begin, const uint8_t* end) {
+        return (const uint8_t*) memrchr(begin, 0, end - begin);
     }
 
-    bool isNonFinalByteOfNumber(char byte) {
-        unsigned char uByte = *((unsigned char*) &byte);
-        return uByte & 0b10000000;
+    static bool isNonFinalByteOfNumber(uint8_t byte) {
+        return byte & 0b10000000;
     }
 
-    // Read a signed literal int64 in the variable-length encoding of binary DRAT/LRAT
-    // https://github.com/marijnheule/drat-trim#binary-drat-format
-    // Adapted from code by Dawn Michaelson
-    int64_t readSignedClauseId(int leftIdx, int rightIdx) {
-        int64_t unadjusted = 0;
-        int64_t coefficient = 1;
-        for (int i = rightIdx; i >= leftIdx; i--) {
-            int32_t tmp = *((unsigned char*) (_num_buffer.data()+i));
-            // continuation bit set?
-            if (tmp & 0b10000000) {
-                unadjusted += coefficient * (tmp & 0b01111111); // remove first bit
-            } else {
-                // last byte
-                unadjusted += coefficient * tmp; // first bit is 0, so can leave it
-            }
-            coefficient *= 128; // 2^7 because we essentially have 7-bit bytes
+    // Number of bytes without continuation bit in [begin, end), 8 bytes at a time
+    static int countFinalBytes(const uint8_t* begin, const uint8_t* end) {
+        int count = 0;
+        for (; begin + 8 <= end; begin += 8) {
+            uint64_t word;
+            memcpy(&word, begin, 8);
+            count += __builtin_popcountll(~word & 0x8080808080808080UL);
         }
-        int64_t id;
-        if (unadjusted % 2) { // odds map to negatives
-            id = -(unadjusted - 1) / 2;
-        } else {
-            id = unadjusted / 2;
-        }
-        return id;
+        for (; begin < end; begin++) count += !isNonFinalByteOfNumber(*begin);
+        return count;
     }
 
-    // Read a signed literal in the variable-length encoding of binary DRAT/LRAT
-    // https://github.com/marijnheule/drat-trim#binary-drat-format
-    // Adapted from code by Dawn Michaelson
-    int32_t readLiteral(int leftIdx, int rightIdx) {
-        int32_t unadjusted = 0;
-        int32_t coefficient = 1;
-        for (int i = rightIdx; i >= leftIdx; i--) {
-            int32_t tmp = *((unsigned char*) (_num_buffer.data()+i));
-            // continuation bit set?
-            if (tmp & 0b10000000) {
-                unadjusted += coefficient * (tmp & 0b01111111); // remove first bit
-            } else {
-                // last byte
-                unadjusted += coefficient * tmp; // first bit is 0, so can leave it
-            }
-            coefficient *= 128; // 2^7 because we essentially have 7-bit bytes
-        }
-        int32_t lit;
-        if (unadjusted % 2) { // odds map to negatives
-            lit = -(unadjusted - 1) / 2;
-        } else {
-            lit = unadjusted / 2;
-        }
-        return lit;
+    // Read a signed number in the variable-length encoding of binary DRAT/LRAT
+    // and advance pos to the subsequent number.
+    int64_t readSignedNumber(const uint8_t*& pos) const {
+        uint64_t unadjusted;
+        pos = lrat_utils::decodeVarint(pos, _data + _size, unadjusted);
+        assert(pos != nullptr);
+        return lrat_utils::fromVarintValue(unadjusted);
     }
 };
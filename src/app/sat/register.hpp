@@ -43,6 +43,14 @@ void register_mallob_app_sat() {
                 }
             }
             return json;
+        },
+        // Program options validator
+        [](const Parameters& params) {
+            if (params.certifiedUnsat() && !params.writeProofFile() && params.proofCheckThreads() == 0) {
+                LOG(V0_CRIT, "[ERROR] Certified UNSAT without writing (-wpf) or checking (-pct) the proof\n");
+                return false;
+            }
+            return true;
         }
     );
 }
@@ -2,8 +2,11 @@
 #pragma once
 
 #include "app/sat/data/clause.hpp"
+#include "app/sat/data/epoch_id_index.hpp"
+#include "app/sat/sharing/buffer/buffer_reader.hpp"
 #include "app/sat/solvers/portfolio_solver_interface.hpp"
 #include "util/logger.hpp"
+#include <algorithm>
 #include <fstream>
 #include <memory>
 
@@ -21,9 +24,9 @@ private:
 
 	std::vector<std::atomic_ulong*> _last_exported_clause_id; 
 	typedef std::vector<unsigned long> EpochIdList;
-	std::vector<EpochIdList> _min_epoch_ids_per_solver;
+	std::vector<EpochIdIndex> _min_epoch_ids_per_solver;
 	std::vector<EpochIdList> _id_offsets_per_solver;
-	EpochIdList _global_epoch_ids;
+	EpochIdIndex _global_epoch_ids;
 
 public:
     ClauseIdAlignment(const Logger& logger, std::vector<std::shared_ptr<PortfolioSolverInterface>>& solvers, int nbOrigClauses, int maxNbThreadsPerProcess) :
@@ -96,26 +99,6 @@ public:
 		}
     }
 
-    bool checkClauseToImport(PortfolioSolverInterface* solver, const Mallob::Clause& clause) {
-        // check via clause ID whether this solver produced this clause
-        unsigned long clauseId = ClauseMetadata::readUnsignedLong(clause.begin);
-        if (getProducingInstanceId(clauseId) == solver->getGlobalId()) {
-            // This solver produced this clause! Do not import.
-            return false;
-        }
-        // Important invariant: incoming clauses must be from EARLIER epochs
-        // than your current epoch.
-        int i = solver->getLocalId();
-        int epoch = _min_epoch_ids_per_solver[i].size()-1;
-        int clauseEpoch = ClauseMetadata::getEpoch(clauseId, _global_epoch_ids);
-        if (clauseEpoch >= epoch) {
-            LOGGER(_logger, V0_CRIT, "[ERROR] Importing clause ID=%lu from epoch %i while I am in epoch %i myself!\n", 
-                clauseId, clauseEpoch, epoch);
-            abort();
-        }
-        return true;
-    }
-
 	bool isLocallyProducedClause(unsigned long clauseId) {
 		auto globalId = getProducingInstanceId(clauseId);
 		for (auto& solver : _solvers) if (solver->getGlobalId() == globalId) return true;
@@ -149,6 +132,57 @@ public:
 		ClauseMetadata::writeUnsignedLong(alignedClauseId, clauseData);
 	}
 
+	// Aligns the clause IDs of all clauses in a buffer.
+	void alignClauseIds(BufferReader& reader) {
+		auto clause = reader.getNextIncomingClause();
+		while (clause.begin != nullptr) {
+			alignClauseId(clause.begin);
+			clause = reader.getNextIncomingClause();
+		}
+	}
+
+	// Checks all clauses of a buffer to import and writes the global ID of each clause's
+	// producing instance to producers, in the order of the reader. A solver must not
+	// import the clauses it produced itself.
+	void getProducersOfClausesToImport(BufferReader& reader, std::vector<int>& producers) {
+		// Important invariant: incoming clauses must be from EARLIER epochs
+		// than the current epoch, which all local solvers share.
+		const int epoch = _min_epoch_ids_per_solver[0].size()-1;
+		const int maxNumSolvers = _solvers[0]->getSolverSetup().maxNumSolvers;
+		producers.clear();
+		auto clause = reader.getNextIncomingClause();
+		while (clause.begin != nullptr) {
+			unsigned long clauseId = ClauseMetadata::readUnsignedLong(clause.begin);
+			int clauseEpoch = getEpochOfAlignedSelfClause(clauseId);
+			if (clauseEpoch >= epoch) {
+				LOGGER(_logger, V0_CRIT, "[ERROR] Importing clause ID=%lu from epoch %i while I am in epoch %i myself!\n", 
+					clauseId, clauseEpoch, epoch);
+				abort();
+			}
+			producers.push_back((clauseId-_num_original_clauses-1) % maxNumSolvers);
+			clause = reader.getNextIncomingClause();
+		}
+	}
+
+	// Un-aligns the clause IDs of all returned clauses in a buffer which were produced
+	// by a local solver. All other clauses cannot be un-aligned and are marked
+	// in the filter bitset (true = filtered), in the order of the reader.
+	void unalignLocallyProducedClauseIds(BufferReader& reader, std::vector<bool>& filter) {
+		std::vector<int> localInstanceIds;
+		for (auto& solver : _solvers) localInstanceIds.push_back(solver->getGlobalId());
+		const int maxNumSolvers = _solvers[0]->getSolverSetup().maxNumSolvers;
+		filter.clear();
+		auto clause = reader.getNextIncomingClause();
+		while (clause.begin != nullptr) {
+			unsigned long clauseId = ClauseMetadata::readUnsignedLong(clause.begin);
+			int producer = (clauseId-_num_original_clauses-1) % maxNumSolvers;
+			bool local = std::find(localInstanceIds.begin(), localInstanceIds.end(), producer) != localInstanceIds.end();
+			if (local) unalignClauseId(clause.begin);
+			filter.push_back(!local);
+			clause = reader.getNextIncomingClause();
+		}
+	}
+
 	void unalignClauseId(int* clauseData) {
 
 		unsigned long clauseId = ClauseMetadata::readUnsignedLong(clauseData);
@@ -172,27 +206,11 @@ public:
 
     int getEpochOfUnalignedSelfClause(unsigned long id) {
         auto producingSolver = getProducingLocalSolverIndex(id);
-        auto& epochList = _min_epoch_ids_per_solver[producingSolver];
-        // will point to 1st element >= id (or end)
-        auto it = std::lower_bound(epochList.begin(), epochList.end(), id);
-        assert(it != epochList.begin());
-        //if (it == epochList.end() || *it > id) {
-            // point to last element < id
-            --it;
-        //}
-        return std::distance(epochList.begin(), it);
+        return _min_epoch_ids_per_solver[producingSolver].getEpoch(id);
     }
 
     int getEpochOfAlignedSelfClause(unsigned long id) {
-        auto& epochList = _global_epoch_ids;
-        // will point to 1st element >= id (or end)
-        auto it = std::lower_bound(epochList.begin(), epochList.end(), id);
-        assert(it != epochList.begin());
-        //if (it == epochList.end() || *it > id) {
-            // point to last element < id
-            --it;
-        //}
-        return std::distance(epochList.begin(), it);
+        return _global_epoch_ids.getEpoch(id);
     }
 		
 	unsigned long getGlobalStartOfSuccessEpoch() {
@@ -2,7 +2,6 @@
 #pragma once
 
 #include "app/sat/sharing/buffer/buffer_reader.hpp"
-#include "app/sat/sharing/clause_id_alignment.hpp"
 #include "app/sat/sharing/filter/produced_clause_filter_commons.hpp"
 #include "app/sat/solvers/portfolio_solver_interface.hpp"
 
@@ -11,18 +10,18 @@ struct ImportingSolver {
     PortfolioSolverInterface* solver;
     SolverStatistics* solverStats;
     std::vector<bool> filter;
-
-    ClauseIdAlignment* _id_alignment {nullptr};
     
-    ImportingSolver(PortfolioSolverInterface* solver, SolverStatistics* stats, ClauseIdAlignment* idAlignment) : 
-        solver(solver), solverStats(stats), _id_alignment(idAlignment) {}
+    ImportingSolver(PortfolioSolverInterface* solver, SolverStatistics* stats) : 
+        solver(solver), solverStats(stats) {}
 
-    void appendCandidate(const Mallob::Clause& clause, cls_producers_bitset producers) {
-        filter.push_back(filterClause(clause, producers));
+    // producingInstance: global ID of the solver which produced the clause
+    // according to its clause ID, or -1 if clause IDs are disabled
+    void appendCandidate(const Mallob::Clause& clause, cls_producers_bitset producers, int producingInstance) {
+        filter.push_back(filterClause(clause, producers, producingInstance));
     }
 
 private:
-    bool filterClause(const Mallob::Clause& clause, cls_producers_bitset producers) {
+    bool filterClause(const Mallob::Clause& clause, cls_producers_bitset producers, int producingInstance) {
 
         int sid = solver->getLocalId();
         solverStats->receivedClauses++;
@@ -37,7 +36,7 @@ private:
             solverStats->receivedClausesFiltered++;
             return true;
         }
-        if (_id_alignment && !_id_alignment->checkClauseToImport(solver, clause)) {
+        if (producingInstance == solver->getGlobalId()) {
             // filtered by having an ID produced by this solver itself
             solverStats->receivedClausesFiltered++;
             return true;
@@ -247,14 +247,16 @@ int SharingManager::prepareSharing(int* begin, int totalLiteralLimit, int& succe
 
 	int numExportedClauses = 0;
 	auto buffer = _clause_store->exportBuffer(totalLiteralLimit, numExportedClauses, numLits,
-			GenericClauseStore::ANY, /*sortClauses=*/true, [&](int* data) {
-
-		// Shift clause ID from a local solver according to the solver's offset
-		if (_id_alignment) _id_alignment->alignClauseId(data);
-	});
+			GenericClauseStore::ANY, /*sortClauses=*/true);
 
 	_clause_filter->releaseAllLocks();
 
+	if (_id_alignment) {
+		// Shift clause IDs from local solvers according to the solvers' offsets
+		auto reader = _clause_store->getBufferReader(buffer.data(), buffer.size());
+		_id_alignment->alignClauseIds(reader);
+	}
+
 	if (_allocated_sharing_buffer_size >= 0 && buffer.size() > _allocated_sharing_buffer_size) {
 		LOGGER(_logger, V1_WARN, "[WARN] prepared buffer len=%i exceeds allocated size %i! Truncating ...\n",
 			(int)buffer.size(), _allocated_sharing_buffer_size);
@@ -306,24 +308,16 @@ void SharingManager::returnClauses(int* begin, int buflen) {
 		// No clause ID alignments: Can just reinsert all clauses, no questions asked
 		_clause_store->addClauses(reader, &_hist_returned_to_db);
 	} else {
-		auto c = reader.getNextIncomingClause();
-		while (c.begin != nullptr) {
-
-			// For certified UNSAT we need to drop returned clauses which do not
-			// originate from this solver, since we can not un-align them to
-			// correctly insert them into the database.
-			if (_id_alignment->isLocallyProducedClause(ClauseMetadata::readUnsignedLong(c.begin))) {
-
-				// Returned clauses would be aligned *again* when re-exported.
-				// => subtract the offsets again here ...
-				_id_alignment->unalignClauseId(c.begin);
-
-				bool success = _clause_store->addClause(c);
-				if (success) _hist_returned_to_db.increment(c.size);
-			}
-
-			c = reader.getNextIncomingClause();
-		}
+		// For certified UNSAT we need to drop returned clauses which do not
+		// originate from this solver, since we can not un-align them to
+		// correctly insert them into the database.
+		// Returned clauses would be aligned *again* when re-exported.
+		// => subtract the offsets again here ...
+		std::vector<bool> foreignClauses;
+		_id_alignment->unalignLocallyProducedClauseIds(reader, foreignClauses);
+		reader = _clause_store->getBufferReader(begin, buflen);
+		reader.setFilterBitset(foreignClauses);
+		_clause_store->addClauses(reader, &_hist_returned_to_db);
 	}
 
 	_clause_filter->releaseAllLocks(); // release filter locks again
@@ -389,7 +383,7 @@ void SharingManager::digestSharingWithFilter(int* begin, int buflen, const int*
 		auto& solver = _solvers[i];
 		if (!solver || !_solver_stats[i]) continue; // solver was cleaned up
 		if (!solver->isClauseSharingEnabled()) continue;
-		importingSolvers.emplace_back(solver.get(), _solver_stats[i], _id_alignment.get());
+		importingSolvers.emplace_back(solver.get(), _solver_stats[i]);
 	}
 
 	_last_num_cls_to_import = 0;
@@ -406,12 +400,20 @@ void SharingManager::digestSharingWithFilter(int* begin, int buflen, const int*
 	// Apply provided global filter to buffer (in-place operation)
 	applyFilterToBuffer(begin, buflen, filter);
 
+	// With clause IDs, find the producing instance of each clause
+	std::vector<int> producingInstances;
+	if (_id_alignment) {
+		auto reader = _clause_store->getBufferReader(begin, buflen);
+		_id_alignment->getProducersOfClausesToImport(reader, producingInstances);
+	}
+
 	auto reader = _clause_store->getBufferReader(begin, buflen);
 
 	_logger.log(verb+2, "DG import\n");
 
 	// For each incoming clause (which was not filtered out)
 	int filterSizeBeingLocked = -1;
+	int clauseIdx = 0;
 	auto clause = reader.getNextIncomingClause();
 	while (clause.begin != nullptr) {
 
@@ -428,11 +430,14 @@ void SharingManager::digestSharingWithFilter(int* begin, int buflen, const int*
 		// bitset of producing solvers
 		auto producers = _clause_filter->confirmSharingAndGetProducers(clause, _internal_epoch);
 
+		int producingInstance = _id_alignment ? producingInstances[clauseIdx] : -1;
+
 		// Decide for each solver whether it should receive the clause
 		for (size_t i = 0; i < importingSolvers.size(); i++) {
-			importingSolvers[i].appendCandidate(clause, producers);
+			importingSolvers[i].appendCandidate(clause, producers, producingInstance);
 		}
 
+		clauseIdx++;
 		clause = reader.getNextIncomingClause();
 	}
 	if (filterSizeBeingLocked != -1) _clause_filter->releaseLock(filterSizeBeingLocked);
@@ -28,14 +28,23 @@ Cadical::Cadical(const SolverSetup& setup)
 
 	if (setup.certifiedUnsat) {
 		//solver->set("binary", false);
-		auto ok = solver->set("proofdelete", false);
+		// Deletions are only needed for trimming the proof on the fly
+		const bool trimProof = setup.proofTrimWindow > 0;
+		auto ok = solver->set("proofdelete", trimProof);
 		if (!ok) {
 			LOGGER(_logger, V0_CRIT, "[ERROR] Cannot configure CaDiCaL for certified UNSAT. "
 				"Did you link to the correct CaDiCaL?\n");
 			abort();
 		}
 		proofFileString = setup.proofDir + "/proof." + std::to_string(setup.globalId + 1) + ".lrat";
-		solver->trace_proof(proofFileString.c_str());
+		if (trimProof) {
+			// CaDiCaL writes into a pipe from which the trimmed proof is written
+			auto pipeFileString = proofFileString + ".pipe";
+			proofTrimmer.reset(new LratOnlineTrimmer(pipeFileString, proofFileString, setup.proofTrimWindow));
+			solver->trace_proof(pipeFileString.c_str());
+		} else {
+			solver->trace_proof(proofFileString.c_str());
+		}
 	}
 }
 
@@ -176,6 +185,8 @@ SatResult Cadical::solve(size_t numAssumptions, const int* assumptions) {
 	if (ClauseMetadata::enabled()) {
 		solver->flush_proof_trace ();
 		solver->close_proof_trace ();
+		// Wait until the trimmed proof is complete
+		if (proofTrimmer) proofTrimmer->join();
 	}
 
 	switch (res) {
@@ -226,7 +237,13 @@ std::set<int> Cadical::getFailedAssumptions() {
 }
 
 void Cadical::setLearnedClauseCallback(const LearnedClauseCallback& callback) {
-	learner.setCallback(callback);
+	if (proofTrimmer) {
+		// Exported clauses can be referenced by other proofs: keep their derivations
+		learner.setCallback([this, callback](const Mallob::Clause& c, int solverId) {
+			proofTrimmer->pinClause(ClauseMetadata::readUnsignedLong(c.begin));
+			callback(c, solverId);
+		});
+	} else learner.setCallback(callback);
 	solver->connect_learner(&learner);
 }
 
@@ -16,10 +16,13 @@
 #include "cadical_terminator.hpp"
 #include "cadical_clause_export.hpp"
 #include "cadical_clause_import.hpp"
+#include "app/sat/proof/lrat_online_trimmer.hpp"
 
 class Cadical : public PortfolioSolverInterface {
 
 private:
+	// (declared before the solver, which must close its proof output first)
+	std::unique_ptr<LratOnlineTrimmer> proofTrimmer;
 	std::unique_ptr<CaDiCaL::Solver> solver;
 
 	Mutex learnMutex;
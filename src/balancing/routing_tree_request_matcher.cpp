@@ -6,6 +6,7 @@
 #include "util/logger.hpp"
 #include "core/scheduling_manager.hpp"
 #include "util/random.hpp"
+#include "util/sys/timer.hpp"
 
 const uint8_t COLL_ASSIGN_STATUS = 1;
 const uint8_t COLL_ASSIGN_REQUESTS = 2;
@@ -48,10 +49,7 @@ void RoutingTreeRequestMatcher::deserialize(const std::vector<uint8_t>& packed,
         if (epoch < _epoch) return; // obsolete!
         if (epoch > _epoch) {
             // new epoch
-            _epoch = epoch;
-            _tree.setEpoch(_epoch);
-            _child_statuses.clear();
-            _status_dirty = true;
+            beginEpoch(epoch);
         }
 
         Status status;
@@ -99,6 +97,14 @@ int RoutingTreeRequestMatcher::getDestination() {
     return destination;
 }
 
+void RoutingTreeRequestMatcher::beginEpoch(int epoch) {
+    _epoch = epoch;
+    _tree.setEpoch(_epoch);
+    _child_statuses.clear();
+    _status_dirty = true;
+    _epoch_start_time = Timer::elapsedSecondsCached();
+}
+
 void RoutingTreeRequestMatcher::resolveRequests() {
 
     if(_request_list.empty()) return;
@@ -160,6 +166,71 @@ void RoutingTreeRequestMatcher::resolveRequests() {
     resolving = false;
 }
 
+void RoutingTreeRequestMatcher::resolveRequestsInBatch() {
+
+    if (_request_list.empty()) return;
+
+    const int myRank = MyMpi::rank(MPI_COMM_WORLD);
+    const bool isRoot = _tree.getCurrentRoot() == myRank;
+    // While the idle counts of a new epoch are still being aggregated, the requests
+    // of all jobs are collected here and later sent to the parent as a single batch
+    const bool withhold = !isRoot && Timer::elapsedSecondsCached() - _epoch_start_time < _batch_window;
+
+    // Idle PEs known to be below this PE, distributed round robin over the children
+    bool selfAvailable = isIdle();
+    std::vector<int> childRanks;
+    for (const auto& [rank, status] : _child_statuses) {
+        if (status.numIdle > 0) childRanks.push_back(rank);
+    }
+    size_t childIdx = childRanks.empty() ? 0 : (size_t) (Random::rand() * childRanks.size());
+
+    std::vector<JobRequest> requestsToKeep;
+    robin_hood::unordered_map<int, std::vector<JobRequest>> requestsPerDestination;
+
+    // Requests re-added by the local callback (e.g., after a rejection) are handled in the next pass
+    auto requests = std::move(_request_list);
+    _request_list.clear();
+
+    for (const auto& req : requests) {
+        if (req.balancingEpoch < _epoch && req.requestedNodeIndex > 0) {
+            // Obsolete request: Discard
+            continue;
+        }
+        if (selfAvailable) {
+            selfAvailable = false;
+            LOG(V4_VVER, "[CA] Digest %s locally\n", req.toStr().c_str());
+            _local_request_callback(req, myRank);
+            continue;
+        }
+        int destination = -1;
+        while (destination < 0 && !childRanks.empty()) {
+            childIdx %= childRanks.size();
+            auto& status = _child_statuses[childRanks[childIdx]];
+            if (status.numIdle > 0) {
+                destination = childRanks[childIdx++];
+                status.numIdle--;
+            } else childRanks.erase(childRanks.begin() + childIdx);
+        }
+        if (destination >= 0) {
+            LOG_ADD_DEST(V4_VVER, "[CA] Send %s to dest.", destination, req.toStr().c_str());
+            requestsPerDestination[destination].push_back(req);
+            // The parent should learn that this subtree has fewer idle PEs now
+            _status_dirty = true;
+        } else if (isRoot || withhold) {
+            requestsToKeep.push_back(req);
+        } else {
+            LOG_ADD_DEST(V5_DEBG, "[CA] Send %s to parent", _tree.getCurrentParent(), req.toStr().c_str());
+            requestsPerDestination[_tree.getCurrentParent()].push_back(req);
+        }
+    }
+
+    for (auto& req : requestsToKeep) _request_list.insert(std::move(req));
+    for (auto& [rank, batch] : requestsPerDestination) {
+        LOG_ADD_DEST(V5_DEBG, "[CA] Send batch of %i requests", rank, (int) batch.size());
+        MyMpi::isend(rank, MSG_NOTIFY_ASSIGNMENT_UPDATE, serialize(batch));
+    }
+}
+
 void RoutingTreeRequestMatcher::addJobRequest(JobRequest& req) {
     if (req.balancingEpoch < _epoch && req.requestedNodeIndex > 0) return; // discard
     LOG(V5_DEBG, "[CA] Add req. %s\n", req.toStr().c_str());
@@ -179,20 +250,20 @@ void RoutingTreeRequestMatcher::advance(int epoch) {
     if (_job_registry == nullptr) return;
     bool newEpoch = epoch > _epoch;
 
-    if (newEpoch) {
-        _epoch = epoch;
-        _tree.setEpoch(_epoch);
-        _child_statuses.clear();
-        _status_dirty = true;
-    }
+    if (newEpoch) beginEpoch(epoch);
     
-    resolveRequests();
+    if (_batched) resolveRequestsInBatch();
+    else resolveRequests();
 
     if (_status_dirty) {
         auto status = getAggregatedStatus();
         if (MyMpi::rank(MPI_COMM_WORLD) == _tree.getCurrentRoot()) {
             LOG(V3_VERB, "[CA] Root: %i requests, %i idle (epoch=%i)\n", _request_list.size(), status.numIdle, _epoch);
+        } else if (_batched && _last_sent_epoch == _epoch && _last_sent_num_idle == status.numIdle) {
+            // The parent already knows this status: no need to announce it again
         } else {
+            _last_sent_epoch = _epoch;
+            _last_sent_num_idle = status.numIdle;
             auto packedStatus = serialize(status);
             LOG_ADD_DEST(V5_DEBG, "[CA] Prop. status: %i idle (epoch=%i)", _tree.getCurrentParent(), status.numIdle, _epoch);
             MyMpi::isend(_tree.getCurrentParent(), MSG_NOTIFY_ASSIGNMENT_UPDATE, std::move(packedStatus));
@@ -8,6 +8,7 @@
 #include "comm/mympi.hpp"
 #include "request_matcher.hpp"
 #include "comm/randomized_routing_tree.hpp"
+#include "util/params.hpp"
 
 class RoutingTreeRequestMatcher : public RequestMatcher {
 
@@ -19,13 +20,22 @@ private:
     std::set<JobRequest> _request_list;
 
     RandomizedRoutingTree& _tree;
+
+    // Batched matching: all requests present at a PE are matched with the idle
+    // PEs below it in a single pass, and at the start of an epoch, requests are
+    // withheld from the parent until the subtree's idle counts have arrived
+    bool _batched;
+    float _batch_window;
+    float _epoch_start_time {0};
+    int _last_sent_epoch {-1};
+    int _last_sent_num_idle {-1};
     
 public:
     RoutingTreeRequestMatcher(JobRegistry& jobRegistry, MPI_Comm workersComm, 
-            RandomizedRoutingTree& tree, 
+            RandomizedRoutingTree& tree, const Parameters& params,
             std::function<void(const JobRequest&, int)> localRequestCallback) : 
         RequestMatcher(jobRegistry, workersComm, localRequestCallback),
-        _tree(tree) {}
+        _tree(tree), _batched(params.batchedMatching()), _batch_window(params.batchedMatchingWindow()) {}
     virtual ~RoutingTreeRequestMatcher() {}
 
     virtual void handle(MessageHandle& handle) override;
@@ -39,7 +49,9 @@ private:
     std::vector<uint8_t> serialize(const std::vector<JobRequest>& requests);
     void deserialize(const std::vector<uint8_t>& packed, int source);
 
+    void beginEpoch(int epoch);
     void resolveRequests();
+    void resolveRequestsInBatch();
 
     int getDestination();
 };
@@ -94,6 +94,11 @@ public:
         _sysstate = new SysState<4>(_comm, /*periodSeconds=*/1, SysState<4>::ALLGATHER);
     }
 
+    int getNumProcessesOnHost() const {
+        if (_sysstate != nullptr) return MyMpi::size(_comm);
+        return std::max(1, _params.processesPerHost());
+    }
+
     void setRamUsageThisWorkerGbs(float ramGbs) {
         _ram_usage_this_worker_gb = ramGbs;
     }
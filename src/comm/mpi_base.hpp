@@ -2,9 +2,14 @@
 #ifndef DOMPASCH_MALLOB_MPI_BASE_HPP
 #define DOMPASCH_MALLOB_MPI_BASE_HPP
 
+#ifdef MALLOB_SIMULATED_MPI
+// In-process stand-in for the scheduler simulation (see sim/simulated_mpi.h)
+#include "sim/simulated_mpi.h"
+#else
 // Turn off incompatible function types warning in openmpi
 #define OMPI_SKIP_MPICXX 1
 #include <mpi.h>
+#endif
 
 #define MPICALL(cmd, str) {int err = cmd; chkerr(err);}
 void chkerr(int err);
@@ -24,24 +24,35 @@ public:
     RandomizedRoutingTree(Parameters& params, MPI_Comm& comm) : _params(params), _comm(comm) {
         _world_rank = MyMpi::rank(_comm);
         _num_workers = MyMpi::size(_comm);
-        init();
+        init(AdjustablePermutation::getPermutations(_num_workers, getNumBounceAlternatives(params, _num_workers)));
+    }
+    // Construct the tree from permutations which have already been drawn (and must be identical
+    // for all workers), e.g., for many simulated workers within a single process
+    RandomizedRoutingTree(Parameters& params, MPI_Comm& comm, const std::vector<std::vector<int>>& permutations) : 
+            _params(params), _comm(comm) {
+        _world_rank = MyMpi::rank(_comm);
+        _num_workers = MyMpi::size(_comm);
+        init(permutations);
     }
 
-    void init() {
-
+    static int getNumBounceAlternatives(Parameters& params, int numWorkers) {
         // Pick fixed number k of bounce destinations
-        int numBounceAlternatives = _params.numBounceAlternatives();
-        _num_workers = MyMpi::size(_comm);
+        int numBounceAlternatives = params.numBounceAlternatives();
         
         // Check validity of num bounce alternatives
-        if (2*numBounceAlternatives > _num_workers) {
-            numBounceAlternatives = std::max(1, _num_workers / 2);
+        if (2*numBounceAlternatives > numWorkers) {
+            numBounceAlternatives = std::max(1, numWorkers / 2);
             LOG(V1_WARN, "[WARN] Num bounce alternatives must be at most half the number of workers!\n");
             LOG(V1_WARN, "[WARN] Falling back to safe value r=%i.\n", numBounceAlternatives);
-        }  
+        }
+        return numBounceAlternatives;
+    }
+
+    void init(const std::vector<std::vector<int>>& permutations) {
+
+        int numBounceAlternatives = permutations.size();
 
         // Create graph, get outgoing edges from this node
-        auto permutations = AdjustablePermutation::getPermutations(_num_workers, numBounceAlternatives);
         _hop_destinations = AdjustablePermutation::createExpanderGraph(permutations, _world_rank);
         
         // Output found bounce alternatives
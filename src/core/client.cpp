@@ -25,6 +25,7 @@
 #include "app/app_registry.hpp"
 #include "util/sys/tmpdir.hpp"
 #include "util/sys/watchdog.hpp"
+#include "core/memory_budget.hpp"
 
 #include "interface/socket/socket_connector.hpp"
 #include "interface/filesystem/naive_filesystem_connector.hpp"
@@ -39,139 +40,78 @@ void Client::readIncomingJobs() {
     LOGGER(log, V3_VERB, "Starting\n");
 
     std::vector<std::future<void>> taskFutures;
-    std::set<std::pair<int, int>> unreadyJobs;
 
     while (true) {
-        // Wait for a nonempty incoming job queue
-        _incoming_job_cond_var.wait(_incoming_job_lock, [&]() {
+        // Wait until some job may be admissible. Periodically wake up to process
+        // events concerning awaited job description files.
+        _incoming_job_cond_var.waitWithTimeout(_incoming_job_lock, 100, [&]() {
             return !_instance_reader.continueRunning() 
-                || (_num_incoming_jobs > 0 && _num_loaded_jobs < _params.loadedJobsPerClient());
+                || (_num_loaded_jobs < _params.loadedJobsPerClient()
+                    && _incoming_job_queue.hasCandidate(Timer::elapsedSeconds()));
         });
         if (!_instance_reader.continueRunning()) break;
         if (_num_loaded_jobs >= _params.loadedJobsPerClient()) continue;
 
-        // Obtain lock, measure time
-        auto lock = _incoming_job_lock.getLock();
-        float time = Timer::elapsedSeconds();
-
-        auto checkUnready = [&](const std::unique_ptr<JobDescription>& desc) {
-            auto pair = std::pair<int, int>(desc->getId(), desc->getRevision());
-            if (!unreadyJobs.count(pair)) {
-                LOGGER(log, V2_INFO, "Deferring #%i rev. %i\n", pair.first, pair.second);
-                unreadyJobs.insert(pair);
-            }
-        };
+        // Obtain lock, extract a single job eligible for parsing
+        std::optional<JobMetadata> optJob;
+        {
+            auto lock = _incoming_job_lock.getLock();
+            optJob = _incoming_job_queue.poll(Timer::elapsedSeconds(), log);
+        }
+        if (!optJob) continue;
+        auto& data = optJob.value();
 
-        // Find a single job eligible for parsing
-        bool foundAJob = false;
-        for (auto& data : _incoming_job_queue) {
-            
-            // Jobs are sorted by arrival:
-            // If this job has not arrived yet, then none have arrived yet
-            if (time < data.description->getArrival()) {
-                checkUnready(data.description);
-                continue;
-            }
+        if (data.description->isIncremental() && data.description->getRevision() > 0) {
+            // The precursor of this incremental job is done: adopt its checksum
+            auto lock = _done_job_lock.getLock();
+            data.description->setChecksum(_done_jobs[data.description->getId()].lastChecksum);
+        }
 
-            // Check job's dependencies
-            bool dependenciesSatisfied = true;
-            {
-                auto lock = _done_job_lock.getLock();
-                for (int jobId : data.dependencies) {
-                    if (!_done_jobs.count(jobId)) {
-                        dependenciesSatisfied = false;
-                        break;
-                    }
-                }
-                if (data.description->isIncremental() && data.description->getRevision() > 0) {
-                    // Check if the precursor of this incremental job is already done
-                    if (!_done_jobs.count(data.description->getId()))
-                        dependenciesSatisfied = false; // no job with this ID is done yet
-                    else if (data.description->getRevision() != _done_jobs[data.description->getId()].revision+1)
-                        dependenciesSatisfied = false; // job with correct revision not done yet
-                    else {
-                        data.description->setChecksum(_done_jobs[data.description->getId()].lastChecksum);
-                    }
-                }
-            }
-            if (!dependenciesSatisfied) {
-                checkUnready(data.description);
-                continue;
-            }
+        // Job can be read: Enqueue reader task into thread pool
+        LOGGER(log, V4_VVER, "ENQUEUE #%i\n", data.description->getId());
 
-            // Check if all job descriptions are already present
-            bool jobDescriptionsPresent = true;
-            for (auto& file : data.files) {
-                if (!FileUtils::exists(file)) {
-                    jobDescriptionsPresent = false;
-                    break;
-                }
-            }
-            if (!jobDescriptionsPresent) {
-                // Print out waiting message every second
-                if (time - data.lastDescriptionAvailabilityCheck >= 1) {
-                    LOGGER(log, V2_INFO, "Waiting for a job description of #%i rev. %i\n", 
-                        data.description->getId(),
-                        data.description->getRevision());
-                    data.lastDescriptionAvailabilityCheck = time;
-                }
-                continue;
+        auto future = ProcessWideThreadPool::get().addTask(
+            [this, &log, foundJobPtr = new JobMetadata(std::move(data))]() mutable {
+            
+            auto& foundJob = *foundJobPtr;
+            if (!_instance_reader.continueRunning()) return;
+            
+            // Read job
+            int id = foundJob.description->getId();
+            float time = Timer::elapsedSeconds();
+            bool success = false;
+            auto filesList = foundJob.getFilesList();
+            foundJob.description->beginInitialization(foundJob.description->getRevision());
+            if (foundJob.hasFiles()) {
+                LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i %s ...\n", id, foundJob.description->getRevision(), filesList.c_str());
+                success = app_registry::getJobReader(foundJob.description->getApplicationId())(
+                    _params, foundJob.files, *foundJob.description
+                );
             }
-
-            // Job can be read: Enqueue reader task into thread pool
-            LOGGER(log, V4_VVER, "ENQUEUE #%i\n", data.description->getId());
-            unreadyJobs.erase(std::pair<int, int>(data.description->getId(), data.description->getRevision()));
-
-            auto node = _incoming_job_queue.extract(data);
-            auto future = ProcessWideThreadPool::get().addTask(
-                [this, &log, foundJobPtr = new JobMetadata(std::move(node.value()))]() mutable {
-                
-                auto& foundJob = *foundJobPtr;
-                if (!_instance_reader.continueRunning()) return;
+            foundJob.description->endInitialization();
+            if (!success) {
+                LOGGER(log, V1_WARN, "[T] [WARN] Unsuccessful read - skipping #%i\n", id);
+                auto lock = _failed_job_lock.getLock();
+                _failed_job_queue.push_back(foundJob.jobName);
+                atomics::incrementRelaxed(_num_failed_jobs);
+            } else {
+                time = Timer::elapsedSeconds() - time;
+                LOGGER(log, V3_VERB, "[T] Initialized job #%i %s in %.3fs: %ld lits w/ separators, %ld assumptions\n", 
+                        id, filesList.c_str(), time, foundJob.description->getNumFormulaLiterals(), 
+                        foundJob.description->getNumAssumptionLiterals());
+                foundJob.description->getStatistics().parseTime = time;
                 
-                // Read job
-                int id = foundJob.description->getId();
-                float time = Timer::elapsedSeconds();
-                bool success = false;
-                auto filesList = foundJob.getFilesList();
-                foundJob.description->beginInitialization(foundJob.description->getRevision());
-                if (foundJob.hasFiles()) {
-                    LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i %s ...\n", id, foundJob.description->getRevision(), filesList.c_str());
-                    success = app_registry::getJobReader(foundJob.description->getApplicationId())(
-                        _params, foundJob.files, *foundJob.description
-                    );
-                }
-                foundJob.description->endInitialization();
-                if (!success) {
-                    LOGGER(log, V1_WARN, "[T] [WARN] Unsuccessful read - skipping #%i\n", id);
-                    auto lock = _failed_job_lock.getLock();
-                    _failed_job_queue.push_back(foundJob.jobName);
-                    atomics::incrementRelaxed(_num_failed_jobs);
-                } else {
-                    time = Timer::elapsedSeconds() - time;
-                    LOGGER(log, V3_VERB, "[T] Initialized job #%i %s in %.3fs: %ld lits w/ separators, %ld assumptions\n", 
-                            id, filesList.c_str(), time, foundJob.description->getNumFormulaLiterals(), 
-                            foundJob.description->getNumAssumptionLiterals());
-                    foundJob.description->getStatistics().parseTime = time;
-                    
-                    // Enqueue in ready jobs
-                    auto lock = _ready_job_lock.getLock();
-                    _ready_job_queue.push_back(std::move(foundJob.description));
-                    atomics::incrementRelaxed(_num_ready_jobs);
-                    atomics::incrementRelaxed(_num_loaded_jobs);
-                    _sys_state.addLocal(SYSSTATE_PARSED_JOBS, 1);
-                }
-
-                delete foundJobPtr;
-            });
-            taskFutures.push_back(std::move(future));
-            foundAJob = true;
-            break;
-        }
+                // Enqueue in ready jobs
+                auto lock = _ready_job_lock.getLock();
+                _ready_job_queue.push_back(std::move(foundJob.description));
+                atomics::incrementRelaxed(_num_ready_jobs);
+                atomics::incrementRelaxed(_num_loaded_jobs);
+                _sys_state.addLocal(SYSSTATE_PARSED_JOBS, 1);
+            }
 
-        if (foundAJob) {
-            _num_incoming_jobs--;
-        }
+            delete foundJobPtr;
+        });
+        taskFutures.push_back(std::move(future));
     }
 
     LOGGER(log, V3_VERB, "Stopping\n");
@@ -207,8 +147,7 @@ void Client::handleNewJob(JobMetadata&& data) {
     }
     {
         auto lock = _incoming_job_lock.getLock();
-        _incoming_job_queue.insert(std::move(data));
-        _num_incoming_jobs++;
+        _incoming_job_queue.insert(std::move(data), Logger::getMainInstance());
     }
     _incoming_job_cond_var.notify();
     _sys_state.addLocal(SYSSTATE_ENTERED_JOBS, 1);
@@ -473,6 +412,8 @@ void Client::introduceNextJob() {
         /*requestedNodeIndex=*/0, /*timeOfBirth=*/time, /*balancingEpoch=*/-1, /*numHops=*/0, job.isIncremental());
     req.revision = job.getRevision();
     req.timeOfBirth = job.getArrival();
+    req.memoryEstimateMbs = MemoryBudget::estimateMbs(job.getNumFormulaLiterals(), 
+        _params.numThreadsPerProcess(), _params);
 
     LOG_ADD_DEST(V2_INFO, "Introducing job #%i rev. %i : %s", nodeRank, jobId, req.revision, req.toStr().c_str());
     if (job.isIncremental() && req.revision > 0) {
@@ -634,9 +575,15 @@ void Client::handleAbort(MessageHandle& handle) {
 void Client::finishJob(int jobId, bool hasIncrementalSuccessors) {
 
     // Clean up job, remember as done
+    int revision = _active_jobs[jobId]->getRevision();
     {
         auto lock = _done_job_lock.getLock();
-        _done_jobs[jobId] = DoneInfo{_active_jobs[jobId]->getRevision(), _active_jobs[jobId]->getChecksum()};
+        _done_jobs[jobId] = DoneInfo{revision, _active_jobs[jobId]->getChecksum()};
+    }
+    {
+        // Release incoming jobs which depend on this job (revision)
+        auto lock = _incoming_job_lock.getLock();
+        _incoming_job_queue.markDone(jobId, revision);
     }
     if (!hasIncrementalSuccessors) {
         _root_nodes.erase(jobId);
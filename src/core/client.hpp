@@ -18,6 +18,7 @@
 #include "util/periodic_event.hpp"
 #include "interface/api/api_connector.hpp"
 #include "comm/msg_queue/message_subscription.hpp"
+#include "core/job_admission_queue.hpp"
 
 #define SYSSTATE_ENTERED_JOBS 0
 #define SYSSTATE_PARSED_JOBS 1
@@ -25,14 +26,6 @@
 #define SYSSTATE_PROCESSED_JOBS 3
 #define SYSSTATE_SUCCESSFUL_JOBS 4
 
-struct JobByArrivalComparator {
-    inline bool operator() (const JobMetadata& struct1, const JobMetadata& struct2) const {
-        if (struct1.description->getArrival() != struct2.description->getArrival())
-            return (struct1.description->getArrival() < struct2.description->getArrival());
-        return struct1.description->getId() < struct2.description->getId();
-    }
-};
-
 /*
 Primary actor in the system who is responsible for introducing jobs from an external interface
 and reporting results back over this interface. There is at most one Client instance for each PE.
@@ -49,8 +42,7 @@ private:
     // For incoming job meta data. Full instance is NOT read yet.
     // Filled from JobFileAdapter, emptied by instance reader thread,
     // ready jobs are put in the ready queue.
-    std::set<JobMetadata, JobByArrivalComparator> _incoming_job_queue;
-    std::atomic_int _num_incoming_jobs = 0;
+    JobAdmissionQueue _incoming_job_queue;
     // Safeguards _incoming_job_queue.
     Mutex _incoming_job_lock;
     ConditionVariable _incoming_job_cond_var;
@@ -0,0 +1,260 @@
+
+#pragma once
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <limits>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "data/job_metadata.hpp"
+#include "util/hashing.hpp"
+#include "util/logger.hpp"
+#include "util/robin_hood.hpp"
+#include "util/sys/fileutils.hpp"
+
+/*
+Event-driven admission structure for incoming jobs of a client.
+A job passes through three stages before it may be read:
+(1) waiting for its dependencies and (if incremental) its precursor revision,
+(2) waiting for its arrival time, and (3) waiting for its description files to appear.
+Each job is registered only with the events it is waiting for: finished jobs release
+their dependents, arrived jobs are taken from an arrival-ordered set, and missing
+files are watched via inotify instead of being polled. Therefore, admitting a job
+costs O(log n) for n queued jobs plus the size of its own dependency list.
+Not thread-safe: all calls must be protected by the owner.
+*/
+class JobAdmissionQueue {
+
+private:
+    struct Entry {
+        JobMetadata data;
+        int numPendingPrerequisites {0};
+        std::string awaitedFile;
+    };
+
+    // All queued jobs, indexed by a running ticket number
+    robin_hood::unordered_node_map<long, Entry> _entries;
+    long _running_ticket {0};
+
+    // Stage (1): jobs waiting for any revision of a job / for a precise job revision
+    robin_hood::unordered_map<int, std::vector<long>> _dependency_waiters;
+    robin_hood::unordered_map<std::pair<int, int>, long, IntPairHasher> _precursor_waiters;
+    robin_hood::unordered_map<int, int> _latest_done_revision;
+
+    // Stage (2): jobs with satisfied prerequisites, ordered by arrival time
+    std::set<std::pair<float, long>> _by_arrival;
+
+    // Stage (3): jobs waiting for a file to appear
+    int _inotify_fd {-1};
+    robin_hood::unordered_map<std::string, std::vector<long>> _file_waiters;
+    robin_hood::unordered_map<std::string, std::pair<int, int>> _dir_to_watch_and_refcount;
+    robin_hood::unordered_map<int, std::string> _watch_to_dir;
+    // Jobs whose files cannot be watched are re-checked periodically
+    std::set<long> _unwatched;
+    float _last_unwatched_check {0};
+    const float _unwatched_check_period {1.0};
+
+public:
+    JobAdmissionQueue() {
+        _inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+    ~JobAdmissionQueue() {
+        if (_inotify_fd >= 0) ::close(_inotify_fd);
+    }
+
+    void insert(JobMetadata&& data, Logger& log) {
+        long ticket = _running_ticket++;
+        auto& entry = _entries[ticket];
+        entry.data = std::move(data);
+        auto& desc = *entry.data.description;
+
+        for (int depId : entry.data.dependencies) {
+            if (_latest_done_revision.count(depId)) continue;
+            _dependency_waiters[depId].push_back(ticket);
+            entry.numPendingPrerequisites++;
+        }
+        if (desc.isIncremental() && desc.getRevision() > 0) {
+            auto it = _latest_done_revision.find(desc.getId());
+            if (it == _latest_done_revision.end() || it->second != desc.getRevision()-1) {
+                _precursor_waiters[std::pair<int, int>(desc.getId(), desc.getRevision()-1)] = ticket;
+                entry.numPendingPrerequisites++;
+            }
+        }
+
+        if (entry.numPendingPrerequisites == 0) {
+            _by_arrival.insert({desc.getArrival(), ticket});
+        } else {
+            LOGGER(log, V3_VERB, "Deferring #%i rev. %i\n", desc.getId(), desc.getRevision());
+        }
+    }
+
+    // Report that the given revision of a job is done, releasing all jobs waiting for it.
+    void markDone(int jobId, int revision) {
+        _latest_done_revision[jobId] = revision;
+
+        auto depIt = _dependency_waiters.find(jobId);
+        if (depIt != _dependency_waiters.end()) {
+            for (long ticket : depIt->second) releasePrerequisite(ticket);
+            _dependency_waiters.erase(depIt);
+        }
+        auto precIt = _precursor_waiters.find(std::pair<int, int>(jobId, revision));
+        if (precIt != _precursor_waiters.end()) {
+            long ticket = precIt->second;
+            _precursor_waiters.erase(precIt);
+            releasePrerequisite(ticket);
+        }
+    }
+
+    // Whether a call to poll() may be successful at the given time.
+    bool hasCandidate(float time) {
+        processFileEvents();
+        if (!_unwatched.empty() && time - _last_unwatched_check >= _unwatched_check_period) return true;
+        return !_by_arrival.empty() && _by_arrival.begin()->first <= time;
+    }
+
+    // Extract the next job (in order of arrival) which has arrived, whose prerequisites are
+    // satisfied, and whose description files are present.
+    std::optional<JobMetadata> poll(float time, Logger& log) {
+        processFileEvents();
+        if (!_unwatched.empty() && time - _last_unwatched_check >= _unwatched_check_period) {
+            recheckUnwatched();
+            _last_unwatched_check = time;
+        }
+
+        while (!_by_arrival.empty()) {
+            auto [arrival, ticket] = *_by_arrival.begin();
+            // Jobs are sorted by arrival: If this job has not arrived yet, then none have
+            if (arrival > time) break;
+            _by_arrival.erase(_by_arrival.begin());
+
+            auto& entry = _entries.at(ticket);
+            auto missingFile = findMissingFile(entry.data);
+            if (missingFile) {
+                LOGGER(log, V2_INFO, "Waiting for a job description of #%i rev. %i\n",
+                    entry.data.description->getId(), entry.data.description->getRevision());
+                awaitFile(ticket, missingFile.value(), log);
+                continue;
+            }
+
+            JobMetadata result = std::move(entry.data);
+            _entries.erase(ticket);
+            return result;
+        }
+        return std::optional<JobMetadata>();
+    }
+
+    size_t size() const {
+        return _entries.size();
+    }
+    size_t numWaitingForFiles() const {
+        size_t n = _unwatched.size();
+        for (auto& [file, tickets] : _file_waiters) n += tickets.size();
+        return n;
+    }
+
+private:
+    void releasePrerequisite(long ticket) {
+        auto& entry = _entries.at(ticket);
+        entry.numPendingPrerequisites--;
+        if (entry.numPendingPrerequisites == 0)
+            _by_arrival.insert({entry.data.description->getArrival(), ticket});
+    }
+
+    std::optional<std::string> findMissingFile(const JobMetadata& data) const {
+        for (auto& file : data.files) {
+            if (!FileUtils::exists(file)) return file;
+        }
+        return std::optional<std::string>();
+    }
+
+    void awaitFile(long ticket, const std::string& file, Logger& log) {
+        auto& entry = _entries.at(ticket);
+        entry.awaitedFile = file;
+
+        auto dir = getDirectory(file);
+        auto it = _dir_to_watch_and_refcount.find(dir);
+        if (it == _dir_to_watch_and_refcount.end()) {
+            int wd = _inotify_fd < 0 ? -1 : inotify_add_watch(_inotify_fd, dir.c_str(),
+                IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE);
+            if (wd < 0) {
+                // Cannot watch this directory (yet): fall back to periodic checks
+                LOGGER(log, V4_VVER, "Cannot watch %s - checking periodically\n", dir.c_str());
+                _unwatched.insert(ticket);
+                return;
+            }
+            it = _dir_to_watch_and_refcount.emplace(dir, std::pair<int, int>(wd, 0)).first;
+            _watch_to_dir[wd] = dir;
+        }
+        it->second.second++;
+        auto key = dir + "/" + getBasename(file);
+        _file_waiters[key].push_back(ticket);
+
+        // The file may have appeared just before the watch was set up
+        if (FileUtils::exists(file)) onFileAppeared(key);
+    }
+
+    void processFileEvents() {
+        if (_inotify_fd < 0 || _file_waiters.empty()) return;
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            auto len = ::read(_inotify_fd, buffer, sizeof(buffer));
+            if (len <= 0) break;
+            for (char* ptr = buffer; ptr < buffer + len; ) {
+                auto event = (inotify_event*) ptr;
+                ptr += sizeof(inotify_event) + event->len;
+                auto dirIt = _watch_to_dir.find(event->wd);
+                if (dirIt == _watch_to_dir.end() || event->len == 0) continue;
+                onFileAppeared(dirIt->second + "/" + std::string(event->name));
+            }
+        }
+    }
+
+    // The file is identified by its watched directory + "/" + its base name
+    void onFileAppeared(const std::string& key) {
+        auto it = _file_waiters.find(key);
+        if (it == _file_waiters.end()) return;
+        auto tickets = std::move(it->second);
+        _file_waiters.erase(it);
+        unrefDirectory(getDirectory(key), tickets.size());
+        // Back to the arrival-ordered stage: the next poll() re-checks all files of the job
+        for (long ticket : tickets) {
+            auto& entry = _entries.at(ticket);
+            entry.awaitedFile.clear();
+            _by_arrival.insert({entry.data.description->getArrival(), ticket});
+        }
+    }
+
+    void recheckUnwatched() {
+        for (auto it = _unwatched.begin(); it != _unwatched.end(); ) {
+            auto& entry = _entries.at(*it);
+            if (FileUtils::exists(entry.awaitedFile)) {
+                entry.awaitedFile.clear();
+                _by_arrival.insert({entry.data.description->getArrival(), *it});
+                it = _unwatched.erase(it);
+            } else ++it;
+        }
+    }
+
+    void unrefDirectory(const std::string& dir, int count) {
+        auto it = _dir_to_watch_and_refcount.find(dir);
+        if (it == _dir_to_watch_and_refcount.end()) return;
+        it->second.second -= count;
+        if (it->second.second > 0) return;
+        inotify_rm_watch(_inotify_fd, it->second.first);
+        _watch_to_dir.erase(it->second.first);
+        _dir_to_watch_and_refcount.erase(it);
+    }
+
+    static std::string getDirectory(const std::string& file) {
+        auto pos = file.rfind('/');
+        if (pos == std::string::npos) return ".";
+        if (pos == 0) return "/";
+        return file.substr(0, pos);
+    }
+    static std::string getBasename(const std::string& file) {
+        auto pos = file.rfind('/');
+        return pos == std::string::npos ? file : file.substr(pos+1);
+    }
+};
@@ -60,7 +60,7 @@ public:
         if (!valid) {
             // Need to clean up shared pointer concurrently 
             // because it might take too much time in the main thread
-            ProcessWideThreadPool::get().addTask([sharedPtr = std::move(dataPtr)]() mutable {
+            ProcessWideThreadPool::get().addDetachedTask([sharedPtr = std::move(dataPtr)]() mutable {
                 sharedPtr.reset();
             });
             return false;
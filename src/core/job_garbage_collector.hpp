@@ -11,6 +11,8 @@
 class JobGarbageCollector {
 
 private:
+    // Whether jobs are freed by a separate janitor thread (or directly in the main thread)
+    const bool _use_janitor;
     BackgroundWorker _worker;
     std::list<Job*> _job_destruct_queue;
     std::list<Job*> _jobs_to_free;
@@ -19,7 +21,8 @@ private:
     std::atomic_int _num_stored_jobs = 0;
 
 public:
-    JobGarbageCollector() {
+    JobGarbageCollector(bool useJanitor = true) : _use_janitor(useJanitor) {
+        if (!_use_janitor) return;
         _worker.run([&]() {
             Proc::nameThisThread("JobJanitor");
             run();
@@ -41,13 +44,17 @@ public:
             Job* job = *it;
             if (job->isDestructible()) {
                 LOG(V4_VVER, "%s ready for destruction\n", job->toStr());
+                it = _job_destruct_queue.erase(it);
+                if (!_use_janitor) {
+                    freeJob(job);
+                    continue;
+                }
                 // Move pointer to "free" queue emptied by janitor thread
                 {
                     auto lock = _mtx.getLock();
                     _jobs_to_free.push_back(job);
                 }
                 _cond_var.notify();
-                it = _job_destruct_queue.erase(it);
             } else ++it;
         }
     }
@@ -89,14 +96,18 @@ private:
             
             // Free each job
             for (Job* job : copy) {
-                int id = job->getId();
-                LOGGER(lg, V4_VVER, "DELETE #%i\n", id);
-                delete job;
-                Logger::getMainInstance().mergeJobLogs(id);
-                _num_stored_jobs--;
+                LOGGER(lg, V4_VVER, "DELETE #%i\n", job->getId());
+                freeJob(job);
             }
 
             if (!_worker.continueRunning()) usleep(100 * 1000); // wait for last jobs to finish
         }
     }
+
+    void freeJob(Job* job) {
+        int id = job->getId();
+        delete job;
+        Logger::getMainInstance().mergeJobLogs(id);
+        _num_stored_jobs--;
+    }
 };
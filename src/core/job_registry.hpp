@@ -32,7 +32,10 @@ private:
     bool _memory_panic {false};
 
 public:
-    JobRegistry(Parameters& params, MPI_Comm& comm) : _params(params), _comm(comm) {}
+    // Jobs are freed by a janitor thread unless useJanitor is false, in which case
+    // they are freed in the main thread (e.g., for many registries in a single process).
+    JobRegistry(Parameters& params, MPI_Comm& comm, bool useJanitor = true) : 
+        _params(params), _comm(comm), _job_gc(useJanitor) {}
 
     Job& create(int jobId, int applicationId, bool incremental) {
 
@@ -236,6 +239,10 @@ public:
         return jobIds;
     }
 
+    const LatencyReport& getLatencyReport() const {
+        return _latency_report;
+    }
+
     bool hasJobsLeftToDelete() const {
         return _job_gc.hasJobsLeftInDestructQueue();
     }
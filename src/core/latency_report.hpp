@@ -21,6 +21,10 @@ public:
         stats.logFullDataIntoFile(".treegrowth-latencies");
     }
 
+    const std::list<std::vector<float>>& getDesireLatencies() const {
+        return _desire_latencies;
+    }
+
     void report(Job& job) {
         // Gather statistics
         auto numDesires = job.getJobTree().getNumDesires();
@@ -0,0 +1,100 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "app/job.hpp"
+#include "util/logger.hpp"
+#include "util/params.hpp"
+#include "util/robin_hood.hpp"
+#include "util/sys/timer.hpp"
+
+/*
+Per-process memory budget for the admission of job nodes. Each job node is assigned
+a memory estimate derived from its formula size and its number of threads, which travels
+with the job's requests. A process refuses to adopt a job node if the estimates of all
+jobs it already holds (active or cached) plus the estimate of the new job node
+would exceed the process's share of the machine's RAM. In addition, the estimate
+of each executed job node is compared to the actual increase in the process's
+memory usage and reported as soon as the job node is suspended or terminated.
+*/
+class MemoryBudget {
+
+private:
+    const Parameters& _params;
+
+    // Latest measurements (refreshed by the worker's periodic stats check)
+    long _used_kbs {0};
+    unsigned long _machine_total_kbs {0};
+    int _num_processes_on_host {1};
+
+    struct Tracking {
+        int estimateMbs;
+        long baselineKbs;
+        long peakKbs;
+    };
+    robin_hood::unordered_map<int, Tracking> _tracked_jobs;
+
+public:
+    MemoryBudget(const Parameters& params) : _params(params) {}
+
+    static int estimateMbs(size_t numLiterals, int numThreads, const Parameters& params) {
+        // Serialized description + per-thread solver copies including learnt clauses
+        double bytes = 4.0 * numLiterals
+            + numThreads * (numLiterals * params.memEstimateBytesPerLitPerThread()
+                + 1024.0 * 1024.0 * params.memEstimateBaseMbsPerThread());
+        return (int) std::ceil(bytes / 1024 / 1024);
+    }
+    static int estimateMbs(const Job& job, const Parameters& params) {
+        if (!job.hasDescription()) return 0;
+        return estimateMbs(job.getDescription().getNumFormulaLiterals(), job.getNumThreads(), params);
+    }
+
+    bool enabled() const {
+        return _params.memoryBudget() > 0 && _machine_total_kbs > 0;
+    }
+
+    void updateMeasurements(long usedKbs, unsigned long machineTotalKbs, int numProcessesOnHost) {
+        _used_kbs = usedKbs;
+        _machine_total_kbs = machineTotalKbs;
+        _num_processes_on_host = std::max(1, numProcessesOnHost);
+        for (auto& [jobId, tracking] : _tracked_jobs) {
+            tracking.peakKbs = std::max(tracking.peakKbs, usedKbs);
+        }
+    }
+
+    int getBudgetMbs() const {
+        return (int) (_params.memoryBudget() * _machine_total_kbs / _num_processes_on_host / 1024);
+    }
+
+    // Whether a job node with the given estimate can be adopted in addition to
+    // the job nodes of this process which are accounted for by residentMbs.
+    bool admits(int estimateMbs, int residentMbs) const {
+        if (!enabled() || estimateMbs <= 0) return true;
+        // Measured usage may exceed the sum of estimates, e.g., due to inaccurate estimates
+        int usedMbs = std::max(residentMbs, (int) (_used_kbs / 1024));
+        if (usedMbs + estimateMbs <= getBudgetMbs()) return true;
+        // Never starve a job which is too large for any budget: admit it on an empty process
+        if (residentMbs == 0) {
+            LOG(V1_WARN, "[WARN] Job node estimate %iMB exceeds memory budget %iMB\n", estimateMbs, getBudgetMbs());
+            return true;
+        }
+        return false;
+    }
+
+    void onJobNodeStarted(int jobId, int estimateMbs) {
+        _tracked_jobs[jobId] = Tracking{estimateMbs, _used_kbs, _used_kbs};
+    }
+
+    void onJobNodeStopped(const Job& job) {
+        auto it = _tracked_jobs.find(job.getId());
+        if (it == _tracked_jobs.end()) return;
+        auto& tracking = it->second;
+        int actualMbs = (int) ((std::max(tracking.peakKbs, _used_kbs) - tracking.baselineKbs) / 1024);
+        LOG(V3_VERB, "MEMEST %s est=%iMB actual=%iMB ratio=%.3f budget=%iMB\n", job.toStr(),
+            tracking.estimateMbs, actualMbs, tracking.estimateMbs > 0 ? actualMbs / (float)tracking.estimateMbs : 0.f,
+            getBudgetMbs());
+        _tracked_jobs.erase(it);
+    }
+};
@@ -10,6 +10,7 @@
 #include "balancing/request_matcher.hpp"
 #include "data/worker_sysstate.hpp"
 #include "comm/randomized_routing_tree.hpp"
+#include "core/memory_budget.hpp"
 
 typedef std::function<void(JobRequest& req, int source)> DeflectJobRequestCallback;
 
@@ -97,15 +98,20 @@ public:
         }
 
         // Find a proper destination rank if none was given
+        bool undirected = false;
         if (dest == -1) {
             int nextNodeRank = job.getJobTree().getRankOfNextDormantChild(); 
             if (nextNodeRank < 0) {
                 tag = MSG_REQUEST_NODE;
                 nextNodeRank = left ? job.getJobTree().getLeftChildNodeRank() : job.getJobTree().getRightChildNodeRank();
+                undirected = true;
             }
             dest = nextNodeRank;
         }
 
+        // Let potential adopters know how much memory the job node is expected to take
+        req.memoryEstimateMbs = MemoryBudget::estimateMbs(job, _params);
+
         LOG_ADD_DEST(V3_VERB, "%s growing: %s", dest, job.toStr(), req.toStr().c_str());
         _sys_state.addLocal(SYSSTATE_SPAWNEDREQUESTS, 1);
         auto time = Timer::elapsedSeconds();
@@ -116,6 +122,13 @@ public:
             _req_matcher->addJobRequest(req);
             return;
         }
+        if (undirected && _params.batchedMatching() && _req_matcher && !_params.prefixSumMatching()
+                && req.multiplicity == 1) {
+            // Skip the initial hop: the local matcher batches this request
+            // with the requests of all other jobs growing from this PE
+            _req_matcher->addJobRequest(req);
+            return;
+        }
         
         MyMpi::isend(dest, tag, req);
     }
@@ -36,7 +36,7 @@ SchedulingManager::SchedulingManager(Parameters& params, MPI_Comm& comm,
             [&](JobRequest& req, int tag, bool left, int dest) {
                 _req_mgr.emitJobRequest(get(req.jobId), req, tag, left, dest);
             }
-        ) {
+        ), _memory_budget(_params) {
 
     _wcsecs_per_instance = params.jobWallclockLimit();
     _cpusecs_per_instance = params.jobCpuLimit();
@@ -135,7 +135,7 @@ RequestMatcher* SchedulingManager::createRequestMatcher() {
         return new PrefixSumRequestMatcher(_job_registry, _comm, cbReceiveRequest);
     } else if (_params.hopsUntilCollectiveAssignment() >= 0) {
         return new RoutingTreeRequestMatcher(
-            _job_registry, _comm, _routing_tree, cbReceiveRequest
+            _job_registry, _comm, _routing_tree, _params, cbReceiveRequest
         );
     }
     return (RequestMatcher*) nullptr;
@@ -150,6 +150,7 @@ void SchedulingManager::execute(Job& job, int source) {
     int jobId = job.getId();
     setLoad(1, jobId);
     LOG_ADD_SRC(V3_VERB, "EXECUTE %s", source, job.toStr());
+    _memory_budget.onJobNodeStarted(jobId, MemoryBudget::estimateMbs(job, _params));
     if (job.getState() == INACTIVE) {
         // Execute job for the first time
         job.start();
@@ -333,6 +334,8 @@ void SchedulingManager::handleIncomingJobRequest(MessageHandle& handle, JobReque
         // Adoption takes place
         LOG_ADD_SRC(V3_VERB, "ADOPT %s mode=%i", source, req.toStr().c_str(), mode);
         assert(!_job_registry.isBusyOrCommitted() || LOG_RETURN_FALSE("Adopting a job, but not idle!\n"));
+        _sys_state.addLocal(SYSSTATE_NUMADOPTIONS, 1);
+        _sys_state.addLocal(SYSSTATE_SUMADOPTIONHOPS, std::max(0, req.numHops));
 
         // Commit on the job, send a request to the parent
         if (!has(req.jobId)) {
@@ -611,7 +614,9 @@ void SchedulingManager::handleLeavingChild(MessageHandle& handle) {
     int rootRank = recv.data[2];
 
     if (!has(jobId)) {
-        MyMpi::isend(rootRank, MSG_NOTIFY_NODE_LEAVING_JOB, handle.moveRecvData());
+        // Forward to the job's root -- unless this is the root, which forgot the job already
+        if (rootRank != MyMpi::rank(MPI_COMM_WORLD))
+            MyMpi::isend(rootRank, MSG_NOTIFY_NODE_LEAVING_JOB, handle.moveRecvData());
         return;
     }
     Job& job = get(jobId);
@@ -1079,6 +1084,11 @@ SchedulingManager::AdoptionResult SchedulingManager::tryAdopt(JobRequest& req, J
         }
     }
 
+    // Would the job node overcommit this process's memory?
+    if (!fitsIntoMemoryBudget(req)) {
+        return REJECT;
+    }
+
     // Is node idle and not committed to another job?
     if (!_job_registry.isBusyOrCommitted()) {
         if (mode != TARGETED_REJOIN) return ADOPT;
@@ -1121,6 +1131,24 @@ SchedulingManager::AdoptionResult SchedulingManager::tryAdopt(JobRequest& req, J
     return REJECT;
 }
 
+bool SchedulingManager::fitsIntoMemoryBudget(const JobRequest& req) {
+
+    if (!_memory_budget.enabled()) return true;
+    // A cached job node of this job is already accounted for
+    if (has(req.jobId) && get(req.jobId).hasDescription()) return true;
+
+    // Sum up the estimates of all job nodes held by this process
+    int residentMbs = 0;
+    for (auto& [jobId, jobPtr] : _job_registry.getJobMap()) {
+        residentMbs += MemoryBudget::estimateMbs(*jobPtr, _params);
+    }
+    if (_memory_budget.admits(req.memoryEstimateMbs, residentMbs)) return true;
+
+    LOG(V4_VVER, "Reject %s : memory budget exceeded (resident=%iMB budget=%iMB)\n", 
+        req.toStr().c_str(), residentMbs, _memory_budget.getBudgetMbs());
+    return false;
+}
+
 void SchedulingManager::resume(Job& job, const JobRequest& req, int source) {
 
     // Remove commitment
@@ -1132,6 +1160,7 @@ void SchedulingManager::resume(Job& job, const JobRequest& req, int source) {
     setLoad(1, req.jobId);
     LOG_ADD_SRC(V3_VERB, "RESUME %s", source, 
                 Job::toStr(req.jobId, req.requestedNodeIndex).c_str());
+    _memory_budget.onJobNodeStarted(req.jobId, MemoryBudget::estimateMbs(job, _params));
     job.resume();
 
     int demand = job.getDemand();
@@ -1146,6 +1175,7 @@ void SchedulingManager::suspend(Job& job) {
     job.suspend();
     setLoad(0, job.getId());
     LOG(V3_VERB, "SUSPEND %s\n", job.toStr());
+    _memory_budget.onJobNodeStopped(job);
     _balancer.onSuspend(job);
 }
 
@@ -1160,6 +1190,7 @@ void SchedulingManager::terminate(Job& job) {
     job.terminate();
     if (job.hasCommitment()) uncommit(job, /*leaving=*/true);
     if (!wasTerminatedBefore) _balancer.onTerminate(job);
+    _memory_budget.onJobNodeStopped(job);
 
     LOG(V4_VVER, "Forget %s\n", job.toStr());
     eraseJobAndQueueForDeletion(job);
@@ -1263,6 +1294,7 @@ SchedulingManager::~SchedulingManager() {
         forgetOldJobs();
         //_janitor_cond_var.notify(); // TODO needed?
         watchdog.reset();
+        if (!_job_registry.hasJobsLeftToDelete()) break;
         usleep(10*1000); // 10 milliseconds
     }
 
@@ -13,6 +13,7 @@
 #include "request_manager.hpp"
 #include "result_store.hpp"
 #include "job_description_interface.hpp"
+#include "memory_budget.hpp"
 #include "balancing/event_driven_balancer.hpp"
 
 // forward declarations
@@ -42,6 +43,7 @@ private:
     ReactivationScheduler _reactivation_scheduler;
     std::pair<int, int> _id_and_source_of_deferred_root_to_reactivate {-1, -1};
     ResultStore _result_store;
+    MemoryBudget _memory_budget;
 
     std::list<MessageSubscription> _subscriptions;
 
@@ -62,6 +64,9 @@ public:
     void tryAdoptPendingRootActivationRequest();
     void forgetOldJobs();
     void triggerMemoryPanic();
+    void updateMemoryMeasurements(long usedKbs, unsigned long machineTotalKbs, int numProcessesOnHost) {
+        _memory_budget.updateMeasurements(usedKbs, machineTotalKbs, numProcessesOnHost);
+    }
     
     enum JobRequestMode {TARGETED_REJOIN, NORMAL, IGNORE_FAIL};
     void handleIncomingJobRequest(MessageHandle& handle, JobRequestMode mode);
@@ -112,4 +117,5 @@ private:
     enum AdoptionResult {ADOPT, REJECT, DEFER, DISCARD};
     AdoptionResult tryAdopt(JobRequest& req, JobRequestMode mode, int sender);
     bool isAdoptionOfferObsolete(const JobRequest& req, bool alreadyAccepted = false);
+    bool fitsIntoMemoryBudget(const JobRequest& req);
 };
@@ -21,7 +21,7 @@
 Worker::Worker(MPI_Comm comm, Parameters& params) :
     _comm(comm), _world_rank(MyMpi::rank(MPI_COMM_WORLD)), 
     _params(params), _job_registry(_params, _comm), _routing_tree(_params, _comm), 
-    _sys_state(_comm, params.sysstatePeriod(), SysState<9>::ALLREDUCE), 
+    _sys_state(_comm, params.sysstatePeriod(), WorkerSysState::ALLREDUCE), 
     _sched_man(_params, _comm, _routing_tree, _job_registry, _sys_state), 
     _watchdog(/*enabled=*/_params.watchdog(), /*checkIntervMillis=*/100, Timer::elapsedSeconds())
 {
@@ -101,6 +101,10 @@ void Worker::checkStats() {
         _sys_state.setLocal(SYSSTATE_GLOBALMEM, _node_memory_gbs);
         LOG(V4_VVER, "mem=%.2fGB mt_cpu=%.3f mt_sys=%.3f\n", _node_memory_gbs, _mainthread_cpu_share, _mainthread_sys_share);
 
+        // Update measurements for memory-aware admission of job nodes
+        _sched_man.updateMemoryMeasurements(1024*1024*_node_memory_gbs, _machine_total_kbs,
+            _host_comm ? _host_comm->getNumProcessesOnHost() : std::max(1, _params.processesPerHost()));
+
         // Update host-internal communicator
         if (_host_comm) {
             _host_comm->setRamUsageThisWorkerGbs(_node_memory_gbs);
@@ -116,7 +120,7 @@ void Worker::checkStats() {
         // (concurrently because computation of PSS is expensive)
         _node_stats_calculated.store(false, std::memory_order_relaxed);
         auto tid = Proc::getTid();
-        ProcessWideThreadPool::get().addTask([&, tid]() {
+        ProcessWideThreadPool::get().addDetachedTask([&, tid]() {
             auto memoryKbs = Proc::getRecursiveProportionalSetSizeKbs(Proc::getPid());
             auto memoryGbs = memoryKbs / 1024.f / 1024.f;
             _node_memory_gbs = memoryGbs;
@@ -196,11 +200,13 @@ void Worker::publishAndResetSysState() {
         int numFulfilledDesires = result[SYSSTATE_NUMFULFILLEDDESIRES];
         float ratioFulfilled = numDesires <= 0 ? 0 : (float)numFulfilledDesires / numDesires;
         float latency = numFulfilledDesires <= 0 ? 0 : result[SYSSTATE_SUMDESIRELATENCIES] / numFulfilledDesires;
+        int numAdoptions = result[SYSSTATE_NUMADOPTIONS];
+        float avgHops = numAdoptions <= 0 ? 0 : result[SYSSTATE_SUMADOPTIONHOPS] / numAdoptions;
 
-        LOG(V2_INFO, "sysstate busyratio=%.3f cmtdratio=%.3f jobs=%i globmem=%.2fGB newreqs=%i hops=%i\n", 
+        LOG(V2_INFO, "sysstate busyratio=%.3f cmtdratio=%.3f jobs=%i globmem=%.2fGB newreqs=%i hops=%i adoptions=%i avghops=%.2f\n", 
                     result[SYSSTATE_BUSYRATIO]/MyMpi::size(_comm), result[SYSSTATE_COMMITTEDRATIO]/MyMpi::size(_comm), 
                     (int)result[SYSSTATE_NUMJOBS], result[SYSSTATE_GLOBALMEM], (int)result[SYSSTATE_SPAWNEDREQUESTS], 
-                    (int)result[SYSSTATE_NUMHOPS]);
+                    (int)result[SYSSTATE_NUMHOPS], numAdoptions, avgHops);
     }
     
     if (!_job_registry.isBusyOrCommitted()) {
@@ -213,6 +219,8 @@ void Worker::publishAndResetSysState() {
     _sys_state.setLocal(SYSSTATE_NUMDESIRES, 0);
     _sys_state.setLocal(SYSSTATE_NUMFULFILLEDDESIRES, 0);
     _sys_state.setLocal(SYSSTATE_SUMDESIRELATENCIES, 0);
+    _sys_state.setLocal(SYSSTATE_NUMADOPTIONS, 0);
+    _sys_state.setLocal(SYSSTATE_SUMADOPTIONHOPS, 0);
 }
 
 Worker::~Worker() {
@@ -148,6 +148,14 @@ public:
         _f_size++;
         if (_use_checksums) _checksum.combine(data);
     }
+    inline void addPermanentData(const float* data, size_t count) {
+        // Append the whole block at once
+        auto& vec = _data_per_revision[_revision];
+        vec->resize(vec->size() + count*sizeof(float));
+        memcpy(vec->data() + vec->size() - count*sizeof(float), data, count*sizeof(float));
+        _f_size += count;
+        if (_use_checksums) for (size_t i = 0; i < count; i++) _checksum.combine(data[i]);
+    }
 
     inline void addTransientData(int lit) {
         // Push literal to raw data, update counter
@@ -16,8 +16,6 @@ struct JobMetadata {
     std::vector<int> dependencies;
     bool done = false;
     bool interrupt = false;
-    
-    mutable float lastDescriptionAvailabilityCheck = 0;
 
     JobMetadata() {}
     JobMetadata(JobMetadata&& other) :
@@ -28,7 +26,12 @@ struct JobMetadata {
         done(other.done), interrupt(other.interrupt) {}
     
     JobMetadata& operator=(JobMetadata&& other) {
-        *this = JobMetadata(std::move(other));
+        jobName = std::move(other.jobName);
+        description = std::move(other.description);
+        files = std::move(other.files);
+        dependencies = std::move(other.dependencies);
+        done = other.done;
+        interrupt = other.interrupt;
         return *this;
     }
 
@@ -8,12 +8,12 @@
 #include "comm/mympi.hpp"
 
 /*static!*/ size_t JobRequest::getMaxTransferSize() {
-    return 8*sizeof(int)+2*(sizeof(ctx_id_t))+sizeof(float)+sizeof(bool)
+    return 9*sizeof(int)+2*(sizeof(ctx_id_t))+sizeof(float)+sizeof(bool)
         +4*sizeof(int);
 }
 
 size_t JobRequest::getTransferSize() const {
-    return 8*sizeof(int)+2*(sizeof(ctx_id_t))+sizeof(float)+sizeof(bool)
+    return 9*sizeof(int)+2*(sizeof(ctx_id_t))+sizeof(float)+sizeof(bool)
         +(multiplicity == 1 ? 2 : 4)*sizeof(int);
 }
 
@@ -33,6 +33,7 @@ std::vector<uint8_t> JobRequest::serialize() const {
     n = sizeof(int); memcpy(packed.data()+i, &numHops, n); i += n;
     n = sizeof(int); memcpy(packed.data()+i, &balancingEpoch, n); i += n;
     n = sizeof(bool); memcpy(packed.data()+i, &incremental, n); i += n;
+    n = sizeof(int); memcpy(packed.data()+i, &memoryEstimateMbs, n); i += n;
     n = sizeof(int); memcpy(packed.data()+i, &multiBaseId, n); i += n;
     n = sizeof(int); memcpy(packed.data()+i, &multiplicity, n); i += n;
     if (multiplicity == 1) return packed;
@@ -55,6 +56,7 @@ JobRequest& JobRequest::deserialize(const std::vector<uint8_t> &packed) {
     n = sizeof(int); memcpy(&numHops, packed.data()+i, n); i += n;
     n = sizeof(int); memcpy(&balancingEpoch, packed.data()+i, n); i += n;
     n = sizeof(bool); memcpy(&incremental, packed.data()+i, n); i += n;
+    n = sizeof(int); memcpy(&memoryEstimateMbs, packed.data()+i, n); i += n;
     n = sizeof(int); memcpy(&multiBaseId, packed.data()+i, n); i += n;
     n = sizeof(int); memcpy(&multiplicity, packed.data()+i, n); i += n;
     if (multiplicity == 1) return *this;
@@ -74,6 +76,7 @@ std::string JobRequest::toStr() const {
             + " hops=" + std::to_string(numHops)
             + " epoch=" + std::to_string(balancingEpoch)
             + " matchId=" + std::to_string(multiBaseId)
+            + (memoryEstimateMbs>0 ? " mem=" + std::to_string(memoryEstimateMbs) + "MB" : "")
             + (multiplicity>1 ? 
                 " x" + std::to_string(multiplicity) 
                     + " [" + std::to_string(multiBegin) + "," + std::to_string(multiEnd) + "]" 
@@ -34,6 +34,7 @@ struct JobRequest : public Serializable {
     int balancingEpoch;
     int applicationId;
     bool incremental;
+    int memoryEstimateMbs {0};
 
     int multiBaseId {-1};
     int multiplicity {1};
@@ -72,6 +73,7 @@ public:
         balancingEpoch = other.balancingEpoch;
         applicationId = other.applicationId;
         incremental = other.incremental;
+        memoryEstimateMbs = other.memoryEstimateMbs;
         multiBaseId = other.multiBaseId;
         multiplicity = other.multiplicity;
         multiBegin = other.multiBegin;
@@ -92,6 +94,7 @@ public:
         balancingEpoch = other.balancingEpoch;
         applicationId = other.applicationId;
         incremental = other.incremental;
+        memoryEstimateMbs = other.memoryEstimateMbs;
         multiBaseId = other.multiBaseId;
         multiplicity = other.multiplicity;
         multiBegin = other.multiBegin;
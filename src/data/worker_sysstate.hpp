@@ -12,5 +12,7 @@
 #define SYSSTATE_NUMDESIRES 6
 #define SYSSTATE_NUMFULFILLEDDESIRES 7
 #define SYSSTATE_SUMDESIRELATENCIES 8
+#define SYSSTATE_NUMADOPTIONS 9
+#define SYSSTATE_SUMADOPTIONHOPS 10
 
-typedef SysState<9> WorkerSysState;
+typedef SysState<11> WorkerSysState;
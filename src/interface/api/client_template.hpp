@@ -20,7 +20,7 @@ private:
     Distribution _dist_burst_size;
     bool _valid = false;
 
-    double _last_arrival;
+    double _last_arrival {0};
     int _remaining_jobs_from_burst = 0;
 
 public:
@@ -276,7 +276,7 @@ void JsonInterface::handleJobDone(JobResult&& result, const JobDescription::Stat
     img->feedback(j);
 
     if (useSolutionFile) {
-        ProcessWideThreadPool::get().addTask([solutionFile, sol = result.extractSolution()]() {
+        ProcessWideThreadPool::get().addDetachedTask([solutionFile, sol = result.extractSolution()]() {
             
             int fd = open(solutionFile.c_str(), O_WRONLY);
             LOG(V4_VVER, "Writing solution: %i ints (%i,%i,...,%i,%i)\n", sol.size(), 
@@ -0,0 +1,261 @@
+
+#pragma once
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/logger.hpp"
+#include "util/sys/proc.hpp"
+#include "util/sys/threading.hpp"
+#include "util/robin_hood.hpp"
+#include "pipelined_connection.hpp"
+
+/*
+Event-driven IPC socket server. A fixed (small) number of event loop threads
+multiplex all client connections via epoll on non-blocking sockets. Incoming
+messages are handed to the receive callback as soon as they are complete, so each
+connection may have many requests in flight at the same time. The callback is
+executed by an event loop thread and should therefore return quickly.
+If a client shuts down its sending side, its connection is kept open until all
+responses awaited via PipelinedConnection::expectResponse() have been written.
+*/
+class EventSocketServer {
+
+public:
+    typedef std::shared_ptr<PipelinedConnection> ConnectionPtr;
+
+    struct SocketSettings {
+        std::string address;
+        int numThreads;
+        int maxMsgSize;
+        std::function<void(const ConnectionPtr&, nlohmann::json&)> receiveCallback;
+    };
+
+private:
+    struct EventLoop {
+        int epollFd {-1};
+        int wakeupFd {-1};
+        std::thread thread;
+    };
+
+    std::string _socket_address;
+    int _read_chunk_size;
+    std::function<void(const ConnectionPtr&, nlohmann::json&)> _recv_callback;
+
+    int _socket_fd {-1};
+    std::vector<EventLoop> _loops;
+    std::atomic_bool _terminate {false};
+
+    Mutex _conn_mutex;
+    robin_hood::unordered_map<int, ConnectionPtr> _connections;
+    int _running_conn_id {1};
+    int _next_loop_idx {0};
+
+    std::atomic_long _num_received {0};
+    std::atomic_int _num_connections_total {0};
+
+public:
+    EventSocketServer(const SocketSettings& settings) :
+            _socket_address(settings.address), _read_chunk_size(settings.maxMsgSize),
+            _recv_callback(settings.receiveCallback), _loops(std::max(1, settings.numThreads)) {
+
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (_socket_address.size() >= sizeof(address.sun_path)) {
+            LOG(V1_WARN, "[WARN] Socket path \"%s\" too long\n", _socket_address.c_str());
+            return;
+        }
+        memcpy(address.sun_path, _socket_address.c_str(), _socket_address.size() + 1);
+
+        if ((_socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+            LOG(V1_WARN, "[WARN] Could not instantiate socket \"%s\"\n", _socket_address.c_str());
+            return;
+        }
+        unlink(_socket_address.c_str());
+        if (bind(_socket_fd, (sockaddr*) &address, sizeof(address)) == -1) {
+            LOG(V1_WARN, "[WARN] Could not bind socket \"%s\"\n", _socket_address.c_str());
+            closeListeningSocket();
+            return;
+        }
+        if (listen(_socket_fd, SOMAXCONN) == -1) {
+            LOG(V1_WARN, "[WARN] Could not listen on socket \"%s\"\n", _socket_address.c_str());
+            closeListeningSocket();
+            return;
+        }
+
+        for (int i = 0; i < _loops.size(); i++) {
+            auto& loop = _loops[i];
+            loop.epollFd = epoll_create1(EPOLL_CLOEXEC);
+            loop.wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr; // wakeup signal
+            epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.wakeupFd, &ev);
+            if (i == 0) {
+                // The first event loop also accepts new connections
+                ev.events = EPOLLIN;
+                ev.data.ptr = this;
+                epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, _socket_fd, &ev);
+            }
+        }
+        for (int i = 0; i < _loops.size(); i++) {
+            _loops[i].thread = std::thread([this, i]() {runEventLoop(i);});
+        }
+    }
+
+    ~EventSocketServer() {
+        _terminate = true;
+        for (auto& loop : _loops) {
+            if (loop.wakeupFd != -1) {
+                uint64_t one = 1;
+                (void) !write(loop.wakeupFd, &one, sizeof(one));
+            }
+        }
+        for (auto& loop : _loops) {
+            if (loop.thread.joinable()) loop.thread.join();
+            if (loop.epollFd != -1) ::close(loop.epollFd);
+            if (loop.wakeupFd != -1) ::close(loop.wakeupFd);
+        }
+        {
+            auto lock = _conn_mutex.getLock();
+            for (auto& [fd, conn] : _connections) conn->close();
+            _connections.clear();
+        }
+        closeListeningSocket();
+        LOG(V3_VERB, "IPC socket server: %i connections, %li requests received\n",
+            (int) _num_connections_total, (long) _num_received);
+    }
+
+private:
+    void runEventLoop(int loopIdx) {
+        std::string threadName = "SocketLoop#" + std::to_string(loopIdx);
+        Proc::nameThisThread(threadName.c_str());
+
+        auto& loop = _loops[loopIdx];
+        const int maxEvents = 64;
+        epoll_event events[maxEvents];
+
+        while (!_terminate) {
+            int numEvents = epoll_wait(loop.epollFd, events, maxEvents, -1);
+            if (numEvents < 0) {
+                if (errno == EINTR) continue;
+                LOG(V1_WARN, "[WARN] epoll_wait failed: %s\n", strerror(errno));
+                break;
+            }
+            for (int i = 0; i < numEvents; i++) {
+                auto& ev = events[i];
+                if (ev.data.ptr == nullptr) continue; // wakeup
+                if (ev.data.ptr == this) {
+                    acceptConnections();
+                    continue;
+                }
+                auto conn = (PipelinedConnection*) ev.data.ptr;
+                bool keep = true;
+                if (ev.events & (EPOLLIN | EPOLLRDHUP)) keep = handleReadable(conn);
+                // Write out queued responses before giving up on a hung-up connection
+                if (keep && (ev.events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) keep = conn->flush();
+                // The peer is gone entirely (not just its sending side)
+                if (keep && (ev.events & (EPOLLERR | EPOLLHUP)) && !(ev.events & EPOLLIN)) keep = false;
+                if (keep && conn->isFinished()) keep = false;
+                if (!keep) dropConnection(loop, conn);
+            }
+        }
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int fd = accept4(_socket_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    LOG(V1_WARN, "[WARN] Cannot accept connection: %s\n", strerror(errno));
+                return;
+            }
+
+            auto lock = _conn_mutex.getLock();
+            auto conn = std::make_shared<PipelinedConnection>(_running_conn_id++, fd, _read_chunk_size);
+            auto& loop = _loops[_next_loop_idx];
+            _next_loop_idx = (_next_loop_idx+1) % _loops.size();
+
+            // Toggle interest in writability whenever responses pile up
+            // and stop polling for incoming data once the peer half-closed
+            int epollFd = loop.epollFd;
+            PipelinedConnection* rawConn = conn.get();
+            conn->setInterestCallback([epollFd, fd, rawConn](bool read, bool write) {
+                epoll_event ev;
+                ev.events = (read ? EPOLLIN | EPOLLRDHUP : 0) | (write ? EPOLLOUT : 0);
+                ev.data.ptr = rawConn;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+            });
+            _connections[fd] = conn;
+            _num_connections_total++;
+
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.ptr = rawConn;
+            epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &ev);
+            LOG(V4_VVER, "Established IPC connection #%i\n", conn->getId());
+        }
+    }
+
+    bool handleReadable(PipelinedConnection* rawConn) {
+        ConnectionPtr conn;
+        {
+            auto lock = _conn_mutex.getLock();
+            auto it = _connections.find(rawConn->getFd());
+            if (it == _connections.end() || it->second.get() != rawConn) return false;
+            conn = it->second;
+        }
+        auto status = conn->readAvailable([&](nlohmann::json& json) {
+            _num_received++;
+            try {
+                _recv_callback(conn, json);
+            } catch (const std::exception& e) {
+                LOG(V1_WARN, "[WARN] IPC connection #%i: error handling request: %s\n", conn->getId(), e.what());
+            }
+        });
+        if (status == PipelinedConnection::READ_EOF) {
+            LOG(V4_VVER, "IPC connection #%i half-closed by peer\n", conn->getId());
+            conn->shutdownRead();
+        }
+        return status != PipelinedConnection::READ_CLOSED;
+    }
+
+    void dropConnection(EventLoop& loop, PipelinedConnection* conn) {
+        int fd = conn->getFd();
+        LOG(V4_VVER, "Closing IPC connection #%i (%i msgs received, %i sent)\n",
+            conn->getId(), conn->getNumReceived(), conn->getNumSent());
+        ConnectionPtr ref;
+        {
+            // Close while holding the lock so that the file descriptor
+            // cannot be reused by a new connection in the meantime
+            auto lock = _conn_mutex.getLock();
+            auto it = _connections.find(fd);
+            if (it == _connections.end() || it->second.get() != conn) return;
+            ref = std::move(it->second);
+            _connections.erase(it);
+            epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            // Pending feedback callbacks may still hold a reference to the connection;
+            // their send attempts fail gracefully after the connection is closed.
+            ref->close();
+        }
+    }
+
+    void closeListeningSocket() {
+        if (_socket_fd == -1) return;
+        ::close(_socket_fd);
+        _socket_fd = -1;
+        unlink(_socket_address.c_str());
+    }
+};
@@ -0,0 +1,257 @@
+
+#pragma once
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "util/json.hpp"
+#include "util/logger.hpp"
+#include "util/sys/threading.hpp"
+
+/*
+Non-blocking, length-prefixed connection to a single client of the IPC socket
+interface. Incoming bytes are appended to a read buffer and split into complete
+frames (4-byte payload size + JSON payload) as they arrive, so a client may have
+an arbitrary number of requests in flight. Responses can be sent from any thread:
+they are written directly if the socket accepts them and otherwise queued until
+the owning event loop signals that the socket became writable again.
+A client may shut down its sending side after its last request (half-close):
+the connection then remains open until all awaited responses have been written.
+*/
+class PipelinedConnection {
+
+public:
+    enum ReadStatus {READ_OK, READ_EOF, READ_CLOSED};
+
+private:
+    int _id;
+    int _fd;
+    int _read_chunk_size;
+
+    // Only accessed by the owning event loop thread
+    std::vector<char> _read_buffer;
+    size_t _read_offset {0};
+    std::atomic_bool _concluded {false};
+
+    // Accessed by any thread which sends a response
+    Mutex _write_mutex;
+    std::vector<char> _write_buffer;
+    size_t _write_offset {0};
+    bool _valid {true};
+    bool _read_closed {false};
+    int _num_awaited_responses {0};
+    std::function<void(bool, bool)> _on_interest_change;
+
+    std::atomic_bool _flip_endian {false};
+    std::atomic_int _num_received {0};
+    std::atomic_int _num_sent {0};
+
+public:
+    PipelinedConnection(int id, int fd, int readChunkSize) :
+        _id(id), _fd(fd), _read_chunk_size(readChunkSize) {}
+    ~PipelinedConnection() {
+        close();
+    }
+
+    // Set by the event loop: called (with the write lock held) with the new interest in
+    // reading and in writing whenever it changes, e.g., if outgoing data piles up.
+    void setInterestCallback(std::function<void(bool, bool)> cb) {
+        _on_interest_change = cb;
+    }
+
+    // Read all currently available data from the socket and report each complete
+    // message to the provided callback. Only to be called by the owning event loop.
+    ReadStatus readAvailable(const std::function<void(nlohmann::json&)>& onMessage) {
+        while (true) {
+            size_t sizeBefore = _read_buffer.size();
+            _read_buffer.resize(sizeBefore + _read_chunk_size);
+            auto size = ::recv(_fd, _read_buffer.data()+sizeBefore, _read_chunk_size, 0);
+            _read_buffer.resize(sizeBefore + std::max(0L, (long) size));
+            if (size == 0) return READ_EOF; // orderly shutdown of the peer's sending side
+            if (size < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                LOG(V1_WARN, "[WARN] IPC connection #%i: recv error: %s\n", _id, strerror(errno));
+                return READ_CLOSED;
+            }
+            if (!extractMessages(onMessage)) return READ_CLOSED;
+        }
+        return READ_OK;
+    }
+
+    bool send(const nlohmann::json& json) {
+        std::string serializedJson = json.dump();
+        int payloadSize = serializedJson.size();
+        int prefix = _flip_endian ? flipEndian(payloadSize) : payloadSize;
+
+        auto lock = _write_mutex.getLock();
+        if (!_valid) return false;
+        _num_awaited_responses--;
+        bool hadPendingWrites = hasPendingWritesWithLockHeld();
+        _write_buffer.insert(_write_buffer.end(), (char*) &prefix, ((char*) &prefix) + sizeof(int));
+        _write_buffer.insert(_write_buffer.end(), serializedJson.begin(), serializedJson.end());
+        LOG(V5_DEBG, "IPC connection #%i: sending msg len=%i \"%s\"\n", _id, payloadSize, serializedJson.c_str());
+        _num_sent++;
+        // If data is still queued, the event loop will flush it as soon as possible
+        if (hadPendingWrites) return true;
+        if (!flushWithLockHeld()) return false;
+        // Let the event loop know if data is queued or if the connection can be closed now
+        if (hasPendingWritesWithLockHeld() || isFinishedWithLockHeld()) updateInterestWithLockHeld(true);
+        return true;
+    }
+
+    // A response to a request received over this connection will be sent later.
+    void expectResponse() {
+        auto lock = _write_mutex.getLock();
+        _num_awaited_responses++;
+    }
+
+    // Called by the owning event loop once the socket became writable again.
+    // Returns false if the connection broke down.
+    bool flush() {
+        auto lock = _write_mutex.getLock();
+        if (!_valid) return false;
+        if (!flushWithLockHeld()) return false;
+        if (!hasPendingWritesWithLockHeld()) updateInterestWithLockHeld(false);
+        return true;
+    }
+
+    // Called by the owning event loop once the peer will not send any further data.
+    void shutdownRead() {
+        auto lock = _write_mutex.getLock();
+        _read_closed = true;
+        updateInterestWithLockHeld(hasPendingWritesWithLockHeld());
+    }
+
+    // Whether the connection can be closed: all queued data is written and the client
+    // either said goodbye or half-closed the connection and received all awaited responses.
+    bool isFinished() {
+        auto lock = _write_mutex.getLock();
+        return isFinishedWithLockHeld();
+    }
+
+    bool hasPendingWrites() {
+        auto lock = _write_mutex.getLock();
+        return hasPendingWritesWithLockHeld();
+    }
+
+    // Do not accept any further requests over this connection; it will be closed
+    // as soon as all queued responses have been written.
+    void conclude() {
+        _concluded = true;
+    }
+    bool isConcluded() const {
+        return _concluded;
+    }
+
+    void close() {
+        auto lock = _write_mutex.getLock();
+        if (!_valid) return;
+        _valid = false;
+        ::close(_fd);
+    }
+    bool valid() {
+        auto lock = _write_mutex.getLock();
+        return _valid;
+    }
+
+    int getId() const {return _id;}
+    int getFd() const {return _fd;}
+    int getNumReceived() const {return _num_received;}
+    int getNumSent() const {return _num_sent;}
+
+private:
+    bool extractMessages(const std::function<void(nlohmann::json&)>& onMessage) {
+        while (!_concluded && _read_buffer.size() - _read_offset >= sizeof(int)) {
+            const char* begin = _read_buffer.data() + _read_offset;
+
+            // How large is the message advertised to be? (Try to be lenient with byte ordering)
+            int payloadSize;
+            memcpy(&payloadSize, begin, sizeof(int));
+            if (_flip_endian || payloadSize < 0 || payloadSize >= INT32_MAX/2) {
+                payloadSize = flipEndian(payloadSize);
+                _flip_endian = true;
+            }
+            if (payloadSize < 0 || payloadSize >= INT32_MAX/2) {
+                LOG(V1_WARN, "[WARN] IPC connection #%i: invalid message size %i\n", _id, payloadSize);
+                return false;
+            }
+
+            // Message has not been read completely: wait for next batch
+            if (_read_buffer.size() - _read_offset - sizeof(int) < payloadSize) break;
+            begin += sizeof(int);
+            _read_offset += sizeof(int) + payloadSize;
+
+            // Single CANCEL byte: goodbye message (ignore any following messages)
+            if (payloadSize == 1 && (int) begin[0] == 24) {
+                conclude();
+                break;
+            }
+
+            _num_received++;
+            LOG(V5_DEBG, "IPC connection #%i: received msg len=%i\n", _id, payloadSize);
+            try {
+                auto json = nlohmann::json::parse(begin, begin+payloadSize);
+                onMessage(json);
+            } catch (const nlohmann::detail::parse_error& e) {
+                LOG(V1_WARN, "[WARN] IPC connection #%i: parse error: %s\n", _id, e.what());
+            }
+        }
+
+        // Compact buffer once the consumed prefix dominates it
+        if (_read_offset > 0 && _read_offset >= _read_buffer.size() / 2) {
+            _read_buffer.erase(_read_buffer.begin(), _read_buffer.begin() + _read_offset);
+            _read_offset = 0;
+        }
+        return true;
+    }
+
+    bool flushWithLockHeld() {
+        while (_write_offset < _write_buffer.size()) {
+            auto n = ::send(_fd, _write_buffer.data()+_write_offset,
+                _write_buffer.size()-_write_offset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                LOG(V1_WARN, "[WARN] IPC connection #%i: send error: %s\n", _id, strerror(errno));
+                return false;
+            }
+            _write_offset += n;
+        }
+        if (_write_offset == _write_buffer.size()) {
+            _write_buffer.clear();
+            _write_offset = 0;
+        }
+        return true;
+    }
+
+    bool hasPendingWritesWithLockHeld() const {
+        return _write_offset < _write_buffer.size();
+    }
+
+    bool isFinishedWithLockHeld() const {
+        return !hasPendingWritesWithLockHeld() && (_concluded || (_read_closed && _num_awaited_responses <= 0));
+    }
+
+    void updateInterestWithLockHeld(bool write) {
+        if (_on_interest_change) _on_interest_change(!_read_closed, write);
+    }
+
+    static int flipEndian(int input) {
+        char in[4];
+        memcpy(in, &input, sizeof(int));
+        char out[4];
+        for (int i = 0; i < 4; i++) {
+            out[i] = in[3-i];
+        }
+        int result;
+        memcpy(&result, out, sizeof(int));
+        return result;
+    }
+};
@@ -90,7 +90,7 @@ public:
                     }
                     delete connection;
                 };
-                _thread_pool.addTask(std::move(task));
+                _thread_pool.addDetachedTask(std::move(task));
             }
         });
     }
@@ -106,7 +106,7 @@ public:
     std::optional<Connection> openConnection() {
 
         sockaddr_un agent; // The other process info
-        socklen_t agent_length;
+        socklen_t agent_length = sizeof(agent);
         memset(&agent, 0, sizeof(sockaddr_un));
 
         int fd = -1;
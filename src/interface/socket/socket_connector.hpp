@@ -5,16 +5,43 @@
 #include "interface/connector.hpp"
 #include "interface/json_interface.hpp"
 #include "socket.hpp"
+#include "event_socket_server.hpp"
 #include "util/params.hpp"
 
 class SocketConnector : public Connector {
 
 private:
-    Socket* _socket;
+    Socket* _socket {nullptr};
+    EventSocketServer* _server {nullptr};
 
 public:
     SocketConnector(Parameters& params, JsonInterface& interface, std::string socketPath) {
 
+        if (params.ipcEventLoopThreads() > 0) {
+            // Event-driven server: all connections are multiplexed on a few threads
+            // and each connection may have multiple requests in flight
+            EventSocketServer::SocketSettings settings;
+            settings.address = socketPath;
+            settings.numThreads = params.ipcEventLoopThreads();
+            settings.maxMsgSize = 65536;
+            settings.receiveCallback = [&interface](const EventSocketServer::ConnectionPtr& conn, nlohmann::json& json) {
+                // The connection object is kept alive until the response has been sent
+                auto cb = [conn](nlohmann::json& result) {
+                    bool sent = conn->send(result);
+                    if (!sent) LOG(V1_WARN, "[WARN] IPC socket send unsuccessful!\n");
+                };
+                // Each accepted job (or increment) is answered once; an interrupt is
+                // answered via the response to the interrupted job
+                const bool awaitsResponse = !(json.contains("interrupt") && json["interrupt"].get<bool>());
+                auto result = interface.handle(json, cb);
+                if (result == JsonInterface::ACCEPT && awaitsResponse) conn->expectResponse();
+                // Close the connection after all pending responses have been written
+                if (result == JsonInterface::ACCEPT_CONCLUDE) conn->conclude();
+            };
+            _server = new EventSocketServer(settings);
+            return;
+        }
+
         // Settings for the local socket
         Socket::SocketSettings settings;
         settings.address = socketPath;
@@ -41,6 +68,7 @@ public:
 
     ~SocketConnector() {
         // Stop listening / processing, clean up
-        delete _socket;
+        if (_server) delete _server;
+        if (_socket) delete _socket;
     }
 };
@@ -101,6 +101,8 @@ void doMainProgram(MPI_Comm& commWorkers, MPI_Comm& commClients, Parameters& par
     // Initialize worker and client as necessary (background threads, callbacks, ...)
     if (isWorker) worker->init();
     if (isClient) client->init();
+    // Keep dispatchers for subprocesses (e.g., SAT solvers) ready
+    if (isWorker) Subprocess::initPool(params.subprocessPoolSize());
     int myRank = MyMpi::rank(MPI_COMM_WORLD);
     
     // Register global callback for exiting msg (not specific to worker nor client)
@@ -181,6 +183,7 @@ void doMainProgram(MPI_Comm& commWorkers, MPI_Comm& commClients, Parameters& par
     }
 
     // Clean up
+    Subprocess::shutdownPool();
     if (streamer != nullptr) delete streamer;
     if (isWorker) delete worker;
     if (isClient) delete client;
@@ -219,6 +222,7 @@ int main(int argc, char *argv[]) {
     logConfig.verbosity = params.verbosity();
     logConfig.coloredOutput = params.coloredOutput();
     logConfig.flushFileImmediately = params.immediateFileFlush();
+    logConfig.asyncLogging = params.asyncLogging();
     logConfig.quiet = params.quiet();
     if (params.zeroOnlyLogging() && rank > 0) logConfig.quiet = true;
     logConfig.cPrefix = params.monoFilename.isSet();
@@ -239,6 +243,10 @@ int main(int argc, char *argv[]) {
 
     if (rank == 0)
         LOG(V2_INFO, "Program options: %s\n", params.getParamsAsString().c_str());
+    if (!app_registry::areProgramOptionsValid(params)) {
+        MPI_Finalize();
+        Process::doExit(1);
+    }
     if (params.help()) {
         // Help requested or no job input provided
         if (rank == 0) {
@@ -354,6 +362,8 @@ int main(int argc, char *argv[]) {
     // Exit properly
     MPI_Barrier(MPI_COMM_WORLD);
     MPI_Finalize();
-    LOG(V2_INFO, "Exiting happily\n");
-    Process::doExit(0);
+    int exitCode = Process::getRequestedExitCode();
+    if (exitCode == 0) LOG(V2_INFO, "Exiting happily\n");
+    else LOG(V2_INFO, "Exiting with code %i\n", exitCode);
+    Process::doExit(exitCode);
 }
@@ -54,11 +54,13 @@ OPTION_GROUP(grpInterface, "interface", "Interface")
  OPT_BOOL(shuffleJobDescriptions,         "sjd", "shuffle-job-descriptions",           false,                   "Shuffle job descriptions given via -job-desc-template option")
  OPT_BOOL(useFilesystemInterface,         "interface-fs", "",                          true,                    "Use filesystem interface ([-apidir]/jobs.*/{in,out}/*.json)")
  OPT_BOOL(useIPCSocketInterface,          "interface-ipc", "",                         false,                   "Use IPC socket interface (.mallob.<pid>.sk)")
+ OPT_INT(ipcEventLoopThreads,             "ipc-elt", "ipc-event-loop-threads",         1,    0, 16,             "Number of event loop threads multiplexing all IPC socket connections (0: legacy mode with one blocking thread per connection)")
  OPT_STRING(streamerResultOutput,         "sro", "streamer-result-output",             "",                      "Path for streamer to write result metadata to")
 
 ///////////////////////////////////////////////////////////////////////
 
 OPTION_GROUP(grpOutput, "output", "Output")
+ OPT_BOOL(asyncLogging,                   "al", "async-logging",                       false,                   "Record log calls in per-thread buffers and format and write them in a background thread")
  OPT_BOOL(coloredOutput,                  "colors", "",                                false,                   "Colored terminal output based on messages' verbosity")
  OPT_BOOL(immediateFileFlush,             "iff", "immediate-file-flush",               false,                   "Flush log files after each line instead of buffering")
  OPT_STRING(logDirectory,                 "log", "log-directory",                      "",                      "Directory to save logs in") //[[AUTOCOMPLETE_DIRECTORY]]
@@ -86,6 +88,8 @@ OPTION_GROUP(grpSchedulingMapping, "scheduling/mapping", "Options for mapping wo
  OPT_BOOL(useDormantChildren,             "dc", "dormant-children",                    false,                   "Simple strategy of maintaining local set of dormant child job contexts which the parent tries to reactivate")
  OPT_BOOL(prefixSumMatching,              "prisma", "prefix-sum-matching",             false,                   "Match requests and idle PEs using prefix sums instead of a routing tree")
  OPT_BOOL(bulkRequests,                   "br", "bulk-requests",                       false,                   "Encode requests for an entire subtree as a single request")
+ OPT_BOOL(batchedMatching,                "bm", "batched-matching",                    false,                   "Hand requests of growing jobs directly to the routing tree matcher, which matches all jobs' requests of an epoch in batches (requires huca >= 0). Trades latency for messages: far fewer request messages, but requests no longer hit an idle PE by a lucky random first hop, so hops and adoption latency increase slightly")
+ OPT_FLOAT(batchedMatchingWindow,         "bmw", "batched-matching-window",            0,    0, 1,              "Time (s) after the start of an epoch during which batched matching withholds requests from the parent PE while idle counts are aggregated")
 
 ///////////////////////////////////////////////////////////////////////
 
@@ -113,15 +117,27 @@ OPTION_GROUP(grpApp, "app", "Application-specific options")
 ///////////////////////////////////////////////////////////////////////
 
 OPTION_GROUP(grpPerformance, "performance", "Performance")
+ OPT_FLOAT(memoryBudget,                  "mem-budget", "memory-budget",               0,    0, 1,              "Refuse to adopt job nodes whose estimated memory would exceed this fraction of the process's share of machine RAM (0: no admission control)")
+ OPT_FLOAT(memEstimateBytesPerLitPerThread, "mebl", "mem-estimate-bytes-per-lit",     32,   0, LARGE_INT,      "Memory estimate of a job node: bytes per formula literal and thread")
+ OPT_INT(memEstimateBaseMbsPerThread,     "mebt", "mem-estimate-base-mbs-per-thread",  16,   0, LARGE_INT,      "Memory estimate of a job node: base MB per thread")
  OPT_BOOL(memoryPanic,                    "mempanic", "",                              true,                    "Monitor RAM usage per physical machine and switch to memory panic mode if necessary")
  OPT_INT(messageBatchingThreshold,        "mbt", "message-batching-threshold",         1000000, 1000, MAX_INT,  "Employ batching of messages in batches of provided size")
  OPT_INT(processesPerHost,                "pph", "processes-per-host",                 0,    0, LARGE_INT,      "Tells Mallob how many MPI processes are executed on each physical host")
  OPT_BOOL(regularProcessDistribution,     "rpa", "regular-process-allocation",         false,                   "Signal that processes have been allocated regularly, i.e., the i-th machine hosts ranks c*i through c*i + c-1")
  OPT_INT(sleepMicrosecs,                  "sleep", "",                                 100,  0, LARGE_INT,      "Sleep this many microseconds between loop cycles of worker main thread")
+ OPT_INT(subprocessPoolSize,              "subproc-pool", "subprocess-pool-size",      0,    0, 64,             "Number of subprocess dispatchers each worker process spawns in advance to reduce job start latency; set to 1 or more for latency-sensitive deployments with frequent job starts")
  OPT_BOOL(yield,                          "yield", "",                                 false,                   "Yield manager thread whenever there are no new messages")
 
 ///////////////////////////////////////////////////////////////////////
 
+OPTION_GROUP(grpSimulation, "simulation", "Scheduler simulation (mallob_sched_sim only)")
+ OPT_FLOAT(simMessageLatency,             "sim-msg-latency", "",                       0.0001, 0, 1,          "Simulated latency of each point-to-point message in seconds")
+ OPT_INT(simNumJobs,                      "sim-jobs", "",                              1000, 1, LARGE_INT,      "Number of jobs to draw from the client template (-client-template)")
+ OPT_INT(simNumPes,                       "sim-pes", "",                               1024, 1, LARGE_INT,      "Number of virtual PEs to simulate")
+ OPT_FLOAT(simTickPeriod,                 "sim-tick", "",                              0.001, 0.0001, 1,      "Simulated period (s) of each PE's main loop; larger values speed up the simulation at the cost of accuracy")
+
+///////////////////////////////////////////////////////////////////////
+
 OPTION_GROUP(grpDebug, "debug", "Debugging")
  OPT_FLOAT(crashMonkeyProbability,        "cmp", "crash-monkey",                       0,    0, 1,              "Have an application thread crash with this probability each time it performs a certain action")
  OPT_BOOL(delayMonkey,                    "delaymonkey", "",                           false,                   "Small chance for each MPI call to block for some random amount of time")
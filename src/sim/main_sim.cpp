@@ -0,0 +1,47 @@
+
+#include "util/sys/timer.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/params.hpp"
+#include "util/sys/proc.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "sim/scheduler_simulation.hpp"
+#include "sim/simulated_job.hpp"
+
+// Scheduler simulation: runs Mallob's scheduling (balancing, request matching, job trees)
+// for a number of virtual PEs (-sim-pes) and jobs (-sim-jobs) drawn from a client template
+// in a single process without MPI, and reports scheduling latencies, utilization and message counts.
+// Example: build/mallob_sched_sim -sim-pes=10000 -sim-jobs=500 -client-template=templates/client-template.json
+int main(int argc, char *argv[]) {
+
+    Timer::init();
+    Proc::nameThisThread("MainThread");
+
+    Parameters params;
+    params.init(argc, argv);
+    if (params.help()) {
+        params.printUsage();
+        return 0;
+    }
+
+    Logger::LoggerConfig logConfig;
+    logConfig.rank = 0;
+    logConfig.verbosity = params.verbosity();
+    logConfig.coloredOutput = params.coloredOutput();
+    logConfig.quiet = params.quiet();
+    std::string logDirectory = params.logDirectory();
+    std::string logFilename = "log.sim";
+    logConfig.logDirOrNull = logDirectory.empty() ? nullptr : &logDirectory;
+    logConfig.logFilenameOrNull = &logFilename;
+    Logger::init(logConfig);
+
+    Random::init(params.seed(), params.seed());
+    ProcessWideThreadPool::init(1);
+    SimulatedJob::registerApplication();
+
+    // Wall clock watchdogs would fire on the simulated clock
+    params.watchdog.set(false);
+
+    SchedulerSimulation sim(params);
+    sim.run();
+}
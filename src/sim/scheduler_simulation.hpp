@@ -0,0 +1,402 @@
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "sim/simulated_environment.hpp"
+#include "sim/simulated_job.hpp"
+#include "app/app_registry.hpp"
+#include "comm/randomized_routing_tree.hpp"
+#include "comm/msg_queue/message_subscription.hpp"
+#include "core/job_registry.hpp"
+#include "core/scheduling_manager.hpp"
+#include "data/job_description.hpp"
+#include "data/job_result.hpp"
+#include "data/job_transfer.hpp"
+#include "data/worker_sysstate.hpp"
+#include "interface/api/client_template.hpp"
+#include "util/data_statistics.hpp"
+#include "util/params.hpp"
+#include "util/periodic_event.hpp"
+#include "util/permutation.hpp"
+#include "util/sys/timer.hpp"
+
+/*
+Deterministic discrete-event simulation of Mallob's scheduling on a large number of virtual PEs
+within a single process, without MPI. Jobs are drawn from a client template (-client-template):
+arrival times, priorities, maximum demands, and durations (wallclock limits of the template,
+or -jwl if the template has none).
+
+Each virtual PE runs the real scheduling stack of a worker (SchedulingManager with its
+RequestManager, EventDrivenBalancer, request matcher and ReactivationScheduler, on top of a
+JobRegistry and a RandomizedRoutingTree) over an in-process MessageQueue (see SimulatedEnvironment).
+Every -sim-tick seconds of simulated time, each PE performs the periodic tasks of Worker::advance.
+Each point-to-point message, including messages to self, takes -sim-msg-latency seconds of
+simulated time. A simulated client, colocated with PE 0, introduces each job at its arrival and
+collects its result just like Client. Jobs are SimulatedJob instances which perform no work and
+report a result after their duration.
+
+Not simulated: memory measurements and the aggregation of system states (sysstate); job
+messages of the application; incremental jobs.
+*/
+class SchedulerSimulation {
+
+private:
+    Parameters& _params;
+    const int _num_pes;
+    const double _latency;
+    const double _tick_period;
+    MPI_Comm _comm {MPI_COMM_WORLD};
+    const int _client_rank {0};
+
+    // Events are processed in order of (time, sequence number) for determinism
+    enum EventType {JOB_ARRIVAL, MESSAGE, TICK};
+    struct SimEvent {
+        double time;
+        long seq;
+        EventType type;
+        int jobId;
+        bool operator>(const SimEvent& other) const {
+            if (time != other.time) return time > other.time;
+            return seq > other.seq;
+        }
+    };
+    std::priority_queue<SimEvent, std::vector<SimEvent>, std::greater<SimEvent>> _events;
+    long _running_seq {0};
+    robin_hood::unordered_map<long, SimulatedEnvironment::Message> _messages_in_flight;
+    double _time {0};
+    unsigned long _num_processed_events {0};
+    unsigned long _num_ticks {0};
+
+    // Counterpart of a Worker
+    struct SimPe {
+        std::unique_ptr<MessageQueue> queue;
+        std::unique_ptr<RandomizedRoutingTree> tree;
+        std::unique_ptr<JobRegistry> registry;
+        std::unique_ptr<WorkerSysState> sysstate;
+        std::unique_ptr<SchedulingManager> schedMan;
+        PeriodicEvent<10, 1> periodicJobCheck;
+        PeriodicEvent<1> periodicBalanceCheck;
+        PeriodicEvent<1000> periodicMaintenance;
+        bool jobActive {false};
+    };
+    std::vector<SimPe> _pes;
+
+    // Counterpart of a Client
+    struct SimJob {
+        std::unique_ptr<JobDescription> desc;
+        double arrival;
+        bool done {false};
+    };
+    std::vector<SimJob> _jobs; // job ID i is at position i-1
+    std::list<MessageSubscription> _client_subscriptions;
+    int _num_done_jobs {0};
+    int _num_timeouts {0};
+
+    // Statistics
+    std::vector<float> _root_latencies;
+    std::vector<float> _response_times;
+    double _sum_busy {0};
+    double _sum_committed {0};
+    double _sum_volumes {0};
+    unsigned long _num_measured_ticks {0};
+
+public:
+    SchedulerSimulation(Parameters& params) : _params(params), _num_pes(params.simNumPes()),
+            _latency(params.simMessageLatency()), _tick_period(params.simTickPeriod()) {
+
+        SimulatedEnvironment::get().init(_num_pes, [&](SimulatedEnvironment::Message&& msg) {
+            long seq = _running_seq++;
+            double time = _time + _latency;
+            _messages_in_flight[seq] = std::move(msg);
+            _events.push(SimEvent{time, seq, MESSAGE, 0});
+        });
+        createJobs();
+        setUpPes();
+        setUpClient();
+        schedule(0, TICK);
+    }
+
+    ~SchedulerSimulation() {
+        // Tear down in the context of each PE so that subscriptions find their queue
+        SimulatedEnvironment::setCurrentRank(_client_rank);
+        _client_subscriptions.clear();
+        for (int rank = 0; rank < _num_pes; rank++) {
+            SimulatedEnvironment::setCurrentRank(rank);
+            auto& pe = _pes[rank];
+            pe.schedMan.reset();
+            pe.registry.reset();
+            pe.sysstate.reset();
+            pe.tree.reset();
+            pe.queue.reset();
+        }
+    }
+
+    void run() {
+        // Timer::elapsedSeconds() follows the simulated clock as well
+        auto wallclockStart = std::chrono::steady_clock::now();
+        while (!_events.empty()) {
+            auto ev = _events.top();
+            _events.pop();
+            if (_params.timeLimit() > 0 && ev.time > _params.timeLimit()) break;
+            _time = ev.time;
+            // All components read the (cached) time, which follows the simulated clock
+            Timer::setElapsedSecondsCached(_time);
+            process(ev);
+            _num_processed_events++;
+        }
+        float wallclockTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - wallclockStart).count();
+        report(wallclockTime, tearDownSchedulers());
+    }
+
+private:
+    void createJobs() {
+        ClientTemplate clientTemplate(_params.seed(), _params.clientTemplate());
+        if (!clientTemplate.valid()) {
+            LOG(V0_CRIT, "[ERROR] Scheduler simulation requires a client template (-client-template)\n");
+            Logger::getMainInstance().flush();
+            abort();
+        }
+        // -jwl serves as the default job duration and must not abort the simulated jobs
+        const float defaultDuration = _params.jobWallclockLimit();
+        _params.jobWallclockLimit.set(0);
+        const int appId = app_registry::getAppId(SimulatedJob::APP_KEY);
+
+        for (int i = 0; i < _params.simNumJobs(); i++) {
+            int id = i+1;
+            double arrival = clientTemplate.getNextArrival();
+            float priority = clientTemplate.getNextPriority();
+            int maxDemand = clientTemplate.getNextMaxDemand();
+            if (_params.maxDemand() > 0 && (maxDemand <= 0 || maxDemand > _params.maxDemand()))
+                maxDemand = _params.maxDemand();
+            float duration = clientTemplate.getNextWallclockLimit();
+            if (duration <= 0) duration = defaultDuration;
+            if (duration <= 0) {
+                LOG(V0_CRIT, "[ERROR] Simulated jobs need a finite wallclock limit (template or -jwl)\n");
+                Logger::getMainInstance().flush();
+                abort();
+            }
+            auto desc = std::make_unique<JobDescription>(id, priority, appId);
+            desc->setClientRank(_client_rank);
+            desc->setMaxDemand(maxDemand);
+            desc->setArrival(arrival);
+            desc->setAppConfigurationEntry(SimulatedJob::DURATION_KEY, std::to_string(duration));
+            desc->beginInitialization(0);
+            desc->endInitialization();
+            _jobs.push_back(SimJob{std::move(desc), arrival});
+            schedule(arrival, JOB_ARRIVAL, id);
+        }
+    }
+
+    void setUpPes() {
+        _pes.resize(_num_pes);
+        // All PEs must share the same bounce graph: draw its permutations only once
+        // (each real process draws them from an identically seeded global RNG)
+        auto permutations = AdjustablePermutation::getPermutations(_num_pes,
+            RandomizedRoutingTree::getNumBounceAlternatives(_params, _num_pes));
+        // Setting up the routing trees is expensive (Dijkstra on the bounce graph
+        // for each PE), so the trees are set up in parallel
+        int numThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; t++) {
+            threads.emplace_back([&, t]() {
+                for (int rank = t; rank < _num_pes; rank += numThreads) {
+                    SimulatedEnvironment::setCurrentRank(rank);
+                    _pes[rank].queue.reset(new MessageQueue(_params.messageBatchingThreshold()));
+                    _pes[rank].tree.reset(new RandomizedRoutingTree(_params, _comm, permutations));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        // The scheduling managers draw from the global RNG: set them up one after the other
+        for (int rank = 0; rank < _num_pes; rank++) {
+            SimulatedEnvironment::setCurrentRank(rank);
+            auto& pe = _pes[rank];
+            pe.registry.reset(new JobRegistry(_params, _comm, /*useJanitor=*/false));
+            pe.sysstate.reset(new WorkerSysState(_comm, _params.sysstatePeriod(), WorkerSysState::ALLREDUCE));
+            pe.schedMan.reset(new SchedulingManager(_params, _comm, *pe.tree, *pe.registry, *pe.sysstate));
+        }
+        LOG(V2_INFO, "SIM set up %i PEs\n", _num_pes);
+    }
+
+    void setUpClient() {
+        SimulatedEnvironment::setCurrentRank(_client_rank);
+        _client_subscriptions.emplace_back(MSG_OFFER_ADOPTION_OF_ROOT, [&](MessageHandle& h) {
+            JobRequest req = Serializable::get<JobRequest>(h.getRecvData());
+            _root_latencies.push_back(_time - req.timeOfBirth);
+            auto& desc = *getJob(req.jobId).desc;
+            MyMpi::isend(h.source, MSG_SEND_JOB_DESCRIPTION, desc.getSerialization(desc.getRevision()));
+        });
+        _client_subscriptions.emplace_back(MSG_NOTIFY_JOB_DONE, [&](MessageHandle& h) {
+            JobStatistics stats = Serializable::get<JobStatistics>(h.getRecvData());
+            MyMpi::isendCopy(stats.successfulRank, MSG_QUERY_JOB_RESULT, h.getRecvData());
+        });
+        _client_subscriptions.emplace_back(MSG_SEND_JOB_RESULT, [&](MessageHandle& h) {
+            JobResult result(h.moveRecvData());
+            finishJob(result.id, /*timeout=*/false);
+        });
+        _client_subscriptions.emplace_back(MSG_NOTIFY_CLIENT_JOB_ABORTING, [&](MessageHandle& h) {
+            IntVec payload = Serializable::get<IntVec>(h.getRecvData());
+            finishJob(payload[0], /*timeout=*/true);
+        });
+    }
+
+    void schedule(double time, EventType type, int jobId = 0) {
+        _events.push(SimEvent{time, _running_seq++, type, jobId});
+    }
+
+    SimJob& getJob(int jobId) {
+        return _jobs[jobId-1];
+    }
+
+    void process(const SimEvent& ev) {
+        switch (ev.type) {
+        case JOB_ARRIVAL:
+            introduceJob(ev.jobId);
+            break;
+        case MESSAGE: {
+            auto it = _messages_in_flight.find(ev.seq);
+            auto msg = std::move(it->second);
+            _messages_in_flight.erase(it);
+            SimulatedEnvironment::get().deliver(std::move(msg));
+            break;
+        }
+        case TICK:
+            tick();
+            if (_num_done_jobs < (int)_jobs.size()) schedule(_time + _tick_period, TICK);
+            break;
+        }
+    }
+
+    // Counterpart of Client::introduceNextJob
+    void introduceJob(int jobId) {
+        auto& job = getJob(jobId);
+        AdjustablePermutation p(_num_pes, jobId);
+        JobRequest req(jobId, job.desc->getApplicationId(), /*rootRank=*/-1, /*requestingNodeRank=*/_client_rank,
+            /*requestedNodeIndex=*/0, /*timeOfBirth=*/job.arrival, /*balancingEpoch=*/-1, /*numHops=*/0, false);
+        SimulatedEnvironment::setCurrentRank(_client_rank);
+        MyMpi::isend(p.get(0), MSG_REQUEST_NODE, req);
+    }
+
+    void finishJob(int jobId, bool timeout) {
+        auto& job = getJob(jobId);
+        if (job.done) return;
+        job.done = true;
+        _num_done_jobs++;
+        if (timeout) _num_timeouts++;
+        else _response_times.push_back(_time - job.arrival);
+    }
+
+    void tick() {
+        _num_ticks++;
+        int numBusy = 0, numCommitted = 0, sumOfVolumes = 0;
+        for (int rank = 0; rank < _num_pes; rank++) {
+            SimulatedEnvironment::setCurrentRank(rank);
+            auto& pe = _pes[rank];
+            pe.queue->advance();
+            advanceWorker(pe);
+            if (pe.registry->hasActiveJob()) {
+                numBusy++;
+                auto& job = pe.registry->getActive();
+                if (job.getJobTree().isRoot()) sumOfVolumes += job.getVolume();
+            } else if (pe.registry->isBusyOrCommitted()) numCommitted++;
+        }
+        if (_time >= getJob(1).arrival) {
+            _sum_busy += numBusy;
+            _sum_committed += numCommitted;
+            _sum_volumes += std::min(sumOfVolumes, _num_pes);
+            _num_measured_ticks++;
+        }
+    }
+
+    // Counterpart of Worker::advance and Worker::checkJobs
+    void advanceWorker(SimPe& pe) {
+        if (pe.registry->hasActiveJob() != pe.jobActive) {
+            pe.jobActive = pe.registry->hasActiveJob();
+            if (pe.jobActive) pe.periodicJobCheck.resetToInitPeriod();
+        }
+        if (pe.periodicBalanceCheck.ready(_time)) {
+            pe.schedMan->advanceBalancing();
+        }
+        if (pe.periodicMaintenance.ready(_time)) {
+            pe.schedMan->forgetOldJobs();
+            pe.schedMan->forwardDeferredRequests();
+        }
+        if (pe.periodicJobCheck.ready(_time)) {
+            pe.schedMan->tryAdoptPendingRootActivationRequest();
+            if (!pe.registry->hasActiveJob()) {
+                float busy = pe.registry->isBusyOrCommitted() ? 1 : 0;
+                pe.sysstate->setLocal(SYSSTATE_BUSYRATIO, busy);
+                pe.sysstate->setLocal(SYSSTATE_COMMITTEDRATIO, busy);
+                pe.sysstate->setLocal(SYSSTATE_NUMJOBS, 0);
+            } else {
+                pe.sysstate->setLocal(SYSSTATE_BUSYRATIO, 1);
+                pe.sysstate->setLocal(SYSSTATE_COMMITTEDRATIO, 0);
+                pe.sysstate->setLocal(SYSSTATE_NUMJOBS, pe.registry->getActive().getJobTree().isRoot() ? 1 : 0);
+                pe.schedMan->checkActiveJob();
+            }
+            pe.schedMan->checkSuspendedJobs();
+            pe.schedMan->checkOldJobs();
+        }
+    }
+
+    struct SchedulerStats {
+        std::vector<float> nodeLatencies;
+        double numAdoptions {0};
+        double sumOfHops {0};
+    };
+    // Destructs the scheduling managers, which report the remaining jobs to their registry
+    SchedulerStats tearDownSchedulers() {
+        SchedulerStats stats;
+        for (int rank = 0; rank < _num_pes; rank++) {
+            SimulatedEnvironment::setCurrentRank(rank);
+            auto& pe = _pes[rank];
+            pe.schedMan.reset();
+            for (auto& latencies : pe.registry->getLatencyReport().getDesireLatencies())
+                stats.nodeLatencies.insert(stats.nodeLatencies.end(), latencies.begin(), latencies.end());
+            stats.numAdoptions += pe.sysstate->getLocal()[SYSSTATE_NUMADOPTIONS];
+            stats.sumOfHops += pe.sysstate->getLocal()[SYSSTATE_SUMADOPTIONHOPS];
+        }
+        return stats;
+    }
+
+    void reportStats(const char* name, std::vector<float>&& data) {
+        DataStatistics stats(std::move(data));
+        stats.computeStats();
+        if (stats.num() == 0) {
+            LOG(V2_INFO, "SIM %s num:0\n", name);
+            return;
+        }
+        LOG(V2_INFO, "SIM %s num:%lu min:%.6f med:%.6f mean:%.6f p99:%.6f max:%.6f\n", name,
+            stats.num(), stats.min(), stats.median(), stats.mean(), stats.percentiles()[99], stats.max());
+    }
+
+    void report(float wallclockTime, SchedulerStats&& stats) {
+        double span = _num_measured_ticks * (double)_num_pes;
+        LOG(V2_INFO, "SIM pes=%i jobs=%i done=%i timeouts=%i simtime=%.3fs ticks=%lu events=%lu walltime=%.3fs\n",
+            _num_pes, (int)_jobs.size(), _num_done_jobs, _num_timeouts, _time, _num_ticks, _num_processed_events, wallclockTime);
+        reportStats("root_latency", std::move(_root_latencies));
+        reportStats("node_latency", std::move(stats.nodeLatencies));
+        reportStats("response_time", std::move(_response_times));
+        LOG(V2_INFO, "SIM adoptions num:%.0f avg_hops:%.3f\n", stats.numAdoptions,
+            stats.numAdoptions > 0 ? stats.sumOfHops / stats.numAdoptions : 0);
+        LOG(V2_INFO, "SIM utilization busy:%.5f committed:%.5f assigned_volume:%.5f fulfilled_volume:%.5f\n",
+            span > 0 ? _sum_busy / span : 0, span > 0 ? _sum_committed / span : 0,
+            span > 0 ? _sum_volumes / span : 0, _sum_volumes > 0 ? _sum_busy / _sum_volumes : 0);
+        unsigned long numMsgs = 0, numBytes = 0;
+        for (const auto& [tag, count] : SimulatedEnvironment::get().getMessageCounts()) {
+            LOG(V2_INFO, "SIM messages tag:%i num:%lu bytes:%lu\n", tag, count.num, count.bytes);
+            numMsgs += count.num;
+            numBytes += count.bytes;
+        }
+        double simSpan = _num_measured_ticks * _tick_period;
+        LOG(V2_INFO, "SIM messages total num:%lu bytes:%lu per_pe_and_second:%.3f\n", numMsgs, numBytes,
+            simSpan > 0 ? numMsgs / simSpan / _num_pes : 0);
+    }
+};
@@ -0,0 +1,96 @@
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "comm/msg_queue/message_queue.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+
+/*
+In-process stand-in for the MPI layer, used by the scheduler simulation (mallob_sched_sim).
+A single process hosts many virtual PEs. The "real" scheduling classes are always executed
+on behalf of one virtual PE at a time (the current rank), and MyMpi::rank(), MyMpi::size()
+and MyMpi::getMessageQueue() resolve to this PE (see simulated_mpi.cpp). Sent messages are
+handed to the simulation, which later delivers each message to its destination's MessageQueue
+at some point in simulated time.
+*/
+class SimulatedEnvironment {
+
+public:
+    struct Message {
+        int source;
+        int dest;
+        int tag;
+        std::vector<uint8_t> data;
+    };
+    struct MessageCount {
+        unsigned long num {0};
+        unsigned long bytes {0};
+    };
+
+private:
+    static inline thread_local int _current_rank {0};
+
+    int _num_pes {1};
+    std::vector<MessageQueue*> _queues;
+    std::optional<Message> _delivery;
+
+    std::function<void(Message&&)> _send_callback;
+
+    std::map<int, MessageCount> _counts_per_tag;
+
+public:
+    static SimulatedEnvironment& get() {
+        static SimulatedEnvironment env;
+        return env;
+    }
+
+    static int getCurrentRank() {return _current_rank;}
+    static void setCurrentRank(int rank) {_current_rank = rank;}
+
+    void init(int numPes, std::function<void(Message&&)> sendCallback) {
+        _num_pes = numPes;
+        _queues.assign(numPes, nullptr);
+        _send_callback = sendCallback;
+    }
+    int getNumPes() const {return _num_pes;}
+
+    void registerQueue(int rank, MessageQueue* queue) {
+        if (rank < (int)_queues.size()) _queues[rank] = queue;
+    }
+    MessageQueue& getQueue(int rank) {
+        assert(_queues.at(rank) != nullptr);
+        return *_queues[rank];
+    }
+
+    void send(int source, int dest, int tag, std::vector<uint8_t>&& data) {
+        assert(dest >= 0 && dest < _num_pes || LOG_RETURN_FALSE("Invalid destination %i\n", dest));
+        auto& c = _counts_per_tag[tag];
+        c.num++;
+        c.bytes += data.size();
+        _send_callback(Message{source, dest, tag, std::move(data)});
+    }
+
+    const std::map<int, MessageCount>& getMessageCounts() const {
+        return _counts_per_tag;
+    }
+
+    // Hand the message to its destination's MessageQueue, which digests it in advance().
+    void deliver(Message&& msg) {
+        int dest = msg.dest;
+        setCurrentRank(dest);
+        _delivery = std::move(msg);
+        getQueue(dest).advance();
+        _delivery.reset();
+    }
+    std::optional<Message> takeDelivery(int rank) {
+        if (!_delivery || _delivery->dest != rank) return std::optional<Message>();
+        auto msg = std::move(_delivery);
+        _delivery.reset();
+        return msg;
+    }
+};
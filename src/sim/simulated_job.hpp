@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include <string>
+
+#include "app/job.hpp"
+#include "app/app_registry.hpp"
+#include "app/sat/job/sat_constants.h"
+#include "data/job_result.hpp"
+
+/*
+Job application of the scheduler simulation. A simulated job does not perform any
+computation: its root reports a result as soon as the job has been active for the
+duration given by its description (application configuration entry "sim-duration").
+*/
+class SimulatedJob : public Job {
+
+private:
+    float _duration {0};
+    JobResult _result;
+
+public:
+    static constexpr const char* APP_KEY = "SIM";
+    static constexpr const char* DURATION_KEY = "sim-duration";
+
+    SimulatedJob(const Parameters& params, const JobSetup& setup, AppMessageTable& table)
+        : Job(params, setup, table) {}
+
+    void appl_start() override {
+        _duration = std::stof(getDescription().getAppConfiguration().map.at(DURATION_KEY));
+    }
+    void appl_suspend() override {}
+    void appl_resume() override {}
+    void appl_terminate() override {}
+    int appl_solved() override {
+        if (!getJobTree().isRoot() || getAgeSinceActivation() < _duration) return -1;
+        _result.id = getId();
+        _result.revision = getRevision();
+        _result.result = RESULT_SAT;
+        _result.setSolutionToSerialize(nullptr, 0);
+        return RESULT_SAT;
+    }
+    JobResult&& appl_getResult() override {return std::move(_result);}
+    void appl_communicate() override {}
+    void appl_communicate(int, int, JobMessage&) override {}
+    void appl_dumpStats() override {}
+    bool appl_isDestructible() override {return true;}
+    void appl_memoryPanic() override {}
+
+    static void registerApplication() {
+        app_registry::registerApplication(APP_KEY,
+            // Job reader: descriptions are assembled by the simulated client
+            [](const Parameters&, const std::vector<std::string>&, JobDescription&) {
+                return true;
+            },
+            // Job creator
+            [](const Parameters& params, const Job::JobSetup& setup, AppMessageTable& table) -> Job* {
+                return new SimulatedJob(params, setup, table);
+            },
+            // Job solution formatter
+            [](const JobResult&) {
+                return nlohmann::json();
+            }
+        );
+    }
+};
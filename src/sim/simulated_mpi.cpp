@@ -0,0 +1,150 @@
+
+// Simulated counterparts of comm/mympi.cpp and comm/msg_queue/message_queue.cpp, which are
+// replaced by this file in the mallob_sched_sim target, and of the few MPI functions declared
+// in sim/simulated_mpi.h. All calls are resolved on behalf of the current virtual PE
+// (see SimulatedEnvironment).
+
+#include <cstring>
+
+#include "comm/mympi.hpp"
+#include "comm/msg_queue/message_queue.hpp"
+#include "sim/simulated_environment.hpp"
+
+int MPI_Test(MPI_Request*, int* flag, MPI_Status*) {
+    *flag = 1;
+    return MPI_SUCCESS;
+}
+int MPI_Comm_group(MPI_Comm comm, MPI_Group* group) {
+    *group = comm;
+    return MPI_SUCCESS;
+}
+int MPI_Group_translate_ranks(MPI_Group, int n, const int* ranks1, MPI_Group, int* ranks2) {
+    // All communicators span all virtual PEs
+    memcpy(ranks2, ranks1, n * sizeof(int));
+    return MPI_SUCCESS;
+}
+int MPI_Isend(const void*, int, MPI_Datatype, int, int, MPI_Comm, MPI_Request*) {
+    abort(); // messages are handed to the simulation in MessageQueue::send
+}
+
+MessageQueue* MyMpi::_msg_queue;
+
+void MyMpi::init() {}
+void MyMpi::setOptions(const Parameters&) {}
+
+int MyMpi::isend(int recvRank, int tag, const Serializable& object) {
+    return getMessageQueue().send(DataPtr(new std::vector<uint8_t>(object.serialize())), recvRank, tag);
+}
+int MyMpi::isend(int recvRank, int tag, std::vector<uint8_t>&& object) {
+    return getMessageQueue().send(DataPtr(new std::vector<uint8_t>(std::move(object))), recvRank, tag);
+}
+int MyMpi::isend(int recvRank, int tag, const DataPtr& object) {
+    return getMessageQueue().send(object, recvRank, tag);
+}
+int MyMpi::isendCopy(int recvRank, int tag, const std::vector<uint8_t>& object) {
+    return getMessageQueue().send(DataPtr(new std::vector<uint8_t>(object)), recvRank, tag);
+}
+
+int MyMpi::size(MPI_Comm) {
+    return SimulatedEnvironment::get().getNumPes();
+}
+int MyMpi::rank(MPI_Comm) {
+    return SimulatedEnvironment::getCurrentRank();
+}
+
+MessageQueue& MyMpi::getMessageQueue() {
+    return SimulatedEnvironment::get().getQueue(SimulatedEnvironment::getCurrentRank());
+}
+
+
+MessageQueue::MessageQueue(int maxMsgSize) : _max_msg_size(maxMsgSize) {
+    _my_rank = SimulatedEnvironment::getCurrentRank();
+    _comm_size = SimulatedEnvironment::get().getNumPes();
+    _current_recv_tag = &_default_tag_var;
+    _current_send_tag = &_default_tag_var;
+    SimulatedEnvironment::get().registerQueue(_my_rank, this);
+}
+
+MessageQueue::~MessageQueue() {
+    SimulatedEnvironment::get().registerQueue(_my_rank, nullptr);
+}
+
+MessageQueue::CallbackRef MessageQueue::registerCallback(int tag, const MsgCallback& cb) {
+    _callbacks[tag].push_back(cb);
+    auto it = _callbacks[tag].end();
+    --it;
+    return it;
+}
+
+void MessageQueue::registerSentCallback(int tag, const SendDoneCallback& cb) {
+    _send_done_callbacks[tag] = cb;
+}
+
+void MessageQueue::clearCallbacks() {
+    _callbacks.clear();
+    _send_done_callbacks.clear();
+}
+
+void MessageQueue::clearCallback(int tag, const CallbackRef& ref) {
+    _callbacks[tag].erase(ref);
+}
+
+int MessageQueue::send(const DataPtr& data, int dest, int tag) {
+    *_current_send_tag = tag;
+    int sendId = _running_send_id++;
+    // Messages are copied right away, so each send completes with the next call to advance()
+    SimulatedEnvironment::get().send(_my_rank, dest, tag, std::vector<uint8_t>(*data));
+    _send_queue.emplace_back(sendId, dest, tag, data, _max_msg_size);
+    return sendId;
+}
+
+void MessageQueue::cancelSend(int sendId) {
+    for (auto& h : _send_queue) if (h.id == sendId) h.cancelled = true;
+}
+
+void MessageQueue::advance() {
+    processSent();
+    auto msg = SimulatedEnvironment::get().takeDelivery(_my_rank);
+    if (!msg) return;
+    MessageHandle h;
+    h.tag = msg->tag;
+    h.source = msg->source;
+    h.setReceive(std::move(msg->data));
+    *_current_recv_tag = h.tag;
+    digestReceivedMessage(h);
+}
+
+void MessageQueue::processSent() {
+    // Callbacks may send further messages: only complete the sends made so far
+    std::list<SendHandle> sent = std::move(_send_queue);
+    _send_queue.clear();
+    for (auto& h : sent) if (!h.cancelled) signalCompletion(h.tag, h.id);
+}
+
+void MessageQueue::signalCompletion(int tag, int id) {
+    auto it = _send_done_callbacks.find(tag);
+    if (it != _send_done_callbacks.end()) it->second(id);
+}
+
+bool MessageQueue::hasOpenSends() {
+    return !_send_queue.empty();
+}
+
+void MessageQueue::digestReceivedMessage(MessageHandle& h) {
+
+    auto it = _callbacks.find(h.tag);
+    if (it == _callbacks.end() || it->second.empty()) {
+        LOG(V1_WARN, "[WARN] No callback for message of tag %i\n", h.tag);
+        return;
+    }
+    auto& callbacks = it->second;
+    if (callbacks.size() == 1) {
+        callbacks.front()(h);
+        return;
+    }
+    for (auto& cb : callbacks) {
+        MessageHandle copy(h);
+        cb(copy);
+    }
+}
+
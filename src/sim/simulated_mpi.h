@@ -0,0 +1,46 @@
+
+#pragma once
+
+/*
+Minimal stand-in for <mpi.h>, used instead of the actual MPI headers if
+MALLOB_SIMULATED_MPI is defined (see comm/mpi_base.hpp). This is the case for
+the scheduler simulation (mallob_sched_sim), which hosts all virtual PEs within
+a single process and exchanges their messages via an in-process MessageQueue.
+Only the types, constants and functions referenced by the scheduling code are
+provided. All communicators are (aliases of) the world communicator, and the
+few MPI calls made outside of the message queue are defined in simulated_mpi.cpp.
+*/
+
+typedef int MPI_Comm;
+typedef int MPI_Group;
+typedef int MPI_Request;
+typedef int MPI_Op;
+typedef int MPI_Datatype;
+struct MPI_Status {
+    int MPI_SOURCE;
+    int MPI_TAG;
+    int MPI_ERROR;
+};
+
+#define MPI_COMM_NULL 0
+#define MPI_COMM_WORLD 1
+#define MPI_REQUEST_NULL 0
+#define MPI_STATUS_IGNORE ((MPI_Status*) 0)
+#define MPI_ANY_SOURCE (-1)
+#define MPI_ANY_TAG (-1)
+#define MPI_SUCCESS 0
+
+#define MPI_SUM 1
+#define MPI_MIN 2
+#define MPI_MAX 3
+
+#define MPI_BYTE 1
+#define MPI_INT 2
+#define MPI_FLOAT 3
+
+int MPI_Test(MPI_Request* request, int* flag, MPI_Status* status);
+int MPI_Comm_group(MPI_Comm comm, MPI_Group* group);
+int MPI_Group_translate_ranks(MPI_Group group1, int n, const int* ranks1, MPI_Group group2, int* ranks2);
+// Declared for the header-defined send handles of the message queue only,
+// which are not used by the simulated message queue
+int MPI_Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm, MPI_Request* request);
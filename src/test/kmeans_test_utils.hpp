@@ -0,0 +1,25 @@
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "util/random.hpp"
+
+// Gaussian blobs around numBlobs random centers
+inline std::vector<float> generateBlobs(int numPoints, int dim, int numBlobs, float spread, uint64_t seed) {
+    SplitMix64Rng rng(seed);
+    auto gaussian = [&]() {
+        // Box-Muller
+        double u1 = rng.randomInRange(1e-12, 1), u2 = rng.randomInRange(0, 1);
+        return (float) (std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2));
+    };
+    std::vector<float> blobs((size_t) numBlobs * dim);
+    for (auto& x : blobs) x = rng.randomInRange(-100, 100);
+    std::vector<float> points((size_t) numPoints * dim);
+    for (int i = 0; i < numPoints; i++) {
+        int blob = rng() % numBlobs;
+        for (int d = 0; d < dim; d++) points[(size_t) i*dim + d] = blobs[(size_t) blob*dim + d] + spread * gaussian();
+    }
+    return points;
+}
@@ -0,0 +1,132 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/async_logger.hpp"
+#include "util/logger.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/timer.hpp"
+
+const int NUM_THREADS = 32;
+
+double getThreadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + 0.000000001 * ts.tv_nsec;
+}
+
+// All threads log concurrently at verbosity 4.
+// Returns the CPU time (s) which the logging threads spent in total.
+double logFromThreads(int round, int numMessages) {
+    std::vector<std::thread> threads;
+    std::vector<double> cpuTimes(NUM_THREADS);
+    for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([t, round, numMessages, &cpuTimes]() {
+            std::string name = "thread#" + std::to_string(t);
+            double time = getThreadCpuSeconds();
+            for (int i = 0; i < numMessages; i++) {
+                LOG(V4_VVER, "r%i %s msg %i %.2f %lu %5.1f%% %-4s|%c %.*s\n", round, name.c_str(), i,
+                    0.5*i, (unsigned long) i << 20, 12.5, "ab", 'x', 3, "truncated");
+            }
+            cpuTimes[t] = getThreadCpuSeconds() - time;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    double sum = 0;
+    for (double time : cpuTimes) sum += time;
+    return sum;
+}
+
+std::string expectedMessage(int round, int t, int i) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "r%i thread#%i msg %i %.2f %lu %5.1f%% %-4s|%c %.*s", round, t, i,
+        0.5*i, (unsigned long) i << 20, 12.5, "ab", 'x', 3, "truncated");
+    return buf;
+}
+
+// Every message of the round occurs exactly once, and the messages of each
+// thread occur in the order they were logged.
+void checkLog(const std::string& logFile, int round, int numMessages) {
+    std::ifstream ifs(logFile);
+    std::string line;
+    std::vector<int> nextIndex(NUM_THREADS, 0);
+    std::string prefix = "r" + std::to_string(round) + " ";
+    size_t numLines = 0;
+    while (std::getline(ifs, line)) {
+        float time; int rank; int offset;
+        if (sscanf(line.c_str(), "%f %i %n", &time, &rank, &offset) != 2) continue;
+        std::string message = line.substr(offset);
+        if (message.rfind(prefix, 0) != 0) continue;
+        int t = atoi(message.c_str() + prefix.size() + 7);
+        assert(t >= 0 && t < NUM_THREADS);
+        assert(message == expectedMessage(round, t, nextIndex[t])
+            || fprintf(stderr, "Unexpected line \"%s\"\n", message.c_str()) < 0);
+        nextIndex[t]++;
+        numLines++;
+    }
+    assert(numLines == NUM_THREADS * numMessages);
+}
+
+int main() {
+    Timer::init();
+    std::string logDir = "/tmp/mallob_test_async_logger." + std::to_string(getpid());
+    std::string logFilename = "log";
+    Logger::LoggerConfig config;
+    config.verbosity = V4_VVER;
+    config.quiet = true;
+    config.logDirOrNull = &logDir;
+    config.logFilenameOrNull = &logFilename;
+    Logger::init(config);
+    const std::string logFile = Logger::getMainInstance().getLogFilename();
+
+    // Short bursts fit into the buffers, so the logging threads only record their calls.
+    // Sustained logging fills the buffers, and the logging threads also drain them.
+    int round = 0;
+    for (int numMessages : {2'000, 10'000}) {
+        float time = Timer::elapsedSeconds();
+        const double cpuTimeSync = logFromThreads(++round, numMessages);
+        Logger::getMainInstance().flush();
+        const float timeSync = Timer::elapsedSeconds() - time;
+
+        AsyncLogger::start();
+        time = Timer::elapsedSeconds();
+        const double cpuTimeAsync = logFromThreads(++round, numMessages);
+        Logger::getMainInstance().flush();
+        const float timeAsync = Timer::elapsedSeconds() - time;
+        AsyncLogger::stop();
+
+        // (Synchronous logging from several threads may interleave the parts of lines.)
+        checkLog(logFile, round, numMessages);
+        printf("%i threads x %i messages: synchronous %.3fs (%.3fs CPU in logging threads), asynchronous %.3fs (%.3fs CPU in logging threads)\n",
+            NUM_THREADS, numMessages, timeSync, cpuTimeSync, timeAsync, cpuTimeAsync);
+    }
+
+    // Non-literal format strings and large messages
+    AsyncLogger::start();
+    std::string format = "non-literal format %i\n";
+    LOG(V2_INFO, format.c_str(), 42);
+    format = "overwritten";
+    std::string large(100'000, 'y');
+    LOG(V2_INFO, "large %s\n", large.c_str());
+    LOG(V2_INFO, "after large\n");
+    AsyncLogger::stop();
+    {
+        std::ifstream ifs(logFile);
+        std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        auto posNonLiteral = content.find(" non-literal format 42\n");
+        auto posLarge = content.find(" large " + large + "\n");
+        auto posAfter = content.find(" after large\n");
+        assert(posNonLiteral != std::string::npos);
+        assert(posLarge != std::string::npos);
+        assert(posAfter != std::string::npos);
+        assert(posNonLiteral < posLarge && posLarge < posAfter);
+    }
+    FileUtils::rmrf(logDir);
+}
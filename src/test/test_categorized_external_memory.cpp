@@ -1,12 +1,15 @@
 
+#include <cstdlib>
+#include <fstream>
+
 #include "util/categorized_external_memory.hpp"
 
 #include "util/sys/timer.hpp"
+#include "util/sys/fileutils.hpp"
 #include "util/random.hpp"
 
-void testBasic() {
-    auto blocksize = 4096;
-    CategorizedExternalMemory<long> ext("test.bin", blocksize);
+void testBasic(const ExternalMemoryConfig& config) {
+    CategorizedExternalMemory<long> ext("test.bin", config);
     
     ext.add(0, 1L);
     ext.add(0, 2L);
@@ -51,6 +54,19 @@ void testBasic() {
         }
         data.clear(); ext.fetchAndRemove(0, data); assert(data.empty());
     }
+
+    // Read ahead, then add more elements before fetching
+    for (int rep = 1; rep <= 10000; rep++) ext.add(5, (long) rep);
+    ext.prefetch(5);
+    for (int rep = 10001; rep <= 20000; rep++) ext.add(5, (long) rep);
+    ext.prefetch(5);
+    {
+        std::vector<long> data;
+        ext.fetchAndRemove(5, data);
+        assert(data.size() == 20000);
+        for (int rep = 0; rep < 20000; rep++) assert(data[rep] == rep+1);
+        assert(ext.size() == 1);
+    }
 }
 
 void testPerformance() {
@@ -93,11 +109,10 @@ void testPerformance() {
     }
 }
 
-void testBuckets() {
+void testBuckets(const ExternalMemoryConfig& config) {
     Random::init(1, 1);
 
-    auto blocksize = 4096;
-    CategorizedExternalMemory<int> ext("test.bin", blocksize);
+    CategorizedExternalMemory<int> ext("test.bin", config);
 
     for (size_t i = 0; i < 1024*1024; i++) {
         int elem = (int) (1024*1024*Random::rand()) + 1;
@@ -124,8 +139,91 @@ void testBuckets() {
     assert(ext.size() == 0);
 }
 
+std::vector<ExternalMemoryConfig> getConfigs() {
+    std::vector<ExternalMemoryConfig> configs;
+    for (auto backend : {AsyncBlockFile::THREADS, AsyncBlockFile::IO_URING}) {
+        for (size_t blockSize : {4096, 65536}) {
+            for (bool direct : {false, true}) {
+                ExternalMemoryConfig config;
+                config.backend = backend;
+                config.blockSize = blockSize;
+                config.directIo = direct;
+                configs.push_back(config);
+            }
+        }
+    }
+    // Odd block size and fully synchronous I/O
+    ExternalMemoryConfig config;
+    config.blockSize = 1000;
+    config.maxPendingWrites = 0;
+    config.readAheadBlocks = 0;
+    configs.push_back(config);
+    return configs;
+}
+
+// Access pattern of the proof assembly: IDs are added to the epochs preceding
+// the current epoch, and the epochs are fetched in decreasing order.
+// Run with MALLOB_EXTMEM_BENCH_DIR=<dir> and MALLOB_EXTMEM_BENCH_MIB=<size> exceeding the RAM.
+void benchmark() {
+    const char* sizeFromEnv = std::getenv("MALLOB_EXTMEM_BENCH_MIB");
+    const size_t numMiB = sizeFromEnv ? atol(sizeFromEnv) : 64;
+    const size_t numElems = numMiB * 1024*1024 / sizeof(unsigned long);
+    const int numEpochs = 1000;
+    const char* dirFromEnv = std::getenv("MALLOB_EXTMEM_BENCH_DIR");
+    const std::string diskDir = dirFromEnv ? dirFromEnv : ".disk";
+    FileUtils::mkdir(diskDir);
+    const std::string diskFile = diskDir + "/disk.benchmark";
+
+    auto run = [&](const char* label, const ExternalMemoryConfig& config) {
+        Random::init(1, 1);
+        float time = Timer::elapsedSeconds();
+        {
+            CategorizedExternalMemory<unsigned long> ext(diskFile, config);
+            for (size_t i = 0; i < numElems; i++) {
+                ext.add((size_t) (Random::rand() * (numEpochs-1)), i);
+            }
+            std::vector<unsigned long> data;
+            size_t numFetched = 0;
+            for (int epoch = numEpochs-1; epoch >= 0; epoch--) {
+                ext.fetchAndRemove(epoch, data);
+                if (epoch > 0) ext.prefetch(epoch-1);
+                numFetched += data.size();
+                data.clear();
+            }
+            assert(numFetched == numElems);
+        }
+        time = Timer::elapsedSeconds() - time;
+        LOG(V2_INFO, "%s: %lu MiB in %.3fs (%.1f MiB/s)\n", label, numMiB, time, 2*numMiB / time);
+    };
+
+    ExternalMemoryConfig synchronous;
+    synchronous.backend = AsyncBlockFile::THREADS;
+    synchronous.maxPendingWrites = 0;
+    synchronous.readAheadBlocks = 0;
+    run("synchronous, 4 KiB blocks", synchronous);
+    ExternalMemoryConfig config;
+    config.backend = AsyncBlockFile::IO_URING;
+    run("io_uring, 4 KiB blocks", config);
+    config.backend = AsyncBlockFile::THREADS;
+    config.blockSize = 65536;
+    run("threads, 64 KiB blocks", config);
+    config.backend = AsyncBlockFile::IO_URING;
+    run("io_uring, 64 KiB blocks", config);
+    config.directIo = true;
+    run("io_uring, 64 KiB blocks, direct I/O", config);
+    FileUtils::rm(diskFile);
+}
+
 int main() {
-    testBasic();
+    Timer::init();
+    Logger::init(0, V2_INFO);
+
+    for (auto& config : getConfigs()) {
+        LOG(V2_INFO, "Block size %lu, backend %i, direct I/O %i, max. pending writes %i\n",
+            config.blockSize, config.backend, config.directIo, config.maxPendingWrites);
+        testBasic(config);
+        testBuckets(config);
+    }
     testPerformance();
-    testBuckets();
+    benchmark();
 }
@@ -0,0 +1,173 @@
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "app/sat/data/clause_metadata.hpp"
+#include "app/sat/sharing/sharing_manager.hpp"
+#include "app/sat/solvers/portfolio_solver_interface.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/params.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+const int NUM_ORIGINAL_CLAUSES = 1000;
+const int NUM_VARS = 100'000;
+
+// Solver which only exports the clauses it is handed and counts the clauses it imports
+class MockSolver : public PortfolioSolverInterface {
+
+private:
+    LearnedClauseCallback _callback;
+
+public:
+    MockSolver(const SolverSetup& setup) : PortfolioSolverInterface(setup) {}
+
+    void produce(const Mallob::Clause& clause) {_callback(clause, getLocalId());}
+
+    int getVariablesCount() override {return NUM_VARS;}
+    int getSplittingVariable() override {return 1;}
+    void setPhase(const int var, const bool phase) override {}
+    SatResult solve(size_t numAssumptions, const int* assumptions) override {return UNKNOWN;}
+    std::vector<int> getSolution() override {return {};}
+    std::set<int> getFailedAssumptions() override {return {};}
+    void addLiteral(int lit) override {}
+    void setLearnedClauseCallback(const LearnedClauseCallback& callback) override {_callback = callback;}
+    void writeStatistics(SolverStatistics& stats) override {}
+    void diversify(int seed) override {}
+    int getNumOriginalDiversifications() override {return 1;}
+    bool supportsIncrementalSat() override {return false;}
+    bool exportsConditionalClauses() override {return false;}
+    void cleanUp() override {}
+    void setSolverInterrupt() override {}
+    void unsetSolverInterrupt() override {}
+    void setSolverSuspend() override {}
+    void unsetSolverSuspend() override {}
+};
+
+struct SharingResult {
+    unsigned long numExported {0};
+    unsigned long numImported {0};
+    float time {0};
+};
+
+// Sharing epochs of a single process: all solvers export clauses, which are then
+// collected, filtered, and imported by the other solvers. With proofs, each clause
+// carries its ID, which is aligned at export and checked at import.
+SharingResult runSharing(Parameters& params, int numSolvers, int numEpochs, int clausesPerSolverAndEpoch) {
+    const bool proofs = ClauseMetadata::enabled();
+    params.numThreadsPerProcess.set(numSolvers);
+    params.distributedProofAssembly.set(proofs);
+
+    // Large enough to share all clauses of an epoch
+    const int bufferSize = numSolvers * clausesPerSolverAndEpoch * (params.strictClauseLengthLimit() + 2);
+
+    std::vector<std::shared_ptr<PortfolioSolverInterface>> solvers;
+    std::vector<MockSolver*> mockSolvers;
+    for (int i = 0; i < numSolvers; i++) {
+        SolverSetup setup {};
+        setup.logger = &Logger::getMainInstance();
+        setup.globalId = i;
+        setup.localId = i;
+        setup.jobname = "bench";
+        setup.diversificationIndex = i;
+        setup.numOriginalClauses = NUM_ORIGINAL_CLAUSES;
+        setup.numVars = NUM_VARS;
+        setup.strictClauseLengthLimit = params.strictClauseLengthLimit();
+        setup.strictLbdLimit = params.strictLbdLimit();
+        setup.qualityClauseLengthLimit = params.qualityClauseLengthLimit();
+        setup.qualityLbdLimit = params.qualityLbdLimit();
+        setup.clauseBaseBufferSize = params.clauseBufferBaseSize();
+        setup.anticipatedLitsToImportPerCycle = bufferSize;
+        setup.minNumChunksPerSolver = params.minNumChunksForImportPerSolver();
+        setup.numBufferedClsGenerations = params.bufferedImportedClsGenerations();
+        setup.adaptiveImportManager = params.adaptiveImportManager();
+        setup.certifiedUnsat = proofs;
+        setup.maxNumSolvers = numSolvers;
+        mockSolvers.push_back(new MockSolver(setup));
+        solvers.emplace_back(mockSolvers.back());
+    }
+    SharingManager sharing(solvers, params, Logger::getMainInstance(), 10'000, 0, 0);
+
+    SharingResult result;
+    std::vector<int> buffer(bufferSize), filter(bufferSize);
+    std::vector<unsigned long> nextClauseIds(numSolvers);
+    for (int i = 0; i < numSolvers; i++) nextClauseIds[i] = NUM_ORIGINAL_CLAUSES + 1 + i;
+    std::vector<int> clauseData;
+    Mallob::Clause imported;
+
+    for (int epoch = 0; epoch < numEpochs; epoch++) {
+        // Generate the clauses beforehand so that only the sharing is timed
+        std::vector<std::vector<int>> clauses;
+        for (int i = 0; i < numSolvers * clausesPerSolverAndEpoch; i++) {
+            // same lengths with and without proofs, where a clause ID takes two more ints
+            const int size = 1 + Random::rand() * (params.strictClauseLengthLimit() - 2);
+            clauseData.assign(ClauseMetadata::numBytes(), 0);
+            for (int k = 0; k < size; k++) {
+                const int var = 1 + Random::rand() * NUM_VARS;
+                clauseData.push_back(Random::rand() < 0.5 ? -var : var);
+            }
+            clauses.push_back(clauseData);
+        }
+
+        float time = Timer::elapsedSeconds();
+        for (int i = 0; i < numSolvers * clausesPerSolverAndEpoch; i++) {
+            const int solverId = i % numSolvers;
+            auto& clause = clauses[i];
+            if (proofs) {
+                ClauseMetadata::writeUnsignedLong(nextClauseIds[solverId], clause.data());
+                nextClauseIds[solverId] += numSolvers;
+            }
+            const int size = clause.size();
+            const int lbd = size - ClauseMetadata::numBytes() == 1 ? 1 : 2;
+            mockSolvers[solverId]->produce(Mallob::Clause(clause.data(), size, lbd));
+        }
+        result.numExported += numSolvers * clausesPerSolverAndEpoch;
+
+        int successfulSolverId = -1, numLits;
+        int buflen = sharing.prepareSharing(buffer.data(), bufferSize, successfulSolverId, numLits);
+        sharing.filterSharing(buffer.data(), buflen, filter.data());
+        sharing.digestSharingWithFilter(buffer.data(), buflen, filter.data());
+        for (auto solver : mockSolvers) {
+            while (solver->fetchLearnedClause(imported)) {
+                if (proofs) {
+                    // A solver never imports its own clauses
+                    auto id = ClauseMetadata::readUnsignedLong(imported.begin);
+                    assert((id - NUM_ORIGINAL_CLAUSES - 1) % numSolvers != (unsigned long) solver->getGlobalId());
+                }
+                result.numImported++;
+            }
+            result.numImported += solver->fetchLearnedUnitClauses().size();
+        }
+        sharing.collectGarbageInFilter();
+        result.time += Timer::elapsedSeconds() - time;
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V2_INFO);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    Parameters params;
+    params.init(argc, argv);
+
+    // Clause IDs can only be enabled, so the run without proofs goes first
+    for (bool proofs : {false, true}) {
+        if (proofs) ClauseMetadata::enableClauseIds();
+        for (int numSolvers : {4, 32}) {
+            auto result = runSharing(params, numSolvers, 50, 2000);
+            assert(result.numImported > 0);
+            LOG(V2_INFO, "proofs %s, %i solvers: %lu clauses exported, %lu imported in %.3fs: %.0f exported, %.0f imported clauses/s\n",
+                proofs ? "on" : "off", numSolvers, result.numExported, result.numImported,
+                result.time, result.numExported / result.time, result.numImported / result.time);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+
+#include <unordered_set>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/bloom_filter.hpp"
+#include "util/compressed_id_set.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+// Compares the set with a reference for sparse, dense, and mixed IDs.
+void testCorrectness() {
+    for (unsigned long range : {1000UL, 100'000UL, 10'000'000UL, 1UL<<50}) {
+        CompressedIdSet set;
+        std::unordered_set<unsigned long> reference;
+        for (int i = 0; i < 200'000; i++) {
+            unsigned long id = (unsigned long) (Random::rand() * range);
+            bool inserted = set.tryInsert(id);
+            assert(inserted == reference.insert(id).second);
+            assert(set.contains(id));
+        }
+        assert(set.size() == reference.size());
+        for (int i = 0; i < 10'000; i++) {
+            unsigned long id = (unsigned long) (Random::rand() * range);
+            assert(set.contains(id) == (reference.count(id) > 0));
+        }
+        LOG(V2_INFO, "range=%lu: %lu IDs, %.3f MB\n", range, set.size(), set.getSizeInBytes() / 1e6);
+    }
+}
+
+// Simulates the deduplication of hints during proof merging: lines arrive in decreasing
+// order of their IDs, and most hints refer to recently derived clauses.
+template <typename Set>
+void simulateMerge(Set& set, unsigned long numLines, std::vector<bool>* insertions) {
+    const unsigned long numOriginalClauses = 1'000'000;
+    const int numInstances = 64;
+    SplitMix64Rng rng(1);
+    for (unsigned long line = numLines; line > 0; line--) {
+        const unsigned long id = numOriginalClauses + line * numInstances + line % numInstances;
+        const int numHints = 1 + rng() % 20;
+        for (int h = 0; h < numHints; h++) {
+            unsigned long hint;
+            if (rng() % 4 == 0) hint = 1 + rng() % (id-1);
+            else hint = id - 1 - rng() % std::min(id-1, 100'000UL);
+            if (hint <= numOriginalClauses) continue;
+            bool inserted = set.tryInsert(hint);
+            if (insertions) insertions->push_back(inserted);
+        }
+    }
+}
+
+void benchmark(unsigned long numLines) {
+    std::vector<bool> exactInsertions, bloomInsertions;
+
+    float time = Timer::elapsedSeconds();
+    CompressedIdSet set;
+    simulateMerge(set, numLines, nullptr);
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "%lu lines: compressed ID set %.3fs, %lu IDs, %.1f MB\n", numLines, time,
+        set.size(), set.getSizeInBytes() / 1e6);
+
+    time = Timer::elapsedSeconds();
+    BloomFilter<unsigned long> bloom(268435399, 4);
+    simulateMerge(bloom, numLines, nullptr);
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "%lu lines: Bloom filter %.3fs, %.1f MB\n", numLines, time, 268435399 / 8 / 1e6);
+
+    // Count the deletions which the Bloom filter misses due to false positives
+    CompressedIdSet set2;
+    BloomFilter<unsigned long> bloom2(268435399, 4);
+    simulateMerge(set2, numLines, &exactInsertions);
+    simulateMerge(bloom2, numLines, &bloomInsertions);
+    assert(exactInsertions.size() == bloomInsertions.size());
+    size_t numMissed = 0;
+    for (size_t i = 0; i < exactInsertions.size(); i++) {
+        assert(exactInsertions[i] || !bloomInsertions[i]);
+        numMissed += exactInsertions[i] && !bloomInsertions[i];
+    }
+    LOG(V2_INFO, "%lu lines: %lu/%lu insertions missed by the Bloom filter\n", numLines, numMissed, set2.size());
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testCorrectness();
+    benchmark(100'000);
+    benchmark(2'000'000);
+}
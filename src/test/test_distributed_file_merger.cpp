@@ -9,6 +9,7 @@
 #include "util/logger.hpp"
 #include "util/sys/timer.hpp"
 #include "comm/mympi.hpp"
+#include "comm/msg_queue/message_subscription.hpp"
 #include "util/params.hpp"
 #include "app/sat/proof/merging/distributed_proof_merger.hpp"
 #include "util/sys/watchdog.hpp"
@@ -27,12 +28,12 @@ public:
     }
 };
 
-void testMerge(int myRank) {
+void testMerge(int myRank, bool check) {
 
     int lineCounter = 0;
     int maxLineCounter = 10000;
 
-    auto merger = DistributedProofMerger(MPI_COMM_WORLD, 5, new LambdaMergeSource<SerializedLratLine>(
+    auto merger = DistributedProofMerger(MPI_COMM_WORLD, 5, {new LambdaMergeSource<SerializedLratLine>(
         [&](SerializedLratLine& out) {
             if (lineCounter == maxLineCounter) {
                 return false;
@@ -46,10 +47,10 @@ void testMerge(int myRank) {
             out = SerializedLratLine(line);
             return true;
         }
-    ), "final_output.txt");
+    )}, "final_output.txt", check ? 2 : 0, check ? std::vector<int>{1, 0} : std::vector<int>());
     merger.setNumOriginalClauses(1);
 
-    MyMpi::getMessageQueue().registerCallback(MSG_ADVANCE_DISTRIBUTED_FILE_MERGE, [&](MessageHandle& h) {
+    MessageSubscription subscription(MSG_ADVANCE_DISTRIBUTED_FILE_MERGE, [&](MessageHandle& h) {
         MergeMessage msg; msg.deserialize(h.getRecvData());
         merger.handle(h.source, msg);
     });
@@ -64,6 +65,8 @@ void testMerge(int myRank) {
         if (merger.finished() && merger.allProcessesFinished()) break;
         watchdog.reset(Timer::elapsedSeconds());
     }
+    // The merged lines do not form a refutation: a check must fail at every process
+    assert(merger.isProofValid() == !check);
     LOG(V2_INFO, "Done, exiting\n");
 }
 
@@ -84,7 +87,8 @@ int main(int argc, char *argv[]) {
 
     ProcessWideThreadPool::init(4);
 
-    testMerge(rank);
+    testMerge(rank, false);
+    testMerge(rank, true);
 
     MPI_Finalize();
 }
\ No newline at end of file
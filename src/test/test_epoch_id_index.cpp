@@ -0,0 +1,93 @@
+
+#include <string>
+#include <vector>
+
+#include "app/sat/data/clause_metadata.hpp"
+#include "app/sat/data/epoch_id_index.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+// Epoch starts as produced by the clause ID alignment: ascending (possibly repeated)
+// IDs with epoch lengths of very different magnitude.
+std::vector<unsigned long> createEpochStarts(int numEpochs, unsigned long maxEpochLength, float probRepeat) {
+    std::vector<unsigned long> starts {0};
+    unsigned long id = 1000;
+    for (int e = 1; e < numEpochs; e++) {
+        if (Random::rand() >= probRepeat) {
+            // lengths distributed over several orders of magnitude
+            unsigned long length = 1 + Random::rand() * maxEpochLength;
+            if (Random::rand() < 0.5) length = 1 + length / 1000;
+            id += length;
+        }
+        starts.push_back(id);
+    }
+    return starts;
+}
+
+std::vector<unsigned long> createQueries(const std::vector<unsigned long>& starts, int numQueries) {
+    std::vector<unsigned long> queries;
+    for (int i = 0; i < numQueries; i++) {
+        double r = Random::rand();
+        if (r < 0.2) {
+            // IDs at and around the epoch starts
+            auto start = starts[(size_t) (Random::rand() * starts.size())];
+            queries.push_back(std::max(1UL, start + (int) (Random::rand() * 5) - 2));
+        } else {
+            queries.push_back(1 + Random::rand() * (starts.back() + 1000));
+        }
+    }
+    return queries;
+}
+
+void testCorrectness() {
+    for (auto [numEpochs, maxEpochLength, probRepeat] : std::vector<std::tuple<int, unsigned long, float>> {
+            {1, 100, 0}, {2, 1, 0}, {10, 10, 0.5}, {100, 1000, 0.1}, {1000, 1'000'000, 0.05},
+            {5000, 1'000'000'000'000UL, 0}, {5000, 3, 0.3}}) {
+
+        auto starts = createEpochStarts(numEpochs, maxEpochLength, probRepeat);
+        // Check after each growth step of the index
+        EpochIdIndex index;
+        std::vector<unsigned long> prefix;
+        for (auto start : starts) {
+            index.push_back(start);
+            prefix.push_back(start);
+            if (prefix.size() % (1 + numEpochs/10) != 0 && prefix.size() != starts.size()) continue;
+            for (auto id : createQueries(prefix, 10000)) {
+                int expected = ClauseMetadata::getEpoch(id, prefix);
+                int actual = index.getEpoch(id);
+                assert(expected == actual || log_return_false("[ERROR] ID %lu: epoch %i, expected %i\n", id, actual, expected));
+            }
+        }
+        assert(index.getStarts() == starts);
+        LOG(V2_INFO, "%i epochs up to %lu checked\n", numEpochs, starts.back());
+    }
+}
+
+void benchmark(int numEpochs) {
+    auto starts = createEpochStarts(numEpochs, 100'000, 0.01);
+    EpochIdIndex index(starts);
+    auto queries = createQueries(starts, 10'000'000);
+
+    unsigned long checksum1 = 0, checksum2 = 0;
+    float time = Timer::elapsedSeconds();
+    for (auto id : queries) checksum1 += ClauseMetadata::getEpoch(id, starts);
+    float timeSearch = Timer::elapsedSeconds() - time;
+    time = Timer::elapsedSeconds();
+    for (auto id : queries) checksum2 += index.getEpoch(id);
+    float timeIndex = Timer::elapsedSeconds() - time;
+    assert(checksum1 == checksum2);
+
+    LOG(V2_INFO, "%i epochs, %lu lookups: binary search %.3fs, index %.3fs\n",
+        numEpochs, queries.size(), timeSearch, timeIndex);
+}
+
+int main() {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V5_DEBG);
+
+    testCorrectness();
+    for (int numEpochs : {100, 10'000, 1'000'000}) benchmark(numEpochs);
+}
@@ -0,0 +1,213 @@
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interface/socket/event_socket_server.hpp"
+#include "interface/socket/socket.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/sys/threading.hpp"
+#include "util/sys/timer.hpp"
+
+// Minimal blocking client speaking the length-prefixed JSON protocol
+
+int connectTo(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int res = connect(fd, (sockaddr*) &address, sizeof(address));
+    assert(res == 0);
+    return fd;
+}
+
+void sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+        assert(n > 0);
+        data += n;
+        size -= n;
+    }
+}
+
+void sendMsg(int fd, const nlohmann::json& json) {
+    std::string payload = json.dump();
+    int size = payload.size();
+    std::string msg((const char*) &size, sizeof(int));
+    msg += payload;
+    sendAll(fd, msg.data(), msg.size());
+}
+
+void sendGoodbye(int fd) {
+    int size = 1;
+    char msg[sizeof(int)+1];
+    memcpy(msg, &size, sizeof(int));
+    msg[sizeof(int)] = 24;
+    sendAll(fd, msg, sizeof(msg));
+}
+
+bool recvAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        auto n = ::recv(fd, data, size, 0);
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Returns false if the server closed the connection
+bool recvMsg(int fd, nlohmann::json& json) {
+    int size;
+    if (!recvAll(fd, (char*) &size, sizeof(int))) return false;
+    std::string payload(size, '\0');
+    if (!recvAll(fd, payload.data(), size)) return false;
+    json = nlohmann::json::parse(payload);
+    return true;
+}
+
+EventSocketServer::SocketSettings getSettings(const std::string& path,
+        std::function<void(const EventSocketServer::ConnectionPtr&, nlohmann::json&)> callback) {
+    EventSocketServer::SocketSettings settings;
+    settings.address = path;
+    settings.numThreads = 1;
+    settings.maxMsgSize = 65536;
+    settings.receiveCallback = callback;
+    return settings;
+}
+
+// The client shuts down its sending side right after its requests: all responses must arrive,
+// those queued at the server as well as those which are only sent later.
+void testHalfClose() {
+    const std::string path = "/tmp/mallob_test_event_socket_server.sk";
+    const int numRequests = 100;
+    Mutex delayedMutex;
+    std::vector<std::pair<EventSocketServer::ConnectionPtr, nlohmann::json>> delayed;
+    EventSocketServer server(getSettings(path, [&](const EventSocketServer::ConnectionPtr& conn, nlohmann::json& json) {
+        conn->expectResponse();
+        if (json["id"].get<int>() % 2 == 0) {
+            // Large responses which the client does not read yet, so they pile up at the server
+            json["data"] = std::string(1<<16, 'x');
+            conn->send(json);
+        } else {
+            auto lock = delayedMutex.getLock();
+            delayed.emplace_back(conn, json);
+        }
+    }));
+
+    int fd = connectTo(path);
+    for (int i = 0; i < numRequests; i++) sendMsg(fd, {{"id", i}});
+    shutdown(fd, SHUT_WR);
+    std::thread responder([&]() {
+        while (true) {
+            usleep(1000 * 50);
+            auto lock = delayedMutex.getLock();
+            if (delayed.size() < numRequests/2) continue;
+            for (auto& [conn, json] : delayed) assert(conn->send(json));
+            delayed.clear();
+            break;
+        }
+    });
+    std::vector<bool> received(numRequests, false);
+    nlohmann::json json;
+    int numReceived = 0;
+    while (recvMsg(fd, json)) {
+        const int id = json["id"].get<int>();
+        assert(!received[id]);
+        received[id] = true;
+        numReceived++;
+    }
+    // The server closed the connection only after the last response
+    assert(numReceived == numRequests || log_return_false("[ERROR] %i/%i responses\n", numReceived, numRequests));
+    responder.join();
+    ::close(fd);
+
+    // A client which vanishes entirely is dropped despite awaited responses
+    fd = connectTo(path);
+    sendMsg(fd, {{"id", 1}});
+    ::close(fd);
+    while (true) {
+        usleep(1000 * 10);
+        auto lock = delayedMutex.getLock();
+        if (delayed.empty()) continue;
+        // The response cannot be delivered, but this is handled gracefully
+        assert(!delayed.front().first->send(delayed.front().second));
+        delayed.clear();
+        break;
+    }
+    LOG(V2_INFO, "Half-close test passed\n");
+}
+
+// Each client thread submits its requests with up to numInFlight requests in flight
+// and waits for all responses; returns the number of requests per second.
+double runClients(const std::string& path, int numConnections, int numRequests, int numInFlight) {
+    std::vector<std::thread> clients;
+    std::atomic_long numDone {0};
+    float time = Timer::elapsedSeconds();
+    for (int c = 0; c < numConnections; c++) {
+        clients.emplace_back([&, c]() {
+            int fd = connectTo(path);
+            int numSent = 0, numReceived = 0;
+            nlohmann::json json;
+            while (numReceived < numRequests) {
+                while (numSent < numRequests && numSent - numReceived < numInFlight) {
+                    sendMsg(fd, {{"user", "bench"}, {"name", "bench-" + std::to_string(c) + "-" + std::to_string(numSent)}});
+                    numSent++;
+                }
+                bool ok = recvMsg(fd, json);
+                assert(ok);
+                numReceived++;
+            }
+            sendGoodbye(fd);
+            ::close(fd);
+            numDone += numReceived;
+        });
+    }
+    for (auto& client : clients) client.join();
+    time = Timer::elapsedSeconds() - time;
+    return numDone / time;
+}
+
+// Throughput of the event-driven server compared to the thread-per-connection server,
+// both answering each request immediately
+void benchmark(int numConnections, int numRequests) {
+    const std::string eventPath = "/tmp/mallob_test_event_socket_server_bench.sk";
+    const std::string legacyPath = "/tmp/mallob_test_thread_socket_server_bench.sk";
+    double eventSingle, eventPipelined, legacy;
+    {
+        EventSocketServer server(getSettings(eventPath, [](const EventSocketServer::ConnectionPtr& conn, nlohmann::json& json) {
+            conn->send(json);
+        }));
+        eventSingle = runClients(eventPath, numConnections, numRequests, 1);
+        eventPipelined = runClients(eventPath, numConnections, numRequests, 16);
+    }
+    {
+        Socket::SocketSettings settings;
+        settings.address = legacyPath;
+        settings.maxNumConnections = numConnections;
+        settings.maxMsgSize = 65536;
+        settings.receiveCallback = [](Connection& conn, nlohmann::json& json) {
+            conn.send(json);
+        };
+        // Deliberately leaked: the legacy server cannot interrupt its blocking accept()
+        new Socket(settings);
+        // The legacy connections process one request at a time
+        legacy = runClients(legacyPath, numConnections, numRequests, 1);
+    }
+    LOG(V2_INFO, "%i connections x %i requests: thread per connection %.0f req/s, event loop %.0f req/s (1 in flight), %.0f req/s (16 in flight)\n",
+        numConnections, numRequests, legacy, eventSingle, eventPipelined);
+}
+
+int main() {
+    Timer::init();
+    Logger::init(0, V2_INFO);
+
+    testHalfClose();
+    benchmark(16, 2000);
+}
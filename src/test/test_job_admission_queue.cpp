@@ -0,0 +1,140 @@
+
+#include <fstream>
+
+#include "util/assert.hpp"
+#include "util/sys/timer.hpp"
+#include "util/random.hpp"
+#include "util/logger.hpp"
+#include "util/sys/fileutils.hpp"
+#include "core/job_admission_queue.hpp"
+
+JobMetadata createJob(int id, int revision, float arrival, std::vector<int> dependencies = {}) {
+    JobMetadata data;
+    data.jobName = "job" + std::to_string(id) + "." + std::to_string(revision);
+    data.description.reset(new JobDescription(id, 1, 0));
+    data.description->setRevision(revision);
+    data.description->setIncremental(revision > 0);
+    data.description->setArrival(arrival);
+    data.dependencies = std::move(dependencies);
+    return data;
+}
+
+void testDependencyChain() {
+    const int numJobs = 100'000;
+    auto log = Logger::getMainInstance().copy("Q", "");
+    JobAdmissionQueue q;
+
+    // Job i depends on job i-1; insert in reverse order
+    float time = Timer::elapsedSeconds();
+    for (int id = numJobs; id >= 1; id--) {
+        q.insert(createJob(id, 0, 0, id > 1 ? std::vector<int>({id-1}) : std::vector<int>()), log);
+    }
+    float insertTime = Timer::elapsedSeconds() - time;
+    assert(q.size() == numJobs);
+
+    // Admit each job and report it as done, which releases its successor
+    time = Timer::elapsedSeconds();
+    for (int id = 1; id <= numJobs; id++) {
+        assert(q.hasCandidate(time));
+        auto job = q.poll(time, log);
+        assert(job);
+        assert(job->description->getId() == id);
+        assert(!q.poll(time, log)); // successor not released yet
+        q.markDone(id, 0);
+    }
+    float admitTime = Timer::elapsedSeconds() - time;
+    assert(q.size() == 0);
+    LOG(V2_INFO, "%i dependent jobs: insert %.4fs, admit %.4fs (%.3f us/job)\n", numJobs,
+        insertTime, admitTime, 1'000'000 * admitTime / numJobs);
+}
+
+void testRandomDependencies() {
+    const int numJobs = 100'000;
+    auto log = Logger::getMainInstance().copy("Q", "");
+    JobAdmissionQueue q;
+
+    // Each job depends on up to three jobs with a smaller ID
+    for (int id = 1; id <= numJobs; id++) {
+        std::vector<int> deps;
+        for (int i = 0; i < 3 && id > 1; i++) deps.push_back(1 + (int) (Random::rand() * (id-1)));
+        q.insert(createJob(id, 0, Random::rand(), deps), log);
+    }
+
+    float time = Timer::elapsedSeconds();
+    std::vector<bool> done(numJobs+1, false);
+    int numAdmitted = 0;
+    while (numAdmitted < numJobs) {
+        auto job = q.poll(1, log);
+        assert(job);
+        for (int dep : job->dependencies) assert(done[dep]);
+        done[job->description->getId()] = true;
+        q.markDone(job->description->getId(), 0);
+        numAdmitted++;
+    }
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "%i randomly dependent jobs: admit %.4fs (%.3f us/job)\n", numJobs,
+        time, 1'000'000 * time / numJobs);
+}
+
+void testIncrementalRevisions() {
+    auto log = Logger::getMainInstance().copy("Q", "");
+    JobAdmissionQueue q;
+    for (int rev = 5; rev >= 0; rev--) q.insert(createJob(1, rev, 0), log);
+    for (int rev = 0; rev <= 5; rev++) {
+        auto job = q.poll(0, log);
+        assert(job);
+        assert(job->description->getRevision() == rev);
+        assert(!q.poll(0, log));
+        q.markDone(1, rev);
+    }
+}
+
+void testArrival() {
+    auto log = Logger::getMainInstance().copy("Q", "");
+    JobAdmissionQueue q;
+    q.insert(createJob(1, 0, 10), log);
+    q.insert(createJob(2, 0, 5), log);
+    assert(!q.hasCandidate(4));
+    assert(!q.poll(4, log));
+    assert(q.poll(5, log)->description->getId() == 2);
+    assert(!q.poll(9, log));
+    assert(q.poll(10, log)->description->getId() == 1);
+}
+
+void testAwaitedFile() {
+    auto log = Logger::getMainInstance().copy("Q", "");
+    std::string dir = "/tmp/mallob_test_admission_queue";
+    FileUtils::mkdir(dir);
+    std::string file = dir + "/job-description.txt";
+    FileUtils::rm(file);
+
+    JobAdmissionQueue q;
+    auto data = createJob(1, 0, 0);
+    data.files.push_back(file);
+    q.insert(std::move(data), log);
+    assert(!q.poll(0, log));
+    assert(q.numWaitingForFiles() == 1);
+    assert(!q.hasCandidate(0));
+
+    {
+        std::ofstream ofs(file);
+        ofs << "content\n";
+    }
+    assert(q.hasCandidate(0));
+    auto job = q.poll(0, log);
+    assert(job);
+    assert(q.numWaitingForFiles() == 0);
+    FileUtils::rm(file);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testArrival();
+    testIncrementalRevisions();
+    testAwaitedFile();
+    testDependencyChain();
+    testRandomDependencies();
+}
@@ -0,0 +1,119 @@
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "app/kmeans/kmeans_utils.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+using namespace KMeansUtils;
+
+std::vector<float> randomMatrix(int rows, int dim) {
+    std::vector<float> data((size_t) rows * dim);
+    for (auto& x : data) x = 1000 * Random::rand() - 500;
+    return data;
+}
+
+// Checks each supported kernel against a double-precision reference
+// for dimensions with and without a remainder w.r.t. the vector width.
+void testCorrectness() {
+    const int numPoints = 100;
+    for (int dim : {1, 3, 7, 8, 15, 16, 17, 31, 64, 100}) {
+        for (int k : {1, 3, 4, 5, 16, 23}) {
+            auto points = randomMatrix(numPoints, dim);
+            auto centers = randomMatrix(k, dim);
+            std::vector<float> distances(k);
+            for (SimdLevel level : {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512}) {
+                if (setSimdLevel(level) != level) continue;
+                for (int p = 0; p < numPoints; p++) {
+                    const float* point = points.data() + (size_t) p * dim;
+                    int nearest = nearestCenter(point, centers.data(), k, dim, distances.data());
+                    int refNearest = 0;
+                    double refMin = INFINITY;
+                    for (int c = 0; c < k; c++) {
+                        double ref = 0;
+                        for (int d = 0; d < dim; d++) {
+                            double diff = (double) point[d] - centers[(size_t) c * dim + d];
+                            ref += diff * diff;
+                        }
+                        assert(std::abs(distances[c] - ref) <= 1e-4 * ref + 1e-3
+                            || log_return_false("[ERROR] %s dim=%i k=%i c=%i: %.6f != %.6f\n",
+                            simdLevelToStr(level), dim, k, c, distances[c], ref));
+                        if (ref < refMin) {refMin = ref; refNearest = c;}
+                    }
+                    assert(nearest == refNearest || std::abs(distances[nearest] - refMin) <= 1e-4 * refMin
+                        || log_return_false("[ERROR] %s dim=%i k=%i: nearest %i != %i\n",
+                        simdLevelToStr(level), dim, k, nearest, refNearest));
+                    float single = eukild(point, centers.data(), dim);
+                    assert(std::abs(single - distances[0]) <= 1e-4 * single + 1e-3);
+                }
+            }
+        }
+    }
+    LOG(V2_INFO, "Correctness checks passed\n");
+}
+
+// Times the assignment of synthetic points to their nearest center per kernel.
+void benchmark(int numPoints, int dim, int k) {
+    auto points = randomMatrix(numPoints, dim);
+    auto centers = randomMatrix(k, dim);
+    std::vector<float> distances(k);
+    std::vector<int> membership(numPoints);
+
+    // Baseline: former per-center layout and call via std::function
+    std::vector<std::vector<float>> centerRows(k);
+    for (int c = 0; c < k; c++) centerRows[c].assign(centers.begin() + (size_t) c * dim, centers.begin() + (size_t) (c+1) * dim);
+    const std::function<float(const float*, const float*, const size_t)> metric =
+        [](const float* p1, const float* p2, const size_t dim) {
+            float sum = 0;
+            for (size_t d = 0; d < dim; d++) {
+                float diff = p1[d] - p2[d];
+                sum += diff * diff;
+            }
+            return sum;
+        };
+    float time = Timer::elapsedSeconds();
+    for (int p = 0; p < numPoints; p++) {
+        int best = -1;
+        float bestDist = INFINITY;
+        for (int c = 0; c < k; c++) {
+            float dist = metric(points.data() + (size_t) p * dim, centerRows[c].data(), dim);
+            if (dist < bestDist) {best = c; bestDist = dist;}
+        }
+        membership[p] = best;
+    }
+    time = Timer::elapsedSeconds() - time;
+    const double numDistances = (double) numPoints * k;
+    LOG(V2_INFO, "n=%i d=%i k=%i baseline : %.4fs (%.1f M dist/s)\n", numPoints, dim, k, time, numDistances / time / 1e6);
+    const auto baseline = membership;
+
+    for (SimdLevel level : {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512}) {
+        if (setSimdLevel(level) != level) continue;
+        time = Timer::elapsedSeconds();
+        for (int p = 0; p < numPoints; p++) {
+            membership[p] = nearestCenter(points.data() + (size_t) p * dim, centers.data(), k, dim, distances.data());
+        }
+        time = Timer::elapsedSeconds() - time;
+        LOG(V2_INFO, "n=%i d=%i k=%i %-8s : %.4fs (%.1f M dist/s)\n", numPoints, dim, k,
+            simdLevelToStr(level), time, numDistances / time / 1e6);
+        int numDiffering = 0;
+        for (int p = 0; p < numPoints; p++) numDiffering += membership[p] != baseline[p];
+        // Ties may be broken differently due to a different summation order
+        assert(numDiffering <= numPoints / 1000);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testCorrectness();
+    benchmark(100'000, 2, 10);
+    benchmark(50'000, 16, 32);
+    benchmark(20'000, 100, 50);
+    benchmark(5'000, 784, 64);
+}
@@ -0,0 +1,109 @@
+
+#include <cmath>
+#include <vector>
+
+#include "app/kmeans/kmeans_utils.hpp"
+#include "test/kmeans_test_utils.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+using namespace KMeansUtils;
+
+// Lloyd iterations until no coordinate changes by more than 0.1% (as in KMeansJob);
+// returns the number of iterations and writes the final sum of squared distances to sse.
+int lloyd(const std::vector<float>& points, int dim, int k, std::vector<float> centers, double& sse) {
+    const int n = points.size() / dim;
+    std::vector<float> distances(k);
+    std::vector<int> membership(n);
+    for (int iteration = 1; iteration <= 1000; iteration++) {
+        sse = 0;
+        for (int i = 0; i < n; i++) {
+            membership[i] = nearestCenter(points.data() + (size_t) i*dim, centers.data(), k, dim, distances.data());
+            sse += distances[membership[i]];
+        }
+        std::vector<double> sums((size_t) k * dim, 0);
+        std::vector<int> counts(k, 0);
+        for (int i = 0; i < n; i++) {
+            counts[membership[i]]++;
+            for (int d = 0; d < dim; d++) sums[(size_t) membership[i]*dim + d] += points[(size_t) i*dim + d];
+        }
+        bool changed = false;
+        for (int c = 0; c < k; c++) {
+            if (counts[c] == 0) continue;
+            for (int d = 0; d < dim; d++) {
+                float& x = centers[(size_t) c*dim + d];
+                float updated = sums[(size_t) c*dim + d] / counts[c];
+                if (std::fabs(updated - x) > 0.001f * std::fabs(updated + x) / 2) changed = true;
+                x = updated;
+            }
+        }
+        if (!changed) return iteration;
+    }
+    return 1000;
+}
+
+void testDeterminism() {
+    auto points = generateBlobs(10'000, 8, 10, 2, 1);
+    for (uint64_t seed : {0UL, 1UL, (1UL << 32) + 7}) {
+        auto c1 = initCentersScalable(points.data(), 10'000, 8, 10, 5, 2, seed);
+        auto c2 = initCentersScalable(points.data(), 10'000, 8, 10, 5, 2, seed);
+        assert(c1.size() == 10 * 8);
+        assert(c1 == c2);
+        auto r1 = initCentersRandom(points.data(), 10'000, 8, 10, seed);
+        auto r2 = initCentersRandom(points.data(), 10'000, 8, 10, seed);
+        assert(r1.size() == 10 * 8);
+        assert(r1 == r2);
+    }
+    // More centers than distinct points
+    std::vector<float> fewPoints = {1, 1, 1, 1, 2, 2};
+    auto c = initCentersScalable(fewPoints.data(), 3, 2, 3, 5, 2, 42);
+    assert(c.size() == 3 * 2);
+    // The distributed sampling only depends on (seed, round, point), not on the worker
+    double sum = 0;
+    for (int i = 0; i < 10'000; i++) {
+        const double coin = getSamplingCoin(42, 3, i);
+        assert(coin >= 0 && coin < 1);
+        assert(coin == getSamplingCoin(42, 3, i));
+        sum += coin;
+    }
+    assert(std::fabs(sum / 10'000 - 0.5) < 0.02);
+    assert(getSamplingCoin(42, 3, 0) != getSamplingCoin(42, 4, 0));
+    // Candidates without weight are never chosen while others have weight
+    SplitMix64Rng rng(1);
+    auto chosen = chooseCentersFromCandidates(points.data(), 10'000, 8, {5, 17, 99}, {0, 1, 0}, 1, rng);
+    assert(std::vector<float>(points.begin() + 17*8, points.begin() + 18*8) == chosen);
+    LOG(V2_INFO, "Determinism checks passed\n");
+}
+
+void compare(int n, int dim, int numBlobs, int k, float spread) {
+    auto points = generateBlobs(n, dim, numBlobs, spread, n + dim + k);
+    const int numRuns = 5;
+    double itersRandom = 0, itersScalable = 0, sseRandom = 0, sseScalable = 0, timeScalable = 0;
+    for (int run = 0; run < numRuns; run++) {
+        double sse;
+        itersRandom += lloyd(points, dim, k, initCentersRandom(points.data(), n, dim, k, run), sse);
+        sseRandom += sse;
+        float time = Timer::elapsedSeconds();
+        auto centers = initCentersScalable(points.data(), n, dim, k, 5, 2, run);
+        timeScalable += Timer::elapsedSeconds() - time;
+        itersScalable += lloyd(points, dim, k, centers, sse);
+        sseScalable += sse;
+    }
+    LOG(V2_INFO, "n=%i d=%i blobs=%i k=%i : random init %.1f iterations (SSE %.4e), k-means|| init %.1f iterations (SSE %.4e, init %.3fs)\n",
+        n, dim, numBlobs, k, itersRandom / numRuns, sseRandom / numRuns,
+        itersScalable / numRuns, sseScalable / numRuns, timeScalable / numRuns);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testDeterminism();
+    compare(20'000, 2, 10, 10, 3);
+    compare(20'000, 16, 25, 25, 5);
+    compare(20'000, 50, 50, 50, 10);
+    compare(20'000, 8, 100, 50, 5);
+}
@@ -0,0 +1,114 @@
+
+#include <cmath>
+#include <vector>
+
+#include "app/kmeans/kmeans_utils.hpp"
+#include "test/kmeans_test_utils.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+using namespace KMeansUtils;
+
+double sumOfSquaredDistances(const std::vector<float>& points, int dim, const std::vector<float>& centers) {
+    const int n = points.size() / dim, k = centers.size() / dim;
+    std::vector<float> distances(k);
+    double sse = 0;
+    for (int i = 0; i < n; i++) {
+        sse += distances[nearestCenter(points.data() + (size_t) i*dim, centers.data(), k, dim, distances.data())];
+    }
+    return sse;
+}
+
+struct Result {
+    int iterations;
+    double distanceComputations;
+    float time;
+    double sse;
+};
+
+// Iterations as performed by KMeansJob (batchFraction = 1: Lloyd, < 1: mini-batch)
+// until convergence w.r.t. threshold (see -kmct) or until maxIterations are done.
+Result run(const std::vector<float>& points, int dim, std::vector<float> centers, float batchFraction, float threshold, int maxIterations) {
+    const int n = points.size() / dim, k = centers.size() / dim;
+    SplitMix64Rng rng(1);
+    std::vector<float> distances(k);
+    std::vector<long> cumulativeCounts;
+    Result result {0, 0, Timer::elapsedSeconds(), 0};
+    while (result.iterations < maxIterations) {
+        result.iterations++;
+        std::vector<double> sums((size_t) k * dim, 0);
+        std::vector<int> counts(k, 0);
+        for (int i = 0; i < n; i++) {
+            if (batchFraction < 1 && rng.randomInRange(0, 1) >= batchFraction) continue;
+            const float* point = points.data() + (size_t) i*dim;
+            int c = nearestCenter(point, centers.data(), k, dim, distances.data());
+            result.distanceComputations += k;
+            counts[c]++;
+            for (int d = 0; d < dim; d++) sums[(size_t) c*dim + d] += point[d];
+        }
+        std::vector<float> means((size_t) k * dim, 0);
+        for (int c = 0; c < k; c++) for (int d = 0; d < dim; d++) {
+            if (counts[c] > 0) means[(size_t) c*dim + d] = sums[(size_t) c*dim + d] / counts[c];
+        }
+        auto oldCenters = centers;
+        if (batchFraction < 1) {
+            miniBatchUpdate(centers.data(), means.data(), counts.data(), cumulativeCounts, k, dim);
+        } else {
+            for (int c = 0; c < k; c++) if (counts[c] > 0)
+                std::copy(means.begin() + (size_t) c*dim, means.begin() + (size_t) (c+1)*dim, centers.begin() + (size_t) c*dim);
+        }
+        bool changed = false;
+        if (batchFraction < 1) {
+            changed = result.iterations == 1 || maxRelativeMovement(oldCenters.data(), centers.data(), k, dim) > threshold;
+        } else for (size_t i = 0; i < centers.size(); i++) {
+            if (std::fabs(centers[i] - oldCenters[i]) > threshold * std::fabs(centers[i] + oldCenters[i]) / 2) changed = true;
+        }
+        if (!changed) break;
+    }
+    result.time = Timer::elapsedSeconds() - result.time;
+    result.sse = sumOfSquaredDistances(points, dim, centers);
+    return result;
+}
+
+void testUpdateRule() {
+    // The first batch of a center moves it to the batch mean, subsequent ones by count/cumulative count
+    std::vector<float> centers = {0, 0};
+    std::vector<float> means = {4, 8};
+    std::vector<int> counts = {2};
+    std::vector<long> cumulative;
+    miniBatchUpdate(centers.data(), means.data(), counts.data(), cumulative, 1, 2);
+    assert(centers[0] == 4 && centers[1] == 8 && cumulative[0] == 2);
+    means = {0, 0};
+    miniBatchUpdate(centers.data(), means.data(), counts.data(), cumulative, 1, 2);
+    assert(centers[0] == 2 && centers[1] == 4 && cumulative[0] == 4);
+    counts = {0};
+    miniBatchUpdate(centers.data(), means.data(), counts.data(), cumulative, 1, 2);
+    assert(centers[0] == 2 && centers[1] == 4 && cumulative[0] == 4);
+}
+
+void compare(int n, int dim, int numBlobs, int k, float spread) {
+    auto points = generateBlobs(n, dim, numBlobs, spread, n + dim + k);
+    auto init = initCentersScalable(points.data(), n, dim, k, 5, 2, 1);
+    auto lloyd = run(points, dim, init, 1, 0.001, 1000);
+    LOG(V2_INFO, "n=%i d=%i k=%i Lloyd          : %3i iterations, %.3e distances, %.3fs, SSE %.4e\n",
+        n, dim, k, lloyd.iterations, lloyd.distanceComputations, lloyd.time, lloyd.sse);
+    for (float batchFraction : {0.1f, 0.01f}) {
+        auto mb = run(points, dim, init, batchFraction, 0.01, 1000);
+        LOG(V2_INFO, "n=%i d=%i k=%i mini-batch %.2f : %3i iterations, %.3e distances, %.3fs, SSE %.4e (%.3fx)\n",
+            n, dim, k, batchFraction, mb.iterations, mb.distanceComputations, mb.time, mb.sse, mb.sse / lloyd.sse);
+        assert(mb.sse < 1.5 * lloyd.sse);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testUpdateRule();
+    compare(200'000, 2, 10, 10, 3);
+    compare(200'000, 16, 25, 25, 5);
+    compare(100'000, 50, 50, 50, 10);
+}
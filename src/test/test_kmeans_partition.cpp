@@ -0,0 +1,76 @@
+
+#include <algorithm>
+#include <vector>
+
+#include "app/kmeans/kmeans_utils.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+
+using namespace KMeansUtils;
+
+// Point owner per point for the given number of workers, via the worker ranges
+std::vector<int> getPointOwners(int numPoints, int numWorkers) {
+    std::vector<int> owners;
+    getSliceOwners(numPoints, numWorkers, owners);
+    std::vector<int> pointOwners(numPoints, -1);
+    for (int w = 0; w < numWorkers; w++) {
+        for (auto [begin, end] : getWorkerRanges(numPoints, owners, w)) {
+            assert(begin < end);
+            for (int p = begin; p < end; p++) {
+                // Each point is covered exactly once
+                assert(pointOwners[p] == -1);
+                pointOwners[p] = w;
+            }
+        }
+    }
+    for (int p = 0; p < numPoints; p++) assert(pointOwners[p] >= 0);
+    return pointOwners;
+}
+
+// Only the points of removed (added) workers move if the number of workers shrinks (grows).
+void testConsistency(int numPoints) {
+    std::vector<int> before = getPointOwners(numPoints, 1);
+    for (int numWorkers = 2; numWorkers <= 64; numWorkers++) {
+        auto after = getPointOwners(numPoints, numWorkers);
+        int numMoved = 0;
+        for (int p = 0; p < numPoints; p++) {
+            if (before[p] != after[p]) {
+                // Grow: a moved point must go to a new worker
+                assert(after[p] == numWorkers-1);
+                numMoved++;
+            }
+        }
+        // Shrinking back yields the original assignment
+        assert(getPointOwners(numPoints, numWorkers-1) == before);
+        LOG(V2_INFO, "n=%i %i->%i workers: %.2f%% of points moved (ideal %.2f%%)\n", numPoints,
+            numWorkers-1, numWorkers, 100.0 * numMoved / numPoints, 100.0 / numWorkers);
+        before = std::move(after);
+    }
+}
+
+// The workers' shares of the points remain reasonably balanced.
+void testBalance(int numPoints) {
+    for (int numWorkers : {1, 2, 3, 7, 16, 100}) {
+        auto owners = getPointOwners(numPoints, numWorkers);
+        std::vector<int> counts(numWorkers, 0);
+        for (int o : owners) counts[o]++;
+        const double avg = (double) numPoints / numWorkers;
+        const int max = *std::max_element(counts.begin(), counts.end());
+        const int min = *std::min_element(counts.begin(), counts.end());
+        LOG(V2_INFO, "n=%i w=%i: min %i max %i avg %.1f\n", numPoints, numWorkers, min, max, avg);
+        assert(max <= 1.25 * avg + 2 || log_return_false("[ERROR] imbalance %i vs. %.1f\n", max, avg));
+    }
+}
+
+int main() {
+    Timer::init();
+    Logger::init(0, V2_INFO);
+
+    for (int k = 0; k < 10; k++) assert(jumpConsistentHash(k, 1) == 0);
+    testConsistency(10);
+    testConsistency(100'000);
+    testConsistency(1'000'000);
+    testBalance(1'000'000);
+    testBalance(10'000'000);
+}
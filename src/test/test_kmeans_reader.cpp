@@ -0,0 +1,155 @@
+
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <vector>
+
+#include "app/kmeans/kmeans_reader.hpp"
+#include "data/job_description.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+#include "util/sys/tmpdir.hpp"
+
+const int k = 10;
+const int dim = 16;
+
+std::vector<float> generatePoints(int numPoints, int numColumns) {
+    std::vector<float> points((size_t) numPoints * numColumns);
+    for (auto& x : points) x = 2000 * Random::rand() - 1000;
+    return points;
+}
+
+void writeText(const std::string& filename, const std::vector<float>& points, int numColumns) {
+    std::ofstream ofs(filename);
+    const int numPoints = points.size() / numColumns;
+    ofs << k << " " << dim << " " << numColumns << " " << numPoints << "\n";
+    ofs.precision(9);
+    for (int i = 0; i < numPoints; i++) {
+        for (int c = 0; c < numColumns; c++) ofs << points[(size_t) i*numColumns + c] << (c+1 < numColumns ? " " : "\n");
+    }
+}
+
+// The former reader: ifstream >> one number at a time
+void readLegacy(const std::string& filename, JobDescription& desc) {
+    desc.beginInitialization(0);
+    std::ifstream ifile(filename);
+    int countClusters, dimension, columnsInFile, pointsCount;
+    ifile >> countClusters >> dimension >> columnsInFile >> pointsCount;
+    desc.addPermanentData(countClusters);
+    desc.addPermanentData(dimension);
+    desc.addPermanentData(pointsCount);
+    float num;
+    for (int point = 0; point < pointsCount; ++point) {
+        for (int entry = 0; entry < dimension; ++entry) {
+            ifile >> num;
+            desc.addPermanentData(num);
+        }
+        for (int skip = dimension; skip < columnsInFile; ++skip) ifile >> num;
+    }
+    desc.endInitialization();
+}
+
+void checkPayload(const JobDescription& desc, const std::vector<float>& points, int numColumns) {
+    const int numPoints = points.size() / numColumns;
+    assert(desc.getFormulaPayloadSize(0) == 3 + (size_t) numPoints * dim);
+    const int* payload = desc.getFormulaPayload(0);
+    assert(payload[0] == k);
+    assert(payload[1] == dim);
+    assert(payload[2] == numPoints);
+    const float* coordinates = (const float*) (payload + 3);
+    for (int i = 0; i < numPoints; i++) for (int d = 0; d < dim; d++) {
+        assert(coordinates[(size_t) i*dim + d] == points[(size_t) i*numColumns + d]
+            || log_return_false("[ERROR] point %i, dim. %i: %.9f != %.9f\n", i, d,
+            coordinates[(size_t) i*dim + d], points[(size_t) i*numColumns + d]));
+    }
+}
+
+void testAndCompare(int numPoints, int numColumns) {
+    auto points = generatePoints(numPoints, numColumns);
+    const std::string textFile = TmpDir::get() + "/mallob_test_kmeans_points.txt";
+    const std::string binaryFile = TmpDir::get() + "/mallob_test_kmeans_points.kmb";
+    writeText(textFile, points, numColumns);
+    std::vector<float> truncated;
+    for (int i = 0; i < numPoints; i++) truncated.insert(truncated.end(),
+        points.begin() + (size_t) i*numColumns, points.begin() + (size_t) i*numColumns + dim);
+    assert(KMeansReader::writeBinary(binaryFile, k, dim, numPoints, truncated.data()));
+
+    float time;
+    {
+        JobDescription desc(1, 1, 0);
+        time = Timer::elapsedSeconds();
+        readLegacy(textFile, desc);
+        time = Timer::elapsedSeconds() - time;
+        checkPayload(desc, points, numColumns);
+        LOG(V2_INFO, "n=%i cols=%i legacy text reader : %.3fs\n", numPoints, numColumns, time);
+    }
+    for (int numThreads : {1, 4}) {
+        JobDescription desc(1, 1, 0);
+        time = Timer::elapsedSeconds();
+        assert(KMeansReader::read(textFile, desc, numThreads));
+        time = Timer::elapsedSeconds() - time;
+        checkPayload(desc, points, numColumns);
+        LOG(V2_INFO, "n=%i cols=%i text reader, %i thread(s) : %.3fs\n", numPoints, numColumns, numThreads, time);
+    }
+    {
+        JobDescription desc(1, 1, 0);
+        time = Timer::elapsedSeconds();
+        assert(KMeansReader::read(binaryFile, desc));
+        time = Timer::elapsedSeconds() - time;
+        checkPayload(desc, truncated, dim);
+        LOG(V2_INFO, "n=%i cols=%i binary reader : %.3fs\n", numPoints, numColumns, time);
+    }
+    std::remove(textFile.c_str());
+    std::remove(binaryFile.c_str());
+}
+
+void testMalformed() {
+    const std::string textFile = TmpDir::get() + "/mallob_test_kmeans_malformed.txt";
+    for (std::string content : {"2 2 2 2\n1 2\n3", "2 2 2 2\n1 2\n3 x\n", "2 2\n",
+            // no clusters, more clusters than points, no or too many dimensions, too few columns
+            "0 2 2 2\n1 2\n3 4\n", "3 2 2 2\n1 2\n3 4\n", "2 0 0 2\n", "2 2000000 2000000 2\n 1 2\n",
+            "2 2 1 2\n1 2\n3 4\n", "2 2 2 2000000000\n1 2\n3 4\n"}) {
+        std::ofstream(textFile) << content;
+        JobDescription desc(1, 1, 0);
+        assert(!KMeansReader::read(textFile, desc) || log_return_false("[ERROR] accepted \"%s\"\n", content.c_str()));
+    }
+    std::remove(textFile.c_str());
+
+    // Binary headers whose payload size overflows or exceeds the file
+    const std::string binaryFile = TmpDir::get() + "/mallob_test_kmeans_malformed.kmb";
+    const std::vector<float> points {1, 2, 3, 4};
+    for (auto [numClusters, dimension, numPoints] : std::vector<std::tuple<int32_t, int32_t, int64_t>> {
+            {0, 2, 2}, {3, 2, 2}, {2, 0, 2}, {2, -1, 2}, {2, KMeansReader::MAX_DIMENSION+1, 2},
+            {2, 2, 3}, {2, 2, -2}, {2, 2, 1L<<33}, {2, 1<<20, INT32_MAX}}) {
+        KMeansReader::BinaryHeader header;
+        memcpy(header.magic, "KMB1", 4);
+        header.numClusters = numClusters;
+        header.dimension = dimension;
+        header.dtype = KMeansReader::FLOAT64;
+        header.numPoints = numPoints;
+        std::ofstream ofs(binaryFile, std::ios::binary);
+        ofs.write((const char*) &header, sizeof(header));
+        ofs.write((const char*) points.data(), points.size() * sizeof(float));
+        ofs.close();
+        JobDescription desc(1, 1, 0);
+        assert(!KMeansReader::read(binaryFile, desc));
+    }
+    // Valid counterpart
+    assert(KMeansReader::writeBinary(binaryFile, 2, 2, 2, points.data()));
+    JobDescription desc(1, 1, 0);
+    assert(KMeansReader::read(binaryFile, desc));
+    std::remove(binaryFile.c_str());
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+    TmpDir::init(0);
+
+    testMalformed();
+    testAndCompare(200'000, dim);
+    testAndCompare(100'000, dim + 3);
+}
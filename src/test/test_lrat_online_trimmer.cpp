@@ -0,0 +1,255 @@
+
+#include <unistd.h>
+#include <deque>
+#include <fstream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/sat/proof/lrat_online_trimmer.hpp"
+#include "app/sat/proof/lrat_batch_io.hpp"
+#include "app/sat/proof/merging/proof_merge_file_input.hpp"
+#include "app/sat/proof/merging/proof_writer.hpp"
+#include "app/sat/proof/proof_instance.hpp"
+#include "app/sat/proof/reverse_binary_lrat_parser.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/robin_hood.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+const LratClauseId NUM_ORIGINAL_CLAUSES = 1000;
+
+struct SimulatedProof {
+    robin_hood::unordered_flat_set<LratClauseId> pinnedIds;
+    robin_hood::unordered_flat_set<LratClauseId> deletedIds;
+    LratClauseId emptyClauseId;
+    size_t untrimmedBytes;
+};
+
+// Writes a random proof like a solver: Each derivation refers to original clauses and
+// to recent derived clauses which are still alive, where only some of the derived clauses
+// are ever used. Most derived clauses are deleted after some time, and a few are exported (pinned). The proof including deletions is
+// written to the trimmer's pipe, and a reference proof without deletions to a file.
+SimulatedProof writeProof(LratOnlineTrimmer& trimmer, const std::string& pipeFile,
+        const std::string& untrimmedFile, int numLines) {
+
+    SimulatedProof proof;
+    std::ofstream pipe(pipeFile, std::ios::binary);
+    std::ofstream untrimmed(untrimmedFile, std::ios::binary);
+    lrat_utils::LratBatchEncoder pipeBatch, untrimmedBatch;
+
+    std::deque<LratClauseId> recent;
+    // deletion "time" and ID of each clause to be deleted
+    std::priority_queue<std::pair<int, LratClauseId>, std::vector<std::pair<int, LratClauseId>>,
+        std::greater<std::pair<int, LratClauseId>>> deletions;
+    LratClauseId id = NUM_ORIGINAL_CLAUSES;
+    LratLine line;
+    for (int i = 0; i <= numLines; i++) {
+        id += 1 + (int) (Random::rand() * 3);
+        line.id = id;
+        line.literals.clear();
+        line.hints.clear();
+        line.signsOfHints.clear();
+        if (i < numLines) {
+            for (int k = 0; k < 3; k++) line.literals.push_back((Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (Random::rand() * 500)));
+        }
+        const int numHints = 1 + Random::rand() * 6;
+        for (int k = 0; k < numHints; k++) {
+            LratClauseId hint = 1 + (int) (Random::rand() * NUM_ORIGINAL_CLAUSES);
+            for (int attempt = 0; !recent.empty() && Random::rand() < 0.7 && attempt < 10; attempt++) {
+                auto candidate = recent[(int) (Random::rand() * recent.size())];
+                if (!proof.deletedIds.count(candidate)) {
+                    hint = candidate;
+                    break;
+                }
+            }
+            line.hints.push_back(hint);
+            line.signsOfHints.push_back(true);
+        }
+        if (Random::rand() < 0.05) {
+            // exported before the clause is deleted
+            trimmer.pinClause(id);
+            proof.pinnedIds.insert(id);
+        }
+        pipeBatch.encodeLine(line);
+        untrimmedBatch.encodeLine(line);
+        if (i == numLines) break;
+
+        if (Random::rand() < 0.3) {
+            recent.push_back(id);
+            if (recent.size() > 2000) recent.pop_front();
+        }
+        if (Random::rand() < 0.9) deletions.push({i + 1 + (int) (Random::rand() * 5000), id});
+        std::vector<unsigned long> toDelete;
+        while (!deletions.empty() && deletions.top().first <= i) {
+            auto deletedId = deletions.top().second;
+            deletions.pop();
+            toDelete.push_back(deletedId);
+            proof.deletedIds.insert(deletedId);
+        }
+        if (!toDelete.empty()) pipeBatch.encodeDeletionLine(toDelete.data(), toDelete.size());
+        if (pipeBatch.full()) pipeBatch.writeTo(pipe);
+        if (untrimmedBatch.full()) untrimmedBatch.writeTo(untrimmed);
+    }
+    pipeBatch.writeTo(pipe);
+    untrimmedBatch.writeTo(untrimmed);
+    proof.emptyClauseId = id;
+    proof.untrimmedBytes = untrimmed.tellp();
+    return proof;
+}
+
+// Backward pass as performed by the proof assembly: returns the IDs of all
+// derived clauses which are required for the empty clause.
+std::vector<LratClauseId> traceRequiredClauses(const std::string& file, LratClauseId emptyClauseId, float& time) {
+    time = Timer::elapsedSeconds();
+    std::vector<LratClauseId> required;
+    std::priority_queue<LratClauseId> frontier;
+    frontier.push(emptyClauseId);
+    ReverseBinaryLratParser parser(file);
+    ReverseBinaryLratParser::LineView view;
+    SerializedLratLine line;
+    while (!frontier.empty() && parser.getNextLineView(view)) {
+        parser.decode(view, line);
+        if (line.getId() != frontier.top()) continue;
+        required.push_back(line.getId());
+        while (!frontier.empty() && frontier.top() == line.getId()) frontier.pop();
+        auto [hints, numHints] = line.getUnsignedHints();
+        for (int i = 0; i < numHints; i++) {
+            if (hints[i] > NUM_ORIGINAL_CLAUSES) frontier.push(hints[i]);
+        }
+    }
+    assert(frontier.empty());
+    time = Timer::elapsedSeconds() - time;
+    return required;
+}
+
+struct AssemblyResult {
+    unsigned long numTracedLines;
+    size_t numOutputBytes;
+    float timeBackwardPass;
+    float timeMerge;
+};
+
+// Proof assembly for a single solver as performed after solving: the backward pass
+// of a ProofInstance writes the required lines in reverse order, and the merge stage
+// reads them and writes the final proof in forward order via a ProofWriter.
+AssemblyResult assemble(const std::string& solverProof, const std::string& outputFile) {
+    const std::string instanceOutput = "test_lrat_online_trimmer.instance.lrat";
+    AssemblyResult result;
+    float time = Timer::elapsedSeconds();
+    {
+        // a single epoch and no clause sharing
+        std::vector<LratClauseId> epochStarts {0};
+        ProofInstance instance(0, 1, NUM_ORIGINAL_CLAUSES, solverProof, 0, 0, epochStarts,
+            std::vector<LratClauseId>(epochStarts), std::vector<LratClauseId>(1, 0), ".",
+            ExternalMemoryConfig(), instanceOutput);
+        std::vector<LratClauseId> noIds;
+        instance.advance(noIds.data(), 0);
+        while (!instance.finished()) usleep(1000);
+        result.numTracedLines = instance.getStats()[2];
+    }
+    result.timeBackwardPass = Timer::elapsedSeconds() - time;
+    time = Timer::elapsedSeconds();
+    {
+        ProofMergeFileInput input(instanceOutput);
+        ProofWriter writer(outputFile, true);
+        SerializedLratLine line;
+        while (input.pollBlocking(line)) writer.pushAdditionBlocking(line);
+        writer.markExhausted();
+        while (!writer.isDone()) usleep(1000);
+    }
+    result.timeMerge = Timer::elapsedSeconds() - time;
+    result.numOutputBytes = std::ifstream(outputFile, std::ios::binary | std::ios::ate).tellg();
+    for (auto file : {instanceOutput, std::string("./disk.0.frontier"), std::string("./disk.0.backlog")})
+        std::remove(file.c_str());
+    return result;
+}
+
+std::string readFile(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+void test(int numLines, size_t windowSize) {
+    const std::string pipeFile = "test_lrat_online_trimmer.pipe";
+    const std::string trimmedFile = "test_lrat_online_trimmer.lrat";
+    const std::string untrimmedFile = "test_lrat_online_trimmer.untrimmed.lrat";
+
+    SimulatedProof proof;
+    LratOnlineTrimmer::Stats stats;
+    {
+        LratOnlineTrimmer trimmer(pipeFile, trimmedFile, windowSize);
+        proof = writeProof(trimmer, pipeFile, untrimmedFile, numLines);
+        trimmer.join();
+        stats = trimmer.getStats();
+    }
+    assert(stats.numReadLines == (unsigned long) numLines+1);
+    assert(stats.numDroppedLines + stats.numWrittenLines == stats.numReadLines);
+
+    // Check the trimmed proof
+    robin_hood::unordered_flat_set<LratClauseId> keptIds;
+    std::vector<LratLine> keptLines;
+    {
+        std::ifstream ifs(trimmedFile, std::ios::binary);
+        lrat_utils::LratBlockReader reader(ifs);
+        LratLine line;
+        while (reader.readLine(line)) {
+            assert(keptLines.empty() || keptLines.back().id < line.id);
+            keptIds.insert(line.id);
+            keptLines.push_back(line);
+        }
+        assert(reader.peekLineType() == 0);
+    }
+    assert(keptLines.size() == stats.numWrittenLines);
+    assert(keptIds.count(proof.emptyClauseId));
+    for (auto id : proof.pinnedIds) assert(keptIds.count(id));
+    // only deleted clauses are dropped
+    assert(stats.numDroppedLines <= proof.deletedIds.size());
+    for (auto& line : keptLines) {
+        for (auto hint : line.hints) {
+            // hints of kept lines are kept as well
+            assert(hint <= NUM_ORIGINAL_CLAUSES || keptIds.count(hint)
+                || log_return_false("[ERROR] Line %lu: hint %lu missing\n", line.id, hint));
+        }
+    }
+
+    // The backward pass finds the same derivation in both proofs
+    float timeUntrimmed, timeTrimmed;
+    auto requiredUntrimmed = traceRequiredClauses(untrimmedFile, proof.emptyClauseId, timeUntrimmed);
+    auto requiredTrimmed = traceRequiredClauses(trimmedFile, proof.emptyClauseId, timeTrimmed);
+    assert(requiredUntrimmed == requiredTrimmed);
+
+    LOG(V2_INFO, "window %lu: %i lines, %lu dropped; %.1f MB -> %.1f MB; backward pass %.3fs -> %.3fs\n",
+        windowSize, numLines+1, stats.numDroppedLines, proof.untrimmedBytes / 1e6, stats.numWrittenBytes / 1e6,
+        timeUntrimmed, timeTrimmed);
+
+    // End to end: the proof assembly yields the same final proof from both solver proofs
+    const std::string outputUntrimmed = "test_lrat_online_trimmer.final.untrimmed.lrat";
+    const std::string outputTrimmed = "test_lrat_online_trimmer.final.lrat";
+    auto untrimmed = assemble(untrimmedFile, outputUntrimmed);
+    auto trimmed = assemble(trimmedFile, outputTrimmed);
+    assert(untrimmed.numTracedLines == requiredUntrimmed.size());
+    assert(trimmed.numTracedLines == requiredTrimmed.size());
+    assert(readFile(outputUntrimmed) == readFile(outputTrimmed));
+    LOG(V2_INFO, "window %lu: assembly of %.1f MB -> %.1f MB solver proof: backward pass %.3fs -> %.3fs, merge %.3fs -> %.3fs, total %.3fs -> %.3fs; final proof %.1f MB\n",
+        windowSize, proof.untrimmedBytes / 1e6, stats.numWrittenBytes / 1e6,
+        untrimmed.timeBackwardPass, trimmed.timeBackwardPass, untrimmed.timeMerge, trimmed.timeMerge,
+        untrimmed.timeBackwardPass + untrimmed.timeMerge, trimmed.timeBackwardPass + trimmed.timeMerge,
+        trimmed.numOutputBytes / 1e6);
+    for (auto file : {trimmedFile, untrimmedFile, outputTrimmed, outputUntrimmed}) std::remove(file.c_str());
+}
+
+int main() {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V5_DEBG);
+    ProcessWideThreadPool::init(2);
+
+    test(10000, 100);
+    test(10000, 1'000'000);
+    test(500'000, 1'000);
+    test(500'000, 100'000);
+}
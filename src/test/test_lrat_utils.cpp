@@ -1,44 +1,53 @@
 
-#include "app/sat/proof/lrat_utils.hpp"
+#include <vector>
+
+#include "app/sat/proof/lrat_batch_io.hpp"
 #include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
 
 void test() {
 
     LratLine line;
     {
         std::ofstream ofs("test.lrat", std::ios_base::binary);
-        lrat_utils::WriteBuffer buf(ofs);
+        lrat_utils::LratBatchEncoder batch;
 
         line.id = 10;
         line.literals = {1, -2, 3};
         line.hints = {4, 5, 6};
         line.signsOfHints = {false, true, false};
-        lrat_utils::writeLine(buf, line);
+        batch.encodeLine(line);
+        // binary LRAT as in drat-trim: numbers are mapped to 2|n| + (n < 0)
+        const std::vector<uint8_t> expected {'a', 20, 2, 5, 6, 0, 9, 10, 13, 0};
+        assert(std::vector<uint8_t>(batch.data(), batch.data()+batch.size()) == expected);
 
         line.id = 111111;
         line.literals.push_back(-100000);
         line.hints.push_back(99999);
         line.signsOfHints.push_back(false);
-        lrat_utils::writeLine(buf, line);
+        batch.encodeLine(line);
 
         line.id = 111112;
         line.literals.clear();
         line.hints = {111111};
         line.signsOfHints = {true};
-        lrat_utils::writeLine(buf, line);
+        batch.encodeLine(line);
+        batch.writeTo(ofs);
     }
     {
         LratLine readLine;
         std::ifstream ifs("test.lrat", std::ios_base::binary);
-        lrat_utils::ReadBuffer buf(ifs);
-        
-        bool success = lrat_utils::readLine(buf, readLine);
+        lrat_utils::LratBlockReader reader(ifs);
+
+        bool success = reader.readLine(readLine);
         assert(success);
         assert(readLine.id == 10);
         assert(readLine.literals.size() == 3);
         assert(readLine.hints.size() == 3);
 
-        success = lrat_utils::readLine(buf, readLine);
+        success = reader.readLine(readLine);
         assert(success);
         assert(readLine.id == 111111);
         assert(readLine.literals.size() == 4 || log_return_false("%i\n", readLine.literals.size()));
@@ -46,7 +55,7 @@ void test() {
         assert(readLine.hints.size() == 4);
         assert(readLine.hints.back() == 99999 && readLine.signsOfHints.back() == false);
 
-        success = lrat_utils::readLine(buf, readLine);
+        success = reader.readLine(readLine);
         assert(success);
         assert(readLine.id == 111112);
         assert(readLine.literals.size() == 0);
@@ -54,11 +63,172 @@ void test() {
         assert(readLine.hints.back() == 111111 && readLine.signsOfHints.back() == true);
 
         LratLine noLine;
-        assert(!lrat_utils::readLine(buf, noLine));
+        assert(!reader.readLine(noLine));
+    }
+}
+
+void testVarints() {
+    std::vector<uint64_t> values {0, 1, 2, 127, 128, 255, 16383, 16384, (1UL<<21)-1, 1UL<<28,
+        (1UL<<49)+12345, (1UL<<56)-1, 1UL<<56, (1UL<<62)+1, 1UL<<63, ~0UL};
+    for (auto value : values) {
+        uint8_t buffer[32] = {0};
+        uint8_t* end = lrat_utils::encodeVarint(buffer, value);
+        assert(end - buffer == lrat_utils::getVarintSize(value));
+        uint64_t decoded;
+        // with (fast path) and without (slow path) eight readable bytes
+        assert(lrat_utils::decodeVarint(buffer, buffer+sizeof(buffer), decoded) == end);
+        assert(decoded == value || log_return_false("%lu != %lu\n", decoded, value));
+        assert(lrat_utils::decodeVarint(buffer, end, decoded) == end);
+        assert(decoded == value);
+        // incomplete varints are detected
+        assert(!lrat_utils::decodeVarint(buffer, end-1, decoded));
+    }
+    for (int64_t n : {0L, 1L, -1L, 1000000L, -1000000L}) {
+        assert(lrat_utils::fromVarintValue(lrat_utils::toVarintValue(n)) == n);
+    }
+    LOG(V2_INFO, "Varint tests passed\n");
+}
+
+std::vector<LratLine> generateLines(int numLines, int maxNumLits, int maxNumHints) {
+    std::vector<LratLine> lines(numLines);
+    unsigned long id = 1000;
+    for (auto& line : lines) {
+        id += 1 + Random::rand() * 1000;
+        line.id = id;
+        int numLits = Random::rand() * (maxNumLits+1);
+        for (int i = 0; i < numLits; i++) {
+            int lit = 1 + Random::rand() * 1'000'000;
+            line.literals.push_back(Random::rand() < 0.5 ? -lit : lit);
+        }
+        int numHints = Random::rand() * (maxNumHints+1);
+        for (int i = 0; i < numHints; i++) {
+            line.hints.push_back(1 + Random::rand() * (id-1));
+            line.signsOfHints.push_back(Random::rand() < 0.9);
+        }
+    }
+    return lines;
+}
+
+std::string readFile(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+void testBatches() {
+    auto lines = generateLines(10000, 20, 100);
+    // one huge line which exceeds all batches and read chunks
+    lines.back().hints.resize(50000, 12345);
+    lines.back().signsOfHints.resize(50000, true);
+    std::vector<unsigned long> deletedIds {1, 127, 128, 1UL<<40};
+    {
+        // reference: a single batch
+        std::ofstream ofs("test.single.lrat", std::ios_base::binary);
+        lrat_utils::LratBatchEncoder batch;
+        for (auto& line : lines) batch.encodeLine(line);
+        batch.encodeDeletionLine(deletedIds.data(), deletedIds.size());
+        batch.writeTo(ofs);
+    }
+    {
+        // small forward batches, alternating between both kinds of lines
+        std::ofstream ofs("test.batch.lrat", std::ios_base::binary);
+        lrat_utils::LratBatchEncoder batch(lrat_utils::LratBatchEncoder::FORWARD, 4096);
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i % 2 == 0) batch.encodeLine(lines[i]);
+            else {
+                SerializedLratLine sline(lines[i]);
+                batch.encodeLine(sline);
+            }
+            if (batch.full()) batch.writeTo(ofs);
+        }
+        batch.encodeDeletionLine(deletedIds.data(), deletedIds.size());
+        batch.writeTo(ofs);
+    }
+    assert(readFile("test.batch.lrat") == readFile("test.single.lrat"));
+    {
+        // backward batches, prepended to each other, with the lines in reverse order
+        std::vector<std::string> batches;
+        lrat_utils::LratBatchEncoder batch(lrat_utils::LratBatchEncoder::BACKWARD, 4096);
+        batch.encodeDeletionLine(deletedIds.data(), deletedIds.size());
+        for (int i = lines.size()-1; i >= 0; i--) {
+            SerializedLratLine sline(lines[i]);
+            batch.encodeLine(sline);
+            if (batch.full()) {
+                batches.emplace_back((const char*) batch.data(), batch.size());
+                batch.reset(lrat_utils::LratBatchEncoder::BACKWARD);
+            }
+        }
+        batches.emplace_back((const char*) batch.data(), batch.size());
+        std::string output;
+        for (int i = batches.size()-1; i >= 0; i--) output += batches[i];
+        assert(output == readFile("test.single.lrat"));
+    }
+    {
+        // small read chunks to exercise line boundaries
+        std::ifstream ifs("test.batch.lrat", std::ios_base::binary);
+        lrat_utils::LratBlockReader reader(ifs, 64);
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i % 2 == 0) {
+                LratLine line;
+                assert(reader.readLine(line));
+                assert(line.id == lines[i].id && line.literals == lines[i].literals);
+                assert(line.hints == lines[i].hints && line.signsOfHints == lines[i].signsOfHints);
+            } else {
+                SerializedLratLine sline;
+                assert(reader.readLine(sline));
+                assert(sline.data() == SerializedLratLine(lines[i]).data());
+            }
+        }
+        // deletion line is not an addition line
+        SerializedLratLine sline;
+        assert(!reader.readLine(sline));
+        assert(reader.peekLineType() == 'd');
+        std::vector<LratClauseId> ids;
+        assert(reader.readDeletionLine(ids));
+        assert(ids == std::vector<LratClauseId>(deletedIds.begin(), deletedIds.end()));
+        assert(reader.peekLineType() == 0);
     }
+    LOG(V2_INFO, "Batch tests passed\n");
+}
+
+void benchmark() {
+    auto lines = generateLines(500'000, 30, 60);
+    std::vector<SerializedLratLine> slines;
+    for (auto& line : lines) slines.emplace_back(line);
+    lines.clear();
+    SerializedLratLine sline;
+    float time = Timer::elapsedSeconds();
+    {
+        std::ofstream ofs("test.batch.lrat", std::ios_base::binary);
+        lrat_utils::LratBatchEncoder batch;
+        for (auto& line : slines) {
+            batch.encodeLine(line);
+            if (batch.full()) batch.writeTo(ofs);
+        }
+        batch.writeTo(ofs);
+    }
+    const float timeWrite = Timer::elapsedSeconds() - time;
+    time = Timer::elapsedSeconds();
+    {
+        std::ifstream ifs("test.batch.lrat", std::ios_base::binary);
+        lrat_utils::LratBlockReader reader(ifs);
+        size_t numRead = 0;
+        while (reader.readLine(sline)) numRead++;
+        assert(numRead == slines.size());
+    }
+    const float timeRead = Timer::elapsedSeconds() - time;
+    const float mib = readFile("test.batch.lrat").size() / (1024.f*1024.f);
+    LOG(V2_INFO, "%lu lines, %.1f MiB: write %.1f MiB/s, read %.1f MiB/s\n",
+        slines.size(), mib, mib/timeWrite, mib/timeRead);
 }
 
 int main() {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V5_DEBG);
+
     test();
+    testVarints();
+    testBatches();
+    benchmark();
 }
 
@@ -0,0 +1,132 @@
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "app/sat/proof/parallel_lrat_checker.hpp"
+#include "app/sat/proof/lrat_line.hpp"
+#include "app/sat/proof/serialized_lrat_line.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+struct Refutation {
+    std::vector<int> formula;
+    std::vector<LratLine> lines; // in forward order
+};
+
+// The formula consists of all 2^n clauses over the variables 1..n, which is unsatisfiable.
+// The proof resolves away the variables n, n-1, ..., 1 one after the other, resulting in
+// 2^n - 1 derived clauses, the last of which is the empty clause.
+Refutation createRefutation(int numVars) {
+    Refutation ref;
+    // IDs of the clauses over the variables 1..v, indexed by their polarities (bit i: variable i+1 positive)
+    std::vector<LratClauseId> ids;
+    LratClauseId id = 0;
+    for (int bits = 0; bits < (1 << numVars); bits++) {
+        for (int var = 1; var <= numVars; var++) {
+            ref.formula.push_back((bits & (1 << (var-1))) ? var : -var);
+        }
+        ref.formula.push_back(0);
+        ids.push_back(++id);
+    }
+    for (int var = numVars; var >= 1; var--) {
+        std::vector<LratClauseId> resolvents;
+        for (int bits = 0; bits < (1 << (var-1)); bits++) {
+            LratLine line;
+            line.id = ++id;
+            for (int v = 1; v < var; v++) line.literals.push_back((bits & (1 << (v-1))) ? v : -v);
+            // C v -x, then C v x
+            line.hints = {ids[bits], ids[bits | (1 << (var-1))]};
+            line.signsOfHints = {true, true};
+            ref.lines.push_back(std::move(line));
+            resolvents.push_back(id);
+        }
+        ids = std::move(resolvents);
+    }
+    return ref;
+}
+
+bool check(const Refutation& ref, int numThreads, float* time = nullptr) {
+    if (time) *time = Timer::elapsedSeconds();
+    ParallelLratChecker checker(numThreads, ref.formula);
+    for (auto it = ref.lines.rbegin(); it != ref.lines.rend(); ++it) {
+        SerializedLratLine line(*it);
+        checker.submitReversed(line);
+    }
+    bool valid = checker.finish();
+    if (time) *time = Timer::elapsedSeconds() - *time;
+    if (valid) assert(checker.getNumCheckedLines() == ref.lines.size());
+    else LOG(V2_INFO, "Checker error: %s\n", checker.getError().c_str());
+    return valid;
+}
+
+void testValid() {
+    for (int numVars : {1, 2, 5, 10}) {
+        auto ref = createRefutation(numVars);
+        for (int numThreads : {1, 4}) {
+            assert(check(ref, numThreads));
+        }
+    }
+}
+
+void testInvalid() {
+    const int numVars = 8;
+    auto ref = createRefutation(numVars);
+    const size_t numOriginalClauses = 1 << numVars;
+
+    std::vector<std::pair<std::string, std::function<void(Refutation&)>>> corruptions {
+        {"missing hint", [&](Refutation& r) {
+            auto& line = r.lines[Random::rand() * r.lines.size()];
+            line.hints.pop_back(); line.signsOfHints.pop_back();
+        }},
+        {"flipped literal", [&](Refutation& r) {
+            LratLine* line;
+            do line = &r.lines[Random::rand() * r.lines.size()]; while (line->literals.empty());
+            line->literals[0] = -line->literals[0];
+        }},
+        {"hint to unknown clause", [&](Refutation& r) {
+            // an ID between the derived clauses which is never derived
+            for (auto& line : r.lines) line.id += line.id - numOriginalClauses;
+            for (auto& line : r.lines) for (auto& hint : line.hints) if (hint > numOriginalClauses)
+                hint += hint - numOriginalClauses;
+            r.lines.back().hints.push_back(r.lines.back().id - 1);
+            r.lines.back().signsOfHints.push_back(true);
+        }},
+        {"RAT hint", [&](Refutation& r) {
+            r.lines[Random::rand() * r.lines.size()].signsOfHints[0] = false;
+        }},
+        {"no empty clause", [&](Refutation& r) {
+            r.lines.pop_back();
+        }},
+    };
+    for (auto& [name, corrupt] : corruptions) {
+        for (int numThreads : {1, 4}) {
+            auto corrupted = ref;
+            corrupt(corrupted);
+            LOG(V2_INFO, "Testing invalid proof (%s) with %i threads\n", name.c_str(), numThreads);
+            assert(!check(corrupted, numThreads));
+        }
+    }
+}
+
+void testPerformance() {
+    const int numVars = 18;
+    auto ref = createRefutation(numVars);
+    for (int numThreads : {1, 2, 4}) {
+        float time;
+        assert(check(ref, numThreads, &time));
+        LOG(V2_INFO, "Checked %lu lines with %i threads in %.3fs\n", ref.lines.size(), numThreads, time);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V5_DEBG);
+
+    testValid();
+    testInvalid();
+    testPerformance();
+}
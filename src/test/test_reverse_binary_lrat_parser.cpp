@@ -0,0 +1,115 @@
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "app/sat/proof/lrat_batch_io.hpp"
+#include "app/sat/proof/reverse_binary_lrat_parser.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+// Deterministic pseudo-random line content per line index, including numbers
+// whose encodings contain 'a' (97) and zero bytes within numbers of several bytes
+LratLine generateLine(unsigned long index) {
+    auto next = [state = index * 0x9E3779B97F4A7C15UL + 1]() mutable {
+        state ^= state >> 12; state ^= state << 25; state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DUL;
+    };
+    LratLine line;
+    line.id = 1000 + 3*index + (index % 7 == 0 ? 48 : 0);
+    const int numLits = next() % 8;
+    for (int i = 0; i < numLits; i++) {
+        int var = 1 + (next() % 4 == 0 ? 48 : next() % (1<<(1 + next() % 30)));
+        line.literals.push_back(next() % 2 ? var : -var);
+    }
+    const int numHints = 1 + next() % 20;
+    for (int i = 0; i < numHints; i++) {
+        LratClauseId hint = next() % 4 == 0 ? 48 : 1 + next() % (1UL<<(1 + next() % 62));
+        line.hints.push_back(hint);
+        line.signsOfHints.push_back(next() % 16 != 0);
+    }
+    return line;
+}
+
+size_t writeProof(const std::string& filename, unsigned long numLines) {
+    std::ofstream ofs(filename, std::ios::binary);
+    lrat_utils::LratBatchEncoder batch;
+    for (unsigned long i = 0; i < numLines; i++) {
+        batch.encodeLine(generateLine(i));
+        if (batch.full()) batch.writeTo(ofs);
+    }
+    batch.writeTo(ofs);
+    ofs.flush();
+    return ofs.tellp();
+}
+
+void test(unsigned long numLines) {
+    const std::string filename = "test_reverse_binary_lrat_parser.lrat";
+    float time = Timer::elapsedSeconds();
+    size_t size = writeProof(filename, numLines);
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "Wrote %lu lines (%.1f MB) in %.3fs\n", numLines, size / 1e6, time);
+
+    // Parse all lines completely and compare them with the original content
+    time = Timer::elapsedSeconds();
+    {
+        ReverseBinaryLratParser parser(filename);
+        SerializedLratLine line;
+        unsigned long index = numLines;
+        while (parser.getNextLine(line)) {
+            assert(index > 0);
+            index--;
+            auto expected = generateLine(index);
+            assert(line.getId() == expected.id);
+            auto [lits, numLits] = line.getLiterals();
+            assert(numLits == expected.literals.size());
+            for (int i = 0; i < numLits; i++) assert(lits[i] == expected.literals[i]);
+            auto [hints, numHints] = line.getUnsignedHints();
+            auto signs = line.getSignsOfHints();
+            assert(numHints == expected.hints.size());
+            for (int i = 0; i < numHints; i++) {
+                assert(hints[i] == expected.hints[i] || log_return_false("[ERROR] line %lu hint %i: %lu != %lu\n",
+                    index, i, hints[i], expected.hints[i]));
+                assert(signs[i] == expected.signsOfHints[i]);
+            }
+        }
+        assert(index == 0);
+        assert(parser.getNumReadBytes() == size);
+    }
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "Parsed and checked %lu lines in %.3fs\n", numLines, time);
+
+    // Walk through line views and decode every 64th line only, as in proof pruning
+    time = Timer::elapsedSeconds();
+    {
+        ReverseBinaryLratParser parser(filename);
+        ReverseBinaryLratParser::LineView view;
+        SerializedLratLine line;
+        unsigned long numViews = 0;
+        unsigned long sumOfIds = 0;
+        while (parser.getNextLineView(view)) {
+            numViews++;
+            sumOfIds += view.id;
+            if (view.id % 64 == 0) parser.decode(view, line);
+        }
+        assert(numViews == numLines);
+    }
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "Traversed %lu line views in %.3fs (%.1f MB/s)\n", numLines, time, size / 1e6 / time);
+
+    std::remove(filename.c_str());
+}
+
+int main(int argc, char** argv) {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    test(1);
+    test(1000);
+    // Pass a number of lines (e.g., 100000000 for a proof of several GB) to benchmark
+    test(argc > 1 ? atol(argv[1]) : 1'000'000);
+}
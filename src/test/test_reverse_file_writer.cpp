@@ -0,0 +1,106 @@
+
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/reverse_file_writer.hpp"
+#include "util/sys/timer.hpp"
+
+std::string readFile(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    return buffer.str();
+}
+
+// Writes random blocks back to front, mixing forward blocks and reversed streams,
+// and compares the final file with the expected content.
+void testWrite(size_t segmentSize, int numBlocks, int maxBlockSize, bool allowPadding,
+        bool forceBuffered = false, size_t virtualEnd = 1UL<<32) {
+    const std::string filename = "test_reverse_file_writer.out";
+    std::vector<std::string> blocks;
+    std::string expected;
+    const char padChar = '#';
+    bool buffered;
+    {
+        ReverseFileWriter writer(filename, segmentSize, virtualEnd, forceBuffered);
+        assert(writer.valid());
+        assert(writer.isBuffered() || !forceBuffered);
+        buffered = writer.isBuffered();
+        std::ostream reversedStream(&writer);
+        for (int i = 0; i < numBlocks; i++) {
+            std::string block;
+            const int size = (int) (Random::rand() * maxBlockSize);
+            for (int j = 0; j < size; j++) block += (char) ('a' + (int) (Random::rand() * 26));
+            blocks.push_back(block);
+            if (Random::rand() < 0.5) {
+                writer.prepend(block.data(), block.size());
+            } else {
+                std::string reversed(block.rbegin(), block.rend());
+                reversedStream.write(reversed.data(), reversed.size());
+                reversedStream.flush();
+            }
+        }
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) expected += *it;
+        assert(writer.size() == expected.size());
+        size_t numPadding = 0;
+        writer.finalize([&](size_t n) {
+            if (!allowPadding) return std::string();
+            numPadding = n;
+            return std::string(n, padChar);
+        });
+        expected = std::string(numPadding, padChar) + expected;
+    }
+    const std::string output = readFile(filename);
+    assert(output == expected || log_return_false("[ERROR] %lu bytes written, %lu bytes expected\n",
+        output.size(), expected.size()));
+    // No reversed file is left behind
+    assert(!std::ifstream(filename + ".inv").good());
+    LOG(V2_INFO, "seg=%lu blocks=%i maxsize=%i padding=%s buffered=%s: %lu bytes OK\n", segmentSize, numBlocks,
+        maxBlockSize, allowPadding ? "yes" : "no", buffered ? "yes" : "no", output.size());
+}
+
+void benchmark(size_t numBytes, bool forceBuffered) {
+    const std::string filename = "test_reverse_file_writer.out";
+    std::string line(100, 'x');
+    float time = Timer::elapsedSeconds();
+    {
+        ReverseFileWriter writer(filename, 1<<22, 1UL<<42, forceBuffered);
+        for (size_t written = 0; written < numBytes; written += line.size())
+            writer.prepend(line.data(), line.size());
+        writer.finalize([](size_t n) {return std::string(n, ' ');});
+    }
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "Wrote %lu MB back to front in %.3fs (buffered=%s)\n", numBytes / (1<<20), time,
+        forceBuffered ? "yes" : "no");
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+
+    testWrite(1<<20, 0, 1, true);
+    testWrite(1<<20, 100, 100, true);
+    testWrite(1024, 1000, 100, true);
+    testWrite(1024, 1000, 5000, true);
+    testWrite(1024, 1000, 5000, false);
+    testWrite(1<<16, 10000, 1000, true);
+    testWrite(1<<16, 10000, 1000, false);
+
+    // Fallback via a reversed file
+    testWrite(1<<20, 0, 1, true, true);
+    testWrite(1<<20, 100, 100, true, true);
+    testWrite(1024, 1000, 5000, true, true);
+    testWrite(1<<16, 10000, 1000, false, true);
+    // Virtual end beyond the maximum file size of common file systems
+    testWrite(1<<16, 1000, 1000, true, false, 1UL<<62);
+
+    benchmark(1UL<<28, false);
+    benchmark(1UL<<28, true);
+}
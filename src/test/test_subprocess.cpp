@@ -0,0 +1,84 @@
+
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/params.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/subprocess.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+#include "util/sys/tmpdir.hpp"
+
+// Requires the executable mallob_process_dispatcher in the working directory
+// (as in the build directory) unless MALLOB_SUBPROC_DISPATCH_PATH is set.
+
+const std::string SCRIPT = "/test_subprocess.sh";
+const std::string OUTPUT = "/test_subprocess.out";
+
+// Writes a script which reports an environment variable and exits
+void writeScript() {
+    std::string script = TmpDir::get() + SCRIPT;
+    {
+        std::ofstream ofs(script);
+        ofs << "#!/bin/sh\necho \"$MALLOB_TEST_SUBPROCESS\" > " << TmpDir::get() + OUTPUT << "\n";
+    }
+    chmod(script.c_str(), 0755);
+}
+
+// Measures the time for start() and the time from the start of the subprocess until it exited
+void runScript(const Parameters& params, float& startTime, float& exitTime) {
+    FileUtils::rm(TmpDir::get() + OUTPUT);
+    float time = Timer::elapsedSeconds();
+    Subprocess subproc(params, TmpDir::get() + SCRIPT);
+    pid_t pid = subproc.start();
+    startTime = Timer::elapsedSeconds() - time;
+    while (!Process::didChildExit(pid)) usleep(100);
+    exitTime = Timer::elapsedSeconds() - time;
+
+    // The environment of this process reached the executed command
+    std::ifstream ifs(TmpDir::get() + OUTPUT);
+    std::string value;
+    ifs >> value;
+    assert(value == "hello" || log_return_false("[ERROR] Subprocess got \"%s\"\n", value.c_str()));
+}
+
+void test(const Parameters& params, int poolSize, int numRuns) {
+    Subprocess::initPool(poolSize);
+    // dispatchers taken from the pool are replaced in the background: give them time
+    auto waitForPool = [&]() {if (poolSize > 0) usleep(1000 * 100);};
+    waitForPool();
+    float sumStartTime = 0, sumExitTime = 0;
+    for (int i = 0; i < numRuns; i++) {
+        float startTime, exitTime;
+        runScript(params, startTime, exitTime);
+        sumStartTime += startTime;
+        sumExitTime += exitTime;
+        waitForPool();
+    }
+    Subprocess::shutdownPool();
+    LOG(V2_INFO, "pool size %i: avg. %.3fms in start(), %.3fms until exit of subprocess\n",
+        poolSize, 1000 * sumStartTime / numRuns, 1000 * sumExitTime / numRuns);
+}
+
+int main(int argc, char** argv) {
+    Timer::init();
+    Logger::init(0, V5_DEBG);
+    TmpDir::init(0);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+    Parameters params;
+    params.init(argc, argv);
+    setenv("MALLOB_TEST_SUBPROCESS", "hello", 1);
+    writeScript();
+
+    test(params, 0, 20);
+    test(params, 1, 20);
+
+    FileUtils::rm(TmpDir::get() + SCRIPT);
+    FileUtils::rm(TmpDir::get() + OUTPUT);
+}
@@ -0,0 +1,178 @@
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/threading.hpp"
+#include "util/sys/timer.hpp"
+
+// Previous design as a baseline for the benchmark: one global queue of
+// std::function tasks, each with a promise, under a single mutex.
+class SingleQueueThreadPool {
+
+private:
+    struct Runnable {
+        std::function<void()> function;
+        std::promise<void> promise;
+    };
+    std::vector<std::thread> _threads;
+    std::list<Runnable> _job_queue;
+    Mutex _job_queue_mutex;
+    ConditionVariable _job_queue_cond_var;
+    std::atomic_bool _terminate {false};
+
+public:
+    SingleQueueThreadPool(size_t size) : _threads(size) {
+        for (auto& thread : _threads) thread = std::thread([&]() {runThread();});
+    }
+    ~SingleQueueThreadPool() {
+        {
+            auto lock = _job_queue_mutex.getLock();
+            _terminate = true;
+        }
+        _job_queue_cond_var.notify();
+        for (auto& thread : _threads) thread.join();
+    }
+    std::future<void> addTask(std::function<void()>&& function) {
+        Runnable r;
+        r.function = std::move(function);
+        std::future<void> future;
+        {
+            auto lock = _job_queue_mutex.getLock();
+            _job_queue.push_back(std::move(r));
+            future = _job_queue.back().promise.get_future();
+        }
+        _job_queue_cond_var.notify();
+        return future;
+    }
+
+private:
+    void runThread() {
+        while (true) {
+            Runnable r;
+            {
+                auto lock = _job_queue_mutex.getLock();
+                _job_queue_cond_var.waitWithLockedMutex(lock, [&]() {return _terminate || !_job_queue.empty();});
+                if (_job_queue.empty()) return;
+                r = std::move(_job_queue.front());
+                _job_queue.pop_front();
+            }
+            r.function();
+            r.promise.set_value();
+        }
+    }
+};
+
+void testTaskStorage() {
+    int counter = 0;
+    // inline storage, moved around
+    ThreadPoolTask small([&]() {counter++;});
+    ThreadPoolTask moved(std::move(small));
+    assert(!small.valid());
+    moved();
+    assert(counter == 1);
+
+    // heap storage for large captures
+    std::array<long, 32> large;
+    large.fill(1);
+    ThreadPoolTask big([&counter, large]() {for (long x : large) counter += x;});
+    ThreadPoolTask bigMoved;
+    bigMoved = std::move(big);
+    bigMoved();
+    assert(counter == 33);
+
+    // move-only captures are destroyed with the task
+    auto ptr = std::make_shared<int>(5);
+    {
+        ThreadPoolTask owning([p = std::unique_ptr<int>(new int(3)), ptr]() {});
+        assert(ptr.use_count() == 2);
+    }
+    assert(ptr.use_count() == 1);
+}
+
+void testExecution() {
+    ThreadPool pool(4);
+    std::atomic_int counter {0};
+
+    // futures
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 1000; i++) futures.push_back(pool.addTask([&]() {counter++;}));
+    for (auto& f : futures) f.get();
+    assert(counter == 1000);
+
+    // detached tasks which spawn further tasks (pushed to the worker's own queue)
+    counter = 0;
+    for (int i = 0; i < 100; i++) {
+        pool.addDetachedTask([&]() {
+            for (int j = 0; j < 100; j++) pool.addDetachedTask([&]() {counter++;});
+        });
+    }
+    while (counter < 10000) usleep(1000);
+    assert(counter == 10000);
+
+    // one long-running task must not block tasks queued behind it
+    std::atomic_bool release {false};
+    auto blocker = pool.addTask([&]() {while (!release) usleep(1000);});
+    futures.clear();
+    for (int i = 0; i < 100; i++) futures.push_back(pool.addTask([&]() {counter++;}));
+    for (auto& f : futures) f.get();
+    release = true;
+    blocker.get();
+    LOG(V2_INFO, "Execution tests passed\n");
+}
+
+// Several threads concurrently submit many tiny tasks (as during heavy clause sharing)
+// and wait for all of them to complete.
+template <typename Submit>
+float runContentionBenchmark(int numSubmitters, int numTasksPerSubmitter, Submit submit) {
+    std::atomic_long counter {0};
+    float time = Timer::elapsedSeconds();
+    std::vector<std::thread> submitters;
+    for (int s = 0; s < numSubmitters; s++) {
+        submitters.emplace_back([&]() {
+            for (int i = 0; i < numTasksPerSubmitter; i++) submit([&counter]() {counter++;});
+        });
+    }
+    for (auto& t : submitters) t.join();
+    while (counter < (long) numSubmitters * numTasksPerSubmitter) std::this_thread::yield();
+    return Timer::elapsedSeconds() - time;
+}
+
+void benchmark() {
+    const int numThreads = 4;
+    const int numSubmitters = 4;
+    const int numTasks = 100'000;
+    float timeOld, timeNew, timeNewFutures;
+    {
+        SingleQueueThreadPool pool(numThreads);
+        timeOld = runContentionBenchmark(numSubmitters, numTasks, [&](auto&& f) {pool.addTask(f);});
+    }
+    {
+        ThreadPool pool(numThreads);
+        timeNewFutures = runContentionBenchmark(numSubmitters, numTasks, [&](auto&& f) {pool.addTask(f);});
+    }
+    {
+        ThreadPool pool(numThreads);
+        timeNew = runContentionBenchmark(numSubmitters, numTasks, [&](auto&& f) {pool.addDetachedTask(f);});
+    }
+    LOG(V2_INFO, "%i submitters, %i threads, %i tasks: single queue %.3fs, work stealing %.3fs (with futures: %.3fs)\n",
+        numSubmitters, numThreads, numSubmitters*numTasks, timeOld, timeNew, timeNewFutures);
+}
+
+int main() {
+    Timer::init();
+    Logger::init(0, V5_DEBG);
+
+    testTaskStorage();
+    testExecution();
+    benchmark();
+}
@@ -0,0 +1,163 @@
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/prefetching_merge_source.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+#include "util/tournament_merger.hpp"
+
+class VectorMergeSource : public MergeSourceInterface<long> {
+private:
+    std::vector<long> _elems;
+    size_t _pos {0};
+public:
+    VectorMergeSource(std::vector<long>&& elems) : _elems(std::move(elems)) {}
+    bool pollBlocking(long& elem) override {
+        if (_pos == _elems.size()) return false;
+        elem = _elems[_pos++];
+        return true;
+    }
+    size_t getCurrentSize() const override {
+        return _elems.size() - _pos;
+    }
+};
+
+// Previous design as a baseline for the benchmark: linear scan over all sources.
+class LinearScanMerger : public MergeSourceInterface<long> {
+private:
+    struct Source {
+        MergeSourceInterface<long>* interface;
+        long nextElem;
+        bool valid {false};
+        bool exhausted {false};
+    };
+    std::vector<Source> _sources;
+public:
+    LinearScanMerger(const std::vector<MergeSourceInterface<long>*>& sources) {
+        for (auto& source : sources) _sources.push_back(Source{source});
+    }
+    bool pollBlocking(long& output) override {
+        Source* best = nullptr;
+        for (auto& source : _sources) {
+            if (source.exhausted) continue;
+            if (!source.valid && !source.interface->pollBlocking(source.nextElem)) {
+                source.exhausted = true;
+                continue;
+            }
+            source.valid = true;
+            if (best == nullptr || source.nextElem > best->nextElem) best = &source;
+        }
+        if (best == nullptr) return false;
+        output = best->nextElem;
+        best->valid = false;
+        return true;
+    }
+    size_t getCurrentSize() const override {return 0;}
+};
+
+// Distributes descending numbers randomly over the given number of sources.
+std::vector<std::unique_ptr<MergeSourceInterface<long>>> createSources(int numSources, long numElems) {
+    std::vector<std::vector<long>> elems(numSources);
+    for (long x = numElems; x >= 1; x--) {
+        elems[(int) (Random::rand() * numSources) % numSources].push_back(x);
+    }
+    std::vector<std::unique_ptr<MergeSourceInterface<long>>> sources;
+    for (auto& vec : elems) sources.emplace_back(new VectorMergeSource(std::move(vec)));
+    return sources;
+}
+
+std::vector<MergeSourceInterface<long>*> getPointers(std::vector<std::unique_ptr<MergeSourceInterface<long>>>& sources) {
+    std::vector<MergeSourceInterface<long>*> ptrs;
+    for (auto& source : sources) ptrs.push_back(source.get());
+    return ptrs;
+}
+
+void checkOutput(MergeSourceInterface<long>& merger, long numElems) {
+    long elem;
+    for (long expected = numElems; expected >= 1; expected--) {
+        bool success = merger.pollBlocking(elem);
+        assert(success);
+        assert(elem == expected || log_return_false("Expected %ld, got %ld\n", expected, elem));
+    }
+    assert(!merger.pollBlocking(elem));
+    assert(!merger.pollBlocking(elem));
+}
+
+void testMerge() {
+    for (int numSources : {0, 1, 2, 3, 5, 8, 17, 100}) {
+        for (long numElems : {0L, 1L, 10L, 10'000L}) {
+            auto sources = createSources(std::max(1, numSources), numSources == 0 ? 0 : numElems);
+            if (numSources == 0) sources.clear();
+            TournamentMerger<long> merger(getPointers(sources));
+            checkOutput(merger, numSources == 0 ? 0 : numElems);
+        }
+    }
+    // Duplicate elements
+    std::vector<std::unique_ptr<MergeSourceInterface<long>>> sources;
+    sources.emplace_back(new VectorMergeSource({5, 3, 3, 1}));
+    sources.emplace_back(new VectorMergeSource({5, 4, 3}));
+    TournamentMerger<long> merger(getPointers(sources));
+    std::vector<long> output;
+    long elem;
+    while (merger.pollBlocking(elem)) output.push_back(elem);
+    assert(output == std::vector<long>({5, 5, 4, 3, 3, 3, 1}));
+    LOG(V2_INFO, "Merge tests passed\n");
+}
+
+void testPrefetching() {
+    for (long numElems : {0L, 1023L, 1024L, 1025L, 100'000L}) {
+        auto sources = createSources(7, numElems);
+        std::vector<std::unique_ptr<MergeSourceInterface<long>>> prefetchers;
+        for (auto& source : sources) {
+            prefetchers.emplace_back(new PrefetchingMergeSource<long>(source.release()));
+        }
+        TournamentMerger<long> merger(getPointers(prefetchers));
+        checkOutput(merger, numElems);
+    }
+    // Destruction before the source was read completely
+    auto sources = createSources(1, 100'000);
+    {
+        PrefetchingMergeSource<long> prefetcher(sources.front().release(), 16, 2);
+        long elem;
+        assert(prefetcher.pollBlocking(elem) && elem == 100'000);
+    }
+    LOG(V2_INFO, "Prefetching tests passed\n");
+}
+
+void benchmark() {
+    const int numSources = 64;
+    const long numElems = 2'000'000;
+    float timeLinear, timeTournament;
+    long elem;
+    {
+        auto sources = createSources(numSources, numElems);
+        LinearScanMerger merger(getPointers(sources));
+        float time = Timer::elapsedSeconds();
+        while (merger.pollBlocking(elem)) {}
+        timeLinear = Timer::elapsedSeconds() - time;
+    }
+    {
+        auto sources = createSources(numSources, numElems);
+        TournamentMerger<long> merger(getPointers(sources));
+        float time = Timer::elapsedSeconds();
+        while (merger.pollBlocking(elem)) {}
+        timeTournament = Timer::elapsedSeconds() - time;
+    }
+    LOG(V2_INFO, "%i sources, %ld elements: linear scan %.3fs, tournament tree %.3fs\n",
+        numSources, numElems, timeLinear, timeTournament);
+}
+
+int main() {
+    Timer::init();
+    Random::init(1, 1);
+    Logger::init(0, V5_DEBG);
+
+    testMerge();
+    testPrefetching();
+    benchmark();
+}
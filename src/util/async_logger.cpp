@@ -0,0 +1,567 @@
+
+#include "async_logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "logger.hpp"
+#include "util/robin_hood.hpp"
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 1 << 18;
+constexpr size_t MAX_RECORD_SIZE = BUFFER_SIZE / 4;
+constexpr int DRAIN_INTERVAL_MICROSECS = 5000;
+constexpr int CRASH_DRAIN_PATIENCE_MILLISECS = 200;
+
+struct RecordHeader {
+    uint32_t size; // including the header, multiple of 8
+    uint32_t options;
+    const Logger* logger; // nullptr: padding up to the end of the buffer
+    const char* format; // nullptr: copy of the format string follows the header
+    float time;
+    int otherRank;
+};
+
+// Type of an argument as consumed from the va_list
+enum ArgType : uint8_t {
+    ARG_STAR, ARG_INT, ARG_LONG, ARG_LONGLONG, ARG_SSIZE, ARG_INTMAX, ARG_PTRDIFF,
+    ARG_UINT, ARG_ULONG, ARG_ULONGLONG, ARG_SIZE, ARG_UINTMAX, ARG_DOUBLE, ARG_LONGDOUBLE,
+    ARG_STRING, ARG_POINTER, ARG_IGNORED
+};
+struct Arg {
+    ArgType type;
+    int precision; // for strings: -1 (none), -2 (given by the preceding star), or the literal
+};
+
+// Single-producer single-consumer ring buffer of records. A buffer is owned by
+// one thread at a time and is handed on to a new thread after its owner exited.
+// Buffers are never freed, so the drainer can traverse the list without locking.
+struct ThreadBuffer {
+    std::vector<uint8_t> data;
+    std::atomic<size_t> head {0}; // advanced by the producer
+    std::atomic<size_t> tail {0}; // advanced by the consumer
+    std::atomic_bool abandoned {false}; // owner thread has exited
+    ThreadBuffer* next {nullptr}; // immutable after publication
+
+    // Producer-side state, only used by the owning thread
+    std::vector<uint8_t> scratch;
+    robin_hood::unordered_node_map<const char*, std::vector<Arg>> parsedFormats;
+    std::vector<Arg> uncachedArguments;
+
+    ThreadBuffer() : data(BUFFER_SIZE) {scratch.reserve(1024);}
+};
+
+struct State {
+    std::atomic_bool active {false};
+    std::atomic_bool running {false};
+    std::mutex drainMutex;
+    std::atomic<ThreadBuffer*> buffers {nullptr}; // head of the list of all buffers
+};
+// Never destructed such that logging remains possible during static destruction
+State& state() {
+    static State* state = new State();
+    return *state;
+}
+
+thread_local bool tlDraining = false;
+
+// Format strings are usually literals with static storage duration and can then be
+// referenced by the records. Others (e.g., from std::string) need to be copied.
+extern "C" char __executable_start;
+extern "C" char edata;
+bool hasStaticStorage(const char* str) {
+    return str >= &__executable_start && str < &edata;
+}
+
+// The calling thread's buffer, set on its first asynchronous log call
+thread_local ThreadBuffer* tlBuffer = nullptr;
+
+// Hands the buffer of an exiting thread on to later threads
+struct BufferRelease {
+    ThreadBuffer* buffer {nullptr};
+    ~BufferRelease() {
+        if (buffer) buffer->abandoned.store(true, std::memory_order_release);
+    }
+};
+thread_local BufferRelease tlBufferRelease;
+
+// Takes over the buffer of an exited thread or publishes a new buffer
+// at the head of the list. Done once per thread.
+ThreadBuffer* registerThread() {
+    auto& buffers = state().buffers;
+    ThreadBuffer* buffer = nullptr;
+    for (ThreadBuffer* b = buffers.load(std::memory_order_acquire); b; b = b->next) {
+        bool abandoned = true;
+        if (b->abandoned.load(std::memory_order_relaxed)
+                && b->abandoned.compare_exchange_strong(abandoned, false, std::memory_order_acquire)) {
+            buffer = b;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new ThreadBuffer();
+        ThreadBuffer* head = buffers.load(std::memory_order_relaxed);
+        do {
+            buffer->next = head;
+        } while (!buffers.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+    }
+    tlBufferRelease.buffer = buffer;
+    tlBuffer = buffer;
+    return buffer;
+}
+
+// Conversion specification of a printf format string
+struct Spec {
+    enum Length {NONE, HH, H, L, LL, Z, J, T, LD} length {NONE};
+    const char* begin; // at '%'
+    const char* end; // after the conversion character
+    char conversion;
+    bool starWidth {false};
+    bool starPrecision {false};
+    bool flagsOrWidth {false};
+    int precision {-1}; // literal precision, if any
+};
+
+// Finds the next conversion (other than "%%") at or after pos.
+// Returns false if there is none.
+bool nextSpec(const char* pos, Spec& spec) {
+    while (true) {
+        pos = strchr(pos, '%');
+        if (!pos) return false;
+        if (pos[1] == '%') {
+            pos += 2;
+            continue;
+        }
+        break;
+    }
+    spec = Spec();
+    spec.begin = pos++;
+    while (*pos && strchr("-+ #0'", *pos)) pos++;
+    if (*pos == '*') {
+        spec.starWidth = true;
+        pos++;
+    } else while (*pos >= '0' && *pos <= '9') pos++;
+    spec.flagsOrWidth = pos != spec.begin+1;
+    if (*pos == '.') {
+        pos++;
+        if (*pos == '*') {
+            spec.starPrecision = true;
+            pos++;
+        } else {
+            spec.precision = 0;
+            while (*pos >= '0' && *pos <= '9') spec.precision = 10*spec.precision + (*pos++ - '0');
+        }
+    }
+    switch (*pos) {
+    case 'h': spec.length = pos[1] == 'h' ? Spec::HH : Spec::H; pos += pos[1] == 'h' ? 2 : 1; break;
+    case 'l': spec.length = pos[1] == 'l' ? Spec::LL : Spec::L; pos += pos[1] == 'l' ? 2 : 1; break;
+    case 'q': spec.length = Spec::LL; pos++; break;
+    case 'z': spec.length = Spec::Z; pos++; break;
+    case 'j': spec.length = Spec::J; pos++; break;
+    case 't': spec.length = Spec::T; pos++; break;
+    case 'L': spec.length = Spec::LD; pos++; break;
+    }
+    spec.conversion = *pos;
+    spec.end = *pos ? pos+1 : pos;
+    return true;
+}
+
+bool isSignedConversion(char c) {return c == 'd' || c == 'i';}
+bool isUnsignedConversion(char c) {return c == 'u' || c == 'o' || c == 'x' || c == 'X';}
+bool isFloatConversion(char c) {return strchr("fFeEgGaA", c) != nullptr && c != '\0';}
+
+template <typename T>
+void append(std::vector<uint8_t>& out, const T& value) {
+    const size_t size = out.size();
+    out.resize(size + sizeof(T));
+    memcpy(out.data() + size, &value, sizeof(T));
+}
+template <typename T>
+T consume(const uint8_t*& pos) {
+    T value;
+    memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+void parseArguments(const char* format, std::vector<Arg>& out) {
+    Spec spec;
+    const char* pos = format;
+    while (nextSpec(pos, spec)) {
+        pos = spec.end;
+        if (spec.starWidth) out.push_back({ARG_STAR, -1});
+        if (spec.starPrecision) out.push_back({ARG_STAR, -1});
+        const char c = spec.conversion;
+        if (isSignedConversion(c) || c == 'c') {
+            switch (spec.length) {
+            case Spec::L: out.push_back({ARG_LONG, -1}); break;
+            case Spec::LL: out.push_back({ARG_LONGLONG, -1}); break;
+            case Spec::Z: out.push_back({ARG_SSIZE, -1}); break;
+            case Spec::J: out.push_back({ARG_INTMAX, -1}); break;
+            case Spec::T: out.push_back({ARG_PTRDIFF, -1}); break;
+            default: out.push_back({ARG_INT, -1});
+            }
+        } else if (isUnsignedConversion(c)) {
+            switch (spec.length) {
+            case Spec::L: out.push_back({ARG_ULONG, -1}); break;
+            case Spec::LL: out.push_back({ARG_ULONGLONG, -1}); break;
+            case Spec::Z: out.push_back({ARG_SIZE, -1}); break;
+            case Spec::J: out.push_back({ARG_UINTMAX, -1}); break;
+            case Spec::T: out.push_back({ARG_PTRDIFF, -1}); break;
+            default: out.push_back({ARG_UINT, -1});
+            }
+        } else if (isFloatConversion(c)) {
+            out.push_back({spec.length == Spec::LD ? ARG_LONGDOUBLE : ARG_DOUBLE, -1});
+        } else if (c == 's') {
+            out.push_back({ARG_STRING, spec.starPrecision ? -2 : spec.precision});
+        } else if (c == 'p') {
+            out.push_back({ARG_POINTER, -1});
+        } else if (c == 'n') {
+            out.push_back({ARG_IGNORED, -1}); // not supported: consume and ignore
+        }
+    }
+}
+
+// Parsed arguments of the format strings recorded in the buffer so far
+const std::vector<Arg>& getArguments(ThreadBuffer& buffer, const char* format, bool cacheable) {
+    if (!cacheable) {
+        buffer.uncachedArguments.clear();
+        parseArguments(format, buffer.uncachedArguments);
+        return buffer.uncachedArguments;
+    }
+    auto it = buffer.parsedFormats.find(format);
+    if (it == buffer.parsedFormats.end()) {
+        it = buffer.parsedFormats.emplace(format, std::vector<Arg>()).first;
+        parseArguments(format, it->second);
+    }
+    return it->second;
+}
+
+// Copies the arguments referenced by the format string to out.
+void encodeArguments(const std::vector<Arg>& arguments, va_list& args, std::vector<uint8_t>& out) {
+    int star = -1;
+    for (const Arg& arg : arguments) {
+        switch (arg.type) {
+        case ARG_STAR: star = va_arg(args, int); append(out, star); break;
+        case ARG_INT: append(out, (long long) va_arg(args, int)); break;
+        case ARG_LONG: append(out, (long long) va_arg(args, long)); break;
+        case ARG_LONGLONG: append(out, va_arg(args, long long)); break;
+        case ARG_SSIZE: append(out, (long long) va_arg(args, ssize_t)); break;
+        case ARG_INTMAX: append(out, (long long) va_arg(args, intmax_t)); break;
+        case ARG_PTRDIFF: append(out, (long long) va_arg(args, ptrdiff_t)); break;
+        case ARG_UINT: append(out, (unsigned long long) va_arg(args, unsigned int)); break;
+        case ARG_ULONG: append(out, (unsigned long long) va_arg(args, unsigned long)); break;
+        case ARG_ULONGLONG: append(out, va_arg(args, unsigned long long)); break;
+        case ARG_SIZE: append(out, (unsigned long long) va_arg(args, size_t)); break;
+        case ARG_UINTMAX: append(out, (unsigned long long) va_arg(args, uintmax_t)); break;
+        case ARG_DOUBLE: append(out, va_arg(args, double)); break;
+        case ARG_LONGDOUBLE: append(out, va_arg(args, long double)); break;
+        case ARG_STRING: {
+            const char* str = va_arg(args, const char*);
+            if (!str) str = "(null)";
+            const int precision = arg.precision == -2 ? star : arg.precision;
+            uint32_t len = precision >= 0 ? strnlen(str, precision) : strlen(str);
+            append(out, len);
+            out.insert(out.end(), (const uint8_t*) str, (const uint8_t*) str + len);
+            break;
+        }
+        case ARG_POINTER: append(out, va_arg(args, void*)); break;
+        case ARG_IGNORED: (void) va_arg(args, void*); break;
+        }
+    }
+}
+
+template <typename T>
+void appendFormatted(std::string& out, const char* spec, T value) {
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf), spec, value);
+    if (len < 0) return;
+    if ((size_t) len < sizeof(buf)) {
+        out.append(buf, len);
+        return;
+    }
+    const size_t oldSize = out.size();
+    out.resize(oldSize + len + 1);
+    snprintf(out.data() + oldSize, len + 1, spec, value);
+    out.resize(oldSize + len);
+}
+
+// Fast path for the most common conversions without flags and width.
+// Returns false (without consuming the argument) if the conversion is not covered.
+bool appendPlain(const Spec& spec, const uint8_t*& pos, std::string& out) {
+    if (spec.flagsOrWidth || spec.starPrecision) return false;
+    char buf[128];
+    std::to_chars_result res;
+    const char c = spec.conversion;
+    if (spec.precision >= 0 && c != 's' && c != 'f') return false;
+    if (isSignedConversion(c)) {
+        long long value;
+        memcpy(&value, pos, sizeof(value));
+        if (spec.length == Spec::NONE) value = (int) value;
+        else if (spec.length == Spec::H || spec.length == Spec::HH) return false;
+        res = std::to_chars(buf, buf+sizeof(buf), value);
+    } else if (c == 'u' || c == 'x') {
+        unsigned long long value;
+        memcpy(&value, pos, sizeof(value));
+        if (spec.length == Spec::NONE) value = (unsigned int) value;
+        else if (spec.length == Spec::H || spec.length == Spec::HH) return false;
+        res = std::to_chars(buf, buf+sizeof(buf), value, c == 'x' ? 16 : 10);
+    } else if (c == 'f' && spec.length != Spec::LD) {
+        double value;
+        memcpy(&value, pos, sizeof(value));
+        if (!std::isfinite(value)) return false;
+        res = std::to_chars(buf, buf+sizeof(buf), value, std::chars_format::fixed,
+            spec.precision >= 0 ? spec.precision : 6);
+    } else if (c == 's') {
+        uint32_t len = consume<uint32_t>(pos);
+        out.append((const char*) pos, len);
+        pos += len;
+        return true;
+    } else if (c == 'c') {
+        out.push_back((char) consume<long long>(pos));
+        return true;
+    } else return false;
+    if (res.ec != std::errc()) return false;
+    out.append(buf, res.ptr - buf);
+    pos += 8;
+    return true;
+}
+
+// Reproduces the formatted message from the format string and the encoded arguments.
+void decodeMessage(const char* format, const uint8_t* pos, std::string& out) {
+    Spec spec;
+    const char* literal = format;
+    std::string specStr;
+    while (nextSpec(literal, spec)) {
+        // Literal text in front of the conversion (with "%%" escapes)
+        for (const char* c = literal; c < spec.begin; c++) {
+            out.push_back(*c);
+            if (c[0] == '%' && c[1] == '%') c++;
+        }
+        literal = spec.end;
+        if (appendPlain(spec, pos, out)) continue;
+
+        // Conversion specification with explicit width and precision
+        specStr.assign(spec.begin, spec.end);
+        if (spec.starWidth) {
+            auto star = specStr.find('*');
+            specStr.replace(star, 1, std::to_string(consume<int>(pos)));
+        }
+        if (spec.starPrecision) {
+            auto star = specStr.find('*');
+            specStr.replace(star, 1, std::to_string(consume<int>(pos)));
+        }
+        const char* s = specStr.c_str();
+        const char c = spec.conversion;
+        if (isSignedConversion(c) || c == 'c') {
+            long long value = consume<long long>(pos);
+            switch (spec.length) {
+            case Spec::L: appendFormatted(out, s, (long) value); break;
+            case Spec::LL: appendFormatted(out, s, value); break;
+            case Spec::Z: appendFormatted(out, s, (ssize_t) value); break;
+            case Spec::J: appendFormatted(out, s, (intmax_t) value); break;
+            case Spec::T: appendFormatted(out, s, (ptrdiff_t) value); break;
+            default: appendFormatted(out, s, (int) value);
+            }
+        } else if (isUnsignedConversion(c)) {
+            unsigned long long value = consume<unsigned long long>(pos);
+            switch (spec.length) {
+            case Spec::L: appendFormatted(out, s, (unsigned long) value); break;
+            case Spec::LL: appendFormatted(out, s, value); break;
+            case Spec::Z: appendFormatted(out, s, (size_t) value); break;
+            case Spec::J: appendFormatted(out, s, (uintmax_t) value); break;
+            case Spec::T: appendFormatted(out, s, (ptrdiff_t) value); break;
+            default: appendFormatted(out, s, (unsigned int) value);
+            }
+        } else if (isFloatConversion(c)) {
+            if (spec.length == Spec::LD) appendFormatted(out, s, consume<long double>(pos));
+            else appendFormatted(out, s, consume<double>(pos));
+        } else if (c == 's') {
+            uint32_t len = consume<uint32_t>(pos);
+            std::string str((const char*) pos, len);
+            pos += len;
+            appendFormatted(out, s, str.c_str());
+        } else if (c == 'p') {
+            appendFormatted(out, s, consume<void*>(pos));
+        } else if (c != 'n') {
+            out += specStr; // unknown conversion: print verbatim
+        }
+    }
+    for (const char* c = literal; *c; c++) {
+        out.push_back(*c);
+        if (c[0] == '%' && c[1] == '%') c++;
+    }
+}
+
+// Position of the next record at or after pos, skipping padding
+size_t skipPadding(const ThreadBuffer& buffer, size_t pos, size_t end) {
+    while (pos < end) {
+        const size_t offset = pos % BUFFER_SIZE;
+        if (BUFFER_SIZE - offset < sizeof(RecordHeader)) {
+            pos += BUFFER_SIZE - offset;
+            continue;
+        }
+        RecordHeader header;
+        memcpy(&header, buffer.data.data() + offset, sizeof(RecordHeader));
+        if (header.logger) break;
+        pos += header.size;
+    }
+    return pos;
+}
+
+}
+
+// Writes all records which have been completed so far, merged by their timestamps.
+// The caller must hold the drain mutex.
+void AsyncLogger::doDrain() {
+    struct Cursor {
+        ThreadBuffer* buffer;
+        size_t pos;
+        size_t end;
+    };
+    std::vector<Cursor> cursors;
+    for (ThreadBuffer* buffer = state().buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        size_t end = buffer->head.load(std::memory_order_acquire);
+        size_t pos = buffer->tail.load(std::memory_order_relaxed);
+        if (pos < end) cursors.push_back(Cursor{buffer, pos, end});
+    }
+
+    std::vector<const Logger*> touchedLoggers;
+    std::string message;
+    while (true) {
+        Cursor* next = nullptr;
+        RecordHeader nextHeader;
+        for (auto& cursor : cursors) {
+            cursor.pos = skipPadding(*cursor.buffer, cursor.pos, cursor.end);
+            if (cursor.pos == cursor.end) {
+                cursor.buffer->tail.store(cursor.pos, std::memory_order_release);
+                continue;
+            }
+            RecordHeader header;
+            memcpy(&header, cursor.buffer->data.data() + cursor.pos % BUFFER_SIZE, sizeof(RecordHeader));
+            if (!next || header.time < nextHeader.time) {
+                next = &cursor;
+                nextHeader = header;
+            }
+        }
+        if (!next) break;
+
+        message.clear();
+        const uint8_t* args = next->buffer->data.data() + next->pos % BUFFER_SIZE + sizeof(RecordHeader);
+        const char* format = nextHeader.format;
+        if (!format) {
+            const uint32_t len = consume<uint32_t>(args);
+            format = (const char*) args;
+            args += len + 1;
+        }
+        decodeMessage(format, args, message);
+        nextHeader.logger->output(nextHeader.options, nextHeader.time, nextHeader.otherRank, message.c_str());
+        if (std::find(touchedLoggers.begin(), touchedLoggers.end(), nextHeader.logger) == touchedLoggers.end())
+            touchedLoggers.push_back(nextHeader.logger);
+
+        next->pos += nextHeader.size;
+        next->buffer->tail.store(next->pos, std::memory_order_release);
+    }
+    for (auto logger : touchedLoggers) logger->flushStreams();
+}
+
+void AsyncLogger::start() {
+    if (state().running.exchange(true)) return;
+    state().active = true;
+    std::thread([]() {
+        while (state().running) {
+            usleep(DRAIN_INTERVAL_MICROSECS);
+            drain();
+        }
+    }).detach();
+}
+
+void AsyncLogger::stop() {
+    if (!state().running.exchange(false)) return;
+    state().active = false;
+    drain();
+}
+
+bool AsyncLogger::isActive() {
+    return state().active.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogger::record(const Logger* logger, unsigned int options, float time, int otherRank,
+        const char* format, va_list& args) {
+
+    if (tlDraining) return false;
+
+    ThreadBuffer* threadBuffer = tlBuffer;
+    if (!threadBuffer) threadBuffer = registerThread();
+    ThreadBuffer& buffer = *threadBuffer;
+
+    // Serialize the record
+    auto& scratch = buffer.scratch;
+    scratch.resize(sizeof(RecordHeader));
+    const bool copyFormat = !hasStaticStorage(format);
+    if (copyFormat) {
+        uint32_t len = strlen(format);
+        append(scratch, len);
+        scratch.insert(scratch.end(), (const uint8_t*) format, (const uint8_t*) format + len + 1);
+    }
+    va_list argsCopy; va_copy(argsCopy, args); // keep args for a fallback to synchronous logging
+    encodeArguments(getArguments(buffer, format, !copyFormat), argsCopy, scratch);
+    va_end(argsCopy);
+    scratch.resize((scratch.size() + 7) & ~7UL);
+    if (scratch.size() > MAX_RECORD_SIZE) {
+        drain();
+        return false;
+    }
+    RecordHeader header {(uint32_t) scratch.size(), options, logger, copyFormat ? nullptr : format, time, otherRank};
+    memcpy(scratch.data(), &header, sizeof(RecordHeader));
+
+    // Reserve space (contiguously) in the ring buffer
+    size_t head = buffer.head.load(std::memory_order_relaxed);
+    const size_t contiguous = BUFFER_SIZE - head % BUFFER_SIZE;
+    const size_t padding = contiguous < scratch.size() ? contiguous : 0;
+    if (head + padding + scratch.size() - buffer.tail.load(std::memory_order_acquire) > BUFFER_SIZE) {
+        // Buffer full: do the work of the background thread
+        drain();
+    }
+    if (padding >= sizeof(RecordHeader)) {
+        RecordHeader paddingHeader {(uint32_t) padding, 0, nullptr, nullptr, 0, 0};
+        memcpy(buffer.data.data() + head % BUFFER_SIZE, &paddingHeader, sizeof(RecordHeader));
+    }
+    head += padding;
+    memcpy(buffer.data.data() + head % BUFFER_SIZE, scratch.data(), scratch.size());
+    buffer.head.store(head + scratch.size(), std::memory_order_release);
+    return true;
+}
+
+void AsyncLogger::drain() {
+    if (tlDraining) return;
+    std::lock_guard<std::mutex> lock(state().drainMutex);
+    tlDraining = true;
+    doDrain();
+    tlDraining = false;
+}
+
+void AsyncLogger::drainOnCrash() {
+    if (tlDraining) return; // crashed while draining
+    auto& mutex = state().drainMutex;
+    for (int i = 0; !mutex.try_lock(); i++) {
+        if (i == CRASH_DRAIN_PATIENCE_MILLISECS) return;
+        usleep(1000);
+    }
+    tlDraining = true;
+    doDrain();
+    tlDraining = false;
+    mutex.unlock();
+}
@@ -0,0 +1,37 @@
+
+#pragma once
+
+#include <stdarg.h>
+
+class Logger;
+
+// Backend for asynchronous logging. A logging thread does not format its message
+// but records the format string, the timestamp, and the raw arguments (copying
+// strings) into its own single-producer single-consumer ring buffer. A background
+// thread periodically merges the records of all threads by their timestamps,
+// formats them, and writes them via the respective Logger instance.
+// Each thread obtains its buffer once, on its first log call, from a lock-free list
+// which the background thread traverses; recording a call takes no lock.
+// If a thread's buffer is full, the thread drains all buffers itself.
+class AsyncLogger {
+
+public:
+    static void start();
+    static void stop();
+    static bool isActive();
+
+    // Returns false if the call could not be recorded (e.g., a huge message),
+    // in which case all previous records have been written and the caller
+    // should log the message synchronously.
+    static bool record(const Logger* logger, unsigned int options, float time, int otherRank,
+        const char* format, va_list& args);
+
+    // Format and write all records made so far within the calling thread.
+    static void drain();
+    // Crash handler variant of drain() which does not wait indefinitely
+    // for the lock on the buffers.
+    static void drainOnCrash();
+
+private:
+    static void doDrain();
+};
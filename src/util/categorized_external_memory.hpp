@@ -1,48 +1,82 @@
 
 #pragma once
 
-#include <fstream>
 #include <vector>
 #include <list>
+#include <memory>
 #include <cstring>
 
 #include "util/assert.hpp"
 #include "util/logger.hpp"
+#include "util/sys/async_block_io.hpp"
+
+struct ExternalMemoryConfig {
+    // Size of each block in the disk file (multiple of 4096 for direct I/O)
+    size_t blockSize {4096};
+    // Bypass the page cache
+    bool directIo {false};
+    AsyncBlockFile::Backend backend {AsyncBlockFile::THREADS};
+    // Max. number of full blocks which are being written to disk at a time
+    int maxPendingWrites {32};
+    // Max. number of blocks which are read ahead via prefetch()
+    int readAheadBlocks {16};
+};
 
 template <typename T>
 class CategorizedExternalMemory {
 
 private:
-    std::fstream _disk;
-    int _blocksize;
+    ExternalMemoryConfig _config;
+    AsyncBlockFile _disk;
+    size_t _blocksize;
     size_t _num_blocks_in_disk = 0;
 
     struct Block {
-        int address;
-        int size = 0;
-        std::vector<uint8_t> buffer;
-        Block(int address, int capacity) : address(address) {
-            buffer.reserve(capacity);
-        }
-        
+        size_t address;
+        size_t size = 0;
+        // Block-sized buffer, or nullptr if the data only resides on disk
+        uint8_t* buffer {nullptr};
+        // Write or read of this block which is in flight, if any
+        std::unique_ptr<AsyncBlockFile::Request> io;
+        Block(size_t address, uint8_t* buffer) : address(address), buffer(buffer) {}
+
         void append(const T& obj) {
-            buffer.resize(size + sizeof(T));
-            memcpy(buffer.data()+size, &obj, sizeof(T));
+            memcpy(buffer+size, &obj, sizeof(T));
             size += sizeof(T);
         }
     };
     std::vector<std::list<Block>> _blocks_per_address;
-    std::list<int> _free_addresses;
+    std::list<size_t> _free_addresses;
 
-    std::vector<uint8_t> _empty_buffer;
+    // Blocks (in the above lists) whose writes are in flight, in the order of submission
+    std::list<Block*> _pending_writes;
+    int _num_pending_reads = 0;
+    std::vector<uint8_t*> _free_buffers;
 
     unsigned long long _num_elems = 0;
 
 public:
-    CategorizedExternalMemory(const std::string& diskFile, int blockSize) : _blocksize(blockSize) {
-        _disk = std::fstream(diskFile, std::fstream::in | std::fstream::out | std::fstream::binary | std::fstream::trunc);
-        assert(_disk.good());
-        _empty_buffer = std::vector<uint8_t>(_blocksize, 0);
+    CategorizedExternalMemory(const std::string& diskFile, int blockSize) :
+        CategorizedExternalMemory(diskFile, [&]() {
+            ExternalMemoryConfig config;
+            config.blockSize = blockSize;
+            return config;
+        }()) {}
+    CategorizedExternalMemory(const std::string& diskFile, const ExternalMemoryConfig& config) :
+            _config(config),
+            _disk(diskFile, config.directIo && config.blockSize % AsyncBlockFile::ALIGNMENT == 0, config.backend),
+            _blocksize(config.blockSize) {
+        if (config.directIo && !_disk.isDirect()) {
+            LOG(V1_WARN, "[WARN] No direct I/O for %s with block size %lu\n", diskFile.c_str(), _blocksize);
+        }
+        assert(_blocksize >= sizeof(T));
+    }
+    ~CategorizedExternalMemory() {
+        for (auto& blocks : _blocks_per_address) for (auto& block : blocks) {
+            if (block.io) _disk.wait(*block.io);
+            if (block.buffer) AsyncBlockFile::freeBuffer(block.buffer);
+        }
+        for (auto buffer : _free_buffers) AsyncBlockFile::freeBuffer(buffer);
     }
 
     void add(size_t address, const T& object) {
@@ -73,30 +107,46 @@ public:
         _num_elems++;
     }
 
+    // Begin to read the blocks at the given address from disk in the background,
+    // anticipating a call to fetchAndRemove(address).
+    void prefetch(size_t address) {
+        if (address >= _blocks_per_address.size()) return;
+        for (auto& block : _blocks_per_address.at(address)) {
+            if (_num_pending_reads >= _config.readAheadBlocks) break;
+            if (!block.buffer) beginRead(block);
+        }
+    }
+
     void fetchAndRemove(size_t address, std::vector<T>& result) {
         assert(result.empty());
         if (address >= _blocks_per_address.size())
-            return; 
+            return;
         // Access block list at address
         auto& blocks = _blocks_per_address.at(address);
-        while (!blocks.empty()) {
-            auto block = std::move(blocks.front());
-            blocks.pop_front();
-            result.resize(result.size() + (block.size / sizeof(T)));
-            auto insertionPoint = result.data() + result.size() - (block.size / sizeof(T));
+
+        // Submit reads for all blocks which are only on disk
+        size_t numElems = 0;
+        for (auto& block : blocks) {
+            if (!block.buffer) beginRead(block);
+            numElems += block.size / sizeof(T);
+        }
+        result.resize(numElems);
+        auto insertionPoint = (uint8_t*) result.data();
+        for (auto& block : blocks) {
             //LOG(V2_INFO, "block #%i: size %i\n", block.address, block.size);
-            if (!block.buffer.empty()) {
-                // Read directly from internal buffer
-                //LOG(V2_INFO, "- fetch from int. buffer\n");
-                memcpy(insertionPoint, block.buffer.data(), block.size);
-            } else {
-                // Read from disk
-                //LOG(V2_INFO, "- fetch from disk\n");
-                _disk.seekg(_blocksize*block.address, std::ios::beg);
-                _disk.read((char*) insertionPoint, block.size);
+            if (block.io) {
+                // Wait for the block's pending write or read
+                _disk.wait(*block.io);
+                if (block.io->write) _pending_writes.remove(&block);
+                else _num_pending_reads--;
+                block.io.reset();
             }
+            memcpy(insertionPoint, block.buffer, block.size);
+            insertionPoint += block.size;
+            releaseBuffer(block.buffer);
             _free_addresses.push_back(block.address);
         }
+        blocks.clear();
         _num_elems -= result.size();
     }
 
@@ -107,11 +157,28 @@ public:
 private:
 
     void sync(Block& block) {
-        assert(block.buffer.size() == block.size);
-        _disk.seekp(_blocksize*block.address, std::ios::beg);
-        _disk.write((const char*) block.buffer.data(), block.buffer.size());
-        _disk.write((const char*) _empty_buffer.data(), _blocksize - block.buffer.size());
-        block.buffer = std::vector<uint8_t>();
+        // Zero the unused rest of the block (the write always covers the full block)
+        memset(block.buffer + block.size, 0, _blocksize - block.size);
+        block.io.reset(new AsyncBlockFile::Request());
+        _disk.submitWrite(*block.io, block.buffer, _blocksize, _blocksize*block.address);
+        _pending_writes.push_back(&block);
+
+        // Release the buffers of blocks which have been written
+        while (!_pending_writes.empty() && ((int) _pending_writes.size() > _config.maxPendingWrites
+                || _disk.test(*_pending_writes.front()->io))) {
+            Block* written = _pending_writes.front();
+            _pending_writes.pop_front();
+            _disk.wait(*written->io);
+            written->io.reset();
+            releaseBuffer(written->buffer);
+        }
+    }
+
+    void beginRead(Block& block) {
+        block.buffer = getBuffer();
+        block.io.reset(new AsyncBlockFile::Request());
+        _disk.submitRead(*block.io, block.buffer, _blocksize, _blocksize*block.address);
+        _num_pending_reads++;
     }
 
     Block fetchFreshBlock() {
@@ -120,13 +187,28 @@ private:
         }
         auto address = _free_addresses.back();
         _free_addresses.pop_back();
-        return Block(address, _blocksize);
+        return Block(address, getBuffer());
     }
 
     void appendBlockToDisk() {
-        _disk.seekp(_blocksize*_num_blocks_in_disk, std::ios::beg);
-        _disk.write((const char*) _empty_buffer.data(), _empty_buffer.size());
+        // The file is extended by the first write to the block
         _free_addresses.push_back(_num_blocks_in_disk);
         _num_blocks_in_disk++;
     }
+
+    uint8_t* getBuffer() {
+        if (_free_buffers.empty()) return AsyncBlockFile::allocateBuffer(_blocksize);
+        auto buffer = _free_buffers.back();
+        _free_buffers.pop_back();
+        return buffer;
+    }
+
+    void releaseBuffer(uint8_t*& buffer) {
+        if ((int) _free_buffers.size() < _config.maxPendingWrites + _config.readAheadBlocks) {
+            _free_buffers.push_back(buffer);
+        } else {
+            AsyncBlockFile::freeBuffer(buffer);
+        }
+        buffer = nullptr;
+    }
 };
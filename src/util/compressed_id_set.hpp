@@ -0,0 +1,101 @@
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "util/robin_hood.hpp"
+
+// Exact set of (clause) IDs in the spirit of Roaring bitmaps. The ID space is partitioned
+// into chunks of 2^16 consecutive values. A chunk stores the lower 16 bits of its IDs in a
+// sorted array while it is sparse and switches to a bitmap of 2^16 bits once it holds more
+// than 1024 IDs, so no chunk takes more than 8 KiB. (Roaring switches at 4096 IDs, which
+// minimizes memory but makes insertions into the sorted arrays expensive.) Memory thus grows
+// with the number and the spread of the inserted IDs instead of being fixed in advance.
+// Clause IDs are mostly dense and bounded, so the chunks of IDs below 2^36 are found via
+// a directory which grows up to the largest such chunk; any larger IDs go to a hash map.
+class CompressedIdSet {
+
+private:
+    static constexpr int CHUNK_BITS = 16;
+    static constexpr unsigned long CHUNK_MASK = (1UL << CHUNK_BITS) - 1;
+    static constexpr size_t MAX_ARRAY_SIZE = 1024;
+    static constexpr size_t NUM_BITMAP_WORDS = (1UL << CHUNK_BITS) / 64;
+    static constexpr unsigned long MAX_DIRECTORY_SIZE = 1UL << 20;
+
+    struct Chunk {
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bitmap;
+        size_t size {0};
+    };
+    std::vector<std::unique_ptr<Chunk>> _directory;
+    robin_hood::unordered_node_map<unsigned long, Chunk> _sparse_chunks;
+    size_t _size {0};
+
+public:
+    // Returns true iff the ID has not been contained before.
+    bool tryInsert(unsigned long id) {
+        Chunk& chunk = getChunk(id >> CHUNK_BITS);
+        const uint16_t low = id & CHUNK_MASK;
+        if (!chunk.bitmap.empty()) {
+            uint64_t& word = chunk.bitmap[low / 64];
+            const uint64_t bit = 1UL << (low % 64);
+            if (word & bit) return false;
+            word |= bit;
+        } else {
+            auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+            if (it != chunk.array.end() && *it == low) return false;
+            chunk.array.insert(it, low);
+            if (chunk.array.size() > MAX_ARRAY_SIZE) convertToBitmap(chunk);
+        }
+        chunk.size++;
+        _size++;
+        return true;
+    }
+
+    bool contains(unsigned long id) const {
+        const Chunk* chunkPtr = findChunk(id >> CHUNK_BITS);
+        if (!chunkPtr) return false;
+        const Chunk& chunk = *chunkPtr;
+        const uint16_t low = id & CHUNK_MASK;
+        if (!chunk.bitmap.empty()) return chunk.bitmap[low / 64] & (1UL << (low % 64));
+        return std::binary_search(chunk.array.begin(), chunk.array.end(), low);
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t getSizeInBytes() const {
+        auto chunkBytes = [](const Chunk& chunk) {
+            return sizeof(chunk) + chunk.array.capacity() * sizeof(uint16_t)
+                + chunk.bitmap.capacity() * sizeof(uint64_t);
+        };
+        size_t bytes = sizeof(*this) + _directory.capacity() * sizeof(void*)
+            + (_sparse_chunks.mask()+1) * (sizeof(void*)+1);
+        for (auto& chunk : _directory) if (chunk) bytes += chunkBytes(*chunk);
+        for (auto& [key, chunk] : _sparse_chunks) bytes += sizeof(key) + chunkBytes(chunk);
+        return bytes;
+    }
+
+private:
+    Chunk& getChunk(unsigned long key) {
+        if (key >= MAX_DIRECTORY_SIZE) return _sparse_chunks[key];
+        if (key >= _directory.size()) _directory.resize(key+1);
+        if (!_directory[key]) _directory[key].reset(new Chunk());
+        return *_directory[key];
+    }
+    const Chunk* findChunk(unsigned long key) const {
+        if (key < MAX_DIRECTORY_SIZE) return key < _directory.size() ? _directory[key].get() : nullptr;
+        auto it = _sparse_chunks.find(key);
+        return it == _sparse_chunks.end() ? nullptr : &it->second;
+    }
+
+    void convertToBitmap(Chunk& chunk) {
+        chunk.bitmap.assign(NUM_BITMAP_WORDS, 0);
+        for (uint16_t low : chunk.array) chunk.bitmap[low / 64] |= 1UL << (low % 64);
+        chunk.array.clear();
+        chunk.array.shrink_to_fit();
+    }
+};
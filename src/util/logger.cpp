@@ -13,6 +13,7 @@
 #include "util/sys/proc.hpp"
 
 #include "logger.hpp"
+#include "async_logger.hpp"
 
 // Taken from https://stackoverflow.com/a/17469726
 enum Code {
@@ -108,6 +109,8 @@ void Logger::init(const LoggerConfig& config) {
             abort();
         }
     }
+
+    if (config.asyncLogging) AsyncLogger::start();
 }
 Logger::Logger(Logger&& other) :
     _log_directory(std::move(other._log_directory)), _log_filename(std::move(other._log_filename)), 
@@ -115,9 +118,12 @@ Logger::Logger(Logger&& other) :
     _verbosity(other._verbosity), _colored_output(other._colored_output), _quiet(other._quiet), 
     _c_prefix(other._c_prefix), _flush_file_immediately(other._flush_file_immediately) {
     
+    // Pending records refer to the other instance
+    if (AsyncLogger::isActive()) AsyncLogger::drain();
     other._log_cfile = nullptr;
 }
 Logger& Logger::operator=(Logger&& other) {
+    if (AsyncLogger::isActive()) AsyncLogger::drain();
     _log_directory = std::move(other._log_directory);
     _log_filename = std::move(other._log_filename);
     _line_prefix = std::move(other._line_prefix);
@@ -133,6 +139,7 @@ Logger& Logger::operator=(Logger&& other) {
     return *this;
 }
 Logger::~Logger() {
+    if (this == &_main_instance) AsyncLogger::stop();
     flush();
     if (_log_cfile != nullptr) fclose(_log_cfile);
 }
@@ -192,6 +199,11 @@ bool Logger::fail(unsigned int options, const char* str, ...) const {
 }
 
 void Logger::flush() const {
+    if (AsyncLogger::isActive()) AsyncLogger::drain();
+    flushStreams();
+}
+
+void Logger::flushStreams() const {
     if (!_quiet) fflush(stdout);
     if (_log_cfile != nullptr) fflush(_log_cfile);
 }
@@ -225,7 +237,6 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
 
     int verbosity = options & 7;
     if (verbosity > _verbosity) return;
-    bool prefix = (options & LOG_NO_PREFIX) == 0;
     bool withDestRank = (options & LOG_ADD_DESTRANK) != 0;
     bool withSrcRank = (options & LOG_ADD_SRCRANK) != 0;
     
@@ -234,6 +245,33 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
         otherRank = va_arg(args, int);
     }
 
+    // Relative time to program start
+    float elapsedRel = Timer::elapsedSeconds();
+
+    // Asynchronous logging: only record the call
+    if (AsyncLogger::isActive() && AsyncLogger::record(this, options, elapsedRel, otherRank, str, args))
+        return;
+
+    // logging message
+    char buffer[1024];
+    va_list argsCopy; va_copy(argsCopy, args); // retrieve copy of "args"
+    int len = vsnprintf(buffer, sizeof(buffer), str, args); // consume original args
+    if (len >= (int) sizeof(buffer)) {
+        std::string message(len, '\0');
+        vsnprintf(message.data(), len+1, str, argsCopy); // consume copied args
+        output(options, elapsedRel, otherRank, message.c_str());
+    } else {
+        output(options, elapsedRel, otherRank, len >= 0 ? buffer : str);
+    }
+    va_end(argsCopy); // destroy copy
+}
+
+void Logger::output(unsigned int options, float time, int otherRank, const char* message) const {
+
+    int verbosity = options & 7;
+    bool prefix = (options & LOG_NO_PREFIX) == 0;
+    bool withDestRank = (options & LOG_ADD_DESTRANK) != 0;
+
     // Colored output, if applicable
     if (!_quiet && _colored_output) {
         if (verbosity <= V0_CRIT) {
@@ -253,22 +291,19 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
 
     // Timestamp and node rank
     if (prefix) {
-        // Relative time to program start
-        float elapsedRel = Timer::elapsedSeconds();
         if (_c_prefix) {
             if (!_quiet) printf("c ");
             if (_log_cfile != nullptr) fprintf(_log_cfile, "c ");
         }
-        if (!_quiet) printf("%.3f %i%s ", elapsedRel, _rank, _line_prefix.c_str());
+        if (!_quiet) printf("%.3f %i%s ", time, _rank, _line_prefix.c_str());
         if (_log_cfile != nullptr) {
-            fprintf(_log_cfile, "%.3f %i%s ", elapsedRel, _rank, _line_prefix.c_str());
+            fprintf(_log_cfile, "%.3f %i%s ", time, _rank, _line_prefix.c_str());
         }
     }
 
     // logging message
-    va_list argsCopy; va_copy(argsCopy, args); // retrieve copy of "args"
-    if (!_quiet) vprintf(str, args); // consume original args
-    if (_log_cfile != nullptr) vfprintf(_log_cfile, str, argsCopy); // consume copied args
+    if (!_quiet) fputs(message, stdout);
+    if (_log_cfile != nullptr) fputs(message, _log_cfile);
     if (otherRank >= 0) {
         auto arrowStr = withDestRank ? "=>" : "<=";
         if (!_quiet) printf(" %s [%i]\n", arrowStr, otherRank);
@@ -276,7 +311,6 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
             fprintf(_log_cfile, " %s [%i]\n", arrowStr, otherRank);
         }
     }
-    va_end(argsCopy); // destroy copy
     
     // Immediate file flushing if desired
     if (_log_cfile != nullptr && _flush_file_immediately) fflush(_log_cfile);
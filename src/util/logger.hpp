@@ -34,6 +34,7 @@ public:
         bool quiet = false;
         bool cPrefix = false;
         bool flushFileImmediately = false;
+        bool asyncLogging = false;
         const std::string* logDirOrNull = nullptr;
         const std::string* logFilenameOrNull = nullptr;
     };
@@ -91,6 +92,11 @@ public:
 private:
 
     void log(va_list& args, unsigned int options, const char* str) const;
+    // Writes a formatted message, decorated according to the options
+    void output(unsigned int options, float time, int otherRank, const char* message) const;
+    void flushStreams() const;
+
+    friend class AsyncLogger;
 };
 
 void log(int options, const char* str, ...);
@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+#include "merge_source_interface.hpp"
+#include "spsc_blocking_ringbuffer.hpp"
+#include "util/sys/background_worker.hpp"
+
+// Reads the elements of another merge source (e.g., parses the lines of a file)
+// ahead of time in a background thread and hands them over in batches,
+// so that the consumer only synchronizes with the background thread once per batch.
+template <typename T>
+class PrefetchingMergeSource : public MergeSourceInterface<T> {
+
+private:
+    std::unique_ptr<MergeSourceInterface<T>> _source;
+    const size_t _batch_size;
+    SPSCBlockingRingbuffer<std::vector<T>> _batches;
+    BackgroundWorker _worker;
+
+    std::vector<T> _current_batch;
+    size_t _current_pos {0};
+
+public:
+    PrefetchingMergeSource(MergeSourceInterface<T>* source, size_t batchSize = 1024, int numBatches = 8) :
+            _source(source), _batch_size(batchSize), _batches(numBatches) {
+        _worker.run([&]() {
+            std::vector<T> batch;
+            bool exhausted = false;
+            while (_worker.continueRunning() && !exhausted) {
+                // The swapped-in batch of the ring buffer is reused
+                batch.resize(_batch_size);
+                size_t size = 0;
+                while (size < _batch_size && _source->pollBlocking(batch[size])) size++;
+                exhausted = size < _batch_size;
+                batch.resize(size);
+                if (size > 0) _batches.pushBlocking(batch);
+            }
+            _batches.markExhausted();
+        });
+    }
+    ~PrefetchingMergeSource() {
+        _worker.stopWithoutWaiting();
+        // Unblock the background thread if it waits for space in the ring buffer
+        std::vector<T> batch;
+        while (!_batches.exhausted()) {
+            if (!_batches.empty()) _batches.pollBlocking(batch);
+            else usleep(100);
+        }
+        _worker.stop();
+    }
+
+    bool pollBlocking(T& elem) override {
+        if (_current_pos == _current_batch.size()) {
+            if (!_batches.pollBlocking(_current_batch)) return false;
+            _current_pos = 0;
+        }
+        std::swap(elem, _current_batch[_current_pos++]);
+        return true;
+    }
+
+    size_t getCurrentSize() const override {
+        return (_current_batch.size() - _current_pos) + _batches.size() * _batch_size;
+    }
+};
@@ -0,0 +1,279 @@
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "util/logger.hpp"
+
+// Writes a file back to front, i.e., the data written last ends up at the file's beginning,
+// without knowing the final file size in advance and without a second pass over the data.
+// The data is placed right below a large virtual end offset of a sparse file. When finalizing,
+// the unused (unallocated) region in front of the data is cut off in constant time if the file
+// system supports FALLOC_FL_COLLAPSE_RANGE. This requires the data to begin at a multiple of
+// the block size, which is achieved by prepending a few bytes of neutral padding provided by
+// the caller (e.g., empty proof lines). Otherwise, the data is moved to the front in place.
+// If the file system does not accept the virtual end offset or cannot collapse ranges (as
+// probed when opening the file), the writer falls back to writing all data in reverse order
+// to "<filename>.inv" and reversing this file into the actual file when finalizing.
+//
+// Data can be added as forward blocks via prepend() or, via the std::streambuf interface,
+// as a reversed byte stream (i.e., the file's last byte first).
+class ReverseFileWriter : public std::streambuf {
+
+private:
+    const std::string _filename;
+    const size_t _virtual_end;
+    int _fd {-1};
+    // Fallback: file with the data in reverse order (if the sparse file is not supported)
+    bool _buffered {false};
+    int _inv_fd {-1};
+
+    std::vector<char> _segment;
+    size_t _segment_begin; // position of the first valid byte in _segment
+    size_t _file_begin; // file offset of the first byte written so far
+
+    bool _finalized {false};
+
+public:
+    ReverseFileWriter(const std::string& filename, size_t segmentSize = 1<<22, size_t virtualEnd = 1UL<<42,
+            bool forceBuffered = false) :
+            _filename(filename), _virtual_end(virtualEnd), _segment(segmentSize),
+            _segment_begin(segmentSize), _file_begin(virtualEnd) {
+        _fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0) {
+            LOG(V0_CRIT, "[ERROR] Cannot open \"%s\": %s\n", filename.c_str(), strerror(errno));
+            return;
+        }
+        _buffered = forceBuffered || !probeSparseFile();
+        if (_buffered) {
+            _inv_fd = ::open(getInvFilename().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (_inv_fd < 0) LOG(V0_CRIT, "[ERROR] Cannot open \"%s\": %s\n", getInvFilename().c_str(), strerror(errno));
+        }
+        LOG(V4_VVER, "Reverse file writer: \"%s\" %s\n", filename.c_str(),
+            _buffered ? "written via reversed file" : "written back to front");
+    }
+    ~ReverseFileWriter() {
+        if (_fd >= 0) ::close(_fd);
+        if (_inv_fd >= 0) {
+            ::close(_inv_fd);
+            ::unlink(getInvFilename().c_str());
+        }
+    }
+
+    bool valid() const {
+        return _fd >= 0 && (!_buffered || _inv_fd >= 0);
+    }
+
+    bool isBuffered() const {
+        return _buffered;
+    }
+
+    // Insert the given bytes in front of all data written so far.
+    void prepend(const char* data, size_t size) {
+        if (size > _segment_begin) flushSegment();
+        if (size > _segment.size()) {
+            writeFront(data, size);
+            return;
+        }
+        _segment_begin -= size;
+        memcpy(_segment.data() + _segment_begin, data, size);
+    }
+
+    size_t size() const {
+        return _virtual_end - _file_begin + (_segment.size() - _segment_begin);
+    }
+
+    // Moves the data to the beginning of the file. padding(n) is called for some n
+    // and may return n bytes which can be put in front of the data without changing its
+    // meaning, or any other string if this is impossible for this n.
+    void finalize(const std::function<std::string(size_t)>& padding) {
+        if (_finalized || !valid()) return;
+        _finalized = true;
+
+        if (_buffered) {
+            flushSegment();
+            reverseIntoFile();
+            return;
+        }
+
+        const size_t begin = _file_begin - (_segment.size() - _segment_begin);
+#ifdef FALLOC_FL_COLLAPSE_RANGE
+        const size_t blockSize = getBlockSize(_fd);
+        for (size_t numPadding = begin % blockSize; numPadding <= begin; numPadding += blockSize) {
+            if (numPadding > 0) {
+                const std::string pad = padding(numPadding);
+                if (pad.size() != numPadding) continue;
+                prepend(pad.data(), pad.size());
+            }
+            flushSegment();
+            if (_file_begin == 0 || fallocate(_fd, FALLOC_FL_COLLAPSE_RANGE, 0, _file_begin) == 0) {
+                LOG(V4_VVER, "Reverse file writer: \"%s\" complete, %lu bytes (%lu bytes padding)\n",
+                    _filename.c_str(), size(), numPadding);
+                _file_begin = 0;
+                return;
+            }
+            LOG(V3_VERB, "Reverse file writer: cannot collapse range (%s), moving data\n", strerror(errno));
+            break;
+        }
+#endif
+        flushSegment();
+        moveToFront();
+    }
+
+protected:
+    // std::streambuf: bytes arrive in reversed order
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::streamsize done = 0;
+        while (done < n) {
+            if (_segment_begin == 0) flushSegment();
+            const size_t chunk = std::min((size_t) (n - done), _segment_begin);
+            std::reverse_copy(s + done, s + done + chunk, _segment.data() + _segment_begin - chunk);
+            _segment_begin -= chunk;
+            done += chunk;
+        }
+        return n;
+    }
+    int_type overflow(int_type c) override {
+        if (c == traits_type::eof()) return traits_type::not_eof(c);
+        char ch = c;
+        xsputn(&ch, 1);
+        return c;
+    }
+
+private:
+    std::string getInvFilename() const {
+        return _filename + ".inv";
+    }
+
+    static size_t getBlockSize(int fd) {
+        struct stat st;
+        return fstat(fd, &st) == 0 && st.st_blksize > 0 ? st.st_blksize : 4096;
+    }
+
+    // Whether data can be written right below the virtual end of the file and the
+    // range in front of it can be collapsed later.
+    bool probeSparseFile() {
+#ifdef FALLOC_FL_COLLAPSE_RANGE
+        // Exceeding the file size limit raises SIGXFSZ
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_FSIZE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                && limit.rlim_cur < _virtual_end) return false;
+        bool supported = ftruncate(_fd, _virtual_end) == 0
+            && fallocate(_fd, FALLOC_FL_COLLAPSE_RANGE, 0, getBlockSize(_fd)) == 0;
+        if (!supported) LOG(V3_VERB, "Reverse file writer: no sparse file for \"%s\" (%s)\n",
+            _filename.c_str(), strerror(errno));
+        if (ftruncate(_fd, 0) != 0) supported = false;
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    size_t advanceFileBegin(size_t size) {
+        if (size > _file_begin) {
+            LOG(V0_CRIT, "[ERROR] Reverse file writer: \"%s\" exceeds %lu bytes\n", _filename.c_str(), _virtual_end);
+            abort();
+        }
+        _file_begin -= size;
+        return _file_begin;
+    }
+
+    void flushSegment() {
+        const size_t size = _segment.size() - _segment_begin;
+        if (size == 0) return;
+        if (_buffered) {
+            // The segment's content is not needed any more: reverse it in place
+            std::reverse(_segment.data() + _segment_begin, _segment.data() + _segment.size());
+            writeAt(_inv_fd, _segment.data() + _segment_begin, size, size_t(_virtual_end - advanceFileBegin(size) - size));
+        } else {
+            writeAt(_fd, _segment.data() + _segment_begin, size, advanceFileBegin(size));
+        }
+        _segment_begin = _segment.size();
+    }
+
+    // Puts a block larger than the segment in front of all data (with an empty segment)
+    void writeFront(const char* data, size_t size) {
+        const size_t offset = advanceFileBegin(size);
+        if (!_buffered) {
+            writeAt(_fd, data, size, offset);
+            return;
+        }
+        // Append the reversed block to the reversed file, using the segment as a buffer
+        size_t invOffset = _virtual_end - offset - size;
+        for (size_t end = size; end > 0; ) {
+            const size_t chunk = std::min(end, _segment.size());
+            std::reverse_copy(data + end - chunk, data + end, _segment.data());
+            writeAt(_inv_fd, _segment.data(), chunk, invOffset);
+            invOffset += chunk;
+            end -= chunk;
+        }
+    }
+
+    void writeAt(int fd, const char* data, size_t size, size_t offset) {
+        while (size > 0) {
+            auto written = pwrite(fd, data, size, offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                LOG(V0_CRIT, "[ERROR] Reverse file writer: cannot write to \"%s\": %s\n", _filename.c_str(), strerror(errno));
+                abort();
+            }
+            data += written; size -= written; offset += written;
+        }
+    }
+
+    void moveToFront() {
+        // Copy chunk by chunk from the data region to the front (which never overtakes the reads)
+        const size_t size = _virtual_end - _file_begin;
+        for (size_t offset = 0; _file_begin > 0 && offset < size; offset += _segment.size()) {
+            const size_t chunk = std::min(_segment.size(), size - offset);
+            readAt(_fd, _segment.data(), chunk, _file_begin + offset);
+            writeAt(_fd, _segment.data(), chunk, offset);
+        }
+        if (ftruncate(_fd, size) != 0) {
+            LOG(V0_CRIT, "[ERROR] Reverse file writer: cannot truncate \"%s\": %s\n", _filename.c_str(), strerror(errno));
+            abort();
+        }
+        _file_begin = 0;
+    }
+
+    // Reads the reversed file back to front and writes its reversed chunks to the actual file
+    void reverseIntoFile() {
+        const size_t size = _virtual_end - _file_begin;
+        size_t offset = 0;
+        for (size_t end = size; end > 0; ) {
+            const size_t chunk = std::min(end, _segment.size());
+            readAt(_inv_fd, _segment.data(), chunk, end - chunk);
+            std::reverse(_segment.data(), _segment.data() + chunk);
+            writeAt(_fd, _segment.data(), chunk, offset);
+            offset += chunk;
+            end -= chunk;
+        }
+        ::close(_inv_fd);
+        _inv_fd = -1;
+        ::unlink(getInvFilename().c_str());
+        LOG(V4_VVER, "Reverse file writer: \"%s\" complete, %lu bytes\n", _filename.c_str(), size);
+    }
+
+    void readAt(int fd, char* data, size_t size, size_t offset) {
+        size_t numRead = 0;
+        while (numRead < size) {
+            auto res = pread(fd, data + numRead, size - numRead, offset + numRead);
+            if (res < 0 && errno == EINTR) continue;
+            if (res <= 0) {
+                LOG(V0_CRIT, "[ERROR] Reverse file writer: cannot read from \"%s\": %s\n", _filename.c_str(), strerror(errno));
+                abort();
+            }
+            numRead += res;
+        }
+    }
+};
@@ -0,0 +1,299 @@
+
+#include "async_block_io.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/sys/proc.hpp"
+
+// Minimal io_uring instance using the raw system calls (no liburing required)
+class AsyncBlockFile::IoUring {
+
+private:
+    int _fd {-1};
+    unsigned _entries {0};
+
+    void* _sq_ptr {MAP_FAILED};
+    size_t _sq_size {0};
+    void* _cq_ptr {MAP_FAILED};
+    size_t _cq_size {0};
+    io_uring_sqe* _sqes {(io_uring_sqe*) MAP_FAILED};
+    size_t _sqes_size {0};
+
+    unsigned* _sq_tail;
+    unsigned* _sq_mask;
+    unsigned* _sq_array;
+    unsigned* _cq_head;
+    unsigned* _cq_tail;
+    unsigned* _cq_mask;
+    io_uring_cqe* _cqes;
+
+public:
+    bool init(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        _fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (_fd < 0) return false;
+        _entries = params.sq_entries;
+
+        _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+        _sq_ptr = mmap(0, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+        if (_sq_ptr == MAP_FAILED) return false;
+        if (singleMmap) {
+            _cq_ptr = _sq_ptr;
+        } else {
+            _cq_ptr = mmap(0, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+            if (_cq_ptr == MAP_FAILED) return false;
+        }
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = (io_uring_sqe*) mmap(0, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if (_sqes == MAP_FAILED) return false;
+
+        uint8_t* sq = (uint8_t*) _sq_ptr;
+        _sq_tail = (unsigned*) (sq + params.sq_off.tail);
+        _sq_mask = (unsigned*) (sq + params.sq_off.ring_mask);
+        _sq_array = (unsigned*) (sq + params.sq_off.array);
+        uint8_t* cq = (uint8_t*) _cq_ptr;
+        _cq_head = (unsigned*) (cq + params.cq_off.head);
+        _cq_tail = (unsigned*) (cq + params.cq_off.tail);
+        _cq_mask = (unsigned*) (cq + params.cq_off.ring_mask);
+        _cqes = (io_uring_cqe*) (cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~IoUring() {
+        if (_sqes != MAP_FAILED) munmap(_sqes, _sqes_size);
+        if (_cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr) munmap(_cq_ptr, _cq_size);
+        if (_sq_ptr != MAP_FAILED) munmap(_sq_ptr, _sq_size);
+        if (_fd >= 0) close(_fd);
+    }
+
+    unsigned capacity() const {return _entries;}
+
+    // The caller must ensure that less than capacity() requests are in flight.
+    void submit(int fileFd, Request& req) {
+        unsigned tail = *_sq_tail;
+        unsigned idx = tail & *_sq_mask;
+        io_uring_sqe* sqe = &_sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        // vectored operations are supported by every kernel with io_uring
+        sqe->opcode = req.write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = fileFd;
+        sqe->addr = (unsigned long) &req.iov;
+        sqe->len = 1;
+        sqe->off = req.offset + req.result;
+        sqe->user_data = (unsigned long) &req;
+        _sq_array[idx] = idx;
+        __atomic_store_n(_sq_tail, tail+1, __ATOMIC_RELEASE);
+        int res;
+        do {
+            res = syscall(__NR_io_uring_enter, _fd, 1, 0, 0, nullptr, 0);
+        } while (res < 0 && errno == EINTR);
+        if (res < 0) {
+            LOG(V0_CRIT, "[ERROR] io_uring_enter failed: %s\n", strerror(errno));
+            abort();
+        }
+    }
+
+    // Calls the callback for each completed request and the result of its (partial) operation.
+    // Returns the number of completions.
+    template <typename F>
+    int reap(bool blocking, F callback) {
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        while (blocking && head == tail) {
+            int res = syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (res < 0 && errno != EINTR) {
+                LOG(V0_CRIT, "[ERROR] io_uring_enter failed: %s\n", strerror(errno));
+                abort();
+            }
+            tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        }
+        int numReaped = 0;
+        while (head != tail) {
+            io_uring_cqe* cqe = &_cqes[head & *_cq_mask];
+            Request* req = (Request*) cqe->user_data;
+            int res = cqe->res;
+            head++;
+            __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+            callback(*req, res);
+            numReaped++;
+        }
+        return numReaped;
+    }
+};
+
+AsyncBlockFile::AsyncBlockFile(const std::string& filename, bool directIo, Backend backend, int queueDepth) :
+        _filename(filename), _direct(directIo), _backend(backend) {
+
+    int flags = O_RDWR | O_CREAT | O_TRUNC;
+    if (_direct) {
+        _fd = open(_filename.c_str(), flags | O_DIRECT, 0644);
+        if (_fd < 0 && errno == EINVAL) {
+            LOG(V1_WARN, "[WARN] %s does not support direct I/O\n", _filename.c_str());
+            _direct = false;
+        }
+    }
+    if (!_direct) _fd = open(_filename.c_str(), flags, 0644);
+    if (_fd < 0) {
+        LOG(V0_CRIT, "[ERROR] Cannot open %s: %s\n", _filename.c_str(), strerror(errno));
+        abort();
+    }
+
+    if (_backend == IO_URING) {
+        _ring.reset(new IoUring());
+        if (!_ring->init(queueDepth)) {
+            LOG(V3_VERB, "io_uring unavailable (%s), using I/O threads for %s\n",
+                strerror(errno), _filename.c_str());
+            _ring.reset();
+            _backend = THREADS;
+        }
+    }
+    if (_backend == THREADS) {
+        _io_threads.resize(4);
+        for (auto& thread : _io_threads) thread = std::thread([&]() {runIoThread();});
+    }
+}
+
+AsyncBlockFile::~AsyncBlockFile() {
+    if (_ring) {
+        while (_num_in_flight > 0) reapCompletions(true);
+        _ring.reset();
+    }
+    {
+        auto lock = _queue_mutex.getLock();
+        _terminate = true;
+    }
+    _queue_cond_var.notify();
+    for (auto& thread : _io_threads) thread.join();
+    close(_fd);
+}
+
+void AsyncBlockFile::submitRead(Request& req, uint8_t* data, size_t size, size_t offset) {
+    req.write = false;
+    req.data = data;
+    req.size = size;
+    req.offset = offset;
+    submit(req);
+}
+
+void AsyncBlockFile::submitWrite(Request& req, const uint8_t* data, size_t size, size_t offset) {
+    req.write = true;
+    req.data = (uint8_t*) data;
+    req.size = size;
+    req.offset = offset;
+    submit(req);
+}
+
+bool AsyncBlockFile::test(Request& req) {
+    if (_ring && !req.done.load(std::memory_order_relaxed)) reapCompletions(false);
+    return req.done.load(std::memory_order_acquire);
+}
+
+size_t AsyncBlockFile::wait(Request& req) {
+    if (_ring) {
+        while (!req.done.load(std::memory_order_relaxed)) reapCompletions(true);
+    } else {
+        _done_cond_var.wait(_queue_mutex, [&]() {return req.done.load(std::memory_order_acquire);});
+    }
+    if (req.result < 0) {
+        LOG(V0_CRIT, "[ERROR] %s of %lu bytes at offset %lu in %s failed: %s\n",
+            req.write ? "Write" : "Read", req.size, req.offset, _filename.c_str(), strerror(-req.result));
+        abort();
+    }
+    return req.result;
+}
+
+uint8_t* AsyncBlockFile::allocateBuffer(size_t size) {
+    size_t alignedSize = ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+    uint8_t* buffer = (uint8_t*) std::aligned_alloc(ALIGNMENT, alignedSize);
+    assert(buffer);
+    return buffer;
+}
+
+void AsyncBlockFile::freeBuffer(uint8_t* buffer) {
+    std::free(buffer);
+}
+
+void AsyncBlockFile::submit(Request& req) {
+    req.result = 0;
+    req.done.store(false, std::memory_order_relaxed);
+    if (_ring) {
+        // Make room in the submission queue if necessary
+        while (_num_in_flight >= (int) _ring->capacity()) reapCompletions(true);
+        req.iov.iov_base = req.data;
+        req.iov.iov_len = req.size;
+        _ring->submit(_fd, req);
+        _num_in_flight++;
+    } else {
+        {
+            auto lock = _queue_mutex.getLock();
+            _queue.push_back(&req);
+        }
+        _queue_cond_var.notifySingle();
+    }
+}
+
+void AsyncBlockFile::reapCompletions(bool blocking) {
+    _ring->reap(blocking, [&](Request& req, int res) {
+        _num_in_flight--;
+        if (res < 0) {
+            req.result = res;
+        } else {
+            req.result += res;
+            // Resubmit the remainder of a partial transfer (unless at the end of the file)
+            if (res > 0 && req.result < (long) req.size) {
+                req.iov.iov_base = req.data + req.result;
+                req.iov.iov_len = req.size - req.result;
+                _ring->submit(_fd, req);
+                _num_in_flight++;
+                return;
+            }
+        }
+        req.done.store(true, std::memory_order_release);
+    });
+}
+
+void AsyncBlockFile::runIoThread() {
+    Proc::nameThisThread("AsyncBlockIO");
+    while (true) {
+        Request* req;
+        {
+            auto lock = _queue_mutex.getLock();
+            _queue_cond_var.waitWithLockedMutex(lock, [&]() {return _terminate || !_queue.empty();});
+            if (_queue.empty()) return;
+            req = _queue.front();
+            _queue.pop_front();
+        }
+        long result = 0;
+        while (result < (long) req->size) {
+            ssize_t res = req->write ?
+                pwrite(_fd, req->data + result, req->size - result, req->offset + result) :
+                pread(_fd, req->data + result, req->size - result, req->offset + result);
+            if (res < 0 && errno == EINTR) continue;
+            if (res < 0) {
+                result = -errno;
+                break;
+            }
+            if (res == 0) break; // end of file
+            result += res;
+        }
+        {
+            auto lock = _queue_mutex.getLock();
+            req->result = result;
+            req->done.store(true, std::memory_order_release);
+        }
+        _done_cond_var.notify();
+    }
+}
@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+#include "util/sys/threading.hpp"
+
+/*
+File for asynchronous reads and writes of (large) blocks at arbitrary offsets.
+Requests are submitted via io_uring if the kernel supports it; otherwise, a few
+I/O threads perform the requests with blocking pread/pwrite calls.
+With direct I/O (O_DIRECT), the page cache is bypassed. In this case, all buffers,
+sizes, and offsets must be multiples of ALIGNMENT; use allocateBuffer().
+Submitting and waiting for requests is not thread-safe, i.e., all calls for
+a particular file must be made by one thread at a time.
+*/
+class AsyncBlockFile {
+
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+
+    enum Backend {THREADS, IO_URING};
+
+    struct Request {
+        bool write;
+        uint8_t* data;
+        size_t size;
+        size_t offset;
+        struct iovec iov;
+        // bytes transferred so far, or -errno
+        long result {0};
+        std::atomic_bool done {false};
+    };
+
+private:
+    class IoUring;
+
+    std::string _filename;
+    int _fd {-1};
+    bool _direct {false};
+    Backend _backend;
+
+    std::unique_ptr<IoUring> _ring;
+    int _num_in_flight {0};
+
+    std::vector<std::thread> _io_threads;
+    std::list<Request*> _queue;
+    Mutex _queue_mutex;
+    ConditionVariable _queue_cond_var;
+    ConditionVariable _done_cond_var;
+    bool _terminate {false};
+
+public:
+    AsyncBlockFile(const std::string& filename, bool directIo, Backend backend, int queueDepth = 64);
+    ~AsyncBlockFile();
+
+    void submitRead(Request& req, uint8_t* data, size_t size, size_t offset);
+    void submitWrite(Request& req, const uint8_t* data, size_t size, size_t offset);
+    // Whether the request is done, without blocking
+    bool test(Request& req);
+    // Blocks until the request is done. Returns the number of bytes transferred.
+    size_t wait(Request& req);
+
+    bool isDirect() const {return _direct;}
+    Backend getBackend() const {return _backend;}
+    const char* getBackendName() const {return _backend == IO_URING ? "io_uring" : "threads";}
+
+    static uint8_t* allocateBuffer(size_t size);
+    static void freeBuffer(uint8_t* buffer);
+
+private:
+    void submit(Request& req);
+    void reapCompletions(bool blocking);
+    void runIoThread();
+};
@@ -94,7 +94,7 @@ public:
                     if (FileUtils::isRegularFile(filenameStr)) {
                         // Trigger CREATE event
                         //LOGGER(logger, V4_VVER, "FileWatcher: File event\n");
-                        ProcessWideThreadPool::get().addTask([this, entry, &sublogger] () {
+                        ProcessWideThreadPool::get().addDetachedTask([this, entry, &sublogger] () {
                             _callback(FileWatcher::Event{IN_MOVED_TO, entry}, sublogger);
                         });
                     }
@@ -123,7 +123,7 @@ public:
                     inotify_event* event = (inotify_event*) &buffer[i];
                     Event ev{event->mask, std::string(event->name, event->len)};
                     //LOGGER(logger, V4_VVER, "FileWatcher: File event\n");
-                    ProcessWideThreadPool::get().addTask([this, ev, &sublogger] () {_callback(ev, sublogger);});
+                    ProcessWideThreadPool::get().addDetachedTask([this, ev, &sublogger] () {_callback(ev, sublogger);});
                     i += eventSize + event->len;
                 }
             }
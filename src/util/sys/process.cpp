@@ -15,6 +15,7 @@
 #include "process.hpp"
 #include "proc.hpp"
 #include "util/logger.hpp"
+#include "util/async_logger.hpp"
 #include "util/sys/stacktrace.hpp"
 #include "util/sys/background_worker.hpp"
 #include "util/sys/thread_pool.hpp"
@@ -31,6 +32,8 @@ std::atomic_bool Process::_exit_signal_caught = false;
 std::atomic_int Process::_exit_signal = 0;
 std::atomic_long Process::_signal_tid = 0;
 
+std::atomic_int Process::_requested_exit_code = 0;
+
 void doNothing(int signum) {
     // Do nothing, just return
     //std::cout << "WOKE_UP" << std::endl;
@@ -44,6 +47,8 @@ void handleSignal(int signum) {
         Process::_signal_tid = Proc::getTid();
         Process::_exit_signal_caught = true;
         if (Process::isCrash(signum)) {
+            // Write out pending asynchronous log records
+            if (AsyncLogger::isActive()) AsyncLogger::drainOnCrash();
             // Try to write a trace of the concerned thread with gdb
             Process::writeTrace(Process::_signal_tid);
         }
@@ -76,6 +81,14 @@ void Process::handleTerminationSignal(const SignalInfo& info) {
     }
 }
 
+void Process::requestExitCode(int retval) {
+    _requested_exit_code = retval;
+}
+
+int Process::getRequestedExitCode() {
+    return _requested_exit_code;
+}
+
 void Process::doExit(int retval) {
     // Exit with normal exit code if terminated or interrupted,
     // with caught signal otherwise
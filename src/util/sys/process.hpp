@@ -26,6 +26,9 @@ public:
     static std::atomic_long _signal_tid;
     static std::atomic_bool _exit_signal_digested;
 
+    // exit code for an otherwise regular exit, e.g., if a result turned out to be invalid
+    static std::atomic_int _requested_exit_code;
+
     static void init(int rank, const std::string& traceDir = ".", bool leafProcess = false);
     
     static int createChild();
@@ -56,6 +59,8 @@ public:
 
     static void writeTrace(long tid);
 
+    static void requestExitCode(int retval);
+    static int getRequestedExitCode();
     static void doExit(int retval);
 };
 
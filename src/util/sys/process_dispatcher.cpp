@@ -6,6 +6,10 @@
 #include <stdlib.h>
 #include <fstream>
 #include <cstdio>
+#include <csignal>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "util/assert.hpp"
 #include "util/sys/shared_memory.hpp"
@@ -18,25 +22,35 @@
 #include "util/sys/fileutils.hpp"
 #include "util/sys/tmpdir.hpp"
 
-void ProcessDispatcher::dispatch() {
+void ProcessDispatcher::dispatch(bool pooled) {
 
     const char* tmpdirCStr = std::getenv("MALLOB_TMP_DIR");
     std::string tmpdir = tmpdirCStr ? tmpdirCStr : "/tmp";
 
-    // Read command from tmp file
+    // A pooled dispatcher may wait for its command for a long time,
+    // so make sure that it does not outlive its parent (thread)
+    if (pooled) {
+        pid_t parentPid = getppid();
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parentPid) return;
+    }
+
+    // Read command from named pipe, blocking until the parent writes to it
     pid_t myPid = Proc::getPid();
     std::string commandOutfile = tmpdir + "/mallob_subproc_cmd_" + std::to_string(myPid);
+    if (mkfifo(commandOutfile.c_str(), 0666) != 0 && errno != EEXIST) {
+        LOG(V0_CRIT, "[ERROR] Cannot create pipe %s: errno %i\n", commandOutfile.c_str(), (int)errno);
+        return;
+    }
     std::string command;
     {
         std::ifstream ifs(commandOutfile);
-        while (!ifs.is_open()) {
-            usleep(100);
-            ifs = std::ifstream(commandOutfile);
-        }
         command = std::string(std::istreambuf_iterator<char>(ifs),
             std::istreambuf_iterator<char>());
     }
     FileUtils::rm(commandOutfile); // clean up immediately
+    // The executed process manages its own lifetime
+    if (pooled) prctl(PR_SET_PDEATHSIG, 0);
 
     // Assemble arguments list
     int numArgs = 0;
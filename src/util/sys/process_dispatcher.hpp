@@ -4,6 +4,7 @@
 class ProcessDispatcher {
 
 public:
-    void dispatch();
+    // If pooled, the dispatcher has been spawned in advance by a long-lived thread.
+    void dispatch(bool pooled);
 
 };
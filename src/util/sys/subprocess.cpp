@@ -0,0 +1,141 @@
+
+#include "subprocess.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include "util/sys/fileutils.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+#ifndef MALLOB_SUBPROC_DISPATCH_PATH
+#define MALLOB_SUBPROC_DISPATCH_PATH ""
+#endif
+
+Mutex Subprocess::_pool_mutex;
+std::vector<pid_t> Subprocess::_pool;
+int Subprocess::_pool_size = 0;
+std::atomic_bool Subprocess::_pool_refilling = false;
+
+pid_t Subprocess::start() {
+
+    float time = Timer::elapsedSeconds();
+    pid_t res = takeFromPool();
+    const bool pooled = res > 0;
+    if (!pooled) res = spawnDispatcher(false);
+
+    // [parent process]
+    // Assemble SAT subprocess command
+    std::string executable;
+    if (_cmd[0] == '/') executable = _cmd;
+    else executable = std::string(MALLOB_SUBPROC_DISPATCH_PATH) + "/" + _cmd;
+    //char* const* argv = _params.asCArgs(executable.c_str());
+    std::string command = _params.getSubprocCommandAsString(executable.c_str());
+
+    // Write command to named pipe (to be read by child process).
+    // The dispatcher may have created the pipe already.
+    std::string commandOutfile = getCommandPipe(res);
+    if (mkfifo(commandOutfile.c_str(), 0666) != 0 && errno != EEXIST) {
+        LOG(V0_CRIT, "[ERROR] Cannot create pipe %s: %s\n", commandOutfile.c_str(), strerror(errno));
+    }
+    {
+        std::ofstream ofs(commandOutfile);
+        ofs << command << " " << std::endl;
+    }
+    LOG(V4_VVER, "Dispatched %s to %s pid %i within %.4fs\n", _cmd.c_str(),
+        pooled ? "pooled" : "new", res, Timer::elapsedSeconds() - time);
+
+    if (pooled) refillPool();
+    return res;
+}
+
+void Subprocess::initPool(int size) {
+    {
+        auto lock = _pool_mutex.getLock();
+        _pool_size = size;
+    }
+    for (int i = 0; i < size; i++) {
+        pid_t pid = spawnDispatcher(true);
+        auto lock = _pool_mutex.getLock();
+        _pool.push_back(pid);
+    }
+    if (size > 0) LOG(V4_VVER, "Spawned %i pooled dispatchers\n", size);
+}
+
+void Subprocess::shutdownPool() {
+    std::vector<pid_t> pool;
+    {
+        auto lock = _pool_mutex.getLock();
+        _pool_size = 0;
+        pool = std::move(_pool);
+        _pool.clear();
+    }
+    for (pid_t pid : pool) {
+        Process::hardkill(pid);
+        while (!Process::didChildExit(pid)) usleep(1000);
+        FileUtils::rm(getCommandPipe(pid));
+    }
+}
+
+pid_t Subprocess::spawnDispatcher(bool pooled) {
+
+    // FORK: Create a child process
+    pid_t res = Process::createChild();
+    if (res == 0) {
+        // [child process]
+        // Danger zone: Do not touch any memory.
+        // (the environment must be passed in both cases, e.g., for MALLOB_TMP_DIR)
+        if (pooled) {
+            execle(MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher",
+                MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher",
+                "pooled", (char*) 0, environ);
+        } else {
+            execle(MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher",
+                MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher",
+                (char*) 0, environ);
+        }
+        
+        // If this is reached, something went very wrong with execvp
+        LOG(V0_CRIT, "[ERROR] execl returned errno %i\n", (int)errno);
+        abort();
+    }
+    return res;
+}
+
+pid_t Subprocess::takeFromPool() {
+    auto lock = _pool_mutex.getLock();
+    if (_pool.empty()) return -1;
+    pid_t pid = _pool.back();
+    _pool.pop_back();
+    return pid;
+}
+
+void Subprocess::refillPool() {
+    if (_pool_refilling.exchange(true)) return;
+    ProcessWideThreadPool::get().addDetachedTask([]() {
+        while (true) {
+            {
+                auto lock = _pool_mutex.getLock();
+                if ((int) _pool.size() >= _pool_size) break;
+            }
+            pid_t pid = spawnDispatcher(true);
+            {
+                auto lock = _pool_mutex.getLock();
+                if (_pool_size > 0) {
+                    _pool.push_back(pid);
+                    continue;
+                }
+            }
+            // pool has been shut down in the meantime
+            Process::hardkill(pid);
+            while (!Process::didChildExit(pid)) usleep(1000);
+            FileUtils::rm(getCommandPipe(pid));
+            break;
+        }
+        _pool_refilling = false;
+    });
+}
+
+std::string Subprocess::getCommandPipe(pid_t pid) {
+    return TmpDir::get() + "/mallob_subproc_cmd_" + std::to_string(pid);
+}
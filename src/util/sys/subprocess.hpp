@@ -5,11 +5,14 @@
 #include "util/params.hpp"
 #include "util/sys/process.hpp"
 #include "util/assert.hpp"
+#include "util/sys/threading.hpp"
 #include "util/sys/tmpdir.hpp"
+#include <atomic>
 #include <cstdlib>
 #include <ctime>
 #include <string>
 #include <fstream>
+#include <vector>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -19,9 +22,10 @@ where an MPI process is the parent, this is done in a quite awkward manner to be
 absolutely safe: The forked process does not touch any non-constant memory and
 immediately executes a generic, parameter-free "dispatcher" executable.
 The parent process then communicates the actual command and args to execute to
-the dispatcher via a tmp file qualified by the dispatcher's PID.
-Obviously this results in additional overhead, so spawning a subprocess via this
-interface should be done sparingly.
+the dispatcher via a named pipe qualified by the dispatcher's PID.
+Obviously this results in additional overhead. To take the fork and the startup
+of the dispatcher off the critical path, each process can keep a small pool of
+dispatchers which have been spawned in advance and block on their pipe.
 */
 class Subprocess {
 
@@ -29,43 +33,27 @@ private:
     const Parameters& _params;
     const std::string _cmd;
 
+    static Mutex _pool_mutex;
+    static std::vector<pid_t> _pool;
+    static int _pool_size;
+    static std::atomic_bool _pool_refilling;
+
 public:
     Subprocess(const Parameters& params, const std::string& cmd) : _params(params), _cmd(cmd) {
         assert(!_cmd.empty());
     }
 
-    pid_t start() {
-
-        // FORK: Create a child process
-        pid_t res = Process::createChild();
-        if (res == 0) {
-            // [child process]
-            // Danger zone: Do not touch any memory.
-            execle(MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher",
-                MALLOB_SUBPROC_DISPATCH_PATH"mallob_process_dispatcher", 
-                (char*) 0, environ);
-            
-            // If this is reached, something went very wrong with execvp
-            LOG(V0_CRIT, "[ERROR] execl returned errno %i\n", (int)errno);
-            abort();
-        }
+    pid_t start();
 
-        // [parent process]
-        // Assemble SAT subprocess command
-        std::string executable;
-        if (_cmd[0] == '/') executable = _cmd;
-        else executable = std::string(MALLOB_SUBPROC_DISPATCH_PATH) + "/" + _cmd;
-        //char* const* argv = _params.asCArgs(executable.c_str());
-        std::string command = _params.getSubprocCommandAsString(executable.c_str());
-        
-        // Write command to tmp file (to be read by child process)
-        std::string commandOutfile = TmpDir::get() + "/mallob_subproc_cmd_" + std::to_string(res);
-        mkfifo(commandOutfile.c_str(), 0666);
-        {
-            std::ofstream ofs(commandOutfile);
-            ofs << command << " " << std::endl;
-        }
-        return res;
-    }
+    // Spawn the given number of dispatchers to be used by subsequent start() calls.
+    // Dispatchers taken from the pool are replaced in the background.
+    static void initPool(int size);
+    // Kill all dispatchers which have not been used and clean up their pipes.
+    static void shutdownPool();
 
+private:
+    static pid_t spawnDispatcher(bool pooled);
+    static pid_t takeFromPool();
+    static void refillPool();
+    static std::string getCommandPipe(pid_t pid);
 };
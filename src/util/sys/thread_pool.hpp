@@ -2,69 +2,235 @@
 #ifndef DOMPASCH_MALLOB_THREAD_POOL_HPP
 #define DOMPASCH_MALLOB_THREAD_POOL_HPP
 
-#include <vector>
-#include <list>
-#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <future>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "util/sys/threading.hpp"
 #include "util/logger.hpp"
 #include "util/sys/proc.hpp"
 
-class ThreadPool {
+// Move-only, type-erased nullary callable. Callables of up to INLINE_SIZE bytes
+// (e.g., lambdas capturing a few pointers or a shared_ptr) are stored in place,
+// so that submitting them to a thread pool does not allocate.
+class ThreadPoolTask {
 
-public:
-    struct Runnable {
-        std::function<void()> function;
-        std::promise<void> promise;
+private:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dest, void* src); // also destroys src
+        void (*destroy)(void* storage);
+    };
+    template <typename F>
+    struct InlineOps {
+        static void invoke(void* storage) {(*static_cast<F*>(storage))();}
+        static void move(void* dest, void* src) {
+            new (dest) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+        static void destroy(void* storage) {static_cast<F*>(storage)->~F();}
+        static constexpr Ops ops {invoke, move, destroy};
+    };
+    template <typename F>
+    struct HeapOps {
+        static void invoke(void* storage) {(**static_cast<F**>(storage))();}
+        static void move(void* dest, void* src) {*static_cast<F**>(dest) = *static_cast<F**>(src);}
+        static void destroy(void* storage) {delete *static_cast<F**>(storage);}
+        static constexpr Ops ops {invoke, move, destroy};
     };
 
+    alignas(std::max_align_t) unsigned char _storage[INLINE_SIZE];
+    const Ops* _ops {nullptr};
+
+public:
+    ThreadPoolTask() {}
+    template <typename Callable, typename F = std::decay_t<Callable>,
+        typename = std::enable_if_t<!std::is_same_v<F, ThreadPoolTask>>>
+    ThreadPoolTask(Callable&& f) {
+        if constexpr (sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<F>) {
+            new (_storage) F(std::forward<Callable>(f));
+            _ops = &InlineOps<F>::ops;
+        } else {
+            *reinterpret_cast<F**>(_storage) = new F(std::forward<Callable>(f));
+            _ops = &HeapOps<F>::ops;
+        }
+    }
+    ThreadPoolTask(ThreadPoolTask&& other) {
+        *this = std::move(other);
+    }
+    ThreadPoolTask& operator=(ThreadPoolTask&& other) {
+        if (this == &other) return *this;
+        reset();
+        if (other._ops) {
+            other._ops->move(_storage, other._storage);
+            _ops = other._ops;
+            other._ops = nullptr;
+        }
+        return *this;
+    }
+    ThreadPoolTask(const ThreadPoolTask& other) = delete;
+    ThreadPoolTask& operator=(const ThreadPoolTask& other) = delete;
+    ~ThreadPoolTask() {reset();}
+
+    void operator()() {_ops->invoke(_storage);}
+    bool valid() const {return _ops != nullptr;}
+    void reset() {
+        if (!_ops) return;
+        _ops->destroy(_storage);
+        _ops = nullptr;
+    }
+};
+
+// Work-stealing thread pool. Each worker thread has its own task queue.
+// Tasks submitted by a worker go to the worker's own queue, tasks submitted
+// by other threads are distributed round-robin. Workers process their own
+// queue in FIFO order and steal tasks from the other queues if it is empty.
+// Idle workers sleep until new tasks arrive.
+class ThreadPool {
+
 private:
+    // Ring buffer of tasks which only grows when it is full, so that
+    // queueing a task does not allocate in the steady state.
+    struct alignas(64) WorkerQueue {
+        Mutex mutex;
+        std::vector<ThreadPoolTask> tasks;
+        size_t head {0};
+        size_t size {0};
+
+        void push(ThreadPoolTask&& task) {
+            if (size == tasks.size()) {
+                std::vector<ThreadPoolTask> grown(std::max((size_t) 16, 2*tasks.size()));
+                for (size_t i = 0; i < size; i++)
+                    grown[i] = std::move(tasks[(head+i) % tasks.size()]);
+                tasks = std::move(grown);
+                head = 0;
+            }
+            tasks[(head+size) % tasks.size()] = std::move(task);
+            size++;
+        }
+        bool pop(ThreadPoolTask& task) {
+            if (size == 0) return false;
+            task = std::move(tasks[head]);
+            head = (head+1) % tasks.size();
+            size--;
+            return true;
+        }
+    };
+
+    std::vector<WorkerQueue> _queues;
     std::vector<std::thread> _threads;
-    std::list<Runnable> _job_queue;
-    Mutex _job_queue_mutex;
-    ConditionVariable _job_queue_cond_var;
-    bool _terminate = false;
+    std::atomic_ulong _next_queue {0};
+
+    // Number of queued tasks which have not been claimed by a worker yet
+    std::atomic_long _num_pending {0};
+    std::atomic_int _num_sleeping {0};
+    Mutex _sleep_mutex;
+    ConditionVariable _sleep_cond_var;
+    std::atomic_bool _terminate {false};
+
+    static inline thread_local ThreadPool* _current_pool {nullptr};
+    static inline thread_local size_t _current_queue {0};
 
 public:
-    ThreadPool(size_t size) : _threads(size) {
+    ThreadPool(size_t size) : _queues(size), _threads(size) {
         for (size_t i = 0; i < _threads.size(); i++) {
             _threads[i] = std::thread([&, i]() {runThread(i);});
         }
     }
     ~ThreadPool() {
-        _terminate = true;
+        {
+            auto lock = _sleep_mutex.getLock();
+            _terminate = true;
+        }
+        _sleep_cond_var.notify();
         for (auto& thread : _threads) thread.join();
     }
 
-    std::future<void> addTask(std::function<void()>&& function) {
-        Runnable r;
-        r.function = std::move(function);
-        std::future<void> future;
-        {
-            auto lock = _job_queue_mutex.getLock();
-            _job_queue.push_back(std::move(r));
-            future = _job_queue.back().promise.get_future();
-        }
-        _job_queue_cond_var.notify();
+    // Executes the function asynchronously and returns a future
+    // which becomes ready once the function has returned.
+    template <typename F>
+    std::future<void> addTask(F&& function) {
+        std::promise<void> promise;
+        std::future<void> future = promise.get_future();
+        enqueue(ThreadPoolTask([function = std::forward<F>(function), promise = std::move(promise)]() mutable {
+            function();
+            promise.set_value();
+        }));
         return future;
     }
 
+    // Executes the function asynchronously without any means to wait for it.
+    template <typename F>
+    void addDetachedTask(F&& function) {
+        enqueue(ThreadPoolTask(std::forward<F>(function)));
+    }
+
 private:
-    void runThread(int id) {
+    void enqueue(ThreadPoolTask&& task) {
+        const size_t queueIdx = _current_pool == this ? _current_queue :
+            _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+        {
+            auto lock = _queues[queueIdx].mutex.getLock();
+            _queues[queueIdx].push(std::move(task));
+        }
+        // A worker either sees the new pending task before going to sleep
+        // or is visible as sleeping here and gets notified
+        _num_pending.fetch_add(1);
+        if (_num_sleeping.load() > 0) {
+            auto lock = _sleep_mutex.getLock();
+            _sleep_cond_var.notifySingle();
+        }
+    }
+
+    bool tryDequeue(size_t id, ThreadPoolTask& task) {
+        bool success;
+        {
+            auto lock = _queues[id].mutex.getLock();
+            success = _queues[id].pop(task);
+        }
+        // Steal from other queues, skipping those which are busy right now
+        for (size_t i = 1; !success && i < _queues.size(); i++) {
+            auto& queue = _queues[(id+i) % _queues.size()];
+            if (!queue.mutex.tryLock()) continue;
+            success = queue.pop(task);
+            queue.mutex.unlock();
+        }
+        if (success) _num_pending.fetch_sub(1);
+        return success;
+    }
+
+    void runThread(size_t id) {
         std::string threadName = "ThreadPool#" + std::to_string(id);
         Proc::nameThisThread(threadName.c_str());
+        _current_pool = this;
+        _current_queue = id;
 
-        Runnable r;
+        ThreadPoolTask task;
         while (!_terminate) {
-            {
-                auto lock = _job_queue_mutex.getLock();
-                _job_queue_cond_var.waitWithLockedMutex(lock, [&]() {return !_job_queue.empty();});
-                r = std::move(_job_queue.front());
-                _job_queue.pop_front();
+            if (tryDequeue(id, task)) {
+                task();
+                task.reset();
+                continue;
+            }
+            // A pending task may be in a queue which was busy: retry
+            if (_num_pending.load() > 0) {
+                std::this_thread::yield();
+                continue;
             }
-            r.function();
-            r.promise.set_value();
+            auto lock = _sleep_mutex.getLock();
+            _num_sleeping++;
+            _sleep_cond_var.waitWithLockedMutex(lock, [&]() {return _num_pending.load() > 0 || _terminate;});
+            _num_sleeping--;
         }
     }
 };
@@ -80,7 +246,7 @@ public:
             exit(1);
         }
         return *pool;
-    }  
+    }
 };
 
 #endif
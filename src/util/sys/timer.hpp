@@ -21,10 +21,15 @@ public:
      * Returns elapsed time since program start (since MyMpi::init) in seconds.
      */
     static inline float elapsedSeconds() {
+#ifdef MALLOB_SIMULATED_CLOCK
+        // The scheduler simulation advances the time explicitly (setElapsedSecondsCached)
+        return lastTimeMeasured;
+#else
         clock_gettime(CLOCK_MONOTONIC_RAW, &timespecEnd);
         float time = timespecEnd.tv_sec - timespecStart.tv_sec  
             + (0.001f * 0.001f * 0.001f) * (timespecEnd.tv_nsec - timespecStart.tv_nsec);
         return time;
+#endif
     }
 
     /**
@@ -45,6 +50,14 @@ public:
         return lastTimeMeasured;
     }
 
+    /**
+     * Overrides the value returned by "elapsedSecondsCached()", e.g., in order
+     * to drive components by a simulated clock. Main thread ONLY.
+     */
+    static inline void setElapsedSecondsCached(float time) {
+        lastTimeMeasured = time;
+    }
+
     static timespec getStartTime();
 };
 
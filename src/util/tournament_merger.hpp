@@ -0,0 +1,112 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "merge_source_interface.hpp"
+
+// Multi-way merger over sources whose elements arrive in descending order.
+// Outputs the greatest element among all sources first. The next element is found
+// with a tournament tree ("loser tree") in O(log k) comparisons for k sources.
+template <typename T>
+class TournamentMerger : public MergeSourceInterface<T> {
+
+private:
+    struct Source {
+        MergeSourceInterface<T>* interface;
+        T nextElem;
+        bool valid {false};
+    };
+    std::vector<Source> _sources;
+
+    // Number of leaves (number of sources, rounded up to a power of two).
+    // Leaf i resides at position _num_leaves+i. Each inner node holds the index
+    // of the source which lost the match at this node, and _tree[0] holds
+    // the index of the overall winner.
+    size_t _num_leaves {1};
+    std::vector<size_t> _tree;
+    bool _initialized {false};
+
+public:
+    TournamentMerger(const std::vector<MergeSourceInterface<T>*>& sources) {
+        for (auto& source : sources) {
+            _sources.emplace_back();
+            _sources.back().interface = source;
+        }
+        while (_num_leaves < _sources.size()) _num_leaves *= 2;
+        _tree.resize(_num_leaves);
+    }
+
+    bool pollBlocking(T& output) override {
+        if (!_initialized) initialize();
+
+        size_t winner = _tree[0];
+        if (!isValid(winner)) return false; // all sources exhausted
+
+        // Write output, fetch the next element of the winner's source
+        auto& source = _sources[winner];
+        std::swap(output, source.nextElem);
+        source.valid = source.interface->pollBlocking(source.nextElem);
+
+        // Replay the matches on the path from the winner's leaf to the root
+        for (size_t node = (_num_leaves + winner) / 2; node >= 1; node /= 2) {
+            if (beats(_tree[node], winner)) std::swap(_tree[node], winner);
+        }
+        _tree[0] = winner;
+        return true;
+    }
+
+    size_t getCurrentSize() const override {
+        size_t size = 0;
+        for (auto& source : _sources) {
+            size += source.interface->getCurrentSize()+(source.valid ? 1 : 0);
+        }
+        return size;
+    }
+
+    std::string getReport() {
+        std::string sizes;
+        for (auto& source : _sources) {
+            sizes += std::to_string(
+                source.interface->getCurrentSize()+(source.valid ? 1 : 0)
+            ) + " ";
+        }
+        return sizes;
+    }
+
+private:
+    void initialize() {
+        for (auto& source : _sources) {
+            source.valid = source.interface->pollBlocking(source.nextElem);
+        }
+        // Play all matches bottom-up, remembering the winner of each subtree
+        std::vector<size_t> winners(2*_num_leaves);
+        for (size_t i = 0; i < _num_leaves; i++) winners[_num_leaves+i] = i;
+        for (size_t node = _num_leaves-1; node >= 1; node--) {
+            size_t left = winners[2*node];
+            size_t right = winners[2*node+1];
+            bool leftWins = beats(left, right);
+            winners[node] = leftWins ? left : right;
+            _tree[node] = leftWins ? right : left;
+        }
+        _tree[0] = winners[1];
+        _initialized = true;
+    }
+
+    bool isValid(size_t idx) const {
+        return idx < _sources.size() && _sources[idx].valid;
+    }
+
+    // Whether the current element of source a is output before that of source b.
+    // Exhausted sources and padding leaves lose, ties go to the lower index.
+    bool beats(size_t a, size_t b) {
+        if (!isValid(a)) return false;
+        if (!isValid(b)) return true;
+        auto& elemA = _sources[a].nextElem;
+        auto& elemB = _sources[b].nextElem;
+        if (elemA > elemB) return true;
+        if (elemB > elemA) return false;
+        return a < b;
+    }
+};